@@ -0,0 +1,26 @@
+﻿#include "AdaptivePollInterval.h"
+
+AdaptivePollInterval::AdaptivePollInterval(uint32_t minMs, uint32_t maxMs, uint32_t fastWindowMs)
+    : m_minMs(minMs)
+    , m_maxMs(maxMs < minMs ? minMs : maxMs)
+    , m_fastWindowMs(fastWindowMs)
+    , m_current(minMs)
+    , m_lastActivity(0)
+{
+}
+
+void AdaptivePollInterval::OnActivity(uint64_t nowMs) {
+    m_lastActivity = nowMs;
+    m_current = m_minMs;
+}
+
+uint32_t AdaptivePollInterval::Next(uint64_t nowMs) {
+    if (nowMs - m_lastActivity < m_fastWindowMs) {
+        m_current = m_minMs; // 최근 활동 -> 빠른 폴링 유지
+    }
+    else {
+        uint32_t doubled = m_current * 2; // 유휴 -> 지수 백오프
+        m_current = doubled > m_maxMs ? m_maxMs : doubled;
+    }
+    return m_current;
+}
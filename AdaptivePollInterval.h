@@ -0,0 +1,22 @@
+﻿#pragma once
+#include <stdint.h>
+
+// 활동량에 따라 폴링 주기를 조정 (플랫폼 독립)
+// - 입력/URL 변경/포커스 전환 직후 fastWindowMs 동안은 minMs로 빠르게
+// - 이후 유휴 상태면 maxMs까지 지수적으로 늘림
+class AdaptivePollInterval {
+public:
+    AdaptivePollInterval(uint32_t minMs = 100, uint32_t maxMs = 1600, uint32_t fastWindowMs = 2000);
+
+    void OnActivity(uint64_t nowMs);
+    uint32_t Next(uint64_t nowMs);
+
+    uint32_t Current() const { return m_current; }
+
+private:
+    uint32_t m_minMs;
+    uint32_t m_maxMs;
+    uint32_t m_fastWindowMs;
+    uint32_t m_current;
+    uint64_t m_lastActivity;
+};
@@ -0,0 +1,213 @@
+﻿#include "AddressBarLocator.h"
+#include "AsyncLogger.h"
+#include <algorithm>
+
+static const int kMaxPathDepth = 64; // 비정상 트리에서 무한 루프 방지
+
+AddressBarLocator::AddressBarLocator() : m_pathHits(0), m_fullSearches(0) {
+}
+
+void AddressBarLocator::Clear() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_paths.clear();
+}
+
+void AddressBarLocator::Snapshot(std::vector<LocatorPathSnapshot>& out) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    for (const auto& kv : m_paths) {
+        out.push_back(LocatorPathSnapshot{ kv.first.type, kv.first.version, kv.second });
+    }
+}
+
+void AddressBarLocator::Restore(const std::vector<LocatorPathSnapshot>& paths) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    for (const LocatorPathSnapshot& p : paths) {
+        if (p.steps.empty()) continue;
+        m_paths[Key{ p.type, p.version }] = p.steps; // 맞지 않으면 Locate가 경로를 버리고 다시 학습
+    }
+}
+
+static bool Contains(const std::wstring& s, const wchar_t* token) {
+    return s.find(token) != std::wstring::npos;
+}
+
+//브라우저 유형별 주소 표시줄 판별 규칙 (기존 FindAddressBarElementByBrowser 분기)
+bool AddressBarLocator::IsAddressBarCandidate(BrowserType type, const UiaNodeInfo& info) {
+    if (info.controlType != kUiaEditControlTypeId) return false;
+
+    const std::wstring& n = info.name;
+
+    switch (type) {
+    case BrowserType::FireFox:
+        // Firefox는 Name이 빈 경우가 많아 포커스 가능한 Edit을 주소 표시줄로 간주
+        if (n.empty()) return info.keyboardFocusable;
+        return Contains(n, L"address") || Contains(n, L"주소") || Contains(n, L"search");
+
+    case BrowserType::IE:
+        return Contains(n, L"Address") || Contains(n, L"주소");
+
+    case BrowserType::Chrome: // 크롬, 웨일, 엣지 (Chromium) 공통 구조
+    case BrowserType::Edge:
+    case BrowserType::Whale:
+    default:
+        return Contains(n, L"Address") || Contains(n, L"address") ||
+            Contains(n, L"search") || Contains(n, L"주소");
+    }
+}
+
+UiaNode AddressBarLocator::Locate(IUiaTree& tree, BrowserType type, const std::wstring& version) {
+    Key key = { (int)type, version };
+
+    // 1. 학습된 경로가 있으면 경로를 바로 따라감
+    std::vector<LocatorPathStep> path;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        auto it = m_paths.find(key);
+        if (it != m_paths.end()) path = it->second;
+    }
+
+    if (!path.empty()) {
+        UiaNode node = WalkPath(tree, path);
+        if (node) {
+            UiaNodeInfo info;
+            if (tree.GetInfo(node, info) && IsAddressBarCandidate(type, info)) {
+                m_pathHits++;
+                return node;
+            }
+            tree.ReleaseNode(node);
+        }
+
+        // 경로가 더 이상 유효하지 않음 (UI 구조 변경) -> 폐기 후 전체 탐색
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_paths.erase(key);
+    }
+
+    // 2. 전체 탐색 후 경로 학습
+    UiaNode found = FullSearch(tree, type);
+    if (!found) return nullptr;
+
+    std::vector<LocatorPathStep> learned;
+    if (RecordPath(tree, found, learned)) {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_paths[key] = learned;
+        AGENT_LOG_INFO("[UIA] AddressBar path learned (type=%d, depth=%d)", (int)type, (int)learned.size());
+    }
+    return found;
+}
+
+// 경로 단계별로 자식을 찾아 내려감 (AutomationId 우선, 없으면 자식 순서)
+UiaNode AddressBarLocator::WalkPath(IUiaTree& tree, const std::vector<LocatorPathStep>& path) {
+    UiaNode cur = nullptr; // nullptr == 루트 (소유권 없음)
+
+    for (const LocatorPathStep& step : path) {
+        UiaNode parent = cur ? cur : tree.Root();
+        UiaNode byIndex = nullptr;
+        UiaNode found = nullptr;
+
+        int i = 0;
+        UiaNode child = tree.FirstChild(parent);
+        while (child) {
+            bool keep = false;
+            if (!step.automationId.empty()) {
+                UiaNodeInfo info;
+                if (tree.GetInfo(child, info) && info.automationId == step.automationId) {
+                    found = child;
+                    break;
+                }
+            }
+            if (i == step.childIndex) {
+                byIndex = child;
+                keep = true;
+                if (step.automationId.empty()) break;
+            }
+
+            UiaNode next = tree.NextSibling(child);
+            if (!keep) tree.ReleaseNode(child);
+            child = next;
+            i++;
+        }
+
+        // AutomationId로 찾지 못하면 (동적 ID 등) 자식 순서로 대체
+        if (found) {
+            if (byIndex && byIndex != found) tree.ReleaseNode(byIndex);
+        }
+        else {
+            found = byIndex;
+        }
+
+        if (cur) tree.ReleaseNode(cur);
+        cur = found;
+        if (!cur) return nullptr;
+    }
+    return cur;
+}
+
+// 기존 방식: Edit 자손 전체를 가져와 판별 규칙 적용
+UiaNode AddressBarLocator::FullSearch(IUiaTree& tree, BrowserType type) {
+    m_fullSearches++;
+
+    std::vector<UiaNode> edits;
+    tree.FindEditDescendants(edits);
+
+    UiaNode found = nullptr;
+    for (UiaNode el : edits) {
+        if (!found) {
+            UiaNodeInfo info;
+            if (tree.GetInfo(el, info) && IsAddressBarCandidate(type, info)) {
+                found = el;
+                continue;
+            }
+        }
+        tree.ReleaseNode(el);
+    }
+    return found;
+}
+
+// 찾은 노드에서 루트까지 올라가며 (자식 순서, AutomationId) 경로 기록
+bool AddressBarLocator::RecordPath(IUiaTree& tree, UiaNode node, std::vector<LocatorPathStep>& pathOut) {
+    std::vector<LocatorPathStep> reversed;
+    UiaNode cur = node;
+    bool owned = false; // node 자체는 호출자 소유
+    bool reachedRoot = false;
+
+    for (int depth = 0; depth < kMaxPathDepth; depth++) {
+        if (tree.IsSameNode(cur, tree.Root())) {
+            reachedRoot = true;
+            break;
+        }
+
+        UiaNode parent = tree.Parent(cur);
+        if (!parent) break;
+
+        int index = -1;
+        int i = 0;
+        UiaNode child = tree.FirstChild(parent);
+        while (child) {
+            bool same = tree.IsSameNode(child, cur);
+            UiaNode next = same ? nullptr : tree.NextSibling(child);
+            tree.ReleaseNode(child);
+            if (same) {
+                index = i;
+                break;
+            }
+            child = next;
+            i++;
+        }
+
+        UiaNodeInfo info;
+        tree.GetInfo(cur, info);
+        if (owned) tree.ReleaseNode(cur);
+        cur = parent;
+        owned = true;
+
+        if (index < 0) break;
+        LocatorPathStep step = { index, info.automationId };
+        reversed.push_back(step);
+    }
+    if (owned) tree.ReleaseNode(cur);
+
+    if (!reachedRoot || reversed.empty()) return false;
+
+    pathOut.assign(reversed.rbegin(), reversed.rend());
+    return true;
+}
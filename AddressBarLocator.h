@@ -0,0 +1,96 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include "BrowserType.h"
+
+// UIA 트리 노드 핸들 (구현체별 의미가 다름: COM 요소 포인터, 합성 트리 인덱스 등)
+typedef void* UiaNode;
+
+// UIA_EditControlTypeId (UIAutomation.h 없이 비교하기 위해 상수로 보관)
+static const int kUiaEditControlTypeId = 50004;
+
+// 주소 표시줄 판별에 필요한 노드 속성 (한 번의 CacheRequest로 함께 가져옴)
+struct UiaNodeInfo {
+    std::wstring name;
+    std::wstring automationId;
+    int controlType = 0;
+    bool keyboardFocusable = false;
+};
+
+// 탐색 로직이 의존하는 트리 인터페이스
+// - Windows: UiaHelper의 UiaElementTree (TreeWalker + CacheRequest)
+// - 그 외: 합성 트리로 대체하여 Linux에서도 탐색 비용 측정 가능
+class IUiaTree {
+public:
+    virtual ~IUiaTree() {}
+
+    virtual UiaNode Root() = 0; // 소유권 없음 (ReleaseNode 금지)
+    virtual UiaNode FirstChild(UiaNode node) = 0;
+    virtual UiaNode NextSibling(UiaNode node) = 0;
+    virtual UiaNode Parent(UiaNode node) = 0;
+    virtual bool GetInfo(UiaNode node, UiaNodeInfo& info) = 0;
+    virtual bool IsSameNode(UiaNode a, UiaNode b) = 0;
+
+    // 전체 탐색: ControlType=Edit 인 모든 자손 (기존 FindAll 경로)
+    virtual void FindEditDescendants(std::vector<UiaNode>& out) = 0;
+
+    // FirstChild/NextSibling/Parent/FindEditDescendants가 반환한 노드 해제
+    virtual void ReleaseNode(UiaNode node) = 0;
+};
+
+// 루트에서 주소 표시줄까지의 경로 한 단계
+struct LocatorPathStep {
+    int childIndex;            // 부모 기준 자식 순서
+    std::wstring automationId; // 비어있지 않으면 순서가 바뀌어도 ID로 재탐색
+};
+
+// 체크포인트용 학습 경로 사본
+struct LocatorPathSnapshot {
+    int type;
+    std::wstring version;
+    std::vector<LocatorPathStep> steps;
+};
+
+// (브라우저 유형, 브라우저 버전)별로 주소 표시줄 경로를 학습하여
+// 다음 탐색부터 전체 FindAll 없이 경로를 바로 따라가는 탐색기
+class AddressBarLocator {
+public:
+    AddressBarLocator();
+
+    // 주소 표시줄 노드 반환 (호출자가 ReleaseNode), 실패 시 nullptr
+    UiaNode Locate(IUiaTree& tree, BrowserType type, const std::wstring& version);
+
+    // 브라우저 유형별 주소 표시줄 판별 규칙
+    static bool IsAddressBarCandidate(BrowserType type, const UiaNodeInfo& info);
+
+    void Clear();
+
+    // 학습한 경로 복사 / 재시작 시 복원 (재시작 직후 첫 탐색부터 FindAll 생략)
+    void Snapshot(std::vector<LocatorPathSnapshot>& out);
+    void Restore(const std::vector<LocatorPathSnapshot>& paths);
+
+    // 통계 (경로 적중 / 전체 탐색 대체 횟수)
+    unsigned long PathHits() const { return m_pathHits.load(); }
+    unsigned long FullSearches() const { return m_fullSearches.load(); }
+
+private:
+    struct Key {
+        int type;
+        std::wstring version;
+        bool operator<(const Key& o) const {
+            return type != o.type ? type < o.type : version < o.version;
+        }
+    };
+
+    std::mutex m_lock;
+    std::map<Key, std::vector<LocatorPathStep>> m_paths;
+    std::atomic<unsigned long> m_pathHits;
+    std::atomic<unsigned long> m_fullSearches;
+
+    UiaNode WalkPath(IUiaTree& tree, const std::vector<LocatorPathStep>& path);
+    UiaNode FullSearch(IUiaTree& tree, BrowserType type);
+    bool RecordPath(IUiaTree& tree, UiaNode node, std::vector<LocatorPathStep>& pathOut);
+};
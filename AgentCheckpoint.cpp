@@ -0,0 +1,240 @@
+﻿#include "AgentCheckpoint.h"
+#include "AsyncLogger.h"
+#include "Crc32.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+    const uint32_t kCheckpointMagic = 0x504B4341; // "ACKP"
+    const uint32_t kCheckpointVersion = 1;
+    const uint32_t kMaxCheckpointSize = 16 * 1024 * 1024;
+    const uint32_t kMaxItems = 1 << 16;
+
+    struct CheckpointHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;  // 본문 바이트 수
+        uint32_t crc;   // 본문 crc32
+    };
+
+    // 본문 직렬화: 정수는 리틀 엔디언 고정 크기, 문자열은 [길이(u32)][바이트]
+    class Writer {
+    public:
+        void U32(uint32_t v) { Raw(&v, sizeof(v)); }
+        void U64(uint64_t v) { Raw(&v, sizeof(v)); }
+        void I32(int32_t v) { Raw(&v, sizeof(v)); }
+        void I64(int64_t v) { Raw(&v, sizeof(v)); }
+        void Str(const std::string& s) { U32((uint32_t)s.size()); Raw(s.data(), s.size()); }
+        void WStr(const std::wstring& s) { U32((uint32_t)s.size()); Raw(s.data(), s.size() * sizeof(wchar_t)); }
+        void Handle(HWND hwnd) { U64((uint64_t)(uintptr_t)hwnd); }
+        const std::string& Data() const { return m_buf; }
+
+    private:
+        void Raw(const void* p, size_t n) { m_buf.append((const char*)p, n); }
+        std::string m_buf;
+    };
+
+    // 읽기 실패(잘림/과도한 길이)는 이후 모든 읽기를 실패로 만듦
+    class Reader {
+    public:
+        Reader(const char* data, size_t size) : m_pos(data), m_end(data + size), m_ok(true) {}
+        bool Ok() const { return m_ok; }
+        bool AtEnd() const { return m_pos == m_end; }
+        uint32_t U32() { uint32_t v = 0; Raw(&v, sizeof(v)); return v; }
+        uint64_t U64() { uint64_t v = 0; Raw(&v, sizeof(v)); return v; }
+        int32_t I32() { int32_t v = 0; Raw(&v, sizeof(v)); return v; }
+        int64_t I64() { int64_t v = 0; Raw(&v, sizeof(v)); return v; }
+        HWND Handle() { return (HWND)(uintptr_t)U64(); }
+        uint32_t Count() {
+            uint32_t n = U32();
+            if (n > kMaxItems) m_ok = false;
+            return m_ok ? n : 0;
+        }
+        void Str(std::string& s) {
+            uint32_t n = U32();
+            if (!Need(n)) return;
+            s.assign(m_pos, n);
+            m_pos += n;
+        }
+        void WStr(std::wstring& s) {
+            uint32_t n = U32();
+            if (!Need((size_t)n * sizeof(wchar_t))) return;
+            s.resize(n);
+            if (n) memcpy(&s[0], m_pos, n * sizeof(wchar_t));
+            m_pos += n * sizeof(wchar_t);
+        }
+
+    private:
+        bool Need(size_t n) {
+            if (m_ok && (size_t)(m_end - m_pos) < n) m_ok = false;
+            return m_ok;
+        }
+        void Raw(void* p, size_t n) {
+            if (!Need(n)) return;
+            memcpy(p, m_pos, n);
+            m_pos += n;
+        }
+        const char* m_pos;
+        const char* m_end;
+        bool m_ok;
+    };
+
+    uint64_t NowFileTime() {
+        FILETIME ft;
+        GetSystemTimeAsFileTime(&ft);
+        return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    }
+}
+
+bool AgentCheckpoint::Save(const char* path) const {
+    Writer w;
+    w.U64(NowFileTime());
+
+    w.U32((uint32_t)windows.size());
+    for (const CheckpointWindow& win : windows) {
+        w.Handle(win.hwnd);
+        w.U32(win.pid);
+        w.WStr(win.browser);
+        w.WStr(win.url);
+    }
+
+    w.U32((uint32_t)visits.size());
+    for (const VisitSnapshot& v : visits) {
+        w.Handle(v.hwnd);
+        w.Str(v.url);
+        w.I64(v.rowId);
+        w.U32(v.ageMs);
+    }
+
+    w.U32((uint32_t)locatorPaths.size());
+    for (const LocatorPathSnapshot& p : locatorPaths) {
+        w.I32(p.type);
+        w.WStr(p.version);
+        w.U32((uint32_t)p.steps.size());
+        for (const LocatorPathStep& step : p.steps) {
+            w.I32(step.childIndex);
+            w.WStr(step.automationId);
+        }
+    }
+
+    w.U32(options.valid ? 1 : 0);
+    w.I32(options.seq);
+    w.I32(options.opt1);
+    w.I32(options.opt2);
+    w.I32(options.opt3);
+
+    const std::string& body = w.Data();
+    CheckpointHeader hdr = { kCheckpointMagic, kCheckpointVersion, (uint32_t)body.size(),
+        Crc32(0, body.data(), body.size()) };
+
+    std::string tmp = std::string(path) + ".tmp";
+    HANDLE file = CreateFileA(tmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        AGENT_LOG_ERROR("[Checkpoint] Cannot create %s (err=%lu)", tmp.c_str(), GetLastError());
+        return false;
+    }
+    DWORD written = 0, bodyWritten = 0;
+    bool ok = WriteFile(file, &hdr, sizeof(hdr), &written, nullptr) && written == sizeof(hdr) &&
+        WriteFile(file, body.data(), (DWORD)body.size(), &bodyWritten, nullptr) && bodyWritten == body.size() &&
+        FlushFileBuffers(file);
+    CloseHandle(file);
+    if (ok) ok = MoveFileExA(tmp.c_str(), path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+    if (!ok) {
+        AGENT_LOG_ERROR("[Checkpoint] Failed to save %s", path);
+        DeleteFileA(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool AgentCheckpoint::Load(const char* path) {
+    *this = AgentCheckpoint();
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false; // 첫 실행 또는 비정상 종료 후 저장 전
+
+    CheckpointHeader hdr = {};
+    DWORD read = 0;
+    std::string body;
+    bool ok = ReadFile(file, &hdr, sizeof(hdr), &read, nullptr) && read == sizeof(hdr) &&
+        hdr.magic == kCheckpointMagic && hdr.version == kCheckpointVersion && hdr.size <= kMaxCheckpointSize;
+    if (ok) {
+        body.resize(hdr.size);
+        ok = hdr.size == 0 || (ReadFile(file, &body[0], hdr.size, &read, nullptr) && read == hdr.size);
+    }
+    CloseHandle(file);
+    if (ok) ok = Crc32(0, body.data(), body.size()) == hdr.crc;
+    if (!ok) {
+        AGENT_LOG_WARN("[Checkpoint] Ignoring invalid checkpoint %s", path);
+        return false;
+    }
+
+    AgentCheckpoint cp;
+    Reader r(body.data(), body.size());
+    cp.savedAt = r.U64();
+
+    uint32_t n = r.Count();
+    for (uint32_t i = 0; i < n && r.Ok(); i++) {
+        CheckpointWindow win;
+        win.hwnd = r.Handle();
+        win.pid = r.U32();
+        r.WStr(win.browser);
+        r.WStr(win.url);
+        cp.windows.push_back(std::move(win));
+    }
+
+    n = r.Count();
+    for (uint32_t i = 0; i < n && r.Ok(); i++) {
+        VisitSnapshot v;
+        v.hwnd = r.Handle();
+        r.Str(v.url);
+        v.rowId = r.I64();
+        v.ageMs = r.U32();
+        cp.visits.push_back(std::move(v));
+    }
+
+    n = r.Count();
+    for (uint32_t i = 0; i < n && r.Ok(); i++) {
+        LocatorPathSnapshot p;
+        p.type = r.I32();
+        r.WStr(p.version);
+        uint32_t steps = r.Count();
+        for (uint32_t k = 0; k < steps && r.Ok(); k++) {
+            LocatorPathStep step;
+            step.childIndex = r.I32();
+            r.WStr(step.automationId);
+            p.steps.push_back(std::move(step));
+        }
+        cp.locatorPaths.push_back(std::move(p));
+    }
+
+    cp.options.valid = r.U32() != 0;
+    cp.options.seq = r.I32();
+    cp.options.opt1 = r.I32();
+    cp.options.opt2 = r.I32();
+    cp.options.opt3 = r.I32();
+
+    if (!r.Ok() || !r.AtEnd()) {
+        AGENT_LOG_WARN("[Checkpoint] Ignoring malformed checkpoint %s", path);
+        return false;
+    }
+    *this = std::move(cp);
+    return true;
+}
+
+uint32_t AgentCheckpoint::ElapsedSinceSaveMs() const {
+    uint64_t now = NowFileTime();
+    if (savedAt == 0 || now <= savedAt) return 0; // 시계가 뒤로 간 경우 경과 없음으로 취급
+    uint64_t ms = (now - savedAt) / 10000;
+    return ms > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)ms;
+}
+
+DWORD AgentCheckpoint::WindowPid(HWND hwnd) {
+    DWORD pid = 0;
+    if (hwnd) GetWindowThreadProcessId(hwnd, &pid);
+    return pid;
+}
+
+bool AgentCheckpoint::IsSameWindow(HWND hwnd, DWORD pid) {
+    return hwnd && pid && IsWindow(hwnd) && WindowPid(hwnd) == pid;
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <windows.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "AddressBarLocator.h"
+#include "VisitAggregator.h"
+
+// 윈도우별 마지막 확정 URL (pid: 재시작 후 같은 HWND가 같은 브라우저 창인지 확인용)
+struct CheckpointWindow {
+    HWND hwnd = nullptr;
+    DWORD pid = 0;
+    std::wstring browser;
+    std::wstring url;     // 정규 URL (비어 있으면 재방문 항목의 소유 윈도우로만 기록)
+};
+
+// 마지막으로 적용한 옵션
+struct CheckpointOptions {
+    bool valid = false;
+    int seq = 0;
+    int opt1 = 0, opt2 = 0, opt3 = 0;
+};
+
+// 종료 시 저장하고 시작 시 읽는 작업 상태 (중복 판정, 주소 표시줄 경로, 옵션)
+// - 파일: [헤더(magic, version, 크기, crc32)][본문]. 검증에 실패하면 전체를 버리고 빈 상태로 시작
+// - 저장은 임시 파일에 쓰고 디스크 반영 후 교체 (중간에 죽어도 이전 파일 또는 새 파일 중 하나)
+// - HWND는 브라우저가 살아 있는 동안만 의미가 있으므로 복원하는 쪽에서 IsSameWindow로 확인
+struct AgentCheckpoint {
+    uint64_t savedAt = 0; // FILETIME (UTC, 100ns)
+    std::vector<CheckpointWindow> windows;
+    std::vector<VisitSnapshot> visits;
+    std::vector<LocatorPathSnapshot> locatorPaths;
+    CheckpointOptions options;
+
+    bool Save(const char* path) const;
+    bool Load(const char* path);
+
+    // 저장 이후 지난 시간 (재방문 항목 나이에 더함)
+    uint32_t ElapsedSinceSaveMs() const;
+
+    // hwnd가 아직 있고 pid 프로세스의 윈도우인지
+    static bool IsSameWindow(HWND hwnd, DWORD pid);
+    static DWORD WindowPid(HWND hwnd);
+};
@@ -0,0 +1,495 @@
+﻿#include "AsyncLogger.h"
+#include "TextCodec.h"
+#include <stdio.h>
+#include <time.h>
+#include <chrono>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+    const size_t kSlotSize = 512;      // 레코드 1개 크기 (헤더 + 인자), 넘치는 문자열은 잘림
+    const size_t kRingSlots = 2048;    // 스레드당 슬롯 수 (2의 거듭제곱)
+    const int kFlushIntervalMs = 50;   // 백그라운드 스레드 주기
+
+    // 레코드 헤더 (슬롯 앞부분)
+    struct RecordHeader {
+        const char* fmt;    // 포맷 ID (정적 리터럴 포인터)
+        uint64_t timeUs;    // epoch 기준 마이크로초
+        uint32_t tid;
+        uint16_t size;      // 헤더 포함 사용 바이트
+        uint8_t level;
+        uint8_t truncated;
+    };
+
+    uint32_t CurrentThreadId() {
+#ifdef _WIN32
+        return (uint32_t)GetCurrentThreadId();
+#else
+        return (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+    }
+
+    const char* LevelName(uint8_t level) {
+        switch ((LogLevel)level) {
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info:  return "INFO";
+        case LogLevel::Warn:  return "WARN";
+        case LogLevel::Error: return "ERROR";
+        }
+        return "?";
+    }
+}
+
+// 단일 생산자(소유 스레드) / 단일 소비자(백그라운드 스레드) 링
+struct AsyncLogger::Ring {
+    std::atomic<uint64_t> head;               // 생산자가 다음에 쓸 위치
+    char pad[64 - sizeof(std::atomic<uint64_t>)]; // head/tail false sharing 방지
+    std::atomic<uint64_t> tail;               // 소비자가 다음에 읽을 위치
+    std::atomic<bool> abandoned;              // 소유 스레드 종료 여부
+    uint32_t tid;
+    uint8_t slots[kRingSlots][kSlotSize];
+
+    Ring() : head(0), tail(0), abandoned(false), tid(CurrentThreadId()) {}
+};
+
+// 스레드 종료 시 링을 소비자에게 넘겨 남은 레코드를 기록 후 해제하게 함
+struct ThreadRingHolder {
+    AsyncLogger::Ring* ring = nullptr;
+    ~ThreadRingHolder() {
+        if (ring) ring->abandoned.store(true, std::memory_order_release);
+    }
+};
+
+static thread_local ThreadRingHolder t_ring;
+
+AsyncLogger& AsyncLogger::Instance() {
+    static AsyncLogger instance;
+    return instance;
+}
+
+AsyncLogger::AsyncLogger()
+    : m_level((int)(AGENT_LOG_MIN_LEVEL > 0 ? AGENT_LOG_MIN_LEVEL : 0)),
+#ifdef _DEBUG
+      m_consoleEcho(true),
+#else
+      m_consoleEcho(false),
+#endif
+      m_running(false), m_dropped(0),
+      m_maxFileBytes(0), m_maxFiles(0), m_file(nullptr), m_fileBytes(0) {
+}
+
+AsyncLogger::~AsyncLogger() {
+    Stop();
+}
+
+bool AsyncLogger::Start(const char* logPath, uint64_t maxFileBytes, int maxFiles) {
+    if (m_running.load()) return true;
+
+    m_path = logPath ? logPath : "";
+    m_maxFileBytes = maxFileBytes;
+    m_maxFiles = maxFiles > 1 ? maxFiles : 1;
+    if (!OpenFile()) {
+        printf("[Logger] Cannot open log file: %s\n", m_path.c_str());
+        // 파일이 없어도 콘솔 에코는 가능하도록 계속 진행
+    }
+
+    m_running.store(true);
+    m_thread = std::thread(&AsyncLogger::WriterThread, this);
+    return true;
+}
+
+void AsyncLogger::Stop() {
+    if (!m_running.exchange(false)) return;
+    m_wakeCv.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+AsyncLogger::Ring* AsyncLogger::ThreadRing() {
+    if (t_ring.ring) return t_ring.ring;
+
+    Ring* ring = new Ring();
+    {
+        std::lock_guard<std::mutex> lock(m_ringsLock);
+        m_rings.push_back(ring);
+    }
+    t_ring.ring = ring;
+    return ring;
+}
+
+bool AsyncLogger::BeginRecord(RecordWriter& w, LogLevel level, const char* fmt) {
+    Ring* ring = ThreadRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    uint64_t tail = ring->tail.load(std::memory_order_acquire);
+    if (head - tail >= kRingSlots) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed); // 가득 차면 호출자를 막지 않고 버림
+        return false;
+    }
+
+    uint8_t* slot = ring->slots[head & (kRingSlots - 1)];
+    RecordHeader* hdr = (RecordHeader*)slot;
+    hdr->fmt = fmt;
+    hdr->timeUs = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    hdr->tid = ring->tid;
+    hdr->level = (uint8_t)level;
+    hdr->truncated = 0;
+
+    w.ring = ring;
+    w.slot = slot;
+    w.pos = slot + sizeof(RecordHeader);
+    w.end = slot + kSlotSize;
+    return true;
+}
+
+void AsyncLogger::CommitRecord(RecordWriter& w) {
+    RecordHeader* hdr = (RecordHeader*)w.slot;
+    hdr->size = (uint16_t)(w.pos - w.slot);
+
+    uint64_t head = w.ring->head.load(std::memory_order_relaxed) + 1;
+    w.ring->head.store(head, std::memory_order_release);
+
+    // 링이 절반 이상 차면 주기를 기다리지 않고 소비자를 깨움
+    if (head - w.ring->tail.load(std::memory_order_relaxed) == kRingSlots / 2)
+        m_wakeCv.notify_one();
+}
+
+void AsyncLogger::Put(RecordWriter& w, const void* data, size_t size) {
+    if (w.pos + size > w.end) {
+        ((RecordHeader*)w.slot)->truncated = 1;
+        return;
+    }
+    memcpy(w.pos, data, size);
+    w.pos += size;
+}
+
+void AsyncLogger::EncodeInt(RecordWriter& w, long long v) {
+    uint8_t tag = kArgInt;
+    if (w.pos + 1 + sizeof(v) > w.end) { ((RecordHeader*)w.slot)->truncated = 1; return; }
+    Put(w, &tag, 1);
+    Put(w, &v, sizeof(v));
+}
+
+void AsyncLogger::EncodeUInt(RecordWriter& w, unsigned long long v) {
+    uint8_t tag = kArgUInt;
+    if (w.pos + 1 + sizeof(v) > w.end) { ((RecordHeader*)w.slot)->truncated = 1; return; }
+    Put(w, &tag, 1);
+    Put(w, &v, sizeof(v));
+}
+
+void AsyncLogger::EncodeDouble(RecordWriter& w, double v) {
+    uint8_t tag = kArgDouble;
+    if (w.pos + 1 + sizeof(v) > w.end) { ((RecordHeader*)w.slot)->truncated = 1; return; }
+    Put(w, &tag, 1);
+    Put(w, &v, sizeof(v));
+}
+
+void AsyncLogger::EncodePtr(RecordWriter& w, const void* p) {
+    uint8_t tag = kArgPtr;
+    if (w.pos + 1 + sizeof(p) > w.end) { ((RecordHeader*)w.slot)->truncated = 1; return; }
+    Put(w, &tag, 1);
+    Put(w, &p, sizeof(p));
+}
+
+// 문자열: 태그(1) + 길이(2) + 바이트, 슬롯에 남은 만큼만 저장
+void AsyncLogger::EncodeStr(RecordWriter& w, const char* s, size_t len) {
+    size_t room = (size_t)(w.end - w.pos);
+    if (room < 3) { ((RecordHeader*)w.slot)->truncated = 1; return; }
+    if (len > room - 3) {
+        len = room - 3;
+        ((RecordHeader*)w.slot)->truncated = 1;
+    }
+    uint8_t tag = kArgStr;
+    uint16_t n = (uint16_t)len;
+    Put(w, &tag, 1);
+    Put(w, &n, 2);
+    Put(w, s, len);
+}
+
+// 와이드 문자열: UTF-16 코드 유닛 그대로 저장 (변환은 백그라운드 스레드에서)
+void AsyncLogger::EncodeWStr(RecordWriter& w, const wchar_t* s, size_t len) {
+    size_t room = (size_t)(w.end - w.pos);
+    if (room < 3) { ((RecordHeader*)w.slot)->truncated = 1; return; }
+    size_t maxUnits = (room - 3) / 2;
+    if (len > maxUnits) {
+        len = maxUnits;
+        ((RecordHeader*)w.slot)->truncated = 1;
+    }
+    uint8_t tag = kArgWStr;
+    uint16_t n = (uint16_t)len;
+    Put(w, &tag, 1);
+    Put(w, &n, 2);
+#if WCHAR_MAX <= 0xFFFF
+    Put(w, s, len * 2);
+#else
+    for (size_t i = 0; i < len; ++i) {
+        uint16_t u = (uint16_t)s[i];
+        Put(w, &u, 2);
+    }
+#endif
+}
+
+void AsyncLogger::WriterThread() {
+    std::string line;
+    line.reserve(4096);
+
+    while (true) {
+        bool running = m_running.load();
+        {
+            std::unique_lock<std::mutex> lock(m_wakeLock);
+            if (running)
+                m_wakeCv.wait_for(lock, std::chrono::milliseconds(kFlushIntervalMs));
+        }
+
+        bool wrote = DrainAll(line);
+        if (wrote && m_file) fflush(m_file);
+
+        if (!running) break; // 종료 요청 후 마지막 drain까지 마친 뒤 탈출
+    }
+}
+
+// 모든 스레드 링을 비움. 종료된 스레드의 링은 비운 뒤 해제
+bool AsyncLogger::DrainAll(std::string& line) {
+    std::vector<Ring*> rings;
+    {
+        std::lock_guard<std::mutex> lock(m_ringsLock);
+        rings = m_rings;
+    }
+
+    bool wrote = false;
+    for (Ring* ring : rings) {
+        bool abandoned = ring->abandoned.load(std::memory_order_acquire);
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+
+        for (; tail != head; ++tail) {
+            line.clear();
+            FormatRecord(ring->slots[tail & (kRingSlots - 1)], line);
+            WriteLine(line);
+            wrote = true;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+
+        if (abandoned) {
+            std::lock_guard<std::mutex> lock(m_ringsLock);
+            for (size_t i = 0; i < m_rings.size(); ++i) {
+                if (m_rings[i] == ring) {
+                    m_rings.erase(m_rings.begin() + i);
+                    break;
+                }
+            }
+            delete ring;
+        }
+    }
+
+    unsigned long long dropped = m_dropped.exchange(0);
+    if (dropped) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), "[Logger] %llu records dropped (ring full)\n", dropped);
+        line.assign(buf);
+        WriteLine(line);
+        wrote = true;
+    }
+    return wrote;
+}
+
+// 레코드 → 텍스트 한 줄. 포맷 문자열의 % 지정자마다 다음 인자를 꺼내 개별 snprintf
+void AsyncLogger::FormatRecord(const uint8_t* slot, std::string& out) {
+    const RecordHeader* hdr = (const RecordHeader*)slot;
+    const uint8_t* p = slot + sizeof(RecordHeader);
+    const uint8_t* end = slot + hdr->size;
+
+    // 타임스탬프 / 레벨 / 스레드 접두어
+    time_t secs = (time_t)(hdr->timeUs / 1000000);
+    struct tm tmv;
+#ifdef _WIN32
+    localtime_s(&tmv, &secs);
+#else
+    localtime_r(&secs, &tmv);
+#endif
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "%04d-%02d-%02d %02d:%02d:%02d.%03u [%s] [%u] ",
+        tmv.tm_year + 1900, tmv.tm_mon + 1, tmv.tm_mday, tmv.tm_hour, tmv.tm_min, tmv.tm_sec,
+        (unsigned)((hdr->timeUs / 1000) % 1000), LevelName(hdr->level), hdr->tid);
+    out.append(prefix);
+
+    char num[128];
+    char spec[32];
+    const char* f = hdr->fmt;
+    while (*f) {
+        if (*f != '%') {
+            const char* lit = f;
+            while (*f && *f != '%') ++f;
+            out.append(lit, f - lit);
+            continue;
+        }
+        if (f[1] == '%') {
+            out.push_back('%');
+            f += 2;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conv 파싱 (길이 지정자는 인자 태그로 대체)
+        const char* start = f++;
+        size_t specLen = 0;
+        spec[specLen++] = '%';
+        while (*f && strchr("-+ #0", *f) && specLen < 16) spec[specLen++] = *f++;
+        while (*f && ((*f >= '0' && *f <= '9') || *f == '.') && specLen < 24) spec[specLen++] = *f++;
+        bool wideSpec = false;
+        while (*f && strchr("hlLqjzt", *f)) {
+            if (*f == 'l') wideSpec = true;
+            ++f;
+        }
+        char conv = *f ? *f++ : 0;
+        if (!conv) {
+            out.append(start);
+            break;
+        }
+        (void)wideSpec;
+        if (conv == '*') {
+            // 가변 폭/정밀도(%.*s)는 인자 순서가 어긋나므로 지원하지 않음 (버퍼 조각은 LogSlice로 전달)
+            out.append("<%* unsupported>");
+            break;
+        }
+
+        if (p >= end) {
+            out.append("<?>"); // 인자 부족 (잘림)
+            continue;
+        }
+        uint8_t tag = *p++;
+        switch (tag) {
+        case kArgInt:
+        case kArgUInt: {
+            uint64_t raw;
+            memcpy(&raw, p, 8);
+            p += 8;
+            if (conv == 'f' || conv == 'e' || conv == 'g' || conv == 'E' || conv == 'G') {
+                spec[specLen] = conv; spec[specLen + 1] = 0;
+                snprintf(num, sizeof(num), spec, tag == kArgInt ? (double)(long long)raw : (double)raw);
+            }
+            else if (conv == 'c') {
+                spec[specLen] = 'c'; spec[specLen + 1] = 0;
+                snprintf(num, sizeof(num), spec, (int)raw);
+            }
+            else {
+                if (conv == 's') conv = tag == kArgInt ? 'd' : 'u';
+                spec[specLen] = 'l'; spec[specLen + 1] = 'l';
+                spec[specLen + 2] = conv; spec[specLen + 3] = 0;
+                if (tag == kArgInt) snprintf(num, sizeof(num), spec, (long long)raw);
+                else snprintf(num, sizeof(num), spec, (unsigned long long)raw);
+            }
+            out.append(num);
+            break;
+        }
+        case kArgDouble: {
+            double v;
+            memcpy(&v, p, 8);
+            p += 8;
+            if (!strchr("feEgGaA", conv)) conv = 'g';
+            spec[specLen] = conv; spec[specLen + 1] = 0;
+            snprintf(num, sizeof(num), spec, v);
+            out.append(num);
+            break;
+        }
+        case kArgPtr: {
+            const void* v;
+            memcpy(&v, p, sizeof(v));
+            p += sizeof(v);
+            snprintf(num, sizeof(num), "%p", v);
+            out.append(num);
+            break;
+        }
+        case kArgStr: {
+            uint16_t n;
+            memcpy(&n, p, 2);
+            p += 2;
+            out.append((const char*)p, n);
+            p += n;
+            break;
+        }
+        case kArgWStr: {
+            uint16_t n;
+            memcpy(&n, p, 2);
+            p += 2;
+            char16_t units[kSlotSize / 2];
+            memcpy(units, p, n * 2);
+            p += n * 2;
+            size_t base = out.size();
+            out.resize(base + Utf8CapacityFor(n));
+            size_t written = TranscodeUtf16ToUtf8(units, n, &out[base], Utf8CapacityFor(n));
+            out.resize(written == kTextCodecOverflow ? base : base + written);
+            break;
+        }
+        default:
+            p = end; // 손상된 레코드
+            break;
+        }
+    }
+
+    if (hdr->truncated) out.append(" <truncated>");
+    if (out.empty() || out.back() != '\n') out.push_back('\n');
+}
+
+void AsyncLogger::WriteLine(const std::string& line) {
+    if (m_consoleEcho.load(std::memory_order_relaxed))
+        fwrite(line.data(), 1, line.size(), stdout);
+
+    if (!m_file) return;
+    if (m_maxFileBytes && m_fileBytes + line.size() > m_maxFileBytes)
+        RotateFiles();
+    if (!m_file) return;
+
+    fwrite(line.data(), 1, line.size(), m_file);
+    m_fileBytes += line.size();
+}
+
+bool AsyncLogger::OpenFile() {
+    if (m_path.empty()) return false;
+
+#ifdef _WIN32
+    // 상위 폴더가 없으면 생성
+    size_t slash = m_path.find_last_of("\\/");
+    if (slash != std::string::npos)
+        CreateDirectoryA(m_path.substr(0, slash).c_str(), nullptr);
+    if (fopen_s(&m_file, m_path.c_str(), "ab") != 0) m_file = nullptr;
+#else
+    m_file = fopen(m_path.c_str(), "ab");
+#endif
+    if (!m_file) return false;
+
+    fseek(m_file, 0, SEEK_END);
+    long pos = ftell(m_file);
+    m_fileBytes = pos > 0 ? (uint64_t)pos : 0;
+    setvbuf(m_file, nullptr, _IOFBF, 64 * 1024);
+    return true;
+}
+
+// agent.log → agent.1.log → ... → agent.(N-1).log, 가장 오래된 파일은 삭제
+static std::string RotatedName(const std::string& path, int index) {
+    if (index == 0) return path;
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("\\/");
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%d", index);
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return path + suffix;
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+void AsyncLogger::RotateFiles() {
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+
+    remove(RotatedName(m_path, m_maxFiles - 1).c_str());
+    for (int i = m_maxFiles - 2; i >= 0; --i)
+        rename(RotatedName(m_path, i).c_str(), RotatedName(m_path, i + 1).c_str());
+
+    OpenFile();
+}
@@ -0,0 +1,156 @@
+﻿#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 로그 레벨
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3
+};
+
+// 컴파일 타임 필터: 이 레벨 미만의 로그 호출은 코드에서 제거됨 (0=Debug ... 3=Error)
+#ifndef AGENT_LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define AGENT_LOG_MIN_LEVEL 0
+#else
+#define AGENT_LOG_MIN_LEVEL 1
+#endif
+#endif
+
+// NUL로 끝나지 않는 문자열 조각 (버퍼 일부를 %s로 기록할 때)
+struct LogSlice {
+    const char* data;
+    size_t size;
+};
+
+// 비동기 바이너리 로거
+// - 호출 스레드: 포맷 문자열 포인터(=포맷 ID) + 원본 인자를 스레드별 lock-free 링에 기록만 함
+// - 백그라운드 스레드: 레코드를 printf 형식으로 포맷하여 회전 파일에 기록
+// - 포맷 문자열은 반드시 정적 리터럴이어야 함 (포인터만 저장)
+// - 링이 가득 차면 호출 스레드를 막지 않고 레코드를 버림 (Dropped()로 확인)
+class AsyncLogger {
+public:
+    static AsyncLogger& Instance();
+
+    // logPath: 예) C:\ProgramData\AgentLogs\agent.log (회전 시 agent.1.log, agent.2.log ...)
+    bool Start(const char* logPath, uint64_t maxFileBytes = 10 * 1024 * 1024, int maxFiles = 5);
+    void Stop(); // 남은 레코드 모두 기록 후 종료
+
+    void SetLevel(LogLevel level) { m_level.store((int)level, std::memory_order_relaxed); }
+    bool Enabled(LogLevel level) const { return (int)level >= m_level.load(std::memory_order_relaxed); }
+    void SetConsoleEcho(bool enable) { m_consoleEcho.store(enable); }
+
+    unsigned long long Dropped() const { return m_dropped.load(); }
+
+    template <typename... Args>
+    void Log(LogLevel level, const char* fmt, const Args&... args) {
+        if (!Enabled(level)) return;
+        RecordWriter w;
+        if (!BeginRecord(w, level, fmt)) return;
+        int dummy[] = { 0, (Encode(w, args), 0)... };
+        (void)dummy;
+        CommitRecord(w);
+    }
+
+    // 인자 태그 (레코드 내 원본 인자 직렬화 형식)
+    enum ArgTag : uint8_t { kArgInt = 1, kArgUInt, kArgDouble, kArgPtr, kArgStr, kArgWStr };
+
+    struct Ring;
+    struct RecordWriter {
+        Ring* ring;
+        uint8_t* slot;
+        uint8_t* pos;
+        uint8_t* end;
+    };
+
+private:
+    AsyncLogger();
+    ~AsyncLogger();
+
+    std::atomic<int> m_level;
+    std::atomic<bool> m_consoleEcho;
+    std::atomic<bool> m_running;
+    std::atomic<unsigned long long> m_dropped;
+
+    std::mutex m_ringsLock;
+    std::vector<Ring*> m_rings;
+
+    std::thread m_thread;
+    std::mutex m_wakeLock;
+    std::condition_variable m_wakeCv;
+
+    std::string m_path;
+    uint64_t m_maxFileBytes;
+    int m_maxFiles;
+    FILE* m_file;
+    uint64_t m_fileBytes;
+
+    Ring* ThreadRing();
+    bool BeginRecord(RecordWriter& w, LogLevel level, const char* fmt);
+    void CommitRecord(RecordWriter& w);
+
+    static void Put(RecordWriter& w, const void* data, size_t size);
+    static void EncodeInt(RecordWriter& w, long long v);
+    static void EncodeUInt(RecordWriter& w, unsigned long long v);
+    static void EncodeDouble(RecordWriter& w, double v);
+    static void EncodePtr(RecordWriter& w, const void* p);
+    static void EncodeStr(RecordWriter& w, const char* s, size_t len);
+    static void EncodeWStr(RecordWriter& w, const wchar_t* s, size_t len);
+
+    static void Encode(RecordWriter& w, int v) { EncodeInt(w, v); }
+    static void Encode(RecordWriter& w, long v) { EncodeInt(w, v); }
+    static void Encode(RecordWriter& w, long long v) { EncodeInt(w, v); }
+    static void Encode(RecordWriter& w, unsigned int v) { EncodeUInt(w, v); }
+    static void Encode(RecordWriter& w, unsigned long v) { EncodeUInt(w, v); }
+    static void Encode(RecordWriter& w, unsigned long long v) { EncodeUInt(w, v); }
+    static void Encode(RecordWriter& w, char v) { EncodeInt(w, v); }
+    static void Encode(RecordWriter& w, unsigned char v) { EncodeUInt(w, v); }
+    static void Encode(RecordWriter& w, short v) { EncodeInt(w, v); }
+    static void Encode(RecordWriter& w, unsigned short v) { EncodeUInt(w, v); }
+    static void Encode(RecordWriter& w, bool v) { EncodeInt(w, v ? 1 : 0); }
+    static void Encode(RecordWriter& w, double v) { EncodeDouble(w, v); }
+    static void Encode(RecordWriter& w, float v) { EncodeDouble(w, v); }
+    static void Encode(RecordWriter& w, const char* s) { EncodeStr(w, s ? s : "(null)", strlen(s ? s : "(null)")); }
+    static void Encode(RecordWriter& w, char* s) { Encode(w, (const char*)s); }
+    static void Encode(RecordWriter& w, const wchar_t* s) { EncodeWStr(w, s ? s : L"(null)", wcslen(s ? s : L"(null)")); }
+    static void Encode(RecordWriter& w, wchar_t* s) { Encode(w, (const wchar_t*)s); }
+    static void Encode(RecordWriter& w, const std::string& s) { EncodeStr(w, s.data(), s.size()); }
+    static void Encode(RecordWriter& w, const std::wstring& s) { EncodeWStr(w, s.data(), s.size()); }
+    static void Encode(RecordWriter& w, const LogSlice& s) { EncodeStr(w, s.data, s.size); }
+    static void Encode(RecordWriter& w, const void* p) { EncodePtr(w, p); }
+
+    void WriterThread();
+    bool DrainAll(std::string& line);
+    void FormatRecord(const uint8_t* slot, std::string& out);
+    void WriteLine(const std::string& line);
+    bool OpenFile();
+    void RotateFiles();
+
+    friend struct ThreadRingHolder;
+};
+
+// 레벨 필터 매크로 (컴파일 타임에 제거 가능)
+#if AGENT_LOG_MIN_LEVEL <= 0
+#define AGENT_LOG_DEBUG(fmt, ...) AsyncLogger::Instance().Log(LogLevel::Debug, fmt, ##__VA_ARGS__)
+#else
+#define AGENT_LOG_DEBUG(fmt, ...) ((void)0)
+#endif
+#if AGENT_LOG_MIN_LEVEL <= 1
+#define AGENT_LOG_INFO(fmt, ...) AsyncLogger::Instance().Log(LogLevel::Info, fmt, ##__VA_ARGS__)
+#else
+#define AGENT_LOG_INFO(fmt, ...) ((void)0)
+#endif
+#if AGENT_LOG_MIN_LEVEL <= 2
+#define AGENT_LOG_WARN(fmt, ...) AsyncLogger::Instance().Log(LogLevel::Warn, fmt, ##__VA_ARGS__)
+#else
+#define AGENT_LOG_WARN(fmt, ...) ((void)0)
+#endif
+#define AGENT_LOG_ERROR(fmt, ...) AsyncLogger::Instance().Log(LogLevel::Error, fmt, ##__VA_ARGS__)
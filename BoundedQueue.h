@@ -0,0 +1,174 @@
+﻿#pragma once
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 큐가 가득 찼을 때의 처리 방식
+enum class QueueOverflowPolicy {
+    Block,          // 공간이 생길 때까지 생산자 대기
+    DropOldest,     // 가장 오래된 항목을 버리고 추가
+    CoalesceByKey   // 같은 키의 대기 항목에 병합, 병합 대상이 없고 가득 차면 가장 오래된 항목을 버림
+};
+
+struct QueueStats {
+    unsigned long long pushed = 0;
+    unsigned long long popped = 0;
+    unsigned long long dropped = 0;
+    unsigned long long coalesced = 0;
+    unsigned long long blocked = 0;   // Block 정책에서 생산자가 대기한 횟수
+    size_t highWater = 0;             // 최대 대기 항목 수
+};
+
+// 용량 제한 + 오버플로 정책을 가진 MPMC 큐
+template <typename T>
+class BoundedQueue {
+public:
+    // 병합 키 (빈 문자열이면 병합하지 않음)
+    typedef std::function<std::string(const T&)> KeyFn;
+    // 대기 중인 항목에 새 항목을 병합 (existing을 갱신)
+    typedef std::function<void(T& existing, T&& incoming)> MergeFn;
+
+    BoundedQueue(size_t capacity, QueueOverflowPolicy policy)
+        : m_capacity(capacity ? capacity : 1), m_policy(policy), m_closed(false) {
+    }
+
+    void SetCoalescer(KeyFn key, MergeFn merge) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_keyFn = std::move(key);
+        m_mergeFn = std::move(merge);
+    }
+
+    // false: 닫힌 큐
+    bool Push(T item) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (m_closed) return false;
+        m_stats.pushed++;
+
+        std::string key;
+        if (m_policy == QueueOverflowPolicy::CoalesceByKey && m_keyFn) {
+            key = m_keyFn(item);
+            if (!key.empty()) {
+                auto found = m_index.find(key);
+                if (found != m_index.end()) {
+                    if (m_mergeFn) m_mergeFn(found->second->item, std::move(item));
+                    else found->second->item = std::move(item);
+                    m_stats.coalesced++;
+                    return true;
+                }
+            }
+        }
+
+        if (m_items.size() >= m_capacity) {
+            if (m_policy == QueueOverflowPolicy::Block) {
+                m_stats.blocked++;
+                m_notFull.wait(lock, [this]() { return m_items.size() < m_capacity || m_closed; });
+                if (m_closed) return false;
+            }
+            else {
+                EraseFront();
+                m_stats.dropped++;
+            }
+        }
+
+        if (m_spare.empty()) {
+            m_items.push_back(Entry{ std::move(item), key });
+        }
+        else {
+            m_items.splice(m_items.end(), m_spare, m_spare.begin());
+            m_items.back().item = std::move(item);
+            m_items.back().key = key;
+        }
+        if (!key.empty()) m_index[key] = std::prev(m_items.end());
+        if (m_items.size() > m_stats.highWater) m_stats.highWater = m_items.size();
+
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    // 항목이 올 때까지 대기. false: 닫혔고 비어 있음
+    bool Pop(T& out) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_notEmpty.wait(lock, [this]() { return !m_items.empty() || m_closed; });
+        if (m_items.empty()) return false;
+
+        out = std::move(m_items.front().item);
+        EraseFront();
+        m_stats.popped++;
+
+        lock.unlock();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    // 대기 없이 꺼내기. false: 비어 있음
+    bool TryPop(T& out) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (m_items.empty()) return false;
+
+        out = std::move(m_items.front().item);
+        EraseFront();
+        m_stats.popped++;
+
+        lock.unlock();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    // 대기 중인 생산자/소비자를 깨움. 남은 항목은 Pop으로 계속 꺼낼 수 있음
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_closed = true;
+        }
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+    // 재시작용
+    void Reopen() {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_closed = false;
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_items.size();
+    }
+
+    QueueStats Stats() {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_stats;
+    }
+
+private:
+    struct Entry {
+        T item;
+        std::string key;
+    };
+
+    // 앞 노드를 예비 목록으로 옮김 (항목은 비워서 붙잡지 않음)
+    void EraseFront() {
+        if (!m_items.front().key.empty()) m_index.erase(m_items.front().key);
+        m_spare.splice(m_spare.begin(), m_items, m_items.begin());
+        m_spare.front().item = T();
+    }
+
+    const size_t m_capacity;
+    const QueueOverflowPolicy m_policy;
+    bool m_closed;
+
+    std::mutex m_lock;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::list<Entry> m_items;
+    std::list<Entry> m_spare; // 꺼낸 노드 재사용 (정상 상태에서 항목당 노드 할당 없음, 최대 대기 수만큼만 유지)
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> m_index;
+
+    KeyFn m_keyFn;
+    MergeFn m_mergeFn;
+    QueueStats m_stats;
+};
@@ -1,4 +1,5 @@
 ﻿#include "BrowserHelper.h"
+#include "Tracer.h"
 #include <tlhelp32.h> //CreateToolhelp32Snapshot, PROCESSENTRY32w
 #include <vector>
 
@@ -23,19 +24,55 @@ std::wstring BrowserHelper::GetProcessName(DWORD pid) {
 
 // 윈도우 타이틀 가져오기
 std::wstring BrowserHelper::GetWindowTitle(HWND hwnd) {
-	if (!hwnd) return L""; //유효하지 않은 핸들일 경우 빈 문자열 반환
+    std::wstring title;
+    GetWindowTitle(hwnd, title);
+    return title;
+}
+
+void BrowserHelper::GetWindowTitle(HWND hwnd, std::wstring& out) {
+    out.clear();
+	if (!hwnd) return; //유효하지 않은 핸들일 경우 빈 문자열
 
     int len = GetWindowTextLengthW(hwnd);
-    if (len <= 0) return L""; //텍스트가 없으면 빈 문자열 반환
+    if (len <= 0) return; //텍스트가 없으면 빈 문자열
+
+    out.resize(len + 1); //텍스트 길이 + 널 종단 문자 (용량이 충분하면 재할당 없음)
+    int copied = GetWindowTextW(hwnd, &out[0], len + 1); //윈도우 텍스트를 버퍼에 복사
+    out.resize(copied > 0 ? copied : 0);
+}
+
+// PID로부터 실행 파일 버전 가져오기 (주소 표시줄 경로 캐시 키로 사용)
+std::wstring BrowserHelper::GetProcessVersion(DWORD pid) {
+    HANDLE hProc = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!hProc) return L"";
+
+    wchar_t path[MAX_PATH] = { 0 };
+    DWORD pathLen = MAX_PATH;
+    BOOL ok = QueryFullProcessImageNameW(hProc, 0, path, &pathLen); //실행 파일 전체 경로
+    CloseHandle(hProc);
+    if (!ok) return L"";
+
+    DWORD dummy = 0;
+    DWORD size = GetFileVersionInfoSizeW(path, &dummy);
+    if (size == 0) return L"";
+
+    std::vector<BYTE> data(size);
+    if (!GetFileVersionInfoW(path, 0, size, data.data())) return L"";
 
-    std::vector<wchar_t> buffer(len + 1); //텍스트 길이 + 널 종단 문자를 위한 벡터 할당
-    GetWindowTextW(hwnd, buffer.data(), len + 1); //윈도우 텍스트를 벡터에 복사
+    VS_FIXEDFILEINFO* info = nullptr;
+    UINT infoLen = 0;
+    if (!VerQueryValueW(data.data(), L"\\", (LPVOID*)&info, &infoLen) || !info) return L"";
 
-    return buffer.data(); //벡터의 내부 데이터를 반환
+    wchar_t ver[64];
+    swprintf_s(ver, _countof(ver), L"%u.%u.%u.%u",
+        HIWORD(info->dwFileVersionMS), LOWORD(info->dwFileVersionMS),
+        HIWORD(info->dwFileVersionLS), LOWORD(info->dwFileVersionLS));
+    return ver;
 }
 
 // HWND를 기반으로 브라우저 유형 확인 및 이름 반환
 BrowserType BrowserHelper::GetBrowserType(HWND hwnd, std::wstring& exeNameOut) {
+    TRACE_SPAN("BrowserHelper::GetBrowserType");
     if (!hwnd) return BrowserType::Unknown;
 
     DWORD pid = 0;
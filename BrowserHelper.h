@@ -1,16 +1,7 @@
 #pragma once
 #include <windows.h>
 #include <string>
-
-//   
-enum class BrowserType {
-    Unknown,
-    Chrome,   // Chrome, Edge (Chromium )
-    Edge,
-    FireFox,
-    Whale,
-    IE        // Internet Explorer
-};
+#include "BrowserType.h"
 
 class BrowserHelper {
 public:
@@ -19,6 +10,10 @@ public:
 
     //  ŸƲ 
     static std::wstring GetWindowTitle(HWND hwnd);
+    static void GetWindowTitle(HWND hwnd, std::wstring& out); // out 뷮  (̺Ʈ ο)
+
+    // PIDκ     (: "120.0.6099.130")
+    static std::wstring GetProcessVersion(DWORD pid);
 
     // HWND    Ȯϰ  ̸ ȯ
     static BrowserType GetBrowserType(HWND hwnd, std::wstring& exeNameOut);
@@ -0,0 +1,11 @@
+﻿#pragma once
+
+// 브라우저 유형 정의 (Win32 의존성 없이 공유하기 위해 분리)
+enum class BrowserType {
+    Unknown,
+    Chrome,   // Chrome, Edge (Chromium 기반)
+    Edge,
+    FireFox,
+    Whale,
+    IE        // Internet Explorer
+};
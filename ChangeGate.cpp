@@ -0,0 +1,96 @@
+﻿#include "ChangeGate.h"
+
+WindowSignature WindowSignature::FromTitle(const wchar_t* title, size_t len) {
+    WindowSignature sig;
+    sig.titleLength = (int)len;
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint64_t)(uint16_t)title[i];
+        h *= 1099511628211ULL;
+    }
+    sig.titleHash = h;
+    return sig;
+}
+
+ChangeGate::ChangeGate(IClock* clock)
+    : m_clock(clock ? clock : SteadyClock::Instance()), m_enabled(true), m_verifyFgMs(2000), m_verifyBgMs(10000),
+      m_checks(0), m_skips(0), m_notifications(0) {
+    for (auto& reads : m_reads) reads.store(0);
+}
+
+double ChangeGate::SkipRate() const {
+    unsigned long long checks = m_checks.load();
+    unsigned long long skips = m_skips.load();
+    if (skips > checks) skips = checks; // 두 값을 따로 읽으므로 사이에 늘어난 건너뜀 보정
+    return checks ? 100.0 * (double)skips / (double)checks : 0.0;
+}
+
+void ChangeGate::SetVerifyInterval(uint32_t foregroundMs, uint32_t backgroundMs) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_verifyFgMs = foregroundMs;
+    m_verifyBgMs = backgroundMs < foregroundMs ? foregroundMs : backgroundMs;
+}
+
+bool ChangeGate::Decide(State& st, bool fresh, const WindowSignature& sig, bool foreground, bool pending, bool force,
+    uint64_t now, GateReason& reason) const {
+    if (fresh) { reason = GateReason::FirstSeen; return true; }
+    if (force) { reason = GateReason::Forced; return true; }
+    if (sig != st.sig) { reason = GateReason::Title; return true; }
+    if (st.dirty) { reason = GateReason::Notified; return true; }
+    if (pending) { reason = GateReason::Pending; return true; }
+
+    uint64_t verifyMs = foreground ? m_verifyFgMs : m_verifyBgMs;
+    if (st.notifies) verifyMs *= kNotifiedVerifyFactor;
+    if (now - st.lastRead >= verifyMs) { reason = GateReason::Verify; return true; }
+    return false;
+}
+
+bool ChangeGate::ShouldRead(HWND hwnd, const WindowSignature& sig, bool foreground, bool pending, bool force) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    uint64_t now = m_clock->NowMs();
+    m_checks++;
+
+    auto it = m_states.find(hwnd);
+    bool fresh = (it == m_states.end());
+    if (fresh) it = m_states.emplace(hwnd, State()).first;
+    State& st = it->second;
+
+    GateReason reason;
+    if (!Decide(st, fresh, sig, foreground, pending, force, now, reason)) {
+        if (m_enabled.load()) {
+            m_skips++;
+            return false;
+        }
+        reason = GateReason::Verify; // 관문 꺼짐: 건너뛸 수 있었던 읽기는 검증으로 집계
+    }
+
+    m_reads[(int)reason]++;
+    st.sig = sig;
+    st.lastRead = now;
+    st.dirty = false;
+    return true;
+}
+
+void ChangeGate::Invalidate(HWND hwnd) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_states.erase(hwnd);
+}
+
+void ChangeGate::MarkChanged(HWND hwnd) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_notifications++;
+    auto it = m_states.find(hwnd);
+    if (it == m_states.end()) return; // 아직 읽은 적 없음 -> 어차피 다음 샘플에서 읽음
+    it->second.dirty = true;
+    it->second.notifies = true;
+}
+
+#ifdef _WIN32
+void ChangeGate::PruneDeadWindows() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (auto it = m_states.begin(); it != m_states.end();) {
+        if (!IsWindow(it->first)) it = m_states.erase(it);
+        else ++it;
+    }
+}
+#endif
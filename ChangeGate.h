@@ -0,0 +1,94 @@
+﻿#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include "IpcProtocol.h"
+#endif
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "Clock.h"
+
+// 교차 프로세스 UIA 호출 없이 얻을 수 있는 윈도우 상태 요약 (1단계 비교용)
+struct WindowSignature {
+    int titleLength = -1;   // GetWindowTextLength (-1 = 아직 모름)
+    uint64_t titleHash = 0; // 제목 FNV-1a
+
+    static WindowSignature FromTitle(const wchar_t* title, size_t len);
+    bool operator==(const WindowSignature& o) const { return titleLength == o.titleLength && titleHash == o.titleHash; }
+    bool operator!=(const WindowSignature& o) const { return !(*this == o); }
+};
+
+// UIA 읽기를 하게 된 이유 (지표용)
+enum class GateReason {
+    FirstSeen,  // 처음 보는 윈도우 또는 무효화됨
+    Forced,     // 호출자가 알고 있는 변화 (포그라운드 전환 등)
+    Title,      // 1단계: 제목 길이/해시가 바뀜
+    Notified,   // 2단계: 주소 표시줄 값 변경 알림을 받음
+    Pending,    // 확정기가 후보를 기다리거나 사용자가 입력 중
+    Verify,     // 검증 주기가 지남 (앞 단계가 놓친 변화 보완)
+    Count
+};
+
+// 주소 표시줄 UIA 읽기 앞의 값싼 변화 감지 관문
+// - 1단계: 마지막 읽기 이후 윈도우 제목(길이, 해시)이 그대로면 건너뜀
+// - 2단계: UIA 값 변경 알림(UiaHelper::SetChangeListener)이 온 윈도우는 다음 샘플에서 읽음
+// - 확정 대기/입력 중이면 매번 읽고, 검증 주기마다 한 번은 무조건 읽음 (제목이 안 바뀌는 SPA 이동 등)
+// - 알림을 한 번이라도 보낸 윈도우는 알림을 믿고 검증 주기를 kNotifiedVerifyFactor배로 늘림
+// - 여러 UIA 작업 스레드와 UIA 이벤트 스레드에서 호출 가능
+// - PruneDeadWindows 외에는 windows.h 비의존 (LoadGen notify에서 그대로 검사)
+class ChangeGate {
+public:
+    explicit ChangeGate(IClock* clock = nullptr);
+
+    // false면 항상 읽음 (지표만 기록)
+    void SetEnabled(bool enable) { m_enabled = enable; }
+    void SetVerifyInterval(uint32_t foregroundMs, uint32_t backgroundMs);
+
+    // 이번 샘플에서 UIA를 읽어야 하면 true (읽기로 하면 서명과 시각을 기록)
+    bool ShouldRead(HWND hwnd, const WindowSignature& sig, bool foreground, bool pending, bool force = false);
+
+    // 읽기 실패: 다음 샘플에서 다시 읽도록 상태 제거
+    void Invalidate(HWND hwnd);
+
+    // 주소 표시줄 값 변경 알림 (UIA 이벤트 스레드)
+    void MarkChanged(HWND hwnd);
+
+#ifdef _WIN32
+    // 소멸된 윈도우 상태 정리
+    void PruneDeadWindows();
+#endif
+
+    // 지표 (잠금 없이 다른 스레드에서 읽음)
+    unsigned long long Checks() const { return m_checks.load(); }
+    unsigned long long Skips() const { return m_skips.load(); }
+    unsigned long long Reads(GateReason reason) const { return m_reads[(int)reason].load(); }
+    unsigned long long Notifications() const { return m_notifications.load(); }
+    double SkipRate() const;
+
+    static const uint32_t kNotifiedVerifyFactor = 4;
+
+private:
+    struct State {
+        WindowSignature sig;    // 마지막으로 읽었을 때의 서명
+        uint64_t lastRead = 0;
+        bool dirty = false;     // 읽은 뒤 값 변경 알림을 받음
+        bool notifies = false;  // 알림을 보낸 적 있음
+    };
+
+    IClock* m_clock;
+    std::atomic<bool> m_enabled;
+    uint32_t m_verifyFgMs;
+    uint32_t m_verifyBgMs;
+
+    std::mutex m_lock;
+    std::unordered_map<HWND, State> m_states;
+    std::atomic<unsigned long long> m_checks;
+    std::atomic<unsigned long long> m_skips;
+    std::atomic<unsigned long long> m_reads[(int)GateReason::Count];
+    std::atomic<unsigned long long> m_notifications;
+
+    bool Decide(State& st, bool fresh, const WindowSignature& sig, bool foreground, bool pending, bool force,
+        uint64_t now, GateReason& reason) const;
+};
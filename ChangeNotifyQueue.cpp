@@ -0,0 +1,22 @@
+﻿#include "ChangeNotifyQueue.h"
+#include <algorithm>
+
+ChangeNotifyQueue::ChangeNotifyQueue(std::function<void()> post) : m_post(post), m_posts(0) {
+}
+
+void ChangeNotifyQueue::Add(HWND hwnd) {
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (std::find(m_pending.begin(), m_pending.end(), hwnd) != m_pending.end()) return;
+        m_pending.push_back(hwnd);
+        if (m_pending.size() > 1) return; // 이미 예약된 post가 함께 처리
+    }
+    m_posts++;
+    m_post();
+}
+
+void ChangeNotifyQueue::Take(std::vector<HWND>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> guard(m_lock);
+    out.swap(m_pending);
+}
@@ -0,0 +1,33 @@
+﻿#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include "IpcProtocol.h"
+#endif
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// 주소 표시줄 값 변경 알림을 UIA 이벤트 스레드에서 스케줄러 스레드로 넘기는 대기 목록
+// - Add: 목록이 비어 있을 때만 post 호출 (스케줄러가 Take하기 전까지 알림이 몰려도 Post 한 번)
+// - 같은 윈도우의 중복 알림은 한 번만 보관
+// - windows.h 비의존 (LoadGen notify에서 그대로 검사)
+class ChangeNotifyQueue {
+public:
+    explicit ChangeNotifyQueue(std::function<void()> post);
+
+    // UIA 이벤트 스레드
+    void Add(HWND hwnd);
+
+    // 스케줄러 스레드: 쌓인 윈도우를 모두 꺼냄 (이후 알림은 다시 post)
+    void Take(std::vector<HWND>& out);
+
+    unsigned long long Posts() const { return m_posts.load(); }
+
+private:
+    std::function<void()> m_post;
+    std::mutex m_lock;
+    std::vector<HWND> m_pending;
+    std::atomic<unsigned long long> m_posts;
+};
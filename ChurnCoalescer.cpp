@@ -0,0 +1,197 @@
+﻿#include "ChurnCoalescer.h"
+#include "AsyncLogger.h"
+#include "TextCodec.h"
+#include <stdio.h>
+#include <string.h>
+
+ChurnCoalescer::ChurnCoalescer(IClock* clock)
+    : m_clock(clock ? clock : SteadyClock::Instance()), m_enabled(true), m_suppressed(0) {
+}
+
+void ChurnCoalescer::SetOptions(const ChurnOptions& options) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_options = options;
+    if (m_options.threshold == 0) m_options.threshold = 1;
+
+    // 정규 URL(UTF-8, 호스트 소문자)과 바로 비교하도록 변환
+    m_exemptHosts.clear();
+    for (const std::wstring& host : m_options.exemptHosts) {
+        std::string utf8(Utf8CapacityFor(host.size()), '\0');
+        utf8.resize(TranscodeUtf16ToUtf8(host.data(), host.size(), &utf8[0], utf8.size()));
+        for (char& c : utf8) {
+            if (c >= 'A' && c <= 'Z') c = (char)(c + ('a' - 'A'));
+        }
+        if (!utf8.empty()) m_exemptHosts.push_back(utf8);
+    }
+    m_keyParams.clear();
+    for (const std::wstring& name : m_options.keyParams) {
+        std::string utf8(Utf8CapacityFor(name.size()), '\0');
+        utf8.resize(TranscodeUtf16ToUtf8(name.data(), name.size(), &utf8[0], utf8.size()));
+        if (!utf8.empty()) m_keyParams.push_back(utf8);
+    }
+    m_states.clear();
+}
+
+// 호스트가 제외 목록과 같거나 그 하위 도메인이면 true (포트는 무시)
+bool ChurnCoalescer::IsExempt(const char* url, size_t hostStart, size_t hostEnd) const {
+    const char* colon = (const char*)memchr(url + hostStart, ':', hostEnd - hostStart);
+    if (colon) hostEnd = (size_t)(colon - url);
+    size_t hostLen = hostEnd - hostStart;
+
+    for (const std::string& exempt : m_exemptHosts) {
+        size_t n = exempt.size();
+        if (n > hostLen) continue;
+        if (memcmp(url + hostEnd - n, exempt.data(), n) != 0) continue;
+        if (n == hostLen || url[hostEnd - n - 1] == '.') return true;
+    }
+    return false;
+}
+
+// 키: "윈도우|스킴://호스트/세그먼트...[?이름=값...]" (keyParams에 있는 쿼리 파라미터만, 프래그먼트 제외)
+// 정규 URL이 아니거나 제외 호스트면 false
+bool ChurnCoalescer::BuildKey(const UrlEvent& ev, std::string& key) const {
+    const char* url = ev.Url();
+    size_t len = ev.UrlLen();
+
+    size_t hostStart = 0;
+    while (hostStart + 2 < len && !(url[hostStart] == ':' && url[hostStart + 1] == '/' && url[hostStart + 2] == '/')) hostStart++;
+    if (hostStart + 2 >= len) return false;
+    hostStart += 3;
+
+    size_t end = hostStart;
+    while (end < len && url[end] != '/' && url[end] != '?' && url[end] != '#') end++;
+    if (IsExempt(url, hostStart, end)) return false;
+
+    for (int seg = 0; seg < m_options.pathSegments && end < len && url[end] == '/'; seg++) {
+        end++;
+        while (end < len && url[end] != '/' && url[end] != '?' && url[end] != '#') end++;
+    }
+
+    char prefix[32];
+    int n = snprintf(prefix, sizeof(prefix), "%p|", (void*)ev.Hwnd());
+    key.assign(prefix, n > 0 ? (size_t)n : 0);
+    key.append(url, end);
+
+    // 검색어처럼 의미 있는 파라미터만 키에 추가 (/search?q=a 와 /search?q=b 는 다른 키, ?q=a&start=10 은 같은 키)
+    const char* hash = (const char*)memchr(url + end, '#', len - end);
+    const char* queryEnd = hash ? hash : url + len;
+    const char* query = m_keyParams.empty() ? nullptr : (const char*)memchr(url + end, '?', (size_t)(queryEnd - (url + end)));
+    if (query) {
+        char sep = '?';
+        for (const char* p = query + 1; p < queryEnd;) {
+            const char* amp = (const char*)memchr(p, '&', (size_t)(queryEnd - p));
+            const char* paramEnd = amp ? amp : queryEnd;
+            const char* eq = (const char*)memchr(p, '=', (size_t)(paramEnd - p));
+            size_t nameLen = (size_t)((eq ? eq : paramEnd) - p);
+            for (const std::string& name : m_keyParams) {
+                if (name.size() == nameLen && memcmp(p, name.data(), nameLen) == 0) {
+                    key.push_back(sep);
+                    key.append(p, (size_t)(paramEnd - p));
+                    sep = '&';
+                    break;
+                }
+            }
+            p = paramEnd + (amp ? 1 : 0);
+        }
+    }
+    return true;
+}
+
+bool ChurnCoalescer::Offer(UrlEventPtr& ev) {
+    ev->SetChanges(1);
+    if (!m_enabled.load()) return true;
+
+    thread_local std::string key; // 용량 재사용
+    if (!BuildKey(*ev, key)) return true;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    uint64_t now = m_clock->NowMs();
+    auto found = m_states.find(key);
+    if (found == m_states.end()) {
+        found = m_states.emplace(key, KeyState()).first;
+        found->second.ring.resize(m_options.threshold + 1);
+    }
+    KeyState& st = found->second;
+    st.lastChange = now;
+
+    // 구간이 지난 시각 제거 후 이번 변경 추가 (가득 차면 가장 오래된 것을 덮어씀)
+    size_t cap = st.ring.size();
+    while (st.ringCount > 0 && now - st.ring[st.ringStart] > m_options.windowMs) {
+        st.ringStart = (st.ringStart + 1) % cap;
+        st.ringCount--;
+    }
+    if (st.ringCount == cap) {
+        st.ringStart = (st.ringStart + 1) % cap;
+        st.ringCount--;
+    }
+    st.ring[(st.ringStart + st.ringCount) % cap] = now;
+    st.ringCount++;
+
+    if (!st.coalesced) {
+        if (st.ringCount <= m_options.threshold) return true;
+        // 이미 내보낸 변경은 그대로 두고 이번 변경부터 간격 단위로 병합
+        st.coalesced = true;
+        st.lastEmit = now;
+        AGENT_LOG_INFO("[Churn] Coalescing %s (%u changes in %u ms)",
+            key.c_str(), (unsigned)st.ringCount, m_options.windowMs);
+    }
+
+    st.pending.swap(ev); // 이번 이벤트를 보류, 이전 보류분(있으면)은 아래에서 풀로 반납
+    st.pendingCount++;
+    if (now - st.lastEmit < m_options.emitIntervalMs) {
+        m_suppressed++;
+        ev.reset();
+        return false;
+    }
+
+    ev.swap(st.pending);
+    st.pending.reset();
+    ev->SetChanges(st.pendingCount);
+    st.pendingCount = 0;
+    st.lastEmit = now;
+    return true;
+}
+
+void ChurnCoalescer::CollectDue(std::vector<UrlEventPtr>& out) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    uint64_t now = m_clock->NowMs();
+
+    for (auto it = m_states.begin(); it != m_states.end();) {
+        KeyState& st = it->second;
+        if (st.pendingCount > 0 && now - st.lastEmit >= m_options.emitIntervalMs) {
+            st.pending->SetChanges(st.pendingCount);
+            out.push_back(std::move(st.pending));
+            st.pendingCount = 0;
+            st.lastEmit = now;
+        }
+
+        // 구간 동안 변경이 없으면 상태 제거 (병합 모드 해제, 메모리 회수)
+        if (st.pendingCount == 0 && now - st.lastChange > m_options.windowMs) {
+            if (st.coalesced) AGENT_LOG_INFO("[Churn] Released %s", it->first.c_str());
+            it = m_states.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void ChurnCoalescer::Drain(std::vector<UrlEventPtr>& out) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (auto& kv : m_states) {
+        KeyState& st = kv.second;
+        if (st.pendingCount == 0) continue;
+        st.pending->SetChanges(st.pendingCount);
+        out.push_back(std::move(st.pending));
+    }
+    m_states.clear();
+}
+
+size_t ChurnCoalescer::CoalescedKeys() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    size_t n = 0;
+    for (const auto& kv : m_states) {
+        if (kv.second.coalesced) n++;
+    }
+    return n;
+}
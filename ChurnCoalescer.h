@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Clock.h"
+#include "UrlEvent.h"
+
+// URL 변경 폭주 감지 설정 (모니터 시작 전에 설정)
+struct ChurnOptions {
+    uint32_t threshold = 10;              // windowMs 안에 이 횟수를 넘게 바뀌면 병합 모드
+    uint32_t windowMs = 60 * 1000;        // 변경 횟수를 세는 구간 (이 시간 동안 변경이 없으면 병합 해제)
+    uint32_t emitIntervalMs = 30 * 1000;  // 병합 모드에서 이벤트 최소 간격
+    int pathSegments = 1;                 // 키에 포함할 경로 앞부분 세그먼트 수
+    std::vector<std::wstring> exemptHosts; // 병합하지 않는 호스트 (하위 도메인 포함)
+    // 키에 값을 넣는 쿼리 파라미터 (검색어, 동영상 ID처럼 값이 다르면 다른 이동). 나머지 쿼리(?ll=, ?t=, ?page= 등)는 키에서 제외
+    std::vector<std::wstring> keyParams = { L"q", L"query", L"search_query", L"v" };
+};
+
+// SPA(지도, 동영상, 무한 스크롤)처럼 주소 표시줄을 계속 바꾸는 페이지의 이벤트 병합
+// - (윈도우, 스킴://호스트/경로 접두어, keyParams 값) 단위로 최근 변경 시각을 세어 임계값을 넘으면 병합 모드
+// - 병합 모드에서는 emitIntervalMs마다 마지막 URL 하나를 변경 횟수와 함께 내보냄
+// - 변경이 멈춘 뒤 남은 이벤트는 CollectDue에서 내보냄 (모니터의 주기 작업에서 호출)
+// - 보류 중인 이벤트는 UrlEvent 핸들로 보관 (복사 없음), 대표 이벤트의 Changes()에 변경 수 기록
+// - 여러 UIA 작업 스레드에서 호출 가능
+class ChurnCoalescer {
+public:
+    explicit ChurnCoalescer(IClock* clock = nullptr);
+
+    void SetOptions(const ChurnOptions& options);
+    void SetEnabled(bool enable) { m_enabled.store(enable); }
+
+    // 확정된 변경 하나 제출. true면 ev를 지금 내보냄
+    // false면 ev를 넘겨받아 보류 (다음 간격 또는 CollectDue에서 내보냄, 이전 보류분은 풀로 반납)
+    bool Offer(UrlEventPtr& ev);
+
+    // 간격이 지난 보류 이벤트 수집, 조용해진 키 정리
+    void CollectDue(std::vector<UrlEventPtr>& out);
+
+    // 간격과 관계없이 보류 이벤트를 모두 수집하고 상태 초기화 (종료 시 유실 방지)
+    void Drain(std::vector<UrlEventPtr>& out);
+
+    size_t CoalescedKeys();
+    unsigned long long Suppressed() const { return m_suppressed.load(); }
+
+private:
+    struct KeyState {
+        std::vector<uint64_t> ring;   // 최근 변경 시각 (threshold + 1개 고정 링)
+        size_t ringStart = 0;
+        size_t ringCount = 0;
+        bool coalesced = false;
+        uint64_t lastEmit = 0;
+        uint64_t lastChange = 0;
+        UrlEventPtr pending;
+        uint32_t pendingCount = 0;
+    };
+
+    IClock* m_clock;
+    ChurnOptions m_options;
+    std::vector<std::string> m_exemptHosts; // UTF-8 소문자
+    std::vector<std::string> m_keyParams;   // UTF-8
+    std::atomic<bool> m_enabled;
+
+    std::mutex m_lock;
+    std::unordered_map<std::string, KeyState> m_states; // 키 수만큼만 할당 (같은 키의 반복 변경은 할당 없음)
+    std::atomic<unsigned long long> m_suppressed;
+
+    bool IsExempt(const char* url, size_t hostStart, size_t hostEnd) const;
+    bool BuildKey(const UrlEvent& ev, std::string& key) const;
+};
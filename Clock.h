@@ -0,0 +1,24 @@
+﻿#pragma once
+#include <stdint.h>
+#include <chrono>
+
+// 주입 가능한 밀리초 시계 (테스트에서는 수동으로 진행시키는 구현으로 대체)
+class IClock {
+public:
+    virtual ~IClock() {}
+    virtual uint64_t NowMs() = 0;
+};
+
+// 기본 구현: 단조 증가 시계
+class SteadyClock : public IClock {
+public:
+    uint64_t NowMs() override {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static SteadyClock* Instance() {
+        static SteadyClock clock;
+        return &clock;
+    }
+};
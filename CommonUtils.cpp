@@ -1,43 +1,61 @@
 #include "CommonUtils.h"
+#include "TextCodec.h"
+#include "AsyncLogger.h"
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <cstdio>
 #include <cstdarg>
+#include <cstring>
 
 //Win32 API C++ ǥ ̺귯  ڿ ڵ  ȣȯ
 std::string Utf16ToUtf8(const std::wstring& ws) {
     if (ws.empty()) return std::string(); //Է ڿ   ڿ ȯ 
 
-    // CP_UTF8  WideCharToMultiByte   windows.h ʿ
-    int len = WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, nullptr, 0, nullptr, nullptr); //ڿ  ʿ  ũ 
-    if (len <= 0) {
-		return std::string(); // ũ     ڿ ȯ
-    }
-	std::string result; //UTF-8  ڿ
-    result.resize(static_cast<size_t>(len)); //len ŭ ڿ ũ (޸ Ҵ)
-    int written = WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, &result[0], len, nullptr, nullptr); //UTF-8  
-    if (written <= 0) {
+    // ־  ũ   Ҵ   н ȯ (ũ   ȣ )
+    std::string result;
+    result.resize(Utf8CapacityFor(ws.size()));
+    size_t written = TranscodeUtf16ToUtf8(ws.data(), ws.size(), &result[0], result.size());
+    if (written == kTextCodecOverflow) {
         return std::string(); //   ڿ ȯ
     }
-    //  null-terminated . C++ string  null ص .
-    if (!result.empty() && result.back() == '\0') {
-		result.pop_back(); // null  
-    }
+    result.resize(written); // ̷ 
     return result; // ȯ ڿ ȯ
 }
 
+// UTF-8 -> UTF-16 (len -1̸ NUL  ڿ)
+std::wstring Utf8ToUtf16(const char* utf8, int len) {
+    if (!utf8) return std::wstring();
+    size_t n = len < 0 ? strlen(utf8) : (size_t)len;
+    if (n == 0) return std::wstring();
+
+    std::wstring result;
+    result.resize(Utf16CapacityFor(n));
+    size_t written = TranscodeUtf8ToUtf16(utf8, n, &result[0], result.size());
+    if (written == kTextCodecOverflow) {
+        return std::wstring();
+    }
+    result.resize(written);
+    return result;
+}
+
 //α ()
-static void VLog(FILE* fp, const wchar_t* prefix, const wchar_t* fmt, va_list ap) {
-    // Windows ֿܼ UTF-16 : fwprintf 
-    fwprintf(fp, L"%ls", prefix);
-    vfwprintf(fp, fmt, ap); //α ޽  
-    fwprintf(fp, L"\n");
+// ̵   Ÿ   Ƿ ȣ 忡  ϰ,
+// ܼ/  񵿱 ΰ ׶ 忡 ñ
+static void VLog(LogLevel level, const wchar_t* fmt, va_list ap) {
+    if (!AsyncLogger::Instance().Enabled(level)) return;
+
+    thread_local wchar_t buf[1024];
+    int n = vswprintf(buf, sizeof(buf) / sizeof(buf[0]), fmt, ap); //α ޽  
+    if (n < 0) buf[sizeof(buf) / sizeof(buf[0]) - 1] = L'\0'; // ߸ 쿡  
+    AsyncLogger::Instance().Log(level, "%ls", (const wchar_t*)buf);
 }
 
 // α 
 void LogInfo(const wchar_t* fmt, ...) {
     va_list ap;
     va_start(ap, fmt);
-    VLog(stdout, L"[INFO] ", fmt, ap); // ǥ 
+    VLog(LogLevel::Info, fmt, ap);
     va_end(ap);
 }
 
@@ -45,6 +63,6 @@ void LogInfo(const wchar_t* fmt, ...) {
 void LogError(const wchar_t* fmt, ...) {
     va_list ap;
     va_start(ap, fmt);
-    VLog(stderr, L"[ERROR] ", fmt, ap);
+    VLog(LogLevel::Error, fmt, ap);
     va_end(ap);
 }
\ No newline at end of file
@@ -6,7 +6,10 @@
 
 // Windows API ȯ ƿƼ
 // - UTF-16(wstring) -> UTF-8(string)
+// - UTF-8 -> UTF-16(wstring)
+// ȣ ۿ  ȯϷ TextCodec.h 
 std::string Utf16ToUtf8(const std::wstring& ws);
+std::wstring Utf8ToUtf16(const char* utf8, int len = -1);
 
 //  α Լ (printf ü)
 void LogInfo(const wchar_t* fmt, ...);
@@ -0,0 +1,31 @@
+﻿#include "Crc32.h"
+
+namespace {
+    // 바이트 단위 테이블 (첫 호출에서 한 번 생성, 함수 내 static 초기화는 스레드 안전)
+    struct CrcTable {
+        uint32_t entries[256];
+
+        CrcTable() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                entries[i] = c;
+            }
+        }
+    };
+
+    const uint32_t* Table() {
+        static const CrcTable table;
+        return table.entries;
+    }
+}
+
+uint32_t Crc32(uint32_t crc, const void* data, size_t size) {
+    const uint32_t* table = Table();
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    while (size--)
+        crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
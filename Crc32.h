@@ -0,0 +1,7 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE 802.3, zlib crc32과 같은 값). 이어서 계산하려면 이전 결과를 crc로 전달 (처음은 0)
+// 스풀 레코드, 체크포인트 파일 검증용 (zlib 없이 빌드)
+uint32_t Crc32(uint32_t crc, const void* data, size_t size);
@@ -1,52 +1,153 @@
 #include "Database.h"
+#include "CommonUtils.h"
+#include "TextCodec.h"
+#include "AsyncLogger.h"
+#include "Tracer.h"
+#include "Watchdog.h"
+#include "EventSpool.h"
+#include "SchemaMigrator.h"
+#include "HistoryImporter.h"
+#include "UrlCanonicalizer.h"
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <stdio.h>
+#include <string.h>
 #include <string>
-
-Database::Database() : m_db(nullptr)
-{
+#include <utility>
+#include <vector>
+
+static const uint32_t kWriteBudgetMs = 5000;   // ̺Ʈ 1/  (  )
+static const uint32_t kReplayBudgetMs = 30000; // Ǯ ġ ÷, ̱׷̼ ûũ
+
+//  ϳ  .  ۾  ̸ ϳ  (SingleFile ġ =  )
+struct Database::Shard {
+    DbShard primary;          //    ù ۾ (÷ ܰ ̸)
+    DbShardOptions options;
+    unsigned spoolTypes = 0;  //  Ͽ ݿ Ǯ ڵ  (1 << SpoolRecordType)
+
+    sqlite3* db = nullptr;
+    std::mutex writeLock;     //  /ݱ, , ÷ Ʈ ȭ
+    std::mutex handleLock;    // db  ü Interrupt ȣ (writeLock  ä  尡 ־ ȹ )
+    std::unique_ptr<SchemaMigrator> migrator;
+    sqlite3_stmt* insertUrlStmt = nullptr; //       (  )
+    sqlite3_stmt* touchUrlStmt = nullptr;
+
+    // Ǯ ÷  ġ (SpoolProgress ̺  , 翬  ٽ )
+    bool spoolLoaded = false;
+    uint64_t spoolGeneration = 0;
+    uint64_t spoolOffset = 0;
+};
+
+const char* const Database::kCanonicalUrlMigration = "BrowserUrls.url canonical";
+
+static const char* const kShardNames[] = { "config", "history", "requests" };
+static const char* const kWriteStages[] = { "db.write.config", "db.write.history", "db.write.requests" };
+static const char* const kReplayStages[] = { "db.replay.config", "db.replay.history", "db.replay.requests" };
+
+DatabaseLayout DatabaseLayout::SingleFile(const char* path) {
+    DatabaseLayout layout;
+    for (DbShardOptions& shard : layout.shards) shard.path = path;
+    return layout;
 }
-Database::~Database() {
-    Close();
+
+DatabaseLayout DatabaseLayout::Sharded(const char* dir) {
+    DatabaseLayout layout;
+    std::string base = dir;
+    if (!base.empty() && base.back() != '\\' && base.back() != '/') base += '\\';
+
+    // ɼ ڰ  ٸǷ ĿԸ ȭ, ̷/û  WAL üũƮ ȭ
+    layout.shards[(int)DbShard::Config].path = base + "AgentOptions.db";
+    layout.shards[(int)DbShard::Config].synchronous = "FULL";
+    layout.shards[(int)DbShard::History].path = base + "AgentHistory.db";
+    layout.shards[(int)DbShard::History].synchronous = "NORMAL";
+    layout.shards[(int)DbShard::RequestLog].path = base + "AgentRequests.db";
+    layout.shards[(int)DbShard::RequestLog].synchronous = "NORMAL";
+    return layout;
 }
 
-// ͺ̽ ʱȭ
-bool Database::Initialize(const char* dbPath) {
-    if (m_db) return true;
+const char* Database::WriteStage(DbShard shard) { return kWriteStages[(int)shard]; }
+const char* Database::ReplayStage(DbShard shard) { return kReplayStages[(int)shard]; }
+const char* Database::SchemaName(DbShard shard) { return kShardNames[(int)shard]; }
 
-    int rc = sqlite3_open(dbPath, &m_db);
-    if (rc != SQLITE_OK) {
-        printf("[DB] Failed to open: %s\n", sqlite3_errmsg(m_db));
-        sqlite3_close(m_db);
-        m_db = nullptr;
-        return false;
-    }
+Database::Database() : m_spool(nullptr) {
+    for (Shard*& route : m_route) route = nullptr;
+}
 
-    if (!CreateTableIfNotExists()) {
-        Close();
-        return false;
+//   õϸ   ִ  (  ̺Ʈ Ǯ)
+static bool IsTransientError(int rc) {
+    switch (rc & 0xFF) {
+    case SQLITE_BUSY:
+    case SQLITE_LOCKED:
+    case SQLITE_FULL:
+    case SQLITE_IOERR:
+    case SQLITE_CANTOPEN:
+    case SQLITE_NOMEM:
+    case SQLITE_READONLY:
+    case SQLITE_INTERRUPT: // ñⰡ  ⸦ ߴܽŲ 
+        return true;
     }
-    if (!CreateBrowserUrlsTable()) {
-        Close();
-        return false;
+    return false;
+}
+// غ  ĳ ( writeLock  ¿ ȣ). ó   prepare
+static sqlite3_stmt* CachedStatement(sqlite3* db, sqlite3_stmt*& slot, const char* sql) {
+    if (!slot && sqlite3_prepare_v2(db, sql, -1, &slot, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(slot);
+        slot = nullptr;
     }
-
-    printf("[DB] Opened: %s\n", dbPath);
-    return true;
+    return slot;
 }
 
-// ͺ̽ ݱ
-void Database::Close() {
-    if (m_db) {
-        sqlite3_close(m_db);
-        m_db = nullptr;
-        printf("[DB] Closed\n");
+// v8(raw_url)   ּ ǥ  url ״ : /   URL ٲٰ  raw_url 
+// (⺻ ȭ ɼ, ȭ   URL ״ ). ȯ: Ȯ  , 0̸ Ϸ,  
+static int CanonicalizeLegacyUrls(sqlite3* db, sqlite3_int64& cursor, int maxRows) {
+    static const UrlCanonicalizer canonicalizer;
+
+    // б⸦    ( ̺ д ߿  )
+    std::vector<std::pair<sqlite3_int64, std::string>> rows;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT id, url FROM BrowserUrls WHERE id > ?1 AND raw_url IS NULL ORDER BY id LIMIT ?2;",
+        -1, &stmt, nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    sqlite3_bind_int64(stmt, 1, cursor);
+    sqlite3_bind_int(stmt, 2, maxRows);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char* url = (const char*)sqlite3_column_text(stmt, 1);
+        rows.emplace_back(sqlite3_column_int64(stmt, 0), std::string(url ? url : "", url ? sqlite3_column_bytes(stmt, 1) : 0));
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) return -1;
+    if (rows.empty()) return 0;
+
+    if (sqlite3_prepare_v2(db, "UPDATE BrowserUrls SET url = ?2, raw_url = ?3 WHERE id = ?1;", -1, &stmt, nullptr) != SQLITE_OK)
+        return -1;
+    for (const auto& row : rows) {
+        std::wstring wide = Utf8ToUtf16(row.second.data(), (int)row.second.size());
+        if (!canonicalizer.Canonicalize(wide)) continue;
+        std::string url = Utf16ToUtf8(wide);
+        if (url.empty() || url == row.second) continue;
+
+        sqlite3_bind_int64(stmt, 1, row.first);
+        sqlite3_bind_text(stmt, 2, url.data(), (int)url.size(), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, row.second.data(), (int)row.second.size(), SQLITE_STATIC);
+        rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (rc != SQLITE_DONE) {
+            sqlite3_finalize(stmt);
+            return -1;
+        }
     }
+    sqlite3_finalize(stmt);
+    cursor = rows.back().first;
+    return (int)rows.size();
 }
 
-// ɼ  ̺ 
-bool Database::CreateTableIfNotExists() {
-    const char* sqlCreate =
+// Ű  ̷: ׻    ߰ϰ  ܰ  
+// (v1~v2 user_version   DB ȣȯǵ IF NOT EXISTS / ÷ Ȯ )
+static void RegisterMigrations(SchemaMigrator& m) {
+    m.AddStep(1, "base tables",
         "CREATE TABLE IF NOT EXISTS Options ("
         " id INTEGER PRIMARY KEY AUTOINCREMENT,"
         " OPT1 INTEGER NOT NULL,"
@@ -54,52 +155,39 @@ bool Database::CreateTableIfNotExists() {
         " OPT3 INTEGER NOT NULL,"
         " SEQ INTEGER NOT NULL,"
         " timestamp DATETIME DEFAULT CURRENT_TIMESTAMP"
-        ");";
-    char* err = nullptr;
-    int rc = sqlite3_exec(m_db, sqlCreate, nullptr, nullptr, &err);
-    if (rc != SQLITE_OK) {
-        printf("[DB] Create table failed: %s\n", err ? err : "unknown");
-        if (err) sqlite3_free(err);
-        return false;
-    }
-
-    bool hasSEQ = false;
-    const char* sqlInfo = "PRAGMA table_info(Options);";
-    sqlite3_stmt* stmt = nullptr;
-    rc = sqlite3_prepare_v2(m_db, sqlInfo, -1, &stmt, nullptr);
-    if (rc == SQLITE_OK && stmt) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            const unsigned char* colName = sqlite3_column_text(stmt, 1);
-            if (colName && sqlite3_stricmp(reinterpret_cast<const char*>(colName), "SEQ") == 0) {
-                hasSEQ = true;
-                break;
+        ");"
+        "CREATE TABLE IF NOT EXISTS BrowserUrls ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "browser_name TEXT NOT NULL, "
+        "url TEXT NOT NULL, "
+        "window_title TEXT, "
+        "timestamp DATETIME DEFAULT CURRENT_TIMESTAMP"
+        ");"
+        "CREATE INDEX IF NOT EXISTS idx_urls_timestamp ON BrowserUrls(timestamp);");
+
+    // ʱ  Options ̺ SEQ ÷ 
+    m.AddStep(2, "Options.SEQ", [](sqlite3* db) {
+        bool hasSEQ = false;
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, "PRAGMA table_info(Options);", -1, &stmt, nullptr) == SQLITE_OK) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                const unsigned char* colName = sqlite3_column_text(stmt, 1);
+                if (colName && sqlite3_stricmp(reinterpret_cast<const char*>(colName), "SEQ") == 0) {
+                    hasSEQ = true;
+                    break;
+                }
             }
+            sqlite3_finalize(stmt);
         }
-    }
-    if (stmt) sqlite3_finalize(stmt);
-
-    if (!hasSEQ) { //÷ SEQ  SEQ ÷ ߰
-        const char* sqlAddSeq = "ALTER TABLE Options ADD COLUMN SEQ INTEGER NOT NULL DEFAULT 0;";
-        rc = sqlite3_exec(m_db, sqlAddSeq, nullptr, nullptr, &err);
-        if (rc != SQLITE_OK) {
-            printf("[DB] Add SEQ column failed: %s\n", err ? err : "unknown");
-            if (err) sqlite3_free(err);
+        if (!hasSEQ && sqlite3_exec(db, "ALTER TABLE Options ADD COLUMN SEQ INTEGER NOT NULL DEFAULT 0;",
+            nullptr, nullptr, nullptr) != SQLITE_OK) {
             return false;
         }
-        const char* sqlIdx = "CREATE INDEX IF NOT EXISTS idx_options_seq ON Options(SEQ);";
-        rc = sqlite3_exec(m_db, sqlIdx, nullptr, nullptr, &err);
-        if (rc != SQLITE_OK) {
-            printf("[DB] Create index failed: %s\n", err ? err : "unknown");
-            if (err) sqlite3_free(err);
-        }
-        printf("[DB] SEQ column added with DEFAULT 0\n");
-    }
-    return true;
-}
+        return sqlite3_exec(db, "CREATE INDEX IF NOT EXISTS idx_options_seq ON Options(SEQ);",
+            nullptr, nullptr, nullptr) == SQLITE_OK;
+    });
 
-// URL α  ̺ 
-bool Database::CreateUrlLogsTableIfNotExists() {
-    const char* sqlCreate =
+    m.AddStep(3, "UrlLogs",
         "CREATE TABLE IF NOT EXISTS UrlLogs ("
         " id INTEGER PRIMARY KEY AUTOINCREMENT,"
         " proc_name TEXT NOT NULL,"
@@ -111,31 +199,222 @@ bool Database::CreateUrlLogsTableIfNotExists() {
         " path TEXT,"
         " full_url TEXT,"
         " timestamp DATETIME DEFAULT CURRENT_TIMESTAMP"
-        ");";
-    char* err = nullptr;
-    int rc = sqlite3_exec(m_db, sqlCreate, nullptr, nullptr, &err);
+        ");"
+        "CREATE INDEX IF NOT EXISTS idx_urllogs_pid_time ON UrlLogs(pid, timestamp);");
+
+    m.AddStep(4, "SpoolProgress",
+        "CREATE TABLE IF NOT EXISTS SpoolProgress ("
+        "id INTEGER PRIMARY KEY CHECK (id = 1), "
+        "generation INTEGER NOT NULL, "
+        "offset INTEGER NOT NULL"
+        ");");
+
+    m.AddStep(5, "background migration state", SchemaMigrator::kBackgroundStateSql);
+
+    //  (pid, host, path) û     ࿡ 
+    m.AddStep(6, "UrlLogs.hit_count",
+        "ALTER TABLE UrlLogs ADD COLUMN hit_count INTEGER NOT NULL DEFAULT 1;");
+
+    //  (, URL) 湮       (last_seen NULL = 湮 )
+    m.AddStep(7, "BrowserUrls.visit_count",
+        "ALTER TABLE BrowserUrls ADD COLUMN visit_count INTEGER NOT NULL DEFAULT 1;"
+        "ALTER TABLE BrowserUrls ADD COLUMN last_seen DATETIME;");
+
+    // url ȭ URL, ּ ǥ  ٸ  raw_url  (NULL = url )
+    m.AddStep(8, "BrowserUrls.raw_url",
+        "ALTER TABLE BrowserUrls ADD COLUMN raw_url TEXT;");
+
+    // ּ  ַ յ ̺Ʈ ǥϴ  
+    m.AddStep(9, "BrowserUrls.change_count",
+        "ALTER TABLE BrowserUrls ADD COLUMN change_count INTEGER NOT NULL DEFAULT 1;");
+
+    //   ̷    ġ (HistoryImporter)
+    m.AddStep(10, "ImportProgress", HistoryImporter::kProgressSql);
+
+    // 뷮  ȯ ûũ  ׶ ̱׷̼  (RunBackgroundMigrations )
+    m.AddBackgroundMigration(Database::kCanonicalUrlMigration, 8, CanonicalizeLegacyUrls);
+}
+
+Database::~Database() {
+    Close();
+}
+
+bool Database::Initialize(const char* dbPath) {
+    return Initialize(DatabaseLayout::SingleFile(dbPath));
+}
+
+//  ʱȭ: ù ȣ⿡ ΰ  ۾  带 ,  带   
+bool Database::Initialize(const DatabaseLayout& layout) {
+    std::lock_guard<std::mutex> lock(m_initLock);
+    if (m_shards.empty()) {
+        for (int i = 0; i < (int)DbShard::Count; i++) {
+            const DbShardOptions& options = layout.shards[i];
+            Shard* shard = nullptr;
+            for (auto& existing : m_shards) {
+                if (sqlite3_stricmp(existing->options.path.c_str(), options.path.c_str()) == 0) shard = existing.get();
+            }
+            if (!shard) {
+                m_shards.emplace_back(new Shard());
+                shard = m_shards.back().get();
+                shard->primary = (DbShard)i;
+                shard->options = options;
+            }
+            if (i == (int)DbShard::History) shard->spoolTypes |= 1u << (int)SpoolRecordType::BrowserUrl;
+            if (i == (int)DbShard::RequestLog) shard->spoolTypes |= 1u << (int)SpoolRecordType::UrlLog;
+            m_route[i] = shard;
+        }
+    }
+
+    bool ok = true;
+    for (auto& shard : m_shards) ok = OpenShard(*shard) && ok;
+    return ok;
+}
+
+//    (̹   ״)
+// Ű  Ͽ  ̷  ( ʴ ̺  )      ε  
+bool Database::OpenShard(Shard& s) {
+    std::lock_guard<std::mutex> lock(s.writeLock);
+    if (s.db) return true;
+
+    const char* dbPath = s.options.path.c_str();
+    sqlite3* db = nullptr;
+    int rc = sqlite3_open(dbPath, &db);
     if (rc != SQLITE_OK) {
-        printf("[DB] Create UrlLogs failed: %s\n", err ? err : "unknown");
-        if (err) sqlite3_free(err);
+        printf("[DB] Failed to open %s: %s\n", dbPath, sqlite3_errmsg(db));
+        sqlite3_close(db);
         return false;
     }
-    const char* sqlIdx = "CREATE INDEX IF NOT EXISTS idx_urllogs_pid_time ON UrlLogs(pid, timestamp);";
-    rc = sqlite3_exec(m_db, sqlIdx, nullptr, nullptr, &err);
-    if (rc != SQLITE_OK) {
-        printf("[DB] Create UrlLogs index failed: %s\n", err ? err : "unknown");
-        if (err) sqlite3_free(err);
+    {
+        std::lock_guard<std::mutex> handle(s.handleLock);
+        s.db = db;
+    }
+
+    // WAL:   ٸ  бⰡ ⸦  ʵ (DB Ͽ Ǵ )
+    if (sqlite3_exec(s.db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        printf("[DB] WAL mode unavailable: %s\n", sqlite3_errmsg(s.db));
     }
+    //   ̹Ƿ   
+    std::string sync = "PRAGMA synchronous=" + s.options.synchronous + ";";
+    if (sqlite3_exec(s.db, sync.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+        printf("[DB] %s failed: %s\n", sync.c_str(), sqlite3_errmsg(s.db));
+    }
+
+    // Ű ̸ֽ PRAGMA user_version   
+    s.migrator.reset(new SchemaMigrator(s.db));
+    RegisterMigrations(*s.migrator);
+    if (!s.migrator->Migrate()) {
+        s.migrator.reset();
+        ReleaseHandle(s);
+        return false;
+    }
+
+    s.spoolLoaded = false; // 翬   ġ DB ٽ 
+    printf("[DB] Opened: %s (synchronous=%s)\n", dbPath, s.options.synchronous.c_str());
     return true;
 }
 
+// db    (writeLock  ¿ ȣ, Interrupt  ڵ  ʵ)
+void Database::ReleaseHandle(Shard& s) {
+    sqlite3_finalize(s.insertUrlStmt);
+    sqlite3_finalize(s.touchUrlStmt);
+    s.insertUrlStmt = s.touchUrlStmt = nullptr;
+
+    sqlite3* db;
+    {
+        std::lock_guard<std::mutex> handle(s.handleLock);
+        db = s.db;
+        s.db = nullptr;
+    }
+    sqlite3_close(db);
+}
+
+void Database::Interrupt(DbShard shard) {
+    Shard* s = Route(shard);
+    if (!s) return;
+    std::lock_guard<std::mutex> handle(s->handleLock);
+    if (s->db) sqlite3_interrupt(s->db);
+}
+
+bool Database::IsOpen() {
+    std::lock_guard<std::mutex> lock(m_initLock);
+    if (m_shards.empty()) return false;
+    for (auto& shard : m_shards) {
+        std::lock_guard<std::mutex> handle(shard->handleLock);
+        if (!shard->db) return false;
+    }
+    return true;
+}
+
+std::string Database::GetPath(DbShard shard) {
+    Shard* s = Route(shard);
+    return s ? s->options.path : std::string();
+}
+
+bool Database::AttachShards(sqlite3* conn) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(conn, "ATTACH DATABASE ?1 AS ?2;", -1, &stmt, nullptr) != SQLITE_OK) {
+        AGENT_LOG_WARN("[DB] Prepare ATTACH failed: %s", sqlite3_errmsg(conn));
+        return false;
+    }
+    bool ok = true;
+    for (int i = 0; i < (int)DbShard::Count && ok; i++) {
+        std::string path = GetPath((DbShard)i);
+        sqlite3_bind_text(stmt, 1, path.c_str(), (int)path.size(), SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, kShardNames[i], -1, SQLITE_STATIC);
+        if (path.empty() || sqlite3_step(stmt) != SQLITE_DONE) {
+            AGENT_LOG_WARN("[DB] ATTACH %s failed: %s", kShardNames[i], sqlite3_errmsg(conn));
+            ok = false;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+// ׶ ̱׷̼ ûũ ϳ  (帶   ª  ̺Ʈ   )
+bool Database::RunBackgroundMigrations(int maxRows) {
+    bool more = false;
+    for (auto& shard : m_shards) {
+        Shard& s = *shard;
+        WATCHDOG_STAGE(kReplayStages[(int)s.primary], kReplayBudgetMs);
+        std::lock_guard<std::mutex> lock(s.writeLock);
+        if (s.db && s.migrator && s.migrator->RunBackgroundChunk(maxRows)) more = true;
+    }
+    return more;
+}
+
+// ͺ̽ ݱ
+void Database::Close() {
+    std::lock_guard<std::mutex> lock(m_initLock);
+    for (auto& shard : m_shards) {
+        Shard& s = *shard;
+        std::lock_guard<std::mutex> write(s.writeLock);
+        if (!s.db) continue;
+        s.migrator.reset();
+        ReleaseHandle(s);
+        printf("[DB] Closed: %s\n", s.options.path.c_str());
+    }
+}
+
+// Ǯ  尡  ݿ  ڵ尡 ִ (     ̺Ʈ Ǯ)
+bool Database::ShardPending(Shard& s) const {
+    if (!m_spool) return false;
+    if (!s.spoolLoaded) return m_spool->HasPending(); //  ġ б  Ǯ ü 
+    return m_spool->HasPendingAfter(s.spoolGeneration, s.spoolOffset);
+}
+
 // ɼ Row 
 bool Database::SaveOptions(int seq, int opt1, int opt2, int opt3) {
-    if (!m_db) return false;
+    Shard* s = Route(DbShard::Config);
+    if (!s) return false;
+    WATCHDOG_STAGE(kWriteStages[(int)DbShard::Config], kWriteBudgetMs);
+    std::lock_guard<std::mutex> lock(s->writeLock);
+    if (!s->db) return false;
     const char* sql = "INSERT INTO Options (OPT1, OPT2, OPT3, SEQ) VALUES (?, ?, ?, ?);";
     sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr);
+    int rc = sqlite3_prepare_v2(s->db, sql, -1, &stmt, nullptr);
     if (rc != SQLITE_OK) {
-        printf("[DB] Prepare failed: %s\n", sqlite3_errmsg(m_db));
+        AGENT_LOG_ERROR("[DB] Prepare failed: %s", sqlite3_errmsg(s->db));
         return false;
     }
 	sqlite3_bind_int(stmt, 1, opt1); //ù° ? opt1 ε
@@ -145,21 +424,24 @@ bool Database::SaveOptions(int seq, int opt1, int opt2, int opt3) {
     rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
     if (rc != SQLITE_DONE) {
-        printf("[DB] Insert failed: %s\n", sqlite3_errmsg(m_db));
+        AGENT_LOG_ERROR("[DB] Insert failed: %s", sqlite3_errmsg(s->db));
         return false;
     }
-    printf("[DB] Saved:[SEQ=%d] OPT1=%d OPT2=%d OPT3=%d\n", seq, opt1, opt2, opt3);
+    AGENT_LOG_DEBUG("[DB] Saved:[SEQ=%d] OPT1=%d OPT2=%d OPT3=%d", seq, opt1, opt2, opt3);
     return true;
 }
 
 // ֽ ɼ Row ε
 bool Database::LoadOptions(int& opt1, int& opt2, int& opt3) {
-    if (!m_db) return false;
+    Shard* s = Route(DbShard::Config);
+    if (!s) return false;
+    std::lock_guard<std::mutex> lock(s->writeLock);
+    if (!s->db) return false;
     const char* sql = "SELECT OPT1, OPT2, OPT3 FROM Options ORDER BY id DESC LIMIT 1;";
     sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr);
+    int rc = sqlite3_prepare_v2(s->db, sql, -1, &stmt, nullptr);
     if (rc != SQLITE_OK) {
-        printf("[DB] Prepare failed: %s\n", sqlite3_errmsg(m_db));
+        AGENT_LOG_ERROR("[DB] Prepare failed: %s", sqlite3_errmsg(s->db));
         return false;
     }
     rc = sqlite3_step(stmt);
@@ -173,145 +455,401 @@ bool Database::LoadOptions(int& opt1, int& opt2, int& opt3) {
     sqlite3_finalize(stmt);
     return false;
 }
-
 // URL α 
 bool Database::SaveUrlLog(const char* procName, int pid, const char* method,
     const char* scheme, const char* host, int port,
-    const char* path, const char* fullUrl) {
-    if (!m_db) return false;
-    const char* sql =
-        "INSERT INTO UrlLogs (proc_name, pid, method, scheme, host, port, path, full_url) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        printf("[DB] Prepare UrlLog failed: %s\n", sqlite3_errmsg(m_db));
-        return false;
+    const char* path, const char* fullUrl, int hitCount) {
+    UrlLogRow row;
+    row.procName = procName ? procName : "";
+    row.nProc = (uint32_t)strlen(row.procName);
+    row.pid = pid;
+    row.method = method ? method : "";
+    row.nMethod = (uint32_t)strlen(row.method);
+    row.scheme = scheme ? scheme : "";
+    row.nScheme = (uint32_t)strlen(row.scheme);
+    row.host = host ? host : "";
+    row.nHost = (uint32_t)strlen(row.host);
+    row.port = port;
+    row.path = path ? path : "";
+    row.nPath = (uint32_t)strlen(row.path);
+    row.fullUrl = fullUrl ? fullUrl : "";
+    row.nFullUrl = (uint32_t)strlen(row.fullUrl);
+    row.hitCount = hitCount;
+
+    Shard* s = Route(DbShard::RequestLog);
+    WATCHDOG_STAGE(kWriteStages[(int)DbShard::RequestLog], kWriteBudgetMs);
+    if (m_spool) {
+        // ÷ ̰ų DB ϸ ٸ ʰ Ǯ  (̹ݿ ڵ尡     Ǯ)
+        if (s) {
+            std::unique_lock<std::mutex> lock(s->writeLock, std::try_to_lock);
+            if (lock.owns_lock() && s->db && !ShardPending(*s)) {
+                int rc = InsertUrlLogs(*s, &row, 1);
+                if (rc == SQLITE_DONE) return true;
+                if (!IsTransientError(rc)) return false;
+            }
+        }
+        return SpoolUrlLog(row);
     }
-	sqlite3_bind_text(stmt, 1, procName ? procName : "", -1, SQLITE_TRANSIENT); //ù° ? procName ε
-    sqlite3_bind_int(stmt, 2, pid);
-    sqlite3_bind_text(stmt, 3, method ? method : "", -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, scheme ? scheme : "", -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 5, host ? host : "", -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 6, port);
-    sqlite3_bind_text(stmt, 7, path ? path : "", -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 8, fullUrl ? fullUrl : "", -1, SQLITE_TRANSIENT);
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    if (rc != SQLITE_DONE) {
-        printf("[DB] Insert UrlLog failed: %s\n", sqlite3_errmsg(m_db));
-        return false;
+    if (!s) return false;
+    std::lock_guard<std::mutex> lock(s->writeLock);
+    if (!s->db) return false;
+    return InsertUrlLogs(*s, &row, 1) == SQLITE_DONE;
+}
+
+// URL α  :  Ʈ + غ   (뷮 )
+bool Database::SaveUrlLogBatch(const std::vector<UrlLogRow>& rows) {
+    if (rows.empty()) return true;
+
+    Shard* s = Route(DbShard::RequestLog);
+    WATCHDOG_STAGE(kWriteStages[(int)DbShard::RequestLog], kWriteBudgetMs);
+    if (s) {
+        std::lock_guard<std::mutex> lock(s->writeLock);
+        if (s->db && !ShardPending(*s)) {
+            int rc = InsertUrlLogs(*s, rows.data(), rows.size());
+            if (rc == SQLITE_DONE) return true;
+            if (!m_spool || !IsTransientError(rc)) return false;
+        }
     }
-    printf("[DB] UrlLog saved: %s\n", fullUrl ? fullUrl : "");
-    return true;
+    if (!m_spool) return false;
+
+    bool ok = true;
+    for (const UrlLogRow& row : rows) ok = SpoolUrlLog(row) && ok;
+    return ok;
 }
 
-bool Database::CreateBrowserUrlsTable() {
-    const char* sql =
-        "CREATE TABLE IF NOT EXISTS BrowserUrls ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-        "browser_name TEXT NOT NULL, "
-        "url TEXT NOT NULL, "
-        "window_title TEXT, "
-        "timestamp DATETIME DEFAULT CURRENT_TIMESTAMP"
-        ");";
+bool Database::SpoolUrlLog(const UrlLogRow& row) {
+    SpoolField fields[] = {
+        { row.procName, row.nProc }, { &row.pid, sizeof(row.pid) }, { row.method, row.nMethod },
+        { row.scheme, row.nScheme }, { row.host, row.nHost }, { &row.port, sizeof(row.port) },
+        { row.path, row.nPath }, { row.fullUrl, row.nFullUrl }, { &row.hitCount, sizeof(row.hitCount) }
+    };
+    return m_spool->Append(SpoolRecordType::UrlLog, fields, sizeof(fields) / sizeof(fields[0]));
+}
 
-    char* err = nullptr;
-    int rc = sqlite3_exec(m_db, sql, nullptr, nullptr, &err);
+// UrlLogs INSERT (s.writeLock  ¿ ȣ), ȯ: sqlite  ڵ
+// count > 1̸ ü Ʈ  (÷ó ̹ Ʈ ̸ 1Ǿ ȣ)
+int Database::InsertUrlLogs(Shard& s, const UrlLogRow* rows, size_t count) {
+    const char* sql =
+        "INSERT INTO UrlLogs (proc_name, pid, method, scheme, host, port, path, full_url, hit_count) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    sqlite3_stmt* stmt = nullptr;
+    int rc = sqlite3_prepare_v2(s.db, sql, -1, &stmt, nullptr);
     if (rc != SQLITE_OK) {
-        printf("[DB] Create BrowserUrls table failed: %s\n", err ? err : "unknown");
-        if (err) sqlite3_free(err);
-        return false;
+        AGENT_LOG_ERROR("[DB] Prepare UrlLog failed: %s", sqlite3_errmsg(s.db));
+        return rc;
     }
 
-    const char* sqlIdx = "CREATE INDEX IF NOT EXISTS idx_urls_timestamp ON BrowserUrls(timestamp);";
-    sqlite3_exec(m_db, sqlIdx, nullptr, nullptr, nullptr);
+    bool txn = count > 1;
+    if (txn && (rc = sqlite3_exec(s.db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr)) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return rc;
+    }
 
-    return true;
+    rc = SQLITE_DONE;
+    for (size_t i = 0; i < count && rc == SQLITE_DONE; i++) {
+        const UrlLogRow& r = rows[i];
+        sqlite3_bind_text(stmt, 1, r.procName, (int)r.nProc, SQLITE_STATIC); //ù° ? procName ε
+        sqlite3_bind_int(stmt, 2, r.pid);
+        sqlite3_bind_text(stmt, 3, r.method, (int)r.nMethod, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, r.scheme, (int)r.nScheme, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 5, r.host, (int)r.nHost, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 6, r.port);
+        sqlite3_bind_text(stmt, 7, r.path, (int)r.nPath, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 8, r.fullUrl, (int)r.nFullUrl, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 9, r.hitCount);
+        rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        AGENT_LOG_ERROR("[DB] Insert UrlLog failed: %s", sqlite3_errmsg(s.db));
+        if (txn) sqlite3_exec(s.db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return rc;
+    }
+    if (txn && (rc = sqlite3_exec(s.db, "COMMIT;", nullptr, nullptr, nullptr)) != SQLITE_OK) {
+        AGENT_LOG_ERROR("[DB] Commit UrlLog batch failed: %s", sqlite3_errmsg(s.db));
+        sqlite3_exec(s.db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return rc;
+    }
+    AGENT_LOG_DEBUG("[DB] UrlLog saved: %zu rows", count);
+    return SQLITE_DONE;
 }
 
 bool Database::SaveBrowserUrl(
     const std::wstring& browserName,
     const std::wstring& url,
-    const std::wstring& windowTitle)
+    const std::wstring& windowTitle,
+    const std::wstring& rawUrl,
+    int64_t* rowIdOut,
+    int changeCount)
 {
-    if (!m_db) return false;
+    // UTF-16  UTF-8 ȯ: 庰  ϳ  ʵ带  н 
+    thread_local std::vector<char> scratch;
+    size_t need = Utf8CapacityFor(browserName.size() + url.size() + windowTitle.size() + rawUrl.size());
+    if (scratch.size() < need + 1) scratch.resize(need + 1); //  ڿ NULL ƴ '' εǵ ּ 1Ʈ
+
+    char* p = scratch.data();
+    size_t cap = scratch.size();
+    BrowserUrlRow row;
+    row.nBrowser = (uint32_t)TranscodeUtf16ToUtf8(browserName.data(), browserName.size(), p, cap);
+    row.nUrl = (uint32_t)TranscodeUtf16ToUtf8(url.data(), url.size(), p + row.nBrowser, cap - row.nBrowser);
+    size_t used = row.nBrowser + row.nUrl;
+    row.nTitle = (uint32_t)TranscodeUtf16ToUtf8(windowTitle.data(), windowTitle.size(), p + used, cap - used);
+    used += row.nTitle;
+    row.nRaw = (uint32_t)TranscodeUtf16ToUtf8(rawUrl.data(), rawUrl.size(), p + used, cap - used);
+    row.browser = p;
+    row.url = p + row.nBrowser;
+    row.title = row.url + row.nUrl;
+    row.raw = row.title + row.nTitle;
+    row.changeCount = changeCount;
+    return SaveBrowserUrl(row, rowIdOut);
+}
 
-    const char* sql =
-        "INSERT INTO BrowserUrls (browser_name, url, window_title) "
-        "VALUES (?, ?, ?);";
+bool Database::SaveBrowserUrl(const BrowserUrlRow& row, int64_t* rowIdOut) {
+    TRACE_SPAN("Database::SaveBrowserUrl");
+    Shard* s = Route(DbShard::History);
+    WATCHDOG_STAGE(kWriteStages[(int)DbShard::History], kWriteBudgetMs);
+    if (rowIdOut) *rowIdOut = 0;
+    if (!s && !m_spool) return false;
+
+    if (m_spool) {
+        if (s) {
+            std::unique_lock<std::mutex> lock(s->writeLock, std::try_to_lock);
+            if (lock.owns_lock() && s->db && !ShardPending(*s)) {
+                int rc = InsertBrowserUrl(*s, row, rowIdOut);
+                if (rc == SQLITE_DONE) return true;
+                if (!IsTransientError(rc)) return false;
+            }
+        }
+        SpoolField fields[] = { { row.browser, row.nBrowser }, { row.url, row.nUrl }, { row.title, row.nTitle },
+            { row.raw, row.nRaw }, { &row.changeCount, sizeof(row.changeCount) } };
+        return m_spool->Append(SpoolRecordType::BrowserUrl, fields, sizeof(fields) / sizeof(fields[0]));
+    }
 
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        printf("[DB] Prepare BrowserUrl failed: %s\n", sqlite3_errmsg(m_db));
+    std::lock_guard<std::mutex> lock(s->writeLock);
+    if (!s->db) return false;
+    return InsertBrowserUrl(*s, row, rowIdOut) == SQLITE_DONE;
+}
+
+bool Database::TouchBrowserUrl(int64_t rowId, const char* title, uint32_t nTitle) {
+    TRACE_SPAN("Database::TouchBrowserUrl");
+    Shard* s = Route(DbShard::History);
+    if (!s) return false;
+    WATCHDOG_STAGE(kWriteStages[(int)DbShard::History], kWriteBudgetMs);
+
+    //  ο   ٻڰų Ǯ и ڵ尡  ٸ 
+    std::unique_lock<std::mutex> lock(s->writeLock, std::try_to_lock);
+    if (!lock.owns_lock() || !s->db || ShardPending(*s)) return false;
+
+    sqlite3_stmt* stmt = CachedStatement(s->db, s->touchUrlStmt,
+        "UPDATE BrowserUrls SET visit_count = visit_count + 1, last_seen = CURRENT_TIMESTAMP, "
+        "window_title = ? WHERE id = ?;");
+    if (!stmt) {
+        AGENT_LOG_ERROR("[DB] Prepare visit update failed: %s", sqlite3_errmsg(s->db));
         return false;
     }
+    sqlite3_bind_text(stmt, 1, title ? title : "", (int)nTitle, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, rowId);
 
-    // UTF-16  UTF-8 ȯ ( WideCharToMultiByte )
-    auto toUtf8 = [](const std::wstring& ws) -> std::string {
-        if (ws.empty()) return "";
-        int len = WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, nullptr, 0, nullptr, nullptr);
-        std::string result(len, 0);
-        WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, &result[0], len, nullptr, nullptr);
-        result.resize(strlen(result.c_str()));
-        return result;
-        };
-
-    std::string browser = toUtf8(browserName);
-    std::string urlUtf8 = toUtf8(url);
-    std::string title = toUtf8(windowTitle);
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt); // SQLITE_STATIC ε ȣ  ۸  Ű ʵ
+    return rc == SQLITE_DONE && sqlite3_changes(s->db) == 1;
+}
+// BrowserUrls INSERT (s.writeLock  ¿ ȣ), ȯ: sqlite  ڵ
+// nRaw == 0̸ raw_url NULL ( URL )
+int Database::InsertBrowserUrl(Shard& s, const BrowserUrlRow& row, int64_t* rowIdOut) {
+    sqlite3_stmt* stmt = CachedStatement(s.db, s.insertUrlStmt,
+        "INSERT INTO BrowserUrls (browser_name, url, window_title, raw_url, change_count) "
+        "VALUES (?, ?, ?, ?, ?);");
+    if (!stmt) {
+        int rc = sqlite3_errcode(s.db);
+        AGENT_LOG_ERROR("[DB] Prepare BrowserUrl failed: %s", sqlite3_errmsg(s.db));
+        return rc != SQLITE_OK ? rc : SQLITE_ERROR;
+    }
 
-    sqlite3_bind_text(stmt, 1, browser.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, urlUtf8.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, title.c_str(), -1, SQLITE_TRANSIENT);
+    //  ۴ step  ȿϹǷ   ε
+    sqlite3_bind_text(stmt, 1, row.browser, (int)row.nBrowser, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, row.url, (int)row.nUrl, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, row.title, (int)row.nTitle, SQLITE_STATIC);
+    if (row.nRaw > 0) sqlite3_bind_text(stmt, 4, row.raw, (int)row.nRaw, SQLITE_STATIC);
+    else sqlite3_bind_null(stmt, 4);
+    sqlite3_bind_int(stmt, 5, row.changeCount > 0 ? row.changeCount : 1);
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
 
     if (rc != SQLITE_DONE) {
-        printf("[DB] Insert BrowserUrl failed: %s\n", sqlite3_errmsg(m_db));
+        AGENT_LOG_ERROR("[DB] Insert BrowserUrl failed: %s", sqlite3_errmsg(s.db));
+    }
+    else if (rowIdOut) {
+        *rowIdOut = sqlite3_last_insert_rowid(s.db);
+    }
+    return rc;
+}
+
+// Ǯ ڵ 1 ش ̺ INSERT. ջ ڵ false + rc=SQLITE_CORRUPT
+bool Database::ApplySpoolRecord(Shard& s, int type, const unsigned char* data, uint32_t size, int& rc) {
+    SpoolFieldReader reader(data, size);
+    rc = SQLITE_CORRUPT;
+
+    if (type == (int)SpoolRecordType::BrowserUrl) {
+        BrowserUrlRow row;
+        if (!reader.NextString(row.browser, row.nBrowser) || !reader.NextString(row.url, row.nUrl) ||
+            !reader.NextString(row.title, row.nTitle))
+            return false;
+        if (!reader.NextString(row.raw, row.nRaw)) { row.raw = ""; row.nRaw = 0; } // raw_url ʵ  ϵ ڵ
+        else if (!reader.NextInt(row.changeCount)) row.changeCount = 1;          // change_count ʵ  ϵ ڵ
+        rc = InsertBrowserUrl(s, row);
+    }
+    else if (type == (int)SpoolRecordType::UrlLog) {
+        UrlLogRow row;
+        if (!reader.NextString(row.procName, row.nProc) || !reader.NextInt(row.pid) ||
+            !reader.NextString(row.method, row.nMethod) || !reader.NextString(row.scheme, row.nScheme) ||
+            !reader.NextString(row.host, row.nHost) || !reader.NextInt(row.port) ||
+            !reader.NextString(row.path, row.nPath) || !reader.NextString(row.fullUrl, row.nFullUrl))
+            return false;
+        if (!reader.NextInt(row.hitCount)) row.hitCount = 1; //  ʵ  ϵ ڵ
+        rc = InsertUrlLogs(s, &row, 1);
+    }
+    else {
         return false;
     }
+    return rc == SQLITE_DONE;
+}
 
-    return true;
+// Ǯ  DB ġ ݿ (Ǯ ڵ带 ޴ 帶)
+// 帶 ڱ ڵ INSERT  ġ   Ʈ ĿϹǷ
+// ÷  Ǿ ߺ/  庰  Ŀ ġ 簳
+// Ǯ ü ݿ ġ  ó   ( 尡 ݿؾ Ǯ )
+int Database::ReplaySpool(size_t maxRecords) {
+    if (!m_spool || !m_spool->IsOpen()) return 0;
+
+    int applied = 0;
+    bool failed = false;
+    bool allLoaded = true;
+    uint64_t generation = m_spool->Generation();
+    uint64_t replayed = UINT64_MAX;
+    for (auto& shard : m_shards) {
+        Shard& s = *shard;
+        if (!s.spoolTypes) continue;
+        int n = ReplayShard(s, maxRecords);
+        if (n < 0) failed = true;
+        else applied += n;
+
+        std::lock_guard<std::mutex> lock(s.writeLock);
+        if (!s.spoolLoaded) allLoaded = false;
+        else if (s.spoolGeneration != generation) replayed = 0; // 밡 ٲ   ݿ 
+        else if (s.spoolOffset < replayed) replayed = s.spoolOffset;
+    }
+    if (allLoaded && replayed != UINT64_MAX) m_spool->MarkReplayed(replayed);
+
+    if (applied == 0 && failed) return -1;
+    return applied;
+}
+
+//  ϳ ġ ݿ. ȯ: а Ѿ ڵ  (ٸ  ڵ ), DB  Ұ  -1
+int Database::ReplayShard(Shard& s, size_t maxRecords) {
+    WATCHDOG_STAGE(kReplayStages[(int)s.primary], kReplayBudgetMs);
+    std::lock_guard<std::mutex> lock(s.writeLock);
+    if (!s.db) return -1;
+
+    uint64_t generation = m_spool->Generation();
+    if (!s.spoolLoaded) {
+        uint64_t start = m_spool->DataStart();
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(s.db, "SELECT generation, offset FROM SpoolProgress WHERE id = 1;", -1, &stmt, nullptr) != SQLITE_OK)
+            return -1;
+        if (sqlite3_step(stmt) == SQLITE_ROW &&
+            (uint64_t)sqlite3_column_int64(stmt, 0) == generation) {
+            start = (uint64_t)sqlite3_column_int64(stmt, 1); //   ̾, ƴϸ ó
+        }
+        sqlite3_finalize(stmt);
+        s.spoolGeneration = generation;
+        s.spoolOffset = start;
+        s.spoolLoaded = true;
+    }
+    else if (s.spoolGeneration != generation) {
+        //  尡 ݿ  Ǯ ó ٽ ̴ 
+        s.spoolGeneration = generation;
+        s.spoolOffset = m_spool->DataStart();
+    }
+
+    std::vector<SpoolRecord> records;
+    if (m_spool->Read(s.spoolOffset, maxRecords, records) == 0) return 0;
+
+    if (sqlite3_exec(s.db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK)
+        return -1;
+
+    int applied = 0;
+    for (const SpoolRecord& rec : records) {
+        if (!(s.spoolTypes & (1u << (int)rec.type))) continue; // ٸ  ڵ
+        int rc = SQLITE_OK;
+        if (ApplySpoolRecord(s, (int)rec.type, rec.data, rec.size, rc)) {
+            applied++;
+            continue;
+        }
+        if (IsTransientError(rc)) {
+            sqlite3_exec(s.db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            return -1;
+        }
+        AGENT_LOG_WARN("[DB] Spool record skipped (type=%d, rc=%d)", (int)rec.type, rc);
+    }
+
+    uint64_t next = records.back().nextOffset;
+    sqlite3_stmt* stmt = nullptr;
+    int rc = sqlite3_prepare_v2(s.db,
+        "INSERT OR REPLACE INTO SpoolProgress (id, generation, offset) VALUES (1, ?, ?);", -1, &stmt, nullptr);
+    if (rc == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, (sqlite3_int64)generation);
+        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)next);
+        rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+    if (rc != SQLITE_DONE || sqlite3_exec(s.db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        AGENT_LOG_ERROR("[DB] Spool replay commit failed: %s", sqlite3_errmsg(s.db));
+        sqlite3_exec(s.db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return -1;
+    }
+
+    s.spoolOffset = next;
+    AGENT_LOG_DEBUG("[DB] Spool replayed %d of %zu records into %s", applied, records.size(),
+        kShardNames[(int)s.primary]);
+    return (int)records.size();
 }
 
 std::vector<std::tuple<std::wstring, std::wstring, std::wstring>>
 Database::GetRecentUrls(int count) {
     std::vector<std::tuple<std::wstring, std::wstring, std::wstring>> result;
-    if (!m_db) return result;
+    Shard* s = Route(DbShard::History);
+    if (!s) return result;
+    std::lock_guard<std::mutex> lock(s->writeLock);
+    if (!s->db) return result;
 
     const char* sql =
         "SELECT browser_name, url, window_title FROM BrowserUrls "
         "ORDER BY timestamp DESC LIMIT ?;";
 
     sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(s->db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
         return result;
     }
 
     sqlite3_bind_int(stmt, 1, count);
 
-    auto toWide = [](const char* utf8) -> std::wstring {
-        if (!utf8) return L"";
-        int len = MultiByteToWideChar(CP_UTF8, 0, utf8, -1, nullptr, 0);
-        std::wstring ws(len, 0);
-        MultiByteToWideChar(CP_UTF8, 0, utf8, -1, &ws[0], len);
-        ws.resize(wcslen(ws.c_str()));
-        return ws;
-        };
-
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         const char* browser = (const char*)sqlite3_column_text(stmt, 0);
         const char* url = (const char*)sqlite3_column_text(stmt, 1);
         const char* title = (const char*)sqlite3_column_text(stmt, 2);
 
+        // ÷ Ʈ ̸ ״  (strlen/wcslen  ʿ)
         result.push_back(std::make_tuple(
-            toWide(browser),
-            toWide(url),
-            toWide(title)
+            Utf8ToUtf16(browser, sqlite3_column_bytes(stmt, 0)),
+            Utf8ToUtf16(url, sqlite3_column_bytes(stmt, 1)),
+            Utf8ToUtf16(title, sqlite3_column_bytes(stmt, 2))
         ));
     }
 
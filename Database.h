@@ -1,39 +1,148 @@
 #pragma once
 #include <sqlite3.h>
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include <tuple>
+#include <mutex>
+#include <memory>
 
+class EventSpool;
+class SchemaMigrator;
+
+// ۾  DB  ( 尡   Ű  ϳ )
+enum class DbShard {
+    Config,     // Options: ڰ (UserOptionResponse) ٸ  
+    History,    // BrowserUrls:  ̷ ( )
+    RequestLog, // UrlLogs: ŷ μ û  (뷮)
+    Count
+};
+
+//  ϳ ϰ  
+struct DbShardOptions {
+    std::string path;
+    std::string synchronous = "FULL"; // PRAGMA synchronous (WAL + NORMAL:     ĿԵ鸸  )
+};
+
+// 庰 DB  ġ
+struct DatabaseLayout {
+    DbShardOptions shards[(int)DbShard::Count];
+
+    //  ۾  ,  ϳ ( ġ)
+    static DatabaseLayout SingleFile(const char* path);
+    // dir Ʒ ۾ : AgentOptions.db(, FULL), AgentHistory.db / AgentRequests.db(NORMAL)
+    static DatabaseLayout Sharded(const char* dir);
+};
+
+// UrlLogs   (ڿ UTF-8,  )
+struct UrlLogRow {
+    const char* procName = ""; uint32_t nProc = 0;
+    int pid = 0;
+    const char* method = ""; uint32_t nMethod = 0;
+    const char* scheme = ""; uint32_t nScheme = 0;
+    const char* host = ""; uint32_t nHost = 0;
+    int port = 0;
+    const char* path = ""; uint32_t nPath = 0;
+    const char* fullUrl = ""; uint32_t nFullUrl = 0;
+    int hitCount = 1;
+};
+
+// BrowserUrls   (ڿ UTF-8,  ). nRaw == 0̸ raw_url NULL
+struct BrowserUrlRow {
+    const char* browser = ""; uint32_t nBrowser = 0;
+    const char* url = ""; uint32_t nUrl = 0;
+    const char* title = ""; uint32_t nTitle = 0;
+    const char* raw = ""; uint32_t nRaw = 0;
+    int changeCount = 1;
+};
+
+// 帶 ,  , غ , Ű, Ǯ ÷  ġ  
+//  ̷/û   ְ ɼ ( ) ٸ  
 class Database {
 public:
     Database();
     ~Database();
 
-    bool Initialize(const char* dbPath);
+    bool Initialize(const char* dbPath); // SingleFile ġ
+    // ù ȣ⿡    ( ȣ  常 ٽ ). ȯ:  尡  true
+    bool Initialize(const DatabaseLayout& layout);
     void Close();
+    bool IsOpen(); //  尡   true
+
+    //  ῡ   SQL ߴ (ٸ 忡 ȣ ). ߴܵ  Ǯ 
+    void Interrupt(DbShard shard);
+
+    // ñ ܰ ̸ (庰): /÷̰  ѱ   ( ڵ鷯 Interrupt ȣ)
+    static const char* WriteStage(DbShard shard);
+    static const char* ReplayStage(DbShard shard);
+
+    //  DB   (б  ,  ̸  ڿ)
+    std::string GetPath(DbShard shard = DbShard::Config);
+
+    //  ῡ    "config", "history", "requests" Ű ATTACH
+    // ġ  history.BrowserUrls JOIN requests.UrlLogs    ȸ  ( ̸     ATTACH)
+    bool AttachShards(sqlite3* conn);
+    static const char* SchemaName(DbShard shard);
+
+    // ¶  ̱׷̼ ûũ . ȯ:  ۾  true
+    bool RunBackgroundMigrations(int maxRows);
+    // ׶ ̱׷̼ ̸ (SchemaBackgroundMigrations.name)
+    static const char* const kCanonicalUrlMigration; // v8  BrowserUrls.url ȭ
+
+    // DB ϰų ٻ  URL ̺Ʈ  Ǯ  (nullptr̸  )
+    void AttachSpool(EventSpool* spool) { m_spool = spool; }
+
+    // Ǯ ڵ带 ִ maxRecords DB ݿ ( ġ  Ʈ)
+    // ȯ: ݿ ڵ , DB  Ұ  -1
+    int ReplaySpool(size_t maxRecords);
 
     bool SaveOptions(int seq, int opt1, int opt2, int opt3);
     bool LoadOptions(int& opt1, int& opt2, int& opt3);
 
     bool SaveUrlLog(const char* procName, int pid, const char* method,
         const char* scheme, const char* host, int port,
-        const char* path, const char* fullUrl);
+        const char* path, const char* fullUrl, int hitCount = 1);
 
-    //  URL ̺ 
-    bool CreateBrowserUrlsTable();
+    //    Ʈ  (DB   Ǯ)
+    bool SaveUrlLogBatch(const std::vector<UrlLogRow>& rows);
 
-    // URL 
+    // URL . url:  URL, rawUrl: ٸ  ϴ  (  raw_url NULL)
+    // rowIdOut: DB ٷ   id (Ǯ ϵǾ 0), changeCount: յ  
     bool SaveBrowserUrl(
         const std::wstring& browserName,
         const std::wstring& url,
-        const std::wstring& windowTitle
+        const std::wstring& windowTitle,
+        const std::wstring& rawUrl = std::wstring(),
+        int64_t* rowIdOut = nullptr,
+        int changeCount = 1
     );
 
+    // ̹ UTF-8   (UrlEvent ۸   ε)
+    bool SaveBrowserUrl(const BrowserUrlRow& row, int64_t* rowIdOut = nullptr);
+
+    // 湮:   visit_count , last_seen/window_title 
+    // DB ٻڰų   false (ȣ    )
+    bool TouchBrowserUrl(int64_t rowId, const char* title, uint32_t nTitle);
+
     // ֱ URL ȸ ()
     std::vector<std::tuple<std::wstring, std::wstring, std::wstring>> GetRecentUrls(int count = 10);
 
 private:
-    sqlite3* m_db;
-    bool CreateTableIfNotExists();
-    bool CreateUrlLogsTableIfNotExists();
+    struct Shard; //  ϳ   (Database.cpp)
+
+    std::mutex m_initLock;                      //  //ݱ ȭ
+    std::vector<std::unique_ptr<Shard>> m_shards; // Ϻ, ù Initialize  Ҹ 
+    Shard* m_route[(int)DbShard::Count];        // ۾   (ù Initialize  Һ)
+    EventSpool* m_spool;
+
+    Shard* Route(DbShard shard) const { return m_route[(int)shard]; }
+    bool OpenShard(Shard& s);
+    void ReleaseHandle(Shard& s);
+    bool ShardPending(Shard& s) const;
+    int ReplayShard(Shard& s, size_t maxRecords);
+
+    int InsertUrlLogs(Shard& s, const UrlLogRow* rows, size_t count);
+    bool SpoolUrlLog(const UrlLogRow& row);
+    int InsertBrowserUrl(Shard& s, const BrowserUrlRow& row, int64_t* rowIdOut = nullptr);
+    bool ApplySpoolRecord(Shard& s, int type, const unsigned char* data, uint32_t size, int& rc);
 };
\ No newline at end of file
@@ -0,0 +1,312 @@
+﻿#include "EventSpool.h"
+#include "AsyncLogger.h"
+#include "Crc32.h"
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const uint32_t kSpoolMagic = 0x4C505341; // 'ASPL'
+    const uint32_t kSpoolVersion = 1;
+
+    // 파일 헤더 (64바이트 영역의 앞부분)
+    struct SpoolHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t generation; // 초기화(재사용)할 때마다 증가
+        uint64_t capacity;
+    };
+
+    // 레코드 헤더: [length][crc] 뒤에 type(1) + payload, 8바이트 정렬
+    // crc는 generation까지 포함하여 계산하므로 이전 세대의 잔여 레코드는 자동으로 무효
+    struct RecordHeader {
+        uint32_t length; // type + payload 바이트 수
+        uint32_t crc;
+    };
+
+    uint64_t Align8(uint64_t v) { return (v + 7) & ~(uint64_t)7; }
+}
+
+bool SpoolFieldReader::NextString(const char*& str, uint32_t& len) {
+    if (m_end - m_pos < 4) return false;
+    memcpy(&len, m_pos, 4);
+    m_pos += 4;
+    if ((uint64_t)(m_end - m_pos) < len) return false;
+    str = (const char*)m_pos;
+    m_pos += len;
+    return true;
+}
+
+bool SpoolFieldReader::NextInt(int& value) {
+    const char* p;
+    uint32_t len;
+    if (!NextString(p, len) || len != sizeof(int)) return false;
+    memcpy(&value, p, sizeof(int));
+    return true;
+}
+
+EventSpool::EventSpool()
+#ifdef _WIN32
+    : m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr), m_base(nullptr), m_capacity(0),
+#else
+    : m_file(-1), m_base(nullptr), m_capacity(0),
+#endif
+      m_writeOffset(kHeaderSize), m_replayedOffset(kHeaderSize), m_progressKnown(false) {
+}
+
+EventSpool::~EventSpool() {
+    Close();
+}
+
+bool EventSpool::Open(const char* path, uint32_t capacity) {
+    if (m_base) return true;
+
+#ifdef _WIN32
+    m_file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        printf("[Spool] Cannot open %s (err=%lu)\n", path, GetLastError());
+        return false;
+    }
+
+    // 기존 파일이 더 크면 그 크기를 유지 (레코드 보존)
+    LARGE_INTEGER size = {};
+    GetFileSizeEx(m_file, &size);
+    m_capacity = (uint64_t)size.QuadPart > capacity ? (uint64_t)size.QuadPart : capacity;
+    bool fresh = size.QuadPart < (LONGLONG)kHeaderSize;
+
+    if ((uint64_t)size.QuadPart < m_capacity) {
+        LARGE_INTEGER newSize;
+        newSize.QuadPart = (LONGLONG)m_capacity;
+        if (!SetFilePointerEx(m_file, newSize, nullptr, FILE_BEGIN) || !SetEndOfFile(m_file)) {
+            printf("[Spool] Cannot size %s (err=%lu)\n", path, GetLastError());
+            Close();
+            return false;
+        }
+    }
+
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (m_mapping)
+        m_base = (uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)m_capacity);
+    if (!m_base) {
+        printf("[Spool] Cannot map %s (err=%lu)\n", path, GetLastError());
+        Close();
+        return false;
+    }
+#else
+    m_file = open(path, O_RDWR | O_CREAT, 0644);
+    if (m_file < 0) {
+        printf("[Spool] Cannot open %s (err=%d)\n", path, errno);
+        return false;
+    }
+
+    struct stat st = {};
+    fstat(m_file, &st);
+    m_capacity = (uint64_t)st.st_size > capacity ? (uint64_t)st.st_size : capacity;
+    bool fresh = (uint64_t)st.st_size < kHeaderSize;
+
+    if ((uint64_t)st.st_size < m_capacity && ftruncate(m_file, (off_t)m_capacity) != 0) {
+        printf("[Spool] Cannot size %s (err=%d)\n", path, errno);
+        Close();
+        return false;
+    }
+
+    void* view = mmap(nullptr, (size_t)m_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+    if (view == MAP_FAILED) {
+        printf("[Spool] Cannot map %s (err=%d)\n", path, errno);
+        Close();
+        return false;
+    }
+    m_base = (uint8_t*)view;
+#endif
+
+    SpoolHeader* hdr = (SpoolHeader*)m_base;
+    if (fresh || hdr->magic != kSpoolMagic || hdr->version != kSpoolVersion) {
+        hdr->magic = kSpoolMagic;
+        hdr->version = kSpoolVersion;
+        hdr->generation = 1;
+        memset(m_base + kHeaderSize, 0, sizeof(RecordHeader));
+    }
+    hdr->capacity = m_capacity;
+
+    m_writeOffset = ScanForEnd();
+    m_replayedOffset = kHeaderSize;
+    m_progressKnown = false;
+
+    printf("[Spool] Opened: %s (generation=%llu, pending=%llu bytes)\n", path,
+        (unsigned long long)hdr->generation, (unsigned long long)(m_writeOffset - kHeaderSize));
+    return true;
+}
+
+void EventSpool::Close() {
+    std::lock_guard<std::mutex> lock(m_lock);
+#ifdef _WIN32
+    if (m_base) {
+        FlushViewOfFile(m_base, 0);
+        UnmapViewOfFile(m_base);
+        m_base = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+        FlushFileBuffers(m_file);
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (m_base) {
+        msync(m_base, (size_t)m_capacity, MS_SYNC);
+        munmap(m_base, (size_t)m_capacity);
+        m_base = nullptr;
+    }
+    if (m_file >= 0) {
+        fsync(m_file);
+        close(m_file);
+        m_file = -1;
+    }
+#endif
+}
+
+bool EventSpool::ValidRecordAt(uint64_t offset, uint64_t generation, uint32_t& payloadSize) const {
+    if (offset + sizeof(RecordHeader) > m_capacity) return false;
+
+    RecordHeader rh;
+    memcpy(&rh, m_base + offset, sizeof(rh));
+    if (rh.length == 0 || offset + sizeof(RecordHeader) + rh.length > m_capacity) return false;
+
+    uint32_t crc = Crc32(0, &generation, sizeof(generation));
+    crc = Crc32(crc, m_base + offset + sizeof(RecordHeader), rh.length);
+    if (crc != rh.crc) return false;
+
+    payloadSize = rh.length;
+    return true;
+}
+
+// 유효한 레코드가 끊기는 지점 = 쓰기 위치 (기록 도중 종료된 레코드는 crc 불일치로 버려짐)
+uint64_t EventSpool::ScanForEnd() const {
+    uint64_t generation = ((const SpoolHeader*)m_base)->generation;
+    uint64_t offset = kHeaderSize;
+    uint32_t length = 0;
+    while (ValidRecordAt(offset, generation, length))
+        offset = Align8(offset + sizeof(RecordHeader) + length);
+    return offset;
+}
+
+bool EventSpool::Append(SpoolRecordType type, const SpoolField* fields, size_t count) {
+    uint64_t length = 1; // type
+    for (size_t i = 0; i < count; i++) length += 4 + fields[i].size;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_base) return false;
+
+    uint64_t offset = m_writeOffset;
+    uint64_t next = Align8(offset + sizeof(RecordHeader) + length);
+    if (next + sizeof(RecordHeader) > m_capacity) {
+        AGENT_LOG_ERROR("[Spool] Full, event dropped (%llu bytes pending)",
+            (unsigned long long)(m_writeOffset - m_replayedOffset));
+        return false;
+    }
+
+    // 본문 → 다음 레코드 자리 종료 표시 → crc → length 순으로 기록
+    uint8_t* p = m_base + offset + sizeof(RecordHeader);
+    *p++ = (uint8_t)type;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(p, &fields[i].size, 4);
+        p += 4;
+        if (fields[i].size) memcpy(p, fields[i].data, fields[i].size);
+        p += fields[i].size;
+    }
+    memset(m_base + next, 0, sizeof(RecordHeader));
+
+    uint64_t generation = ((SpoolHeader*)m_base)->generation;
+    RecordHeader rh;
+    rh.length = (uint32_t)length;
+    rh.crc = Crc32(Crc32(0, &generation, sizeof(generation)), m_base + offset + sizeof(RecordHeader), (size_t)length);
+    memcpy(m_base + offset + 4, &rh.crc, 4);
+    memcpy(m_base + offset, &rh.length, 4);
+
+    m_writeOffset = next;
+    return true;
+}
+
+bool EventSpool::HasPending() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_base) return false;
+    if (!m_progressKnown) return m_writeOffset > kHeaderSize;
+    return m_writeOffset > m_replayedOffset;
+}
+
+bool EventSpool::HasPendingAfter(uint64_t generation, uint64_t offset) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_base) return false;
+    if (generation != ((const SpoolHeader*)m_base)->generation) offset = kHeaderSize;
+    return m_writeOffset > offset;
+}
+
+uint64_t EventSpool::Generation() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_base ? ((const SpoolHeader*)m_base)->generation : 0;
+}
+
+uint64_t EventSpool::ReplayedOffset() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_replayedOffset;
+}
+
+size_t EventSpool::Read(uint64_t offset, size_t maxRecords, std::vector<SpoolRecord>& out) const {
+    out.clear();
+
+    uint64_t end, generation;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_base) return 0;
+        end = m_writeOffset;
+        generation = ((const SpoolHeader*)m_base)->generation;
+    }
+
+    // 쓰기 위치 이전 영역은 더 이상 변경되지 않으므로 잠금 없이 읽음
+    while (offset < end && out.size() < maxRecords) {
+        uint32_t length = 0;
+        if (!ValidRecordAt(offset, generation, length)) break;
+
+        SpoolRecord rec;
+        const uint8_t* body = m_base + offset + sizeof(RecordHeader);
+        rec.type = (SpoolRecordType)body[0];
+        rec.data = body + 1;
+        rec.size = length - 1;
+        rec.nextOffset = Align8(offset + sizeof(RecordHeader) + length);
+        out.push_back(rec);
+        offset = rec.nextOffset;
+    }
+    return out.size();
+}
+
+void EventSpool::MarkReplayed(uint64_t offset) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (offset < kHeaderSize) offset = kHeaderSize;
+    if (offset > m_writeOffset) offset = m_writeOffset;
+    m_replayedOffset = offset;
+    m_progressKnown = true;
+}
+
+bool EventSpool::ResetIfDrained() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_base || !m_progressKnown) return false;
+    if (m_replayedOffset != m_writeOffset || m_writeOffset == kHeaderSize) return false;
+
+    // DB에는 이미 (이전 세대, 끝 위치)가 커밋되어 있으므로 어느 시점에 종료되어도 중복/유실 없음
+    SpoolHeader* hdr = (SpoolHeader*)m_base;
+    memset(m_base + kHeaderSize, 0, sizeof(RecordHeader));
+    hdr->generation++;
+    m_writeOffset = kHeaderSize;
+    m_replayedOffset = kHeaderSize;
+    return true;
+}
@@ -0,0 +1,95 @@
+﻿#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+// 스풀 레코드 종류
+enum class SpoolRecordType : uint8_t {
+    BrowserUrl = 1, // browser_name, url, window_title
+    UrlLog = 2      // proc_name, pid, method, scheme, host, port, path, full_url
+};
+
+// 레코드 필드 (문자열은 UTF-8, 정수는 4바이트로 저장)
+struct SpoolField {
+    const void* data;
+    uint32_t size;
+};
+
+// 리플레이용으로 읽어낸 레코드 (data는 매핑 영역을 가리킴)
+struct SpoolRecord {
+    SpoolRecordType type;
+    const uint8_t* data;
+    uint32_t size;
+    uint64_t nextOffset; // 이 레코드까지 반영했을 때의 진행 위치
+};
+
+// 레코드 페이로드 순차 디코더
+class SpoolFieldReader {
+public:
+    SpoolFieldReader(const uint8_t* data, uint32_t size) : m_pos(data), m_end(data + size) {}
+    bool NextString(const char*& str, uint32_t& len);
+    bool NextInt(int& value);
+
+private:
+    const uint8_t* m_pos;
+    const uint8_t* m_end;
+};
+
+// 메모리 매핑 기반 append-only 스풀 저널
+// - DB가 느리거나 실패할 때 이벤트를 체크섬 + 길이 접두 레코드로 기록
+// - 에이전트가 비정상 종료되어도 매핑된 페이지는 OS가 파일에 기록하므로 유실 없음
+// - 열 때 레코드를 검증하며 스캔하여 마지막 유효 레코드 뒤를 쓰기 위치로 복구
+// - 리플레이 진행 위치는 DB에 (generation, offset)으로 저장 (Database::ReplaySpool 참고)
+class EventSpool {
+public:
+    EventSpool();
+    ~EventSpool();
+
+    bool Open(const char* path, uint32_t capacity = 32 * 1024 * 1024);
+    void Close();
+    bool IsOpen() const { return m_base != nullptr; }
+
+    // 레코드 추가 (가득 차면 false)
+    bool Append(SpoolRecordType type, const SpoolField* fields, size_t count);
+
+    // 아직 DB에 반영되지 않은 레코드가 있는지 (있으면 순서 보장을 위해 새 이벤트도 스풀로)
+    bool HasPending() const;
+    // (generation, offset)까지 반영한 소비자(DB 샤드)에게 남은 레코드가 있는지. 세대가 다르면 처음부터 기준
+    bool HasPendingAfter(uint64_t generation, uint64_t offset) const;
+
+    uint64_t Generation() const;
+    uint64_t ReplayedOffset() const;
+    uint64_t DataStart() const { return kHeaderSize; }
+
+    // offset부터 최대 maxRecords개 읽기 (리플레이 스레드 전용)
+    size_t Read(uint64_t offset, size_t maxRecords, std::vector<SpoolRecord>& out) const;
+
+    // 리플레이 진행 위치 반영 (DB 커밋 후 호출)
+    void MarkReplayed(uint64_t offset);
+
+    // 모두 반영되었으면 세대를 올리고 처음부터 다시 사용
+    bool ResetIfDrained();
+
+private:
+    static const uint64_t kHeaderSize = 64;
+
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#else
+    int m_file; // POSIX 빌드(LoadGen)용 파일 디스크립터
+#endif
+    uint8_t* m_base;
+    uint64_t m_capacity;
+
+    mutable std::mutex m_lock;
+    uint64_t m_writeOffset;
+    uint64_t m_replayedOffset;
+    bool m_progressKnown;     // DB에서 진행 위치를 읽기 전에는 보수적으로 pending 취급
+
+    uint64_t ScanForEnd() const;
+    bool ValidRecordAt(uint64_t offset, uint64_t generation, uint32_t& payloadSize) const;
+};
@@ -0,0 +1,518 @@
+﻿#include "HistoryExporter.h"
+#include "Database.h"
+#include "MessageRouter.h"
+#include "IpcProtocol.h"
+#include "AsyncLogger.h"
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#ifdef AGENT_HAVE_ZLIB
+#include <zlib.h> // 3rdparty\zlib (SYS_Program.vcxproj에서 AGENT_HAVE_ZLIB 정의)
+#endif
+
+namespace {
+    const size_t kWriteBufferBytes = 1024 * 1024;  // 순차 쓰기 단위
+    const int kReaderBusyTimeoutMs = 2000;
+    const char* kStateFileName = "export.state";
+#ifdef AGENT_HAVE_ZLIB
+    const bool kCompressionAvailable = true;
+#else
+    const bool kCompressionAvailable = false;
+#endif
+
+    // 큰 버퍼에 모았다가 한 번에 WriteFile (압축 시 gzip 스트림으로 변환 후 기록)
+    class ExportFileWriter {
+    public:
+        ExportFileWriter() : m_file(INVALID_HANDLE_VALUE), m_used(0), m_compress(false), m_rawBytes(0) {}
+        ~ExportFileWriter() { Abort(); }
+
+        bool Open(const std::string& path, bool compress) {
+            m_file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE) return false;
+            if (m_buf.size() != kWriteBufferBytes) m_buf.resize(kWriteBufferBytes);
+            m_used = 0;
+            m_rawBytes = 0;
+            m_compress = false;
+            if (compress && !kCompressionAvailable) { // 압축 요청을 비압축 파일로 대신하지 않음
+                Abort();
+                return false;
+            }
+#ifdef AGENT_HAVE_ZLIB
+            if (compress) {
+                memset(&m_zs, 0, sizeof(m_zs));
+                // windowBits 15 + 16: gzip 헤더/트레일러
+                if (deflateInit2(&m_zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                    Abort();
+                    return false;
+                }
+                m_zout.resize(kWriteBufferBytes / 4);
+                m_compress = true;
+            }
+#endif
+            return true;
+        }
+
+        bool IsOpen() const { return m_file != INVALID_HANDLE_VALUE; }
+        uint64_t RawBytes() const { return m_rawBytes; }
+
+        bool Write(const char* data, size_t len) {
+            m_rawBytes += len;
+            while (len) {
+                size_t n = m_buf.size() - m_used;
+                if (n > len) n = len;
+                memcpy(m_buf.data() + m_used, data, n);
+                m_used += n;
+                data += n;
+                len -= n;
+                if (m_used == m_buf.size() && !FlushBuffer(false)) return false;
+            }
+            return true;
+        }
+
+        // 남은 버퍼(와 압축 스트림 끝)를 기록하고 디스크에 반영 후 닫기
+        bool Close() {
+            if (!IsOpen()) return false;
+            bool ok = FlushBuffer(true) && FlushFileBuffers(m_file);
+            Release();
+            return ok;
+        }
+
+        void Abort() {
+            if (IsOpen()) Release();
+        }
+
+    private:
+        HANDLE m_file;
+        std::vector<char> m_buf;
+        size_t m_used;
+        bool m_compress;
+        uint64_t m_rawBytes;
+#ifdef AGENT_HAVE_ZLIB
+        z_stream m_zs;
+        std::vector<char> m_zout;
+#endif
+
+        void Release() {
+#ifdef AGENT_HAVE_ZLIB
+            if (m_compress) deflateEnd(&m_zs);
+#endif
+            m_compress = false;
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+
+        bool WriteRaw(const char* data, size_t len) {
+            while (len) {
+                DWORD chunk = len > 0x40000000 ? 0x40000000 : (DWORD)len;
+                DWORD written = 0;
+                if (!WriteFile(m_file, data, chunk, &written, nullptr) || written == 0) return false;
+                data += written;
+                len -= written;
+            }
+            return true;
+        }
+
+        bool FlushBuffer(bool finish) {
+#ifdef AGENT_HAVE_ZLIB
+            if (m_compress) {
+                m_zs.next_in = (Bytef*)m_buf.data();
+                m_zs.avail_in = (uInt)m_used;
+                int zrc;
+                do {
+                    m_zs.next_out = (Bytef*)m_zout.data();
+                    m_zs.avail_out = (uInt)m_zout.size();
+                    zrc = deflate(&m_zs, finish ? Z_FINISH : Z_NO_FLUSH);
+                    if (zrc == Z_STREAM_ERROR) return false;
+                    size_t have = m_zout.size() - m_zs.avail_out;
+                    if (have && !WriteRaw(m_zout.data(), have)) return false;
+                } while (finish ? zrc != Z_STREAM_END : m_zs.avail_out == 0);
+                m_used = 0;
+                return true;
+            }
+#else
+            (void)finish;
+#endif
+            if (m_used && !WriteRaw(m_buf.data(), m_used)) return false;
+            m_used = 0;
+            return true;
+        }
+    };
+
+    void AppendJsonString(std::string& out, const char* s, int n) {
+        static const char* kHex = "0123456789abcdef";
+        out.push_back('"');
+        for (int i = 0; i < n; i++) {
+            unsigned char c = (unsigned char)s[i];
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out.push_back(kHex[c >> 4]);
+                    out.push_back(kHex[c & 0xF]);
+                }
+                else {
+                    out.push_back((char)c); // UTF-8은 그대로
+                }
+            }
+        }
+        out.push_back('"');
+    }
+
+    // RFC 4180: 구분자/따옴표/줄바꿈이 있으면 따옴표로 감싸고 따옴표는 두 번
+    void AppendCsvField(std::string& out, const char* s, int n) {
+        bool quote = false;
+        for (int i = 0; i < n && !quote; i++)
+            quote = s[i] == ',' || s[i] == '"' || s[i] == '\n' || s[i] == '\r';
+        if (!quote) {
+            out.append(s, n);
+            return;
+        }
+        out.push_back('"');
+        for (int i = 0; i < n; i++) {
+            if (s[i] == '"') out.push_back('"');
+            out.push_back(s[i]);
+        }
+        out.push_back('"');
+    }
+
+    void AppendNumber(std::string& out, sqlite3_stmt* stmt, int col) {
+        char num[32];
+        int n = sqlite3_column_type(stmt, col) == SQLITE_INTEGER
+            ? snprintf(num, sizeof(num), "%lld", (long long)sqlite3_column_int64(stmt, col))
+            : snprintf(num, sizeof(num), "%.17g", sqlite3_column_double(stmt, col));
+        out.append(num, n);
+    }
+
+    void FormatNdjsonRow(std::string& out, sqlite3_stmt* stmt, int columns) {
+        out.push_back('{');
+        for (int c = 0; c < columns; c++) {
+            if (c) out.push_back(',');
+            const char* name = sqlite3_column_name(stmt, c);
+            AppendJsonString(out, name, (int)strlen(name));
+            out.push_back(':');
+            switch (sqlite3_column_type(stmt, c)) {
+            case SQLITE_NULL: out += "null"; break;
+            case SQLITE_INTEGER:
+            case SQLITE_FLOAT: AppendNumber(out, stmt, c); break;
+            default:
+                AppendJsonString(out, (const char*)sqlite3_column_text(stmt, c), sqlite3_column_bytes(stmt, c));
+            }
+        }
+        out += "}\n";
+    }
+
+    void FormatCsvHeader(std::string& out, sqlite3_stmt* stmt, int columns) {
+        for (int c = 0; c < columns; c++) {
+            if (c) out.push_back(',');
+            const char* name = sqlite3_column_name(stmt, c);
+            AppendCsvField(out, name, (int)strlen(name));
+        }
+        out += "\r\n";
+    }
+
+    void FormatCsvRow(std::string& out, sqlite3_stmt* stmt, int columns) {
+        for (int c = 0; c < columns; c++) {
+            if (c) out.push_back(',');
+            switch (sqlite3_column_type(stmt, c)) {
+            case SQLITE_NULL: break;
+            case SQLITE_INTEGER:
+            case SQLITE_FLOAT: AppendNumber(out, stmt, c); break;
+            default:
+                AppendCsvField(out, (const char*)sqlite3_column_text(stmt, c), sqlite3_column_bytes(stmt, c));
+            }
+        }
+        out += "\r\n";
+    }
+}
+
+HistoryExporter::HistoryExporter(Database* database, const ExportOptions& options)
+    : m_database(database), m_options(options), m_marks{ { Database::SchemaName(DbShard::History), "BrowserUrls", 0 },
+        { Database::SchemaName(DbShard::RequestLog), "UrlLogs", 0 } },
+      m_marksLoaded(false), m_exportRequested(false), m_running(false), m_cancel(false) {
+    if (m_options.compress && !kCompressionAvailable)
+        printf("[Export] Compression requested but this build has no zlib (AGENT_HAVE_ZLIB), export disabled\n");
+}
+
+HistoryExporter::~HistoryExporter() {
+    Stop();
+}
+
+void HistoryExporter::Start() {
+    bool expected = false;
+    if (!m_running.compare_exchange_strong(expected, true)) return;
+    m_cancel.store(false);
+    m_thread = std::thread(&HistoryExporter::ExportThread, this);
+}
+
+void HistoryExporter::Stop() {
+    if (!m_running.exchange(false)) return;
+    m_cancel.store(true);
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void HistoryExporter::RegisterHandlers(MessageRouter& router) {
+    // 요청은 내보내기 스레드를 깨우기만 하므로 밀린 요청은 하나로 충분
+    RouteOptions options;
+    options.ordering = HandlerOrdering::Serial;
+    options.capacity = 4;
+    options.overflow = QueueOverflowPolicy::DropOldest;
+    router.Register(IMT_EXPORT_HISTORY, "ExportHistory", [this](const IpcMessage&) { RequestExport(); }, options);
+}
+
+void HistoryExporter::RequestExport() {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_exportRequested = true;
+    }
+    m_cv.notify_all();
+}
+
+void HistoryExporter::ExportThread() {
+    while (m_running.load()) {
+        {
+            std::unique_lock<std::mutex> lk(m_lock);
+            auto wake = [this]() { return !m_running.load() || m_exportRequested; };
+            if (m_options.intervalSec > 0)
+                m_cv.wait_for(lk, std::chrono::seconds(m_options.intervalSec), wake);
+            else
+                m_cv.wait(lk, wake);
+            if (!m_running.load()) break;
+            m_exportRequested = false;
+        }
+        ExportOnce();
+    }
+}
+
+long long HistoryExporter::ExportOnce() {
+    std::lock_guard<std::mutex> guard(m_exportLock);
+    auto start = std::chrono::steady_clock::now();
+
+    if (!m_marksLoaded) {
+        LoadMarks();
+        m_marksLoaded = true;
+    }
+    if (m_options.compress && !kCompressionAvailable) {
+        AGENT_LOG_ERROR("[Export] Failed: compression requested but not available in this build");
+        return -1;
+    }
+    CreateDirectoryA(m_options.outputDir.c_str(), nullptr);
+
+    std::string dbPath = m_database->GetPath(DbShard::Config);
+    if (dbPath.empty()) {
+        AGENT_LOG_WARN("[Export] Skipped, database not opened yet");
+        return -1;
+    }
+
+    // 에이전트 쓰기 연결과 별개인 읽기 전용 연결
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        AGENT_LOG_WARN("[Export] Cannot open %s: %s", dbPath.c_str(), db ? sqlite3_errmsg(db) : "out of memory");
+        sqlite3_close(db);
+        return -1;
+    }
+    sqlite3_busy_timeout(db, kReaderBusyTimeoutMs);
+    if (!m_database->AttachShards(db)) {
+        sqlite3_close(db);
+        return -1;
+    }
+
+    long long total = 0;
+    for (TableMark& mark : m_marks) {
+        if (m_cancel.load()) break;
+        long long n = ExportTable(db, mark);
+        if (n > 0) total += n;
+    }
+    sqlite3_close(db);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    AGENT_LOG_INFO("[Export] Exported %lld rows in %.1f ms (BrowserUrls<=%lld, UrlLogs<=%lld)",
+        total, ms, (long long)m_marks[0].lastId, (long long)m_marks[1].lastId);
+    return total;
+}
+
+// mark.lastId 이후 행을 청크 단위로 읽어 파일에 기록
+// 파일이 완료(이름 변경)될 때마다 high-water mark를 저장하므로 중간에 죽어도 완료된 파일은 다시 내보내지 않음
+long long HistoryExporter::ExportTable(sqlite3* db, TableMark& mark) {
+    // 이번 실행의 상한을 고정 (실행 중 추가되는 행은 다음 실행에서)
+    const std::string source = std::string(mark.schema) + "." + mark.table;
+    std::string sql = "SELECT MAX(id) FROM " + source + ";";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        AGENT_LOG_WARN("[Export] %s: %s", mark.table, sqlite3_errmsg(db));
+        return -1;
+    }
+    int64_t upper = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : 0;
+    sqlite3_finalize(stmt);
+
+    if (upper < mark.lastId) {
+        // DB 파일이 새로 만들어져 id가 처음부터 다시 시작된 경우
+        AGENT_LOG_WARN("[Export] %s max id %lld < mark %lld, restarting from 0",
+            mark.table, (long long)upper, (long long)mark.lastId);
+        mark.lastId = 0;
+        SaveMarks();
+    }
+    if (upper == mark.lastId) return 0;
+
+    sql = "SELECT * FROM " + source + " WHERE id > ?1 AND id <= ?2 ORDER BY id LIMIT ?3;";
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        AGENT_LOG_WARN("[Export] %s: %s", mark.table, sqlite3_errmsg(db));
+        return -1;
+    }
+    const int columns = sqlite3_column_count(stmt);
+    int idCol = -1;
+    for (int c = 0; c < columns; c++) {
+        if (sqlite3_stricmp(sqlite3_column_name(stmt, c), "id") == 0) idCol = c;
+    }
+    if (idCol < 0) {
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    const bool csv = m_options.format == ExportFormat::Csv;
+    const bool compress = m_options.compress;
+    const std::string partPath = m_options.outputDir + "\\" + mark.table + ".part";
+
+    ExportFileWriter out;
+    std::string line; // 행 하나 서식 버퍼 (재사용)
+    int64_t cursor = mark.lastId;
+    int64_t fileFirstId = 0;
+    long long fileRows = 0;
+    long long exported = 0;
+    bool ok = true;
+
+    // 작성 중인 파일을 닫고 최종 이름으로 바꾼 뒤 진행 위치 저장
+    auto finishFile = [&]() -> bool {
+        if (!out.Close()) return false;
+        SYSTEMTIME st;
+        GetLocalTime(&st);
+        char name[160];
+        snprintf(name, sizeof(name), "%s-%04u%02u%02u-%02u%02u%02u-%lld-%lld.%s%s", mark.table,
+            (unsigned)st.wYear, (unsigned)st.wMonth, (unsigned)st.wDay,
+            (unsigned)st.wHour, (unsigned)st.wMinute, (unsigned)st.wSecond,
+            (long long)fileFirstId, (long long)cursor, csv ? "csv" : "ndjson", compress ? ".gz" : "");
+        std::string finalPath = m_options.outputDir + "\\" + name;
+        if (!MoveFileExA(partPath.c_str(), finalPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+            return false;
+        mark.lastId = cursor;
+        exported += fileRows;
+        fileRows = 0;
+        SaveMarks();
+        return true;
+    };
+
+    while (ok && cursor < upper && !m_cancel.load()) {
+        // 청크마다 짧은 읽기 트랜잭션 (WAL 스냅샷), id 범위 탐색이라 메모리 사용량 일정
+        sqlite3_bind_int64(stmt, 1, cursor);
+        sqlite3_bind_int64(stmt, 2, upper);
+        sqlite3_bind_int(stmt, 3, m_options.chunkRows);
+
+        int rows = 0;
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            int64_t id = sqlite3_column_int64(stmt, idCol);
+            line.clear();
+            if (!out.IsOpen()) {
+                if (!out.Open(partPath, compress)) {
+                    AGENT_LOG_ERROR("[Export] Cannot create %s", partPath.c_str());
+                    ok = false;
+                    break;
+                }
+                fileFirstId = id;
+                if (csv) FormatCsvHeader(line, stmt, columns);
+            }
+            if (csv) FormatCsvRow(line, stmt, columns);
+            else FormatNdjsonRow(line, stmt, columns);
+            if (!out.Write(line.data(), line.size())) {
+                AGENT_LOG_ERROR("[Export] Write failed: %s", partPath.c_str());
+                ok = false;
+                break;
+            }
+            cursor = id;
+            rows++;
+            fileRows++;
+        }
+        sqlite3_reset(stmt);
+        if (ok && rc != SQLITE_DONE) {
+            AGENT_LOG_WARN("[Export] %s read failed: %s", mark.table, sqlite3_errmsg(db));
+            ok = false;
+        }
+        if (!ok || rows == 0) break;
+
+        if (out.RawBytes() >= m_options.maxFileBytes && !finishFile()) ok = false;
+    }
+    sqlite3_finalize(stmt);
+
+    if (ok && out.IsOpen() && !finishFile()) ok = false;
+    if (!ok) {
+        // 완료되지 않은 파일의 행은 다음 실행에서 다시 내보냄
+        out.Abort();
+        DeleteFileA(partPath.c_str());
+        AGENT_LOG_WARN("[Export] %s stopped at id %lld", mark.table, (long long)mark.lastId);
+    }
+    return exported;
+}
+
+std::string HistoryExporter::StatePath() const {
+    return m_options.outputDir + "\\" + kStateFileName;
+}
+
+// 상태 파일: 테이블마다 "이름=마지막id" 한 줄
+void HistoryExporter::LoadMarks() {
+    HANDLE file = CreateFileA(StatePath().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return; // 첫 실행
+
+    char buf[1024];
+    DWORD read = 0;
+    BOOL ok = ReadFile(file, buf, sizeof(buf) - 1, &read, nullptr);
+    CloseHandle(file);
+    if (!ok) return;
+    buf[read] = '\0';
+
+    for (char* line = buf; line && *line;) {
+        char* next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        char* eq = strchr(line, '=');
+        if (eq) {
+            *eq = '\0';
+            for (TableMark& mark : m_marks) {
+                if (strcmp(mark.table, line) == 0) mark.lastId = _strtoi64(eq + 1, nullptr, 10);
+            }
+        }
+        line = next;
+    }
+}
+
+// 임시 파일에 쓰고 디스크 반영 후 교체 (중간에 죽어도 이전 상태 또는 새 상태 중 하나)
+bool HistoryExporter::SaveMarks() {
+    std::string text;
+    for (const TableMark& mark : m_marks) {
+        char line[96];
+        int n = snprintf(line, sizeof(line), "%s=%lld\n", mark.table, (long long)mark.lastId);
+        text.append(line, n);
+    }
+
+    std::string path = StatePath();
+    std::string tmp = path + ".tmp";
+    HANDLE file = CreateFileA(tmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    DWORD written = 0;
+    bool ok = WriteFile(file, text.data(), (DWORD)text.size(), &written, nullptr) && written == text.size() &&
+        FlushFileBuffers(file);
+    CloseHandle(file);
+    if (ok) ok = MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+    if (!ok) AGENT_LOG_ERROR("[Export] Failed to save %s", path.c_str());
+    return ok;
+}
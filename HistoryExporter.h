@@ -0,0 +1,71 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sqlite3.h>
+
+class Database;
+class MessageRouter;
+
+enum class ExportFormat { Ndjson, Csv };
+
+struct ExportOptions {
+    std::string outputDir = "C:\\ProgramData\\AgentExports";
+    ExportFormat format = ExportFormat::Ndjson;
+    bool compress = false;                    // gzip, AGENT_HAVE_ZLIB 없는 빌드에서 요청하면 내보내기 실패
+    uint32_t intervalSec = 900;               // 주기 실행 간격, 0이면 IPC 요청 시에만
+    uint64_t maxFileBytes = 64 * 1024 * 1024; // 파일 회전 기준 (압축 전 바이트)
+    int chunkRows = 2000;                     // 읽기 트랜잭션 하나에서 읽는 행 수
+};
+
+// BrowserUrls / UrlLogs를 SIEM 수집용 NDJSON/CSV 파일로 증분 내보내기
+// - 테이블별 마지막으로 내보낸 id(high-water mark)를 상태 파일에 저장하여 새 행만 내보냄
+// - 별도 읽기 전용 연결에서 id 범위로 나눠 짧은 읽기 트랜잭션으로 읽음 (WAL이라 저장을 막지 않음)
+// - 연결에 모든 DB 샤드를 ATTACH하므로 샤드 배치와 관계없이 같은 연결로 읽음
+// - 작성 중 파일은 <테이블>.part, 완료되면 <테이블>-<시각>-<첫id>-<끝id>.<확장자>로 이름 변경
+class HistoryExporter {
+public:
+    HistoryExporter(Database* database, const ExportOptions& options = ExportOptions());
+    ~HistoryExporter();
+
+    void Start();
+    void Stop(); // 진행 중인 내보내기는 현재 청크까지 마무리하고 종료
+
+    // IMT_EXPORT_HISTORY 요청 시 즉시 내보내기
+    void RegisterHandlers(MessageRouter& router);
+    void RequestExport();
+
+    // 모든 테이블 한 번 내보내기 (호출 스레드에서 실행)
+    // 반환: 내보낸 행 수, DB를 열 수 없으면 -1 (에이전트가 아직 DB를 열지 못한 경우 포함)
+    long long ExportOnce();
+
+private:
+    struct TableMark {
+        const char* schema; // ATTACH한 샤드 스키마 이름
+        const char* table;
+        int64_t lastId; // 완료된 파일에 기록된 마지막 id
+    };
+
+    Database* m_database; // 경로만 사용, 읽기는 별도 연결
+    const ExportOptions m_options;
+
+    TableMark m_marks[2];
+    bool m_marksLoaded;
+    std::mutex m_exportLock; // ExportOnce 직렬화 (주기 실행과 수동 호출)
+
+    std::thread m_thread;
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    bool m_exportRequested;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_cancel; // Stop 시 진행 중인 내보내기를 청크 경계에서 중단
+
+    void ExportThread();
+    long long ExportTable(sqlite3* db, TableMark& mark);
+    std::string StatePath() const;
+    void LoadMarks();
+    bool SaveMarks();
+};
@@ -0,0 +1,541 @@
+﻿#include "HistoryImporter.h"
+#include "TextCodec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+const char* HistoryImporter::kProgressSql =
+    "CREATE TABLE IF NOT EXISTS ImportProgress ("
+    "source TEXT PRIMARY KEY, "
+    "last_visit_id INTEGER NOT NULL DEFAULT 0, "
+    "rows INTEGER NOT NULL DEFAULT 0, "
+    "completed INTEGER NOT NULL DEFAULT 0, "
+    "updated DATETIME DEFAULT CURRENT_TIMESTAMP"
+    ");";
+
+namespace {
+    const int kTargetBusyTimeoutMs = 5000;
+    const int kMaxChromiumProfiles = 16;   // "Default", "Profile 1".."Profile 16"
+    const size_t kCopyBufferBytes = 1024 * 1024;
+    const char* const kCopySuffixes[] = { "-wal", "-journal" }; // 커밋되지 않은 내용도 복사본에서 복구/롤백되도록
+
+    // 큰 버퍼로 순차 복사 (원본을 브라우저가 열고 있어도 읽기 공유로 열림)
+    bool CopyFileBytes(const std::string& from, const std::string& to) {
+        FILE* in = fopen(from.c_str(), "rb");
+        if (!in) return false;
+        FILE* out = fopen(to.c_str(), "wb");
+        if (!out) {
+            fclose(in);
+            return false;
+        }
+        std::vector<char> buf(kCopyBufferBytes);
+        bool ok = true;
+        size_t n;
+        while ((n = fread(buf.data(), 1, buf.size(), in)) > 0) {
+            if (fwrite(buf.data(), 1, n, out) != n) {
+                ok = false;
+                break;
+            }
+        }
+        if (ferror(in)) ok = false;
+        fclose(in);
+        if (fclose(out) != 0) ok = false;
+        return ok;
+    }
+
+    bool FileExists(const std::string& path) {
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return false;
+        fclose(f);
+        return true;
+    }
+
+    void RemoveCopy(const std::string& copyPath) {
+        remove(copyPath.c_str());
+        for (const char* suffix : kCopySuffixes) remove((copyPath + suffix).c_str());
+    }
+
+    std::string DirName(const std::string& path) {
+        size_t slash = path.find_last_of("\\/");
+        return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+    }
+
+    bool Exec(sqlite3* db, const char* sql, std::string& error) {
+        char* msg = nullptr;
+        if (sqlite3_exec(db, sql, nullptr, nullptr, &msg) == SQLITE_OK) return true;
+        error = msg ? msg : sqlite3_errmsg(db);
+        sqlite3_free(msg);
+        return false;
+    }
+
+    // UTF-8 <-> wstring (정규화기 입력용)
+#if WCHAR_MAX <= 0xFFFF
+    void Widen(const char* s, size_t n, std::wstring& out) {
+        out.resize(Utf16CapacityFor(n));
+        size_t len = TranscodeUtf8ToUtf16(s, n, &out[0], out.size());
+        out.resize(len == kTextCodecOverflow ? 0 : len);
+    }
+
+    void Narrow(const std::wstring& s, std::string& out) {
+        out.resize(Utf8CapacityFor(s.size()));
+        size_t len = TranscodeUtf16ToUtf8(s.data(), s.size(), &out[0], out.size());
+        out.resize(len == kTextCodecOverflow ? 0 : len);
+    }
+#else
+    // wchar_t가 32비트인 플랫폼: UTF-16 단위를 그대로 담아 되돌릴 때 서로게이트 쌍이 다시 결합되도록
+    void Widen(const char* s, size_t n, std::wstring& out) {
+        thread_local std::u16string units;
+        units.resize(Utf16CapacityFor(n));
+        size_t len = TranscodeUtf8ToUtf16(s, n, &units[0], units.size());
+        if (len == kTextCodecOverflow) len = 0;
+        out.assign(units.begin(), units.begin() + len);
+    }
+
+    void Narrow(const std::wstring& s, std::string& out) {
+        thread_local std::u16string units;
+        units.assign(s.begin(), s.end());
+        out.resize(Utf8CapacityFor(units.size()));
+        size_t len = TranscodeUtf16ToUtf8(units.data(), units.size(), &out[0], out.size());
+        out.resize(len == kTextCodecOverflow ? 0 : len);
+    }
+#endif
+
+    // 원본 URL id별 정규화 결과 (방문마다 같은 URL을 다시 정규화하지 않음)
+    struct UrlEntry {
+        std::string url;
+        std::string raw; // 정규 URL과 다를 때만
+        bool ok;
+    };
+
+    // 대상 DB에 이미 있는 (정규 URL → 시각들), 시각은 정렬된 유닉스 초
+    typedef std::unordered_map<std::string, std::vector<int64_t>> ExistingVisits;
+
+    bool IsDuplicate(const ExistingVisits& existing, const std::string& url, int64_t sec, int64_t window) {
+        auto found = existing.find(url);
+        if (found == existing.end()) return false;
+        const std::vector<int64_t>& times = found->second;
+        auto it = std::lower_bound(times.begin(), times.end(), sec - window);
+        return it != times.end() && *it <= sec + window;
+    }
+
+    // 형식별 SQL: 두 문장 모두 ?1 = 이미 가져온 마지막 방문 id, 시각은 유닉스 초로 변환
+    // 모니터가 보지 못하는 방문(하위 프레임)은 제외: Chromium transition 코어 3/4, Firefox visit_type 4(EMBED)/8(FRAMED_LINK)
+    struct SourceQueries {
+        const char* name;
+        const char* rangeSql; // 남은 방문 수, 최소/최대 시각
+        const char* visitSql; // 방문 id, URL id, URL, 제목, 시각 (방문 id 순)
+    };
+
+    // Chromium visit_time: 1601-01-01 기준 마이크로초
+    const SourceQueries kChromiumQueries = {
+        "chromium",
+        "SELECT COUNT(*), MIN(visit_time) / 1000000 - 11644473600, MAX(visit_time) / 1000000 - 11644473600 "
+        "FROM visits WHERE id > ?1 AND (transition & 255) NOT IN (3, 4);",
+        "SELECT v.id, u.id, u.url, u.title, v.visit_time / 1000000 - 11644473600 "
+        "FROM visits v JOIN urls u ON u.id = v.url "
+        "WHERE v.id > ?1 AND (v.transition & 255) NOT IN (3, 4) ORDER BY v.id;"
+    };
+
+    // Firefox visit_date: 유닉스 기준 마이크로초
+    const SourceQueries kFirefoxQueries = {
+        "firefox",
+        "SELECT COUNT(*), MIN(visit_date) / 1000000, MAX(visit_date) / 1000000 "
+        "FROM moz_historyvisits WHERE id > ?1 AND visit_type NOT IN (4, 8);",
+        "SELECT v.id, p.id, p.url, p.title, v.visit_date / 1000000 "
+        "FROM moz_historyvisits v JOIN moz_places p ON p.id = v.place_id "
+        "WHERE v.id > ?1 AND v.visit_type NOT IN (4, 8) ORDER BY v.id;"
+    };
+}
+
+HistoryImporter::HistoryImporter(const std::string& targetPath, const HistoryImportOptions& options)
+    : m_targetPath(targetPath), m_options(options), m_canonicalizer(options.canonicalize), m_cancel(false) {
+}
+
+HistoryImporter::~HistoryImporter() {
+    Stop();
+}
+
+void HistoryImporter::AddSource(const HistorySource& source) {
+    m_sources.push_back(source);
+}
+
+std::vector<HistorySource> HistoryImporter::DiscoverSources() {
+    std::vector<HistorySource> sources;
+
+    struct ChromiumBrowser {
+        const char* userData; // %LOCALAPPDATA% 기준
+        const char* exe;
+    };
+    static const ChromiumBrowser kChromium[] = {
+        { "\\Google\\Chrome\\User Data\\", "chrome.exe" },
+        { "\\Microsoft\\Edge\\User Data\\", "msedge.exe" },
+        { "\\Naver\\Naver Whale\\User Data\\", "whale.exe" },
+    };
+    const char* local = getenv("LOCALAPPDATA");
+    if (local && *local) {
+        for (const ChromiumBrowser& b : kChromium) {
+            std::string base = std::string(local) + b.userData;
+            for (int i = 0; i <= kMaxChromiumProfiles; i++) {
+                std::string profile = i == 0 ? std::string("Default") : "Profile " + std::to_string(i);
+                HistorySource s;
+                s.kind = HistorySourceKind::Chromium;
+                s.browser = b.exe;
+                s.path = base + profile + "\\History";
+                if (FileExists(s.path)) sources.push_back(s);
+            }
+        }
+    }
+
+    // Firefox 프로필 폴더 이름은 무작위이므로 profiles.ini의 Path= 항목을 따름
+    const char* roaming = getenv("APPDATA");
+    if (roaming && *roaming) {
+        std::string base = std::string(roaming) + "\\Mozilla\\Firefox\\";
+        FILE* ini = fopen((base + "profiles.ini").c_str(), "r");
+        if (ini) {
+            char line[1024];
+            std::string path;
+            bool relative = true;
+            auto flush = [&]() {
+                if (path.empty()) return;
+                std::replace(path.begin(), path.end(), '/', '\\');
+                HistorySource s;
+                s.kind = HistorySourceKind::Firefox;
+                s.browser = "firefox.exe";
+                s.path = (relative ? base + path : path) + "\\places.sqlite";
+                if (FileExists(s.path)) sources.push_back(s);
+                path.clear();
+                relative = true;
+            };
+            while (fgets(line, sizeof(line), ini)) {
+                size_t len = strcspn(line, "\r\n");
+                line[len] = '\0';
+                if (line[0] == '[') flush();
+                else if (strncmp(line, "Path=", 5) == 0) path = line + 5;
+                else if (strncmp(line, "IsRelative=", 11) == 0) relative = atoi(line + 11) != 0;
+            }
+            flush();
+            fclose(ini);
+        }
+    }
+    return sources;
+}
+
+bool HistoryImporter::ParseSourceSpec(const char* spec, HistorySource& out) {
+    const char* kindEnd = spec ? strchr(spec, ':') : nullptr;
+    const char* browserEnd = kindEnd ? strchr(kindEnd + 1, ':') : nullptr; // 경로의 드라이브 ':'는 그대로
+    if (!browserEnd || browserEnd == kindEnd + 1 || !browserEnd[1]) return false;
+
+    std::string kind(spec, kindEnd - spec);
+    if (kind == "chromium") out.kind = HistorySourceKind::Chromium;
+    else if (kind == "firefox") out.kind = HistorySourceKind::Firefox;
+    else return false;
+    out.browser.assign(kindEnd + 1, browserEnd - kindEnd - 1);
+    out.path = browserEnd + 1;
+    return true;
+}
+
+void HistoryImporter::Start() {
+    if (m_sources.empty() || m_thread.joinable()) return;
+    m_cancel = false;
+    m_thread = std::thread(&HistoryImporter::ImportThread, this);
+    printf("[Import] Started (%zu sources, batch %d rows, duty %d%%%s)\n",
+        m_sources.size(), m_options.offline ? m_options.offlineBatchRows : m_options.batchRows,
+        m_options.dutyPercent, m_options.offline ? ", offline" : "");
+}
+
+void HistoryImporter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_cancel = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void HistoryImporter::ImportThread() {
+#ifdef _WIN32
+    // CPU와 디스크 I/O 모두 낮은 우선순위 (사용자 작업과 에이전트 저장 경로에 양보)
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+    for (const HistorySource& source : m_sources) {
+        if (m_cancel.load()) break;
+        HistoryImportStats stats;
+        Import(source, stats);
+        if (!stats.error.empty()) {
+            printf("[Import] %s %s failed: %s\n", source.browser.c_str(), source.path.c_str(), stats.error.c_str());
+            continue;
+        }
+        printf("[Import] %s %s: %llu visits, %llu rows (duplicates %llu, skipped %llu) in %d batches, %.0f ms%s\n",
+            source.browser.c_str(), source.path.c_str(), stats.visits, stats.inserted, stats.duplicates,
+            stats.skipped, stats.batches, stats.elapsedMs, stats.completed ? "" : " (interrupted, will resume)");
+    }
+}
+
+// 원본과 -wal/-journal을 복사 (남아 있던 이전 복사본의 보조 파일은 지움)
+bool HistoryImporter::CopySource(const HistorySource& source, const std::string& copyPath, std::string& error) {
+    RemoveCopy(copyPath);
+    if (!CopyFileBytes(source.path, copyPath)) {
+        error = "cannot copy " + source.path;
+        RemoveCopy(copyPath);
+        return false;
+    }
+    for (const char* suffix : kCopySuffixes) {
+        std::string side = source.path + suffix;
+        if (FileExists(side) && !CopyFileBytes(side, copyPath + suffix)) {
+            error = "cannot copy " + side;
+            RemoveCopy(copyPath);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HistoryImporter::Import(const HistorySource& source, HistoryImportStats& stats) {
+    auto start = std::chrono::steady_clock::now();
+    stats = HistoryImportStats();
+    std::string key = source.browser + "|" + source.path; // 진행 위치 키
+
+    char name[32];
+    snprintf(name, sizeof(name), "import-%016llx.sqlite", (unsigned long long)std::hash<std::string>()(key));
+    std::string dir = m_options.workDir.empty() ? DirName(m_targetPath) : m_options.workDir;
+    std::string copyPath = dir + (dir.find('\\') != std::string::npos ? "\\" : "/") + name;
+
+    sqlite3* src = nullptr;
+    sqlite3* dst = nullptr;
+    bool ok = CopySource(source, copyPath, stats.error);
+
+    // 복사본에서 WAL 반영/미완료 트랜잭션 롤백 후 롤백 저널 모드로 바꿔 읽기 전용으로 다시 엶
+    if (ok) {
+        ok = sqlite3_open_v2(copyPath.c_str(), &src, SQLITE_OPEN_READWRITE, nullptr) == SQLITE_OK &&
+            Exec(src, "PRAGMA journal_mode=DELETE;", stats.error);
+        if (!ok && stats.error.empty()) stats.error = src ? sqlite3_errmsg(src) : "cannot open copy";
+        sqlite3_close(src);
+        src = nullptr;
+    }
+    if (ok && sqlite3_open_v2(copyPath.c_str(), &src, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        stats.error = sqlite3_errmsg(src);
+        ok = false;
+    }
+
+    // 대상은 에이전트가 만든 DB만 (스키마는 에이전트의 마이그레이션이 관리)
+    if (ok) {
+        if (sqlite3_open_v2(m_targetPath.c_str(), &dst, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+            stats.error = "cannot open " + m_targetPath + ": " + sqlite3_errmsg(dst);
+            ok = false;
+        }
+        else {
+            sqlite3_busy_timeout(dst, kTargetBusyTimeoutMs);
+            ok = Exec(dst, "PRAGMA synchronous=NORMAL; PRAGMA temp_store=MEMORY; PRAGMA cache_size=-65536;", stats.error) &&
+                Exec(dst, kProgressSql, stats.error);
+        }
+    }
+
+    if (ok) ok = ImportCopy(src, dst, source, key, stats);
+
+    sqlite3_close(src);
+    sqlite3_close(dst);
+    RemoveCopy(copyPath);
+    stats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ok && stats.completed;
+}
+
+bool HistoryImporter::ImportCopy(sqlite3* src, sqlite3* dst, const HistorySource& source, const std::string& key,
+    HistoryImportStats& stats) {
+    const SourceQueries& q = source.kind == HistorySourceKind::Firefox ? kFirefoxQueries : kChromiumQueries;
+    const std::string& browser = source.browser;
+
+    // 이전 실행의 진행 위치
+    int64_t lastId = 0;
+    int64_t totalRows = 0;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(dst, "SELECT last_visit_id, rows FROM ImportProgress WHERE source = ?1;", -1, &stmt, nullptr) != SQLITE_OK) {
+        stats.error = sqlite3_errmsg(dst);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, key.data(), (int)key.size(), SQLITE_STATIC);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        lastId = sqlite3_column_int64(stmt, 0);
+        totalRows = sqlite3_column_int64(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+
+    // 남은 방문 범위 (형식이 다르면 여기서 실패)
+    int64_t pending = 0, minSec = 0, maxSec = 0;
+    if (sqlite3_prepare_v2(src, q.rangeSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        stats.error = std::string("unsupported ") + q.name + " schema: " + sqlite3_errmsg(src);
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, lastId);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        pending = sqlite3_column_int64(stmt, 0);
+        minSec = sqlite3_column_int64(stmt, 1);
+        maxSec = sqlite3_column_int64(stmt, 2);
+    }
+    sqlite3_finalize(stmt);
+    if (pending == 0) {
+        stats.completed = true;
+        return true;
+    }
+
+    // 같은 시간대에 모니터가 기록한 행 (timestamp 인덱스 범위 조회, 인덱스를 지우기 전에)
+    const int64_t window = m_options.dedupWindowSec;
+    ExistingVisits existing;
+    if (sqlite3_prepare_v2(dst,
+        "SELECT url, CAST(strftime('%s', timestamp) AS INTEGER) FROM BrowserUrls "
+        "WHERE timestamp BETWEEN datetime(?2, 'unixepoch') AND datetime(?3, 'unixepoch') "
+        "AND browser_name = ?1 COLLATE NOCASE;", -1, &stmt, nullptr) != SQLITE_OK) {
+        stats.error = sqlite3_errmsg(dst);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, browser.data(), (int)browser.size(), SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, minSec - window);
+    sqlite3_bind_int64(stmt, 3, maxSec + window);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* url = (const char*)sqlite3_column_text(stmt, 0);
+        if (!url) continue;
+        existing[std::string(url, sqlite3_column_bytes(stmt, 0))].push_back(sqlite3_column_int64(stmt, 1));
+    }
+    sqlite3_finalize(stmt);
+    for (auto& kv : existing) std::sort(kv.second.begin(), kv.second.end());
+
+    // 오프라인 가져오기는 행마다 인덱스를 갱신하지 않고 끝에서 한 번에 생성 (오류/중단 시에도 아래에서 다시 만듦)
+    const int batchRows = m_options.offline ? m_options.offlineBatchRows : m_options.batchRows;
+    bool deferred = m_options.offline && (size_t)pending >= m_options.deferIndexRows;
+    if (deferred && !Exec(dst, "DROP INDEX IF EXISTS idx_urls_timestamp;", stats.error)) return false;
+
+    sqlite3_stmt* visits = nullptr;
+    sqlite3_stmt* insert = nullptr;
+    sqlite3_stmt* progress = nullptr;
+    bool ok = sqlite3_prepare_v2(src, q.visitSql, -1, &visits, nullptr) == SQLITE_OK;
+    if (!ok) stats.error = std::string("unsupported ") + q.name + " schema: " + sqlite3_errmsg(src);
+    ok = ok && sqlite3_prepare_v2(dst,
+        "INSERT INTO BrowserUrls (browser_name, url, window_title, raw_url, timestamp) "
+        "VALUES (?1, ?2, ?3, ?4, datetime(?5, 'unixepoch'));", -1, &insert, nullptr) == SQLITE_OK &&
+        sqlite3_prepare_v2(dst,
+        "INSERT OR REPLACE INTO ImportProgress (source, last_visit_id, rows, completed, updated) "
+        "VALUES (?1, ?2, ?3, ?4, CURRENT_TIMESTAMP);", -1, &progress, nullptr) == SQLITE_OK;
+    if (!ok && stats.error.empty()) stats.error = sqlite3_errmsg(dst);
+
+    if (ok) {
+        sqlite3_bind_int64(visits, 1, lastId);
+        sqlite3_bind_text(insert, 1, browser.data(), (int)browser.size(), SQLITE_STATIC);
+        sqlite3_bind_text(progress, 1, key.data(), (int)key.size(), SQLITE_STATIC);
+    }
+
+    std::unordered_map<int64_t, UrlEntry> urls;
+    std::wstring wide; // 정규화 버퍼 재사용
+    std::string raw;
+    bool done = false;
+    while (ok && !done && !m_cancel.load()) {
+        auto batchStart = std::chrono::steady_clock::now();
+        if (!Exec(dst, "BEGIN IMMEDIATE;", stats.error)) {
+            ok = false;
+            break;
+        }
+
+        int n = 0;
+        int rc = SQLITE_ROW;
+        while (n < batchRows && (rc = sqlite3_step(visits)) == SQLITE_ROW) {
+            n++;
+            stats.visits++;
+            lastId = sqlite3_column_int64(visits, 0);
+
+            int64_t urlId = sqlite3_column_int64(visits, 1);
+            auto found = urls.find(urlId);
+            if (found == urls.end()) {
+                const char* url = (const char*)sqlite3_column_text(visits, 2);
+                raw.assign(url ? url : "", url ? sqlite3_column_bytes(visits, 2) : 0);
+                Widen(raw.data(), raw.size(), wide);
+                UrlEntry entry;
+                entry.ok = m_canonicalizer.Canonicalize(wide);
+                if (entry.ok) {
+                    Narrow(wide, entry.url);
+                    if (entry.url != raw) entry.raw = raw;
+                }
+                found = urls.emplace(urlId, std::move(entry)).first;
+            }
+            const UrlEntry& entry = found->second;
+            if (!entry.ok) {
+                stats.skipped++;
+                continue;
+            }
+
+            int64_t sec = sqlite3_column_int64(visits, 4);
+            if (IsDuplicate(existing, entry.url, sec, window)) {
+                stats.duplicates++;
+                continue;
+            }
+
+            // 제목은 원본 행 버퍼를 그대로 바인딩 (원본 step 전에 INSERT 완료)
+            const char* title = (const char*)sqlite3_column_text(visits, 3);
+            sqlite3_bind_text(insert, 2, entry.url.data(), (int)entry.url.size(), SQLITE_STATIC);
+            sqlite3_bind_text(insert, 3, title ? title : "", title ? sqlite3_column_bytes(visits, 3) : 0, SQLITE_STATIC);
+            if (!entry.raw.empty()) sqlite3_bind_text(insert, 4, entry.raw.data(), (int)entry.raw.size(), SQLITE_STATIC);
+            else sqlite3_bind_null(insert, 4);
+            sqlite3_bind_int64(insert, 5, sec);
+            int irc = sqlite3_step(insert);
+            sqlite3_reset(insert);
+            if (irc != SQLITE_DONE) {
+                stats.error = std::string("insert failed: ") + sqlite3_errmsg(dst);
+                ok = false;
+                break;
+            }
+            stats.inserted++;
+            totalRows++;
+        }
+        if (ok && rc != SQLITE_ROW && rc != SQLITE_DONE) {
+            stats.error = std::string("read failed: ") + sqlite3_errmsg(src);
+            ok = false;
+        }
+        done = rc == SQLITE_DONE;
+
+        if (ok) {
+            sqlite3_bind_int64(progress, 2, lastId);
+            sqlite3_bind_int64(progress, 3, totalRows);
+            sqlite3_bind_int(progress, 4, done ? 1 : 0);
+            int prc = sqlite3_step(progress);
+            sqlite3_reset(progress);
+            if (prc != SQLITE_DONE) {
+                stats.error = std::string("progress update failed: ") + sqlite3_errmsg(dst);
+                ok = false;
+            }
+        }
+        if (!ok || !Exec(dst, "COMMIT;", stats.error)) {
+            ok = false;
+            sqlite3_exec(dst, "ROLLBACK;", nullptr, nullptr, nullptr);
+            break;
+        }
+        stats.batches++;
+        if (!done) Throttle(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batchStart).count());
+    }
+    sqlite3_finalize(visits);
+    sqlite3_finalize(insert);
+    sqlite3_finalize(progress);
+
+    if (deferred) {
+        std::string error;
+        if (!Exec(dst, "CREATE INDEX IF NOT EXISTS idx_urls_timestamp ON BrowserUrls(timestamp);", error)) {
+            if (stats.error.empty()) stats.error = "index rebuild failed: " + error;
+            ok = false;
+        }
+    }
+    stats.completed = ok && done;
+    return ok;
+}
+
+// 배치에 걸린 시간에 비례해 쉼 (dutyPercent 비율만큼만 실행)
+void HistoryImporter::Throttle(double batchMs) {
+    int duty = m_options.dutyPercent;
+    if (duty >= 100) return;
+    if (duty < 1) duty = 1;
+    auto pause = std::chrono::milliseconds((long long)(batchMs * (100 - duty) / duty));
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_cv.wait_for(lock, pause, [this]() { return m_cancel.load(); });
+}
@@ -0,0 +1,94 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sqlite3.h>
+#include "UrlCanonicalizer.h"
+
+// 가져올 브라우저 이력 DB 형식
+enum class HistorySourceKind { Chromium, Firefox };
+
+// 가져오기 원본 하나 (브라우저 프로필의 History / places.sqlite)
+struct HistorySource {
+    HistorySourceKind kind = HistorySourceKind::Chromium;
+    std::string browser; // BrowserUrls.browser_name에 기록할 이름 (모니터와 같은 실행 파일 이름, 예: "chrome.exe")
+    std::string path;    // 원본 파일 경로 (직접 열지 않고 복사본을 읽음)
+};
+
+struct HistoryImportOptions {
+    std::string workDir;              // 원본 복사 위치 (비어 있으면 대상 DB와 같은 폴더)
+    int batchRows = 2000;             // 쓰기 트랜잭션 하나의 행 수 (진행 위치도 같은 트랜잭션에 기록, 모니터 쓰기를 오래 막지 않는 크기)
+    uint32_t dedupWindowSec = 2;      // 같은 브라우저/URL의 기존 행이 ±초 안에 있으면 이미 기록된 방문으로 봄
+    int dutyPercent = 50;             // 배치 처리 시간 대비 실행 비율 (50이면 처리한 만큼 쉼, 100이면 쉬지 않음)
+    // 오프라인/첫 실행 가져오기 (모니터가 아직 쓰거나 조회하지 않을 때만): 큰 배치 + 인덱스 생성을 끝으로 미룸
+    bool offline = false;
+    int offlineBatchRows = 50000;     // offline일 때 batchRows 대신 사용
+    size_t deferIndexRows = 100000;   // offline이고 가져올 방문이 이 이상이면 timestamp 인덱스를 지웠다가 끝난 뒤 한 번에 생성
+    CanonicalizeOptions canonicalize = CanonicalizeOptions::Default(); // 모니터와 같은 정규화 (같은 URL이면 같은 문자열)
+};
+
+struct HistoryImportStats {
+    unsigned long long visits = 0;     // 원본에서 읽은 방문 (하위 프레임 등 모니터가 보지 못하는 방문 제외)
+    unsigned long long inserted = 0;
+    unsigned long long duplicates = 0; // 모니터가 이미 기록한 방문
+    unsigned long long skipped = 0;    // 정규화할 수 없는 URL (모니터도 기록하지 않음)
+    int batches = 0;
+    double elapsedMs = 0;
+    bool completed = false;            // false면 중단됨 (다음 실행에서 진행 위치부터 이어서)
+    std::string error;
+};
+
+// 브라우저 프로필 이력을 BrowserUrls로 일괄 가져오기 (에이전트 배포 시 기존 이력 채우기)
+// - 원본은 브라우저가 잠그고 있으므로 복사본(-wal 포함)을 만들어 읽기 전용으로 읽음
+// - 방문 1건 = BrowserUrls 1행 (timestamp = 방문 시각, url = 모니터와 같은 정규 URL, 다르면 raw_url에 원본)
+// - 모니터가 이미 기록한 방문은 (브라우저, URL, 시각 ±dedupWindowSec)으로 걸러냄
+// - 대상 DB에는 별도 연결로 작은 배치 트랜잭션 + 준비된 문장 하나로 기록
+//   (timestamp 인덱스는 유지: 가져오는 동안에도 모니터/내보내기의 시간 범위 조회가 느려지지 않음)
+//   offline 옵션이면 큰 배치로 쓰고 많을 때는 인덱스 생성을 끝으로 미룸 (중단/오류 시에도 다시 만듦)
+// - 원본 방문 id를 ImportProgress에 배치와 같은 트랜잭션으로 기록 → 중단/재실행 시 이어서 가져오고 중복 없음
+// - 배치 사이에 쉬어 CPU/디스크를 양보 (Windows에서는 백그라운드 우선순위 스레드)
+// 에이전트의 쓰기와는 SQLite 잠금으로 조정됨: 배치 하나(batchRows) 동안만 쓰기 잠금, 그동안 바쁜 쓰기는 스풀로 감
+// windows.h 비의존 (LoadGen import에서 픽스처 DB로 그대로 실행)
+class HistoryImporter {
+public:
+    // 진행 위치 테이블 (스키마 단계에서 생성, 이전 스키마 DB를 위해 가져오기 시작 시에도 실행)
+    static const char* kProgressSql;
+
+    HistoryImporter(const std::string& targetPath, const HistoryImportOptions& options = HistoryImportOptions());
+    ~HistoryImporter();
+
+    void AddSource(const HistorySource& source);
+    size_t SourceCount() const { return m_sources.size(); }
+
+    // 현재 사용자의 기본 위치에서 Chrome/Edge/Whale 프로필과 Firefox 프로필(profiles.ini) 찾기
+    static std::vector<HistorySource> DiscoverSources();
+    // "chromium:브라우저:경로" 또는 "firefox:브라우저:경로" (명령줄 옵션용)
+    static bool ParseSourceSpec(const char* spec, HistorySource& out);
+
+    // 등록한 원본을 백그라운드 스레드에서 차례로 가져옴
+    void Start();
+    void Stop(); // 진행 중인 배치까지 커밋하고 종료
+
+    // 원본 하나 가져오기 (호출 스레드에서 실행). 반환: 끝까지 가져왔으면 true (중단/오류는 stats에)
+    bool Import(const HistorySource& source, HistoryImportStats& stats);
+
+private:
+    const std::string m_targetPath;
+    const HistoryImportOptions m_options;
+    const UrlCanonicalizer m_canonicalizer;
+    std::vector<HistorySource> m_sources;
+
+    std::thread m_thread;
+    std::mutex m_lock;
+    std::condition_variable m_cv; // 배치 사이 쉬는 동안 Stop이 바로 깨움
+    std::atomic<bool> m_cancel;
+
+    void ImportThread();
+    bool CopySource(const HistorySource& source, const std::string& copyPath, std::string& error);
+    bool ImportCopy(sqlite3* src, sqlite3* dst, const HistorySource& source, const std::string& key, HistoryImportStats& stats);
+    void Throttle(double batchMs);
+};
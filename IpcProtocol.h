@@ -0,0 +1,103 @@
+﻿#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#else
+// Windows 외 빌드(LoadGen의 Linux 벤치마크)용 최소 정의
+#include <stdint.h>
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint64_t ULONGLONG;
+typedef void* HWND;
+#endif
+
+// 에이전트 ↔ 사용자 프로그램 IPC 정의 (IpcServer, UrlMonitor, WorkerThread 공용)
+
+// madCHook IPC 큐 이름
+#define IPC_NAME_OPTIONS "UserOptionUpdate"
+#define IPC_NAME_URL "BrowserUrlEvent"
+#define IPC_NAME_OPTION_RESPONSE "UserOptionResponse"
+#define IPC_NAME_URL_LOG "UrlLogBatch"
+#define IPC_NAME_CONTROL "AgentControl" // 운영 도구 → 에이전트 제어 명령
+
+// 메시지 종류 (IPC_MSG_HEADER::nType)
+#define IMT_USER_OPTION_UPDATE 0x8001
+#define IMT_OPTION_ACK_BATCH 0x8002  // 에이전트 → 사용자 프로그램: 옵션 적용 결과 묶음 (UserOptionResponse 큐, 바이너리)
+#define IMT_URL_EVENT 0x9001
+#define IMT_URL_LOG_BATCH 0x9101 // 후킹된 프로세스의 HTTP 요청 기록 묶음 (바이너리)
+#define IMT_EXPORT_HISTORY 0xA001 // 이력 내보내기 즉시 실행 (페이로드 없음)
+#define IMT_TRACE_CONTROL 0xA002  // 구간 추적 제어 ("start" | "stop" | "dump")
+
+// 모든 메시지 앞에 붙는 헤더, 뒤에 dwSize 바이트의 페이로드
+#pragma pack(push,1)
+typedef struct _IPC_MSG_HEADER { DWORD nType; DWORD dwSize; } IPC_MSG_HEADER, * PIPC_MSG_HEADER;
+#pragma pack(pop)
+
+// 선택적 추적 트레일러: 송신 측 추적이 켜져 있으면 페이로드 맨 끝(텍스트는 NUL 뒤)에 붙이고 dwSize에 포함
+// NUL까지만 읽는 기존 수신 측에는 보이지 않음. 라우터가 떼어내고 IpcMessage::traceId로 전달
+#define IPC_TRACE_TRAILER_MAGIC 0x31435254 // "TRC1"
+#pragma pack(push,1)
+typedef struct _IPC_TRACE_TRAILER { ULONGLONG qwCorrelationId; DWORD dwMagic; } IPC_TRACE_TRAILER, * PIPC_TRACE_TRAILER;
+#pragma pack(pop)
+
+// IMT_URL_EVENT 선택적 병합 트레일러: 주소 변경 폭주로 여러 변경을 한 이벤트로 묶었을 때 NUL 바로 뒤에 붙임
+// (추적 트레일러가 있으면 그 앞). 없으면 변경 1회
+#define IPC_URL_CHURN_TRAILER_MAGIC 0x314E4843 // "CHN1"
+#pragma pack(push,1)
+typedef struct _IPC_URL_CHURN_TRAILER { DWORD dwChangeCount; DWORD dwMagic; } IPC_URL_CHURN_TRAILER, * PIPC_URL_CHURN_TRAILER;
+#pragma pack(pop)
+
+// IMT_URL_LOG_BATCH 페이로드
+//   URL_LOG_BATCH_HEADER + 프로세스 이름(wProcNameLen)
+//   + wCount × (URL_LOG_RECORD + method + scheme + host + path + fullUrl)
+// 문자열은 모두 UTF-8, NUL 종료 없음
+#define URL_LOG_BATCH_VERSION 1
+#define URL_LOG_BATCH_MAX_RECORDS 4096
+
+#pragma pack(push,1)
+typedef struct _URL_LOG_BATCH_HEADER {
+    WORD wVersion;
+    WORD wCount;
+    DWORD dwPid;
+    WORD wProcNameLen;
+    WORD wReserved;
+} URL_LOG_BATCH_HEADER, * PURL_LOG_BATCH_HEADER;
+
+typedef struct _URL_LOG_RECORD {
+    WORD wPort;
+    BYTE bMethodLen;
+    BYTE bSchemeLen;
+    WORD wHostLen;
+    WORD wPathLen;
+    WORD wFullUrlLen;
+} URL_LOG_RECORD, * PURL_LOG_RECORD;
+#pragma pack(pop)
+
+// IMT_OPTION_ACK_BATCH 페이로드: OPTION_ACK_BATCH_HEADER + wCount × OPTION_ACK_RECORD (SEQ 오름차순)
+// 같은 SEQ의 결과는 한 번만 보냄 (전달 실패 시 재시도, 기한이 지나면 버림)
+// 옵션 메시지마다 결과 레코드 하나: 대기 중에 더 높은 SEQ로 병합되어 적용하지 않은 메시지는 OPTION_ACK_SUPERSEDED
+// (dwOpt/qwSentAt은 그 메시지의 값, 적용 결과는 병합한 SEQ의 레코드로 따로 옴)
+#define OPTION_ACK_BATCH_VERSION 1
+#define OPTION_ACK_BATCH_MAX_RECORDS 256
+
+// OPTION_ACK_RECORD::wStatus
+#define OPTION_ACK_APPLIED 0          // DB 저장 완료
+#define OPTION_ACK_ALREADY_APPLIED 1  // 마지막으로 적용한 옵션과 같은 재전송 (저장 생략)
+#define OPTION_ACK_STORAGE_FAILED 2   // DB 오류
+#define OPTION_ACK_INVALID 3          // 메시지 형식 오류
+#define OPTION_ACK_SUPERSEDED 4       // 처리 전에 더 최신 옵션 메시지로 대체됨 (적용/저장하지 않음)
+
+#pragma pack(push,1)
+typedef struct _OPTION_ACK_BATCH_HEADER {
+    WORD wVersion;
+    WORD wCount;
+} OPTION_ACK_BATCH_HEADER, * POPTION_ACK_BATCH_HEADER;
+
+typedef struct _OPTION_ACK_RECORD {
+    DWORD dwSeq;
+    WORD wStatus;
+    WORD wAttempts;      // 이 결과를 보낸 시도 횟수 (1부터)
+    DWORD dwOpt[3];      // 적용한 OPT1~3 (부호 있는 정수 값을 그대로 담음)
+    ULONGLONG qwSentAt;  // 요청의 TS 값 (없으면 0, 부하 생성기의 지연 계산용)
+} OPTION_ACK_RECORD, * POPTION_ACK_RECORD;
+#pragma pack(pop)
@@ -1,60 +1,65 @@
 #include <windows.h>
 #include "IpcServer.h"
-#include "WorkerThread.h"
+#include "MessageRouter.h"
+#include "AsyncLogger.h"
+#include "IpcProtocol.h"
 #include <stdio.h>
 #include <string>
 #include <string.h>
 #include "madCHook.h"
 
-#pragma pack(push,1)
-typedef struct _IPC_MSG_HEADER { DWORD nType; DWORD dwSize; } IPC_MSG_HEADER, * PIPC_MSG_HEADER;
-#pragma pack(pop)
+IpcServer::IpcServer(MessageRouter* router) : m_router(router) {}
 
-#define IMT_USER_OPTION_UPDATE 0x8001
-#define IMT_URL_EVENT 0x9001
-
-#define IPC_NAME_OPTIONS "UserOptionUpdate"
-#define IPC_NAME_URL "BrowserUrlEvent"
-
-IpcServer::IpcServer(WorkerThread* worker) : m_worker(worker) {}
+void IpcServer::AddQueue(const char* name, std::initializer_list<DWORD> types) {
+    if (!name || !*name) return;
+    std::unique_ptr<Queue> queue(new Queue());
+    queue->server = this;
+    queue->name = name;
+    queue->types.assign(types.begin(), types.end());
+    queue->created = false;
+    m_queues.push_back(std::move(queue));
+}
 
 bool IpcServer::Start() {
-    BOOL ok1 = CreateIpcQueue(IPC_NAME_OPTIONS, (PIPC_CALLBACK_ROUTINE)OnIpcMsg, m_worker);
-    BOOL ok2 = CreateIpcQueue(IPC_NAME_URL, (PIPC_CALLBACK_ROUTINE)OnUrlMsg, m_worker);
-    return ok1 && ok2;
+    bool ok = true;
+    for (auto& queue : m_queues) {
+        if (CreateIpcQueue(queue->name.c_str(), (PIPC_CALLBACK_ROUTINE)OnIpcMsg, queue.get())) {
+            queue->created = true;
+        }
+        else {
+            printf("[SYSTEM] CreateIpcQueue failed: %s\n", queue->name.c_str());
+            ok = false;
+        }
+    }
+    return ok;
 }
 
 void IpcServer::Stop() {
-    DestroyIpcQueue(IPC_NAME_OPTIONS);
-    DestroyIpcQueue(IPC_NAME_URL);
+    for (auto& queue : m_queues) {
+        if (!queue->created) continue;
+        DestroyIpcQueue(queue->name.c_str());
+        queue->created = false;
+    }
 }
 
+//  ť  ݹ: ť  nType ͷ  (  ڵ鷯  Ͱ )
 void __stdcall IpcServer::OnIpcMsg(LPVOID ctx, PVOID pMessage, DWORD dwSize) {
-    WorkerThread* worker = (WorkerThread*)ctx;
-    if (!pMessage || dwSize < sizeof(IPC_MSG_HEADER)) {
-        printf("[SYSTEM] Invalid message\n"); return;
+    Queue* queue = (Queue*)ctx;
+    if (!queue || !queue->server->m_router) {
+        AGENT_LOG_WARN("[SYSTEM] router ctx is null");
+        return;
     }
-    PIPC_MSG_HEADER hdr = (PIPC_MSG_HEADER)pMessage;
-    if (hdr->nType != IMT_USER_OPTION_UPDATE) {
-        printf("[SYSTEM] Unknown type\n"); return;
-    }
-    const char* payload = (const char*)pMessage + sizeof(IPC_MSG_HEADER);
-    printf("[SYSTEM] Payload: %s\n", payload);
-    if (worker) worker->PushMessage(std::string(payload));
-    else printf("[SYSTEM] worker ctx is null\n");
-}
-
-void __stdcall IpcServer::OnUrlMsg(LPVOID ctx, PVOID pMessage, DWORD dwSize) {
-    WorkerThread* worker = (WorkerThread*)ctx;
     if (!pMessage || dwSize < sizeof(IPC_MSG_HEADER)) {
-        printf("[SYSTEM] Invalid URL message\n"); return;
+        queue->server->m_router->Dispatch(pMessage, dwSize); // ߸  ó/ Ϳ ñ
+        return;
     }
-    PIPC_MSG_HEADER hdr = (PIPC_MSG_HEADER)pMessage;
-    if (hdr->nType != IMT_URL_EVENT) {
-        printf("[SYSTEM] Unknown URL type\n"); return;
+
+    DWORD type = ((PIPC_MSG_HEADER)pMessage)->nType;
+    for (DWORD allowed : queue->types) {
+        if (allowed == type) {
+            queue->server->m_router->Dispatch(pMessage, dwSize);
+            return;
+        }
     }
-    const char* payload = (const char*)pMessage + sizeof(IPC_MSG_HEADER);
-    printf("[SYSTEM] URL Payload: %s\n", payload);
-    if (worker) worker->PushUrlMessage(std::string(payload)); // URL  ť 
-    else printf("[SYSTEM] worker ctx is null\n");
-}
\ No newline at end of file
+    AGENT_LOG_WARN("[SYSTEM] Rejected message type 0x%04X on queue %s", (unsigned)type, queue->name.c_str());
+}
@@ -1,17 +1,34 @@
 #pragma once
+#include <windows.h>
+#include <initializer_list>
+#include <memory>
 #include <string>
+#include <vector>
 
-class WorkerThread;
+class MessageRouter;
 
 class IpcServer {
 public:
-    IpcServer(WorkerThread* worker);
+    IpcServer(MessageRouter* router);
+
+    //  madCHook ť  ť  ޽  ߰ (Start  ȣ)
+    // Ͽ  nType Ϳ ѱ ʰ  (ٸ ť ڵ鷯  ť ȣ ϵ)
+    void AddQueue(const char* name, std::initializer_list<DWORD> types);
+
     bool Start();
     void Stop();
 
     static void __stdcall OnIpcMsg(LPVOID ctx, PVOID pMessage, DWORD dwSize);
-    static void __stdcall OnUrlMsg(LPVOID ctx, PVOID pMessage, DWORD dwSize); // URL ̺Ʈ
 
 private:
-    WorkerThread* m_worker;
+    // ť ݹ ؽƮ (Start  ּҰ ٲ ʵ  Ҵ)
+    struct Queue {
+        IpcServer* server;
+        std::string name;
+        std::vector<DWORD> types;
+        bool created;
+    };
+
+    MessageRouter* m_router;
+    std::vector<std::unique_ptr<Queue>> m_queues;
 };
\ No newline at end of file
@@ -0,0 +1,207 @@
+﻿#include "LoadTransport.h"
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "madCHook.h"
+#else
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // 같은 프로세스 안의 수신 콜백을 바로 호출
+    class LocalTransport : public LoadTransport {
+    public:
+        const char* Name() const override { return "local"; }
+
+        bool Send(const char* queue, const void* data, uint32_t size) override {
+            std::shared_ptr<ReceiveFn> fn;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                auto it = m_queues.find(queue);
+                if (it == m_queues.end()) return false; // 수신 측 큐가 없으면 실패 (madCHook과 같음)
+                fn = it->second;
+            }
+            (*fn)(data, size);
+            return true;
+        }
+
+        bool Listen(const char* queue, ReceiveFn fn) override {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_queues[queue] = std::make_shared<ReceiveFn>(std::move(fn));
+            return true;
+        }
+
+        void Close() override {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_queues.clear();
+        }
+
+    private:
+        std::mutex m_lock;
+        std::unordered_map<std::string, std::shared_ptr<ReceiveFn>> m_queues;
+    };
+
+#ifdef _WIN32
+    class MadCHookTransport : public LoadTransport {
+    public:
+        MadCHookTransport() { InitializeMadCHook(); }
+        ~MadCHookTransport() override {
+            Close();
+            FinalizeMadCHook();
+        }
+
+        const char* Name() const override { return "madchook"; }
+
+        bool Send(const char* queue, const void* data, uint32_t size) override {
+            return SendIpcMessage(queue, (PVOID)data, (DWORD)size) != FALSE;
+        }
+
+        bool Listen(const char* queue, ReceiveFn fn) override {
+            std::unique_ptr<Listener> listener(new Listener{ queue, std::move(fn) });
+            if (!CreateIpcQueue(queue, (PIPC_CALLBACK_ROUTINE)OnIpcMsg, listener.get())) {
+                printf("[LoadGen] CreateIpcQueue failed: %s\n", queue);
+                return false;
+            }
+            m_listeners.push_back(std::move(listener));
+            return true;
+        }
+
+        void Close() override {
+            for (auto& listener : m_listeners) DestroyIpcQueue(listener->queue.c_str());
+            m_listeners.clear();
+        }
+
+    private:
+        struct Listener {
+            std::string queue;
+            ReceiveFn fn;
+        };
+        std::vector<std::unique_ptr<Listener>> m_listeners;
+
+        static void __stdcall OnIpcMsg(LPVOID ctx, PVOID pMessage, DWORD dwSize) {
+            Listener* listener = (Listener*)ctx;
+            if (listener) listener->fn(pMessage, dwSize);
+        }
+    };
+#else
+    // 큐 하나 = socketDir/<큐 이름>에 바인드된 데이터그램 소켓
+    class UnixSocketTransport : public LoadTransport {
+    public:
+        explicit UnixSocketTransport(const std::string& dir) : m_dir(dir), m_sendFd(-1), m_running(true) {}
+        ~UnixSocketTransport() override { Close(); }
+
+        bool Open() {
+            mkdir(m_dir.c_str(), 0755);
+            m_sendFd = socket(AF_UNIX, SOCK_DGRAM, 0);
+            return m_sendFd >= 0;
+        }
+
+        const char* Name() const override { return "unix"; }
+
+        bool Send(const char* queue, const void* data, uint32_t size) override {
+            sockaddr_un addr;
+            if (!MakeAddress(queue, addr)) return false;
+            // 수신 측 버퍼가 가득 차면 블록 (IPC와 같은 역압)
+            ssize_t n = sendto(m_sendFd, data, size, 0, (const sockaddr*)&addr, sizeof(addr));
+            return n == (ssize_t)size;
+        }
+
+        bool Listen(const char* queue, ReceiveFn fn) override {
+            sockaddr_un addr;
+            if (!MakeAddress(queue, addr)) return false;
+            int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+            if (fd < 0) return false;
+            unlink(addr.sun_path);
+            if (bind(fd, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+                printf("[LoadGen] bind failed: %s (%s)\n", addr.sun_path, strerror(errno));
+                close(fd);
+                return false;
+            }
+            int rcvbuf = 4 * 1024 * 1024;
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+            timeval tv = { 0, 200 * 1000 }; // 종료 확인 주기
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+            std::unique_ptr<Listener> listener(new Listener{ fd, addr.sun_path, std::move(fn), std::thread() });
+            Listener* raw = listener.get();
+            listener->thread = std::thread([this, raw]() { ReceiveLoop(raw); });
+            m_listeners.push_back(std::move(listener));
+            return true;
+        }
+
+        void Close() override {
+            m_running.store(false);
+            for (auto& listener : m_listeners) {
+                if (listener->thread.joinable()) listener->thread.join();
+                close(listener->fd);
+                unlink(listener->path.c_str());
+            }
+            m_listeners.clear();
+            if (m_sendFd >= 0) close(m_sendFd);
+            m_sendFd = -1;
+        }
+
+    private:
+        struct Listener {
+            int fd;
+            std::string path;
+            ReceiveFn fn;
+            std::thread thread;
+        };
+
+        std::string m_dir;
+        int m_sendFd;
+        std::atomic<bool> m_running;
+        std::vector<std::unique_ptr<Listener>> m_listeners;
+
+        bool MakeAddress(const char* queue, sockaddr_un& addr) const {
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            int n = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s", m_dir.c_str(), queue);
+            return n > 0 && (size_t)n < sizeof(addr.sun_path);
+        }
+
+        void ReceiveLoop(Listener* listener) {
+            std::vector<char> buf(256 * 1024);
+            while (m_running.load()) {
+                ssize_t n = recv(listener->fd, buf.data(), buf.size(), 0);
+                if (n > 0) listener->fn(buf.data(), (uint32_t)n);
+            }
+        }
+    };
+#endif
+}
+
+const char* DefaultLoadTransport() {
+#ifdef _WIN32
+    return "madchook";
+#else
+    return "unix";
+#endif
+}
+
+std::unique_ptr<LoadTransport> CreateLoadTransport(const std::string& kind, const std::string& socketDir) {
+    if (kind == "local") return std::unique_ptr<LoadTransport>(new LocalTransport());
+#ifdef _WIN32
+    (void)socketDir;
+    if (kind == "madchook") return std::unique_ptr<LoadTransport>(new MadCHookTransport());
+#else
+    if (kind == "unix") {
+        std::unique_ptr<UnixSocketTransport> transport(new UnixSocketTransport(socketDir));
+        if (transport->Open()) return std::unique_ptr<LoadTransport>(transport.release());
+    }
+#endif
+    return nullptr;
+}
@@ -0,0 +1,32 @@
+﻿#pragma once
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <string>
+
+// LoadGen과 에이전트 사이의 메시지 통로 (큐 이름 단위, 메시지 경계 유지)
+// - madchook: 실제 에이전트와 madCHook IPC (Windows)
+// - unix:     socketDir/<큐 이름> Unix 도메인 데이터그램 소켓 (Linux, `LoadGen echo`와 짝)
+// - local:    같은 프로세스 안에서 바로 전달 (하네스 자체 오버헤드 측정용)
+class LoadTransport {
+public:
+    typedef std::function<void(const void* data, uint32_t size)> ReceiveFn;
+
+    virtual ~LoadTransport() {}
+
+    virtual const char* Name() const = 0;
+
+    // 여러 스레드에서 동시에 호출 가능
+    virtual bool Send(const char* queue, const void* data, uint32_t size) = 0;
+
+    // 큐를 열고 수신 콜백 등록 (콜백은 전송 계층 스레드 또는 송신 스레드에서 호출됨)
+    virtual bool Listen(const char* queue, ReceiveFn fn) = 0;
+
+    virtual void Close() = 0;
+};
+
+// kind: "madchook" | "unix" | "local". 이 플랫폼에서 지원하지 않거나 초기화에 실패하면 nullptr
+std::unique_ptr<LoadTransport> CreateLoadTransport(const std::string& kind, const std::string& socketDir);
+
+// 플랫폼 기본값 (Windows: madchook, 그 외: unix)
+const char* DefaultLoadTransport();
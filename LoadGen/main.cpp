@@ -0,0 +1,2101 @@
+﻿// LoadGen: 에이전트 IPC 부하 생성기 / 종단 간 지연 벤치마크
+//   LoadGen bench  [--rate=초당메시지] [--option-percent=N] [공통 옵션]
+//       IMT_USER_OPTION_UPDATE / IMT_URL_EVENT를 섞어 보내고 UserOptionResponse(결과 묶음 또는 문자열)로 지연 백분위 측정
+//   LoadGen urllog [--rate=초당레코드] [--batch=N] [--hosts=N] [--paths=N] [공통 옵션]
+//       후킹 DLL과 같은 형식의 IMT_URL_LOG_BATCH 묶음 전송 (에이전트 쪽 처리량은 agent.log 참고)
+//       --transport=local이면 같은 프로세스의 수집 경로(IngestSink)가 받아 임시 DB(--work-dir)에 저장
+//   LoadGen echo   [공통 옵션]
+//       에이전트 대역: 옵션 메시지마다 SEQ/TS를 담은 IMT_OPTION_ACK_BATCH로 응답 (Linux에서 unix 전송과 함께 사용)
+//   LoadGen canon  [--corpus=파일] [--iterations=N] [--hosts=N] [--paths=N]
+//       URL 정규화 비용(URL당 ns)과 중복 축소율 측정 (코퍼스: 한 줄에 URL 하나, UTF-8 / 없으면 합성 코퍼스)
+//   LoadGen codec  [--iterations=N] [--hosts=N] [--paths=N]
+//       TextCodec을 스칼라 참조 구현과 비교 (ASCII 고속 경로 경계 길이, 서로게이트, 잘못된 UTF-8, 무작위) 후 처리량(MB/s) 측정
+//   LoadGen alloc  [--iterations=N] [--hosts=N] [--paths=N]
+//       URL 이벤트 경로(풀, 폭주 병합, 재방문 집계, 파이프라인 단계, 라우터 수신)의 정상 상태 operator new 호출 수 (0이어야 함)
+//   LoadGen import [--visits=N] [--hosts=N] [--paths=N] [--work-dir=경로] [--duty=%]
+//       합성 Chromium History / Firefox places.sqlite 픽스처를 HistoryImporter로 가져와 처리량, 중복 제거, 중단 후 이어 가져오기 확인
+//       (모니터링 중 기본 작은 배치와 offline 옵션의 큰 배치 + 인덱스 재생성 둘 다)
+//   LoadGen ingest [--rate=초당레코드] [--batch=N] [--hosts=N] [--paths=N] [--work-dir=경로] [--seconds=N --threads=N]
+//       urllog 묶음을 local 전송으로 실제 수집 경로(MessageRouter → UrlLogIngest → Database::SaveUrlLogBatch)에 넣어 임시 DB 기준 records/s 측정
+//   LoadGen migrate [--rows=N] [--hosts=N] [--paths=N] [--work-dir=경로]
+//       백그라운드 마이그레이션(v8 이전 BrowserUrls.url 정규화)을 청크 도중 Interrupt로 중단 → 롤백 확인 → 재시작 후 이어서 완료되는지
+//   LoadGen pool   [--iterations=N]
+//       WorkStealingPool Submit/Stop 경합 (받아들인 작업은 Stop 전에 실행), 풀 정지 후 MessageRouter 직렬/병렬 경로의 거부된 제출 처리
+//   LoadGen stage  [--items=N]
+//       PipelineStage 검사: 두 단계 순서 보존/처리량, 가득 찬 채널의 역압력, Stop 시 남은 항목 처리
+//   LoadGen uia    [--nodes=N] [--iterations=N]
+//       합성 UIA 트리에서 AddressBarLocator 전체 탐색 대비 학습 경로 비용 (트리 호출 수, locate당 ns), 구조 변경 후 재학습 확인
+//   LoadGen notify
+//       주소 표시줄 값 변경 알림 경로 검사: ChangeNotifyQueue + ChangeGate + TimerWheel로 알림받은 윈도우가 다음 예약 샘플 전에 읽히는지
+//   공통 옵션: --seconds=N --threads=N --transport=madchook|unix|local --socket-dir=경로
+// Linux 빌드: g++ -std=c++14 -O2 -I.. main.cpp LoadTransport.cpp ../UrlCanonicalizer.cpp ../HistoryImporter.cpp ../TextCodec.cpp ../Tracer.cpp ../Watchdog.cpp ../AsyncLogger.cpp
+//             ../UrlEvent.cpp ../ChurnCoalescer.cpp ../VisitAggregator.cpp ../MessageRouter.cpp ../WorkStealingPool.cpp
+//             ../AddressBarLocator.cpp ../ChangeGate.cpp ../ChangeNotifyQueue.cpp ../TimerWheel.cpp
+//             ../Database.cpp ../EventSpool.cpp ../Crc32.cpp ../SchemaMigrator.cpp ../CommonUtils.cpp ../UrlLogIngest.cpp
+//             -lsqlite3 -lpthread
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <sqlite3.h>
+#include "AddressBarLocator.h"
+#include "ChangeGate.h"
+#include "ChangeNotifyQueue.h"
+#include "ChurnCoalescer.h"
+#include "Database.h"
+#include "HistoryImporter.h"
+#include "IpcProtocol.h"
+#include "LoadTransport.h"
+#include "MessageRouter.h"
+#include "PipelineStage.h"
+#include "TextCodec.h"
+#include "TimerWheel.h"
+#include "UrlCanonicalizer.h"
+#include "UrlEvent.h"
+#include "UrlLogIngest.h"
+#include "VisitAggregator.h"
+#include "WorkStealingPool.h"
+
+struct LoadConfig {
+    std::string transport = DefaultLoadTransport();
+    std::string socketDir = "/tmp/pcagent-ipc";
+    double rate = 0;          // 0이면 최대 속도 (bench: 메시지/초, urllog: 레코드/초)
+    int seconds = 10;
+    int threads = 2;
+    int optionPercent = 10;   // bench: 옵션 메시지 비율
+    int drainMs = 2000;       // bench: 전송 종료 후 응답 대기
+    int batch = 256;          // urllog: 메시지당 레코드 수
+    int hosts = 200;          // 호스트 종류 수 (집계 효율에 영향)
+    int paths = 50;           // 호스트당 경로 종류 수
+    int iterations = 20;      // canon: 코퍼스 반복 횟수
+    std::string corpus;       // canon: URL 목록 파일 (비어 있으면 합성)
+    int visits = 1000000;     // import: Chromium 픽스처 방문 수 (Firefox는 1/4)
+    int duty = 100;           // import: HistoryImportOptions::dutyPercent
+    std::string workDir = "."; // import: 픽스처/대상 DB 위치
+    int items = 200000;       // stage: 순서 검사에서 흘려 보낼 항목 수
+    int nodes = 3000;         // uia: 합성 트리 노드 수 (웹 콘텐츠 포함)
+    int rows = 100000;        // migrate: v8 이전 형식 BrowserUrls 행 수
+};
+
+struct LoadCounters {
+    std::atomic<unsigned long long> records{ 0 };   // urllog: 레코드, bench: URL 메시지
+    std::atomic<unsigned long long> options{ 0 };
+    std::atomic<unsigned long long> messages{ 0 };
+    std::atomic<unsigned long long> failed{ 0 };
+};
+
+static uint64_t NowUs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool ParseIntArg(const char* arg, const char* name, int& out) {
+    size_t n = strlen(name);
+    if (strncmp(arg, name, n) != 0) return false;
+    out = atoi(arg + n);
+    return true;
+}
+
+static bool ParseStringArg(const char* arg, const char* name, std::string& out) {
+    size_t n = strlen(name);
+    if (strncmp(arg, name, n) != 0) return false;
+    out = arg + n;
+    return true;
+}
+
+static void Append(std::vector<BYTE>& buf, const void* data, size_t len) {
+    const BYTE* p = (const BYTE*)data;
+    buf.insert(buf.end(), p, p + len);
+}
+
+// 헤더 + 텍스트 페이로드(NUL 포함) 메시지 작성
+static size_t BuildTextMessage(std::vector<BYTE>& buf, DWORD type, const char* text, size_t len) {
+    buf.resize(sizeof(IPC_MSG_HEADER) + len + 1);
+    IPC_MSG_HEADER hdr = { type, (DWORD)(len + 1) };
+    memcpy(buf.data(), &hdr, sizeof(hdr));
+    memcpy(buf.data() + sizeof(hdr), text, len);
+    buf[sizeof(hdr) + len] = 0;
+    return buf.size();
+}
+
+// 송신 스레드 공통: 스레드 몫의 속도에 맞춰 send()를 반복 (밀리면 따라잡기)
+template <typename SendFn>
+static void PacedLoop(double perThreadRate, int unitsPerSend, int seconds, SendFn send) {
+    using clock = std::chrono::steady_clock;
+    auto interval = std::chrono::duration<double>(perThreadRate > 0 ? unitsPerSend / perThreadRate : 0.0);
+    auto start = clock::now();
+    auto end = start + std::chrono::seconds(seconds);
+    auto next = start;
+
+    while (clock::now() < end) {
+        send();
+        if (perThreadRate > 0) {
+            next += std::chrono::duration_cast<clock::duration>(interval);
+            auto now = clock::now();
+            if (next > now) std::this_thread::sleep_for(next - now);
+        }
+    }
+}
+
+// 1초마다 진행 상황 출력
+static void ReportProgress(const LoadConfig& cfg, const LoadCounters& counters, const char* unit) {
+    unsigned long long last = 0;
+    for (int s = 0; s < cfg.seconds; s++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        unsigned long long now = counters.messages.load();
+        printf("[LoadGen] %3d s: %llu msg/s, %llu %s total (failed sends %llu)\n",
+            s + 1, now - last, counters.records.load(), unit, counters.failed.load());
+        last = now;
+    }
+}
+
+// 실패한 검사 이름을 출력하고 false
+static bool Check(bool cond, const char* what) {
+    if (!cond) printf("[LoadGen]   FAILED: %s\n", what);
+    return cond;
+}
+
+// ---------------------------------------------------------------- urllog
+
+// 스레드별 가짜 PID/프로세스 이름으로 묶음 하나 작성 (IPC 헤더 포함)
+static void BuildUrlLogBatch(std::vector<BYTE>& buf, const LoadConfig& cfg, DWORD pid, unsigned int& seed) {
+    static const char* kProc = "loadgen.exe";
+    static const char* kMethods[] = { "GET", "POST", "GET", "GET" };
+
+    buf.clear();
+    buf.resize(sizeof(IPC_MSG_HEADER));
+
+    URL_LOG_BATCH_HEADER bh = {};
+    bh.wVersion = URL_LOG_BATCH_VERSION;
+    bh.wCount = (WORD)cfg.batch;
+    bh.dwPid = pid;
+    bh.wProcNameLen = (WORD)strlen(kProc);
+    Append(buf, &bh, sizeof(bh));
+    Append(buf, kProc, bh.wProcNameLen);
+
+    char host[64], path[64], fullUrl[160];
+    for (int i = 0; i < cfg.batch; i++) {
+        seed = seed * 1103515245u + 12345u; // 재현 가능한 LCG
+        unsigned int h = (seed >> 8) % (unsigned int)cfg.hosts;
+        unsigned int p = (seed >> 4) % (unsigned int)cfg.paths;
+        const char* method = kMethods[seed & 3];
+        const char* scheme = (h & 1) ? "https" : "http";
+
+        int hostLen = snprintf(host, sizeof(host), "host%u.example.com", h);
+        int pathLen = snprintf(path, sizeof(path), "/api/v1/item/%u", p);
+        int urlLen = snprintf(fullUrl, sizeof(fullUrl), "%s://%s%s?r=%u", scheme, host, path, seed & 0xFFFF);
+
+        URL_LOG_RECORD rec = {};
+        rec.wPort = (h & 1) ? 443 : 80;
+        rec.bMethodLen = (BYTE)strlen(method);
+        rec.bSchemeLen = (BYTE)strlen(scheme);
+        rec.wHostLen = (WORD)hostLen;
+        rec.wPathLen = (WORD)pathLen;
+        rec.wFullUrlLen = (WORD)urlLen;
+        Append(buf, &rec, sizeof(rec));
+        Append(buf, method, rec.bMethodLen);
+        Append(buf, scheme, rec.bSchemeLen);
+        Append(buf, host, hostLen);
+        Append(buf, path, pathLen);
+        Append(buf, fullUrl, urlLen);
+    }
+
+    IPC_MSG_HEADER hdr = { IMT_URL_LOG_BATCH, (DWORD)(buf.size() - sizeof(IPC_MSG_HEADER)) };
+    memcpy(buf.data(), &hdr, sizeof(hdr));
+}
+
+static int RunUrlLog(const LoadConfig& cfg, LoadTransport& transport) {
+    printf("[LoadGen] urllog via %s: rate=%.0f rec/s, %d s, %d threads, batch=%d, hosts=%d, paths=%d\n",
+        transport.Name(), cfg.rate, cfg.seconds, cfg.threads, cfg.batch, cfg.hosts, cfg.paths);
+
+    LoadCounters counters;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < cfg.threads; i++) {
+        threads.emplace_back([&cfg, &transport, &counters, i]() {
+            DWORD pid = 100000 + (DWORD)i; // 에이전트가 스레드를 서로 다른 프로세스로 집계하도록
+            unsigned int seed = 0x9E3779B9u * (unsigned int)(i + 1);
+            std::vector<BYTE> buf;
+            PacedLoop(cfg.rate / cfg.threads, cfg.batch, cfg.seconds, [&]() {
+                BuildUrlLogBatch(buf, cfg, pid, seed);
+                if (transport.Send(IPC_NAME_URL_LOG, buf.data(), (uint32_t)buf.size())) {
+                    counters.records += (unsigned long long)cfg.batch;
+                    counters.messages++;
+                }
+                else {
+                    counters.failed++;
+                }
+            });
+        });
+    }
+
+    ReportProgress(cfg, counters, "records");
+    for (auto& t : threads) t.join();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("[LoadGen] sent %llu records in %llu messages, %.2f s, %.0f rec/s, failed sends %llu\n",
+        counters.records.load(), counters.messages.load(), elapsed,
+        elapsed > 0 ? counters.records.load() / elapsed : 0.0, counters.failed.load());
+    return counters.failed.load() == 0 ? 0 : 1;
+}
+
+// ---------------------------------------------------------------- echo (에이전트 대역)
+
+// WorkerThread와 같은 응답 계약: 옵션 메시지마다 결과 레코드(SEQ, 상태, TS)를 IMT_OPTION_ACK_BATCH로 응답 큐에 전송
+class EchoAgent {
+public:
+    explicit EchoAgent(LoadTransport& transport) : m_transport(transport), m_options(0), m_urls(0), m_batches(0) {}
+
+    // urlLog: false면 URL 로그 큐는 다른 수신 측(IngestSink)에 맡김
+    bool Start(bool urlLog = true) {
+        return m_transport.Listen(IPC_NAME_OPTIONS, [this](const void* d, uint32_t n) { OnMessage(d, n); }) &&
+            m_transport.Listen(IPC_NAME_URL, [this](const void* d, uint32_t n) { OnMessage(d, n); }) &&
+            (!urlLog || m_transport.Listen(IPC_NAME_URL_LOG, [this](const void* d, uint32_t n) { OnMessage(d, n); }));
+    }
+
+    void Report() const {
+        printf("[LoadGen] echo: options=%llu urls=%llu urlLogBatches=%llu\n",
+            m_options.load(), m_urls.load(), m_batches.load());
+    }
+
+private:
+    LoadTransport& m_transport;
+    std::atomic<unsigned long long> m_options;
+    std::atomic<unsigned long long> m_urls;
+    std::atomic<unsigned long long> m_batches;
+
+    void OnMessage(const void* data, uint32_t size) {
+        if (size < sizeof(IPC_MSG_HEADER)) return;
+        IPC_MSG_HEADER hdr;
+        memcpy(&hdr, data, sizeof(hdr));
+        const char* payload = (const char*)data + sizeof(hdr);
+        size_t len = std::min<size_t>(hdr.dwSize, size - sizeof(hdr));
+
+        if (hdr.nType == IMT_URL_EVENT) {
+            m_urls++;
+        }
+        else if (hdr.nType == IMT_URL_LOG_BATCH) {
+            m_batches++;
+        }
+        else if (hdr.nType == IMT_USER_OPTION_UPDATE) {
+            m_options++;
+            std::string text(payload, strnlen(payload, len));
+            OPTION_ACK_RECORD rec = {};
+            rec.wStatus = OPTION_ACK_APPLIED;
+            rec.wAttempts = 1;
+            size_t pos = text.find("SEQ=");
+            if (pos != std::string::npos) rec.dwSeq = (DWORD)atoi(text.c_str() + pos + 4);
+            pos = text.find("TS=");
+            if (pos != std::string::npos) rec.qwSentAt = strtoull(text.c_str() + pos + 3, nullptr, 10);
+
+            char response[sizeof(IPC_MSG_HEADER) + sizeof(OPTION_ACK_BATCH_HEADER) + sizeof(OPTION_ACK_RECORD)];
+            IPC_MSG_HEADER out = { IMT_OPTION_ACK_BATCH, (DWORD)(sizeof(response) - sizeof(IPC_MSG_HEADER)) };
+            OPTION_ACK_BATCH_HEADER batch = { OPTION_ACK_BATCH_VERSION, 1 };
+            memcpy(response, &out, sizeof(out));
+            memcpy(response + sizeof(out), &batch, sizeof(batch));
+            memcpy(response + sizeof(out) + sizeof(batch), &rec, sizeof(rec));
+            m_transport.Send(IPC_NAME_OPTION_RESPONSE, response, (uint32_t)sizeof(response));
+        }
+    }
+};
+
+static int RunEcho(const LoadConfig& cfg, LoadTransport& transport) {
+    EchoAgent echo(transport);
+    if (!echo.Start()) {
+        printf("[LoadGen] echo: cannot open queues\n");
+        return 1;
+    }
+    printf("[LoadGen] echo via %s for %d s\n", transport.Name(), cfg.seconds);
+    std::this_thread::sleep_for(std::chrono::seconds(cfg.seconds));
+    echo.Report();
+    return 0;
+}
+
+// ---------------------------------------------------------------- bench
+
+// 응답 지연 수집 (응답 큐 콜백 스레드에서 기록)
+class LatencyRecorder {
+public:
+    LatencyRecorder() : m_responses(0), m_unmatched(0), m_batches(0) { m_samplesUs.reserve(1 << 20); }
+
+    void OnResponse(const void* data, uint32_t size) {
+        uint64_t now = NowUs();
+        if (OnAckBatch(data, size, now)) return;
+
+        // 문자열 응답 (--option-ack=text 또는 구버전 에이전트)
+        const char* text = (const char*)data;
+        std::string response(text, strnlen(text, size));
+        size_t pos = response.find("TS=");
+        m_responses++;
+        if (pos == std::string::npos) {
+            m_unmatched++; // TS를 돌려주지 않는 (구버전) 에이전트
+            return;
+        }
+        uint64_t sentUs = strtoull(response.c_str() + pos + 3, nullptr, 10);
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_samplesUs.push_back(now >= sentUs ? now - sentUs : 0);
+    }
+
+    unsigned long long Responses() const { return m_responses.load(); }
+
+    void Report(unsigned long long requests) {
+        std::vector<uint64_t> samples;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            samples = m_samplesUs;
+        }
+        unsigned long long responses = m_responses.load();
+        printf("[LoadGen] option responses %llu / %llu in %llu batches (unanswered %llu: coalesced or dropped by agent, no TS %llu)\n",
+            responses, requests, m_batches.load(), requests > responses ? requests - responses : 0, m_unmatched.load());
+        if (samples.empty()) return;
+
+        std::sort(samples.begin(), samples.end());
+        auto pct = [&samples](double q) {
+            size_t i = (size_t)(q * samples.size());
+            return samples[std::min(i, samples.size() - 1)] / 1000.0;
+        };
+        printf("[LoadGen] latency ms: p50=%.3f p90=%.3f p99=%.3f p99.9=%.3f max=%.3f (n=%zu)\n",
+            pct(0.50), pct(0.90), pct(0.99), pct(0.999), samples.back() / 1000.0, samples.size());
+    }
+
+private:
+    std::mutex m_lock;
+    std::vector<uint64_t> m_samplesUs;
+    std::atomic<unsigned long long> m_responses;
+    std::atomic<unsigned long long> m_unmatched;
+    std::atomic<unsigned long long> m_batches;
+
+    // IMT_OPTION_ACK_BATCH면 레코드마다 지연 기록. false: 묶음 메시지가 아님
+    bool OnAckBatch(const void* data, uint32_t size, uint64_t now) {
+        const size_t prefix = sizeof(IPC_MSG_HEADER) + sizeof(OPTION_ACK_BATCH_HEADER);
+        if (size < prefix) return false;
+        IPC_MSG_HEADER hdr;
+        memcpy(&hdr, data, sizeof(hdr));
+        if (hdr.nType != IMT_OPTION_ACK_BATCH) return false;
+        OPTION_ACK_BATCH_HEADER batch;
+        memcpy(&batch, (const char*)data + sizeof(hdr), sizeof(batch));
+        if (batch.wVersion != OPTION_ACK_BATCH_VERSION || size < prefix + (size_t)batch.wCount * sizeof(OPTION_ACK_RECORD))
+            return false;
+
+        m_batches++;
+        m_responses += batch.wCount;
+        const char* pos = (const char*)data + prefix;
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (WORD i = 0; i < batch.wCount; i++, pos += sizeof(OPTION_ACK_RECORD)) {
+            OPTION_ACK_RECORD rec;
+            memcpy(&rec, pos, sizeof(rec));
+            if (rec.qwSentAt == 0) {
+                m_unmatched++;
+                continue;
+            }
+            m_samplesUs.push_back(now >= rec.qwSentAt ? now - rec.qwSentAt : 0);
+        }
+        return true;
+    }
+};
+
+static int RunBench(const LoadConfig& cfg, LoadTransport& transport) {
+    printf("[LoadGen] bench via %s: rate=%.0f msg/s, %d s, %d threads, options=%d%%\n",
+        transport.Name(), cfg.rate, cfg.seconds, cfg.threads, cfg.optionPercent);
+
+    LatencyRecorder latency;
+    if (!transport.Listen(IPC_NAME_OPTION_RESPONSE, [&latency](const void* d, uint32_t n) { latency.OnResponse(d, n); })) {
+        printf("[LoadGen] cannot open response queue %s\n", IPC_NAME_OPTION_RESPONSE);
+        return 1;
+    }
+
+    LoadCounters counters;
+    std::atomic<unsigned int> nextSeq{ 1 };
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < cfg.threads; i++) {
+        threads.emplace_back([&, i]() {
+            unsigned int seed = 0x9E3779B9u * (unsigned int)(i + 1);
+            std::vector<BYTE> buf;
+            char text[256];
+            PacedLoop(cfg.rate / cfg.threads, 1, cfg.seconds, [&]() {
+                seed = seed * 1103515245u + 12345u;
+                bool option = (int)((seed >> 8) % 100) < cfg.optionPercent;
+                size_t size;
+                const char* queue;
+                if (option) {
+                    // 에이전트는 TS를 해석하지 않고 응답에 그대로 돌려줌
+                    int len = snprintf(text, sizeof(text), "OPT1=%u;OPT2=%u;OPT3=%u;SEQ=%u;TS=%llu",
+                        seed & 1, (seed >> 1) & 1, (seed >> 2) & 1, nextSeq.fetch_add(1),
+                        (unsigned long long)NowUs());
+                    size = BuildTextMessage(buf, IMT_USER_OPTION_UPDATE, text, (size_t)len);
+                    queue = IPC_NAME_OPTIONS;
+                }
+                else {
+                    unsigned int h = (seed >> 4) % 500;
+                    int len = snprintf(text, sizeof(text), "loadgen|https://host%u.example.com/page/%u|LoadGen TS=%llu",
+                        h, (seed >> 12) % 100, (unsigned long long)NowUs());
+                    size = BuildTextMessage(buf, IMT_URL_EVENT, text, (size_t)len);
+                    queue = IPC_NAME_URL;
+                }
+
+                if (transport.Send(queue, buf.data(), (uint32_t)size)) {
+                    counters.messages++;
+                    if (option) counters.options++;
+                    else counters.records++;
+                }
+                else {
+                    counters.failed++;
+                }
+            });
+        });
+    }
+
+    ReportProgress(cfg, counters, "url events");
+    for (auto& t : threads) t.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // 남은 응답 대기
+    auto drainUntil = std::chrono::steady_clock::now() + std::chrono::milliseconds(cfg.drainMs);
+    while (latency.Responses() < counters.options.load() && std::chrono::steady_clock::now() < drainUntil)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    printf("[LoadGen] sent %llu messages (options %llu, urls %llu) in %.2f s, %.0f msg/s, failed sends %llu\n",
+        counters.messages.load(), counters.options.load(), counters.records.load(), elapsed,
+        elapsed > 0 ? counters.messages.load() / elapsed : 0.0, counters.failed.load());
+    latency.Report(counters.options.load());
+    return counters.failed.load() == 0 ? 0 : 1;
+}
+
+// ----------------------------------------------------------------
+
+// ---------------------------------------------------------------- canon
+
+// UTF-8 한 줄 → wstring (wchar_t가 16비트면 BMP 밖 문자는 서로게이트 쌍)
+static void DecodeUtf8Line(const char* p, size_t len, std::wstring& out) {
+    out.clear();
+    for (size_t i = 0; i < len;) {
+        unsigned char c = (unsigned char)p[i];
+        uint32_t cp;
+        size_t n;
+        if (c < 0x80) { cp = c; n = 1; }
+        else if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; n = 2; }
+        else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; n = 3; }
+        else { cp = c & 0x07; n = 4; }
+        if (i + n > len) break;
+        for (size_t k = 1; k < n; k++) cp = (cp << 6) | ((unsigned char)p[i + k] & 0x3F);
+        i += n;
+        if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+            cp -= 0x10000;
+            out += (wchar_t)(0xD800 + (cp >> 10));
+            out += (wchar_t)(0xDC00 + (cp & 0x3FF));
+        }
+        else {
+            out += (wchar_t)cp;
+        }
+    }
+}
+
+static bool LoadCorpus(const std::string& path, std::vector<std::wstring>& urls) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char line[8192];
+    std::wstring url;
+    while (fgets(line, sizeof(line), f)) {
+        size_t len = strlen(line);
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) len--;
+        if (len == 0) continue;
+        DecodeUtf8Line(line, len, url);
+        urls.push_back(url);
+    }
+    fclose(f);
+    return true;
+}
+
+// 같은 자원을 가리키는 표기 변형(대소문자, 기본 포트, 끝 '/', 프래그먼트, 추적 파라미터, %xx, dot-segment)을 섞은 합성 코퍼스
+// 자원(호스트 × 경로)마다 변형 4개, 호스트 8개 중 1개는 IDN (유니코드/punycode 표기 혼용)
+static void BuildSyntheticCorpus(const LoadConfig& cfg, std::vector<std::wstring>& urls) {
+    static const wchar_t* kHosts[] = { L"www.example.com", L"WWW.Example.COM", L"www.example.com:443", L"www.example.com." };
+    static const wchar_t* kIdnHosts[] = { L"\uD55C\uAD6D.example", L"xn--3e0b707e.example" };
+    static const wchar_t* kSuffixes[] = { L"", L"/", L"#top", L"?utm_source=news&utm_medium=mail", L"?fbclid=IwAR0abc", L"?gclid=xyz" };
+    const int kVariants = 4;
+    wchar_t buf[256];
+    unsigned int seed = 12345;
+    for (int i = 0; i < cfg.hosts * cfg.paths * kVariants; i++) {
+        int h = i / (cfg.paths * kVariants);
+        int p = (i / kVariants) % cfg.paths;
+        seed = seed * 1103515245u + 12345u;
+        const wchar_t* host = (h % 8 == 0) ? kIdnHosts[(seed >> 8) & 1] : kHosts[(seed >> 8) & 3];
+        const wchar_t* dir = ((seed >> 12) & 3) == 0 ? L"/./b/../" : L"/";
+        const wchar_t* item = ((seed >> 14) & 3) == 0 ? L"%7Eitem" : L"~item";
+        swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"https://%ls%lssite%d/%ls%d%ls",
+            host, dir, h, item, p, kSuffixes[(seed >> 16) % 6]);
+        urls.push_back(buf);
+    }
+}
+
+static int RunCanon(const LoadConfig& cfg) {
+    std::vector<std::wstring> corpus;
+    if (!cfg.corpus.empty()) {
+        if (!LoadCorpus(cfg.corpus, corpus)) {
+            printf("[LoadGen] cannot read corpus: %s\n", cfg.corpus.c_str());
+            return 1;
+        }
+    }
+    else {
+        BuildSyntheticCorpus(cfg, corpus);
+    }
+    if (corpus.empty()) {
+        printf("[LoadGen] empty corpus\n");
+        return 1;
+    }
+
+    UrlCanonicalizer canonicalizer;
+    std::unordered_set<std::wstring> rawSet(corpus.begin(), corpus.end()), canonSet;
+    size_t rawChars = 0, canonChars = 0, failed = 0;
+    std::wstring buf; // 모니터와 같이 버퍼 하나를 재사용
+
+    for (const std::wstring& url : corpus) {
+        buf.assign(url);
+        rawChars += url.size();
+        if (!canonicalizer.Canonicalize(buf)) { failed++; continue; }
+        canonChars += buf.size();
+        canonSet.insert(buf);
+    }
+
+    uint64_t start = NowUs();
+    size_t checksum = 0;
+    for (int it = 0; it < cfg.iterations; it++) {
+        for (const std::wstring& url : corpus) {
+            buf.assign(url);
+            canonicalizer.Canonicalize(buf);
+            checksum += buf.size();
+        }
+    }
+    uint64_t elapsedUs = NowUs() - start;
+    double total = (double)corpus.size() * cfg.iterations;
+
+    printf("[LoadGen] canon: %zu urls (%s), %zu failed\n", corpus.size(),
+        cfg.corpus.empty() ? "synthetic" : cfg.corpus.c_str(), failed);
+    printf("[LoadGen] distinct raw %zu -> canonical %zu (%.1f%% fewer rows)\n", rawSet.size(), canonSet.size(),
+        rawSet.empty() ? 0.0 : 100.0 * (1.0 - (double)canonSet.size() / rawSet.size()));
+    printf("[LoadGen] chars raw %zu -> canonical %zu\n", rawChars, canonChars);
+    printf("[LoadGen] %.1f ns/url over %d iterations (checksum %zu)\n",
+        total > 0 ? elapsedUs * 1000.0 / total : 0.0, cfg.iterations, checksum);
+    return 0;
+}
+
+// ---------------------------------------------------------------- codec
+
+// 스칼라 참조 구현 (TextCodec과 같은 규칙: 짝 없는 서로게이트/잘못된 UTF-8 바이트 하나 → U+FFFD)
+static void RefUtf16ToUtf8(const std::u16string& src, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < src.size(); i++) {
+        uint32_t c = src[i];
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < src.size() && src[i + 1] >= 0xDC00 && src[i + 1] <= 0xDFFF) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (src[i + 1] - 0xDC00);
+            i++;
+        }
+        else if (c >= 0xD800 && c <= 0xDFFF) {
+            c = 0xFFFD;
+        }
+        if (c < 0x80) {
+            out += (char)c;
+        }
+        else if (c < 0x800) {
+            out += (char)(0xC0 | (c >> 6));
+            out += (char)(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000) {
+            out += (char)(0xE0 | (c >> 12));
+            out += (char)(0x80 | ((c >> 6) & 0x3F));
+            out += (char)(0x80 | (c & 0x3F));
+        }
+        else {
+            out += (char)(0xF0 | (c >> 18));
+            out += (char)(0x80 | ((c >> 12) & 0x3F));
+            out += (char)(0x80 | ((c >> 6) & 0x3F));
+            out += (char)(0x80 | (c & 0x3F));
+        }
+    }
+}
+
+static void RefUtf8ToUtf16(const std::string& src, std::u16string& out) {
+    const unsigned char* s = (const unsigned char*)src.data();
+    size_t len = src.size();
+    out.clear();
+    for (size_t i = 0; i < len;) {
+        // 선행 바이트별 (길이, 최소값, 최대값). 조건을 모두 만족해야 한 문자
+        uint32_t c = s[i];
+        size_t need = c < 0x80 ? 1 : c >= 0xC2 && c <= 0xDF ? 2 : c >= 0xE0 && c <= 0xEF ? 3 : c >= 0xF0 && c <= 0xF4 ? 4 : 0;
+        uint32_t cp = 0xFFFD;
+        size_t used = 1;
+        if (need == 1) {
+            cp = c;
+        }
+        else if (need > 1 && i + need <= len) {
+            uint32_t v = c & (0x7F >> need);
+            size_t k = 1;
+            for (; k < need && (s[i + k] & 0xC0) == 0x80; k++) v = (v << 6) | (s[i + k] & 0x3F);
+            bool valid = k == need &&
+                !(need == 3 && (v < 0x800 || (v >= 0xD800 && v <= 0xDFFF))) &&
+                !(need == 4 && (v < 0x10000 || v > 0x10FFFF));
+            if (valid) {
+                cp = v;
+                used = need;
+            }
+        }
+        if (cp >= 0x10000) {
+            out += (char16_t)(0xD800 + ((cp - 0x10000) >> 10));
+            out += (char16_t)(0xDC00 + ((cp - 0x10000) & 0x3FF));
+        }
+        else {
+            out += (char16_t)cp;
+        }
+        i += used;
+    }
+}
+
+struct CodecCheck {
+    unsigned long long cases = 0;
+    unsigned long long failures = 0;
+};
+
+// 참조와 같은 결과인지, 정확한 크기 버퍼면 성공하고 한 칸 모자라면 Overflow인지
+static void CheckUtf16Case(CodecCheck& check, const std::u16string& src, const char* label) {
+    std::string expect;
+    RefUtf16ToUtf8(src, expect);
+    std::vector<char> buf(Utf8CapacityFor(src.size()) + 1);
+    size_t n = TranscodeUtf16ToUtf8(src.data(), src.size(), buf.data(), buf.size());
+    size_t exact = TranscodeUtf16ToUtf8(src.data(), src.size(), buf.data(), expect.size());
+    size_t shortBy1 = expect.empty() ? 0 : TranscodeUtf16ToUtf8(src.data(), src.size(), buf.data(), expect.size() - 1);
+    bool ok = n == expect.size() && exact == expect.size() && memcmp(buf.data(), expect.data(), n) == 0 &&
+        (expect.empty() || shortBy1 == kTextCodecOverflow);
+    check.cases++;
+    if (!ok && check.failures++ < 10)
+        printf("[LoadGen]   utf16->utf8 mismatch: %s (%zu units, got %zu, expected %zu)\n", label, src.size(), n, expect.size());
+}
+
+static void CheckUtf8Case(CodecCheck& check, const std::string& src, const char* label) {
+    std::u16string expect;
+    RefUtf8ToUtf16(src, expect);
+    std::vector<char16_t> buf(Utf16CapacityFor(src.size()) + 1);
+    size_t n = TranscodeUtf8ToUtf16(src.data(), src.size(), buf.data(), buf.size());
+    size_t exact = TranscodeUtf8ToUtf16(src.data(), src.size(), buf.data(), expect.size());
+    size_t shortBy1 = expect.empty() ? 0 : TranscodeUtf8ToUtf16(src.data(), src.size(), buf.data(), expect.size() - 1);
+    bool ok = n == expect.size() && exact == expect.size() &&
+        memcmp(buf.data(), expect.data(), n * sizeof(char16_t)) == 0 &&
+        (expect.empty() || shortBy1 == kTextCodecOverflow);
+    check.cases++;
+    if (!ok && check.failures++ < 10)
+        printf("[LoadGen]   utf8->utf16 mismatch: %s (%zu bytes, got %zu, expected %zu)\n", label, src.size(), n, expect.size());
+}
+
+// ASCII 고속 경로 경계 (SSE2 8/16, AVX2 16/32 단위) 앞뒤 길이에 특수 문자를 위치마다 끼워 넣어 비교
+static void CheckCodecBoundaries(CodecCheck& check) {
+    static const size_t kLengths[] = { 0, 1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 47, 48, 63, 64, 65 };
+    struct Insert16 { const char* name; std::u16string units; };
+    const Insert16 inserts16[] = {
+        { "latin1", u"é" },
+        { "hangul", u"가" },
+        { "surrogate pair", std::u16string{ (char16_t)0xD83D, (char16_t)0xDE00 } },
+        { "lone high surrogate", std::u16string{ (char16_t)0xD800 } },
+        { "lone low surrogate", std::u16string{ (char16_t)0xDC00 } },
+        { "reversed pair", std::u16string{ (char16_t)0xDE00, (char16_t)0xD83D } },
+        { "0x7F", std::u16string{ (char16_t)0x7F } },
+        { "0x80", std::u16string{ (char16_t)0x80 } },
+        { "0xFF80", std::u16string{ (char16_t)0xFF80 } },
+    };
+    struct Insert8 { const char* name; std::string bytes; };
+    const Insert8 inserts8[] = {
+        { "2-byte", "\xC3\xA9" },
+        { "3-byte", "\xEA\xB0\x80" },
+        { "4-byte", "\xF0\x9F\x98\x80" },
+        { "lone continuation", "\x80" },
+        { "overlong", "\xC0\xAF" },
+        { "overlong 3-byte", "\xE0\x80\xAF" },
+        { "encoded surrogate", "\xED\xA0\x80" },
+        { "truncated 3-byte", "\xE2\x82" },
+        { "above U+10FFFF", "\xF4\x90\x80\x80" },
+        { "invalid lead", "\xF5\x80\x80\x80" },
+        { "0xFF", "\xFF" },
+    };
+
+    for (size_t len : kLengths) {
+        std::u16string ascii16;
+        std::string ascii8;
+        for (size_t i = 0; i < len; i++) {
+            ascii16 += (char16_t)('a' + i % 26);
+            ascii8 += (char)('a' + i % 26);
+        }
+        CheckUtf16Case(check, ascii16, "ascii");
+        CheckUtf8Case(check, ascii8, "ascii");
+
+        // 위치 0..len (끝 포함): 블록 중간/경계/마지막 꼬리에서 고속 경로가 멈추는지
+        for (size_t pos = 0; pos <= len; pos++) {
+            for (const Insert16& ins : inserts16) {
+                std::u16string s = ascii16;
+                s.insert(pos, ins.units);
+                CheckUtf16Case(check, s, ins.name);
+            }
+            for (const Insert8& ins : inserts8) {
+                std::string s = ascii8;
+                s.insert(pos, ins.bytes);
+                CheckUtf8Case(check, s, ins.name);
+            }
+        }
+    }
+}
+
+// 무작위 입력 (ASCII 위주에 특수 단위를 섞음)
+static void CheckCodecRandom(CodecCheck& check, int count) {
+    unsigned int seed = 12345;
+    auto next = [&seed]() { seed = seed * 1103515245 + 12345; return (seed >> 8) & 0xFFFF; };
+    for (int n = 0; n < count; n++) {
+        size_t len = next() % 80;
+        std::u16string s16;
+        std::string s8;
+        for (size_t i = 0; i < len; i++) {
+            unsigned int r = next();
+            s16 += (char16_t)(r % 4 ? 0x20 + r % 0x5F : next()); // 1/4은 임의 UTF-16 단위 (서로게이트 포함)
+            s8 += (char)(r % 4 ? 0x20 + r % 0x5F : next() & 0xFF);
+        }
+        CheckUtf16Case(check, s16, "random");
+        CheckUtf8Case(check, s8, "random");
+    }
+}
+
+static int RunCodec(const LoadConfig& cfg) {
+    CodecCheck check;
+    CheckCodecBoundaries(check);
+    CheckCodecRandom(check, 100000);
+    printf("[LoadGen] codec: %llu cases against scalar reference, %llu mismatches\n", check.cases, check.failures);
+
+    // 처리량: 합성 URL (대부분 ASCII)과 한글이 섞인 제목
+    std::vector<std::wstring> urls;
+    BuildSyntheticCorpus(cfg, urls);
+    std::vector<std::u16string> ascii, mixed;
+    for (const std::wstring& u : urls) {
+        ascii.push_back(std::u16string(u.begin(), u.end()));
+        mixed.push_back(ascii.back().substr(0, 24) + u"검색 결과 - " + ascii.back().substr(24));
+    }
+
+    struct Row { const char* name; const std::vector<std::u16string>* input; };
+    const Row rows[] = { { "url", &ascii }, { "title", &mixed } };
+    std::vector<char> buf8;
+    std::vector<char16_t> buf16;
+    std::string ref8;
+    std::u16string ref16;
+    for (const Row& row : rows) {
+        std::vector<std::string> encoded;
+        size_t units = 0, bytes = 0;
+        for (const std::u16string& s : *row.input) {
+            RefUtf16ToUtf8(s, ref8);
+            encoded.push_back(ref8);
+            units += s.size();
+            bytes += ref8.size();
+        }
+
+        // 변환기와 참조 구현을 같은 입력으로 (참조는 출력 문자열 재사용)
+        size_t checksum = 0;
+        uint64_t t0 = NowUs();
+        for (int it = 0; it < cfg.iterations; it++) {
+            for (const std::u16string& s : *row.input) {
+                buf8.resize(Utf8CapacityFor(s.size()));
+                checksum += TranscodeUtf16ToUtf8(s.data(), s.size(), buf8.data(), buf8.size());
+            }
+        }
+        uint64_t t1 = NowUs();
+        for (int it = 0; it < cfg.iterations; it++) {
+            for (const std::u16string& s : *row.input) {
+                RefUtf16ToUtf8(s, ref8);
+                checksum += ref8.size();
+            }
+        }
+        uint64_t t2 = NowUs();
+        for (int it = 0; it < cfg.iterations; it++) {
+            for (const std::string& s : encoded) {
+                buf16.resize(Utf16CapacityFor(s.size()));
+                checksum += TranscodeUtf8ToUtf16(s.data(), s.size(), buf16.data(), buf16.size());
+            }
+        }
+        uint64_t t3 = NowUs();
+        for (int it = 0; it < cfg.iterations; it++) {
+            for (const std::string& s : encoded) {
+                RefUtf8ToUtf16(s, ref16);
+                checksum += ref16.size();
+            }
+        }
+        uint64_t t4 = NowUs();
+
+        double mb16 = (double)units * 2 * cfg.iterations / 1e6, mb8 = (double)bytes * cfg.iterations / 1e6;
+        auto rate = [](double mb, uint64_t us) { return us ? mb * 1e6 / us : 0.0; };
+        printf("[LoadGen] %-5s utf16->utf8 %7.0f MB/s (reference %5.0f), utf8->utf16 %7.0f MB/s (reference %5.0f) [%zu]\n",
+            row.name, rate(mb16, t1 - t0), rate(mb16, t2 - t1), rate(mb8, t3 - t2), rate(mb8, t4 - t3), checksum);
+    }
+
+    printf("[LoadGen] codec check %s\n", check.failures == 0 ? "passed" : "FAILED");
+    return check.failures == 0 ? 0 : 1;
+}
+
+// ---------------------------------------------------------------- alloc
+
+// 전역 operator new 호출 수 (alloc 모드에서 정상 상태 할당 확인, 다른 모드에서는 세기만 함)
+static std::atomic<unsigned long long> g_allocations(0);
+
+// 교체 가능한 형태를 모두 같은 카운터와 malloc/free로 보냄 (하나라도 빠지면 라이브러리 기본 구현과 섞여 할당/해제 짝이 어긋남)
+// 인라인되면 GCC가 new 식과 free를 직접 짝지어 -Wmismatched-new-delete를 내므로 함수 경계를 유지
+#ifdef _MSC_VER
+#define LOADGEN_NOINLINE __declspec(noinline)
+#else
+#define LOADGEN_NOINLINE __attribute__((noinline))
+#endif
+static LOADGEN_NOINLINE void* CountedAlloc(size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+static LOADGEN_NOINLINE void CountedFree(void* p) noexcept { free(p); }
+
+void* operator new(size_t size) {
+    if (void* p = CountedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+    if (void* p = CountedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void operator delete(void* p) noexcept { CountedFree(p); }
+void operator delete[](void* p) noexcept { CountedFree(p); }
+void operator delete(void* p, size_t) noexcept { CountedFree(p); }
+void operator delete[](void* p, size_t) noexcept { CountedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { CountedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { CountedFree(p); }
+
+// 이벤트마다 진행시키는 시계 (폭주 병합/재방문 창을 실제 시간과 무관하게 재현)
+class StepClock : public IClock {
+public:
+    uint64_t NowMs() override { return m_now.load(); }
+    void Advance(uint64_t ms) { m_now.fetch_add(ms); }
+
+private:
+    std::atomic<uint64_t> m_now{ 1000000 };
+};
+
+// UrlMonitor의 확정 이후 경로를 그대로 구성:
+//   정규화(버퍼 재사용) → UrlEventPool → ChurnCoalescer → 저장 단계(VisitAggregator) → 전송 단계(FinishIpc)
+//   → 수신 측 MessageRouter::Dispatch (IpcServer 콜백과 같은 호출, 직렬 경로 + 작업 훔치기 풀)
+// 풀/채널/라우터 큐는 최대 대기 수까지만 자라므로 워밍업에서 그 상한을 먼저 채운 뒤,
+// 같은 URL 집합을 반복해 operator new 호출 수를 셈 (DB/UIA/madCHook 호출은 제외)
+static int RunAlloc(const LoadConfig& cfg) {
+    std::vector<std::wstring> corpus;
+    BuildSyntheticCorpus(cfg, corpus);
+    const HWND hwnd = (HWND)(uintptr_t)0x1234;
+    const std::wstring browser = L"chrome.exe";
+    const std::wstring title = L"검색 결과 - Example";
+    const std::wstring noRaw;
+    const size_t kStageCapacity = 64;
+    const size_t kRouteCapacity = 32;
+
+    StepClock clock;
+    UrlCanonicalizer canonicalizer;
+    ChurnCoalescer churn(&clock);
+    VisitAggregator visits(&clock);
+    WorkStealingPool pool(2);
+    MessageRouter router(&pool);
+
+    // 워밍업 중 수신 핸들러를 막아 두는 문 (라우터 큐 → 전송 채널 → 저장 채널 순으로 가득 참)
+    std::mutex gateLock;
+    std::condition_variable gateCv;
+    bool gateOpen = false;
+    std::atomic<unsigned long long> received(0), receivedBytes(0);
+    RouteOptions route;
+    route.ordering = HandlerOrdering::Serial;
+    route.capacity = kRouteCapacity;
+    route.overflow = QueueOverflowPolicy::Block;
+    router.Register(IMT_URL_EVENT, "BrowserUrlEvent", [&](const IpcMessage& msg) {
+        {
+            std::unique_lock<std::mutex> lk(gateLock);
+            gateCv.wait(lk, [&]() { return gateOpen; });
+        }
+        receivedBytes += msg.payload.size();
+        received++;
+    }, route);
+
+    std::atomic<unsigned long long> stored(0), revisits(0);
+    int64_t nextRowId = 1; // 저장 단계 스레드만 사용
+    PipelineStage<UrlEventPtr> notifyStage("AllocNotify", kStageCapacity);
+    PipelineStage<UrlEventPtr> storeStage("AllocStore", kStageCapacity);
+    notifyStage.Start([&](UrlEventPtr& ev) {
+        DWORD totalSize = 0;
+        PIPC_MSG_HEADER hdr = ev->FinishIpc(IMT_URL_EVENT, ev->TraceId(), totalSize);
+        router.Dispatch(hdr, totalSize);
+    });
+    storeStage.Start([&](UrlEventPtr& ev) {
+        int64_t rowId = 0;
+        if (ev->Changes() <= 1 && visits.Lookup(ev->Hwnd(), ev->Url(), ev->UrlLen(), rowId)) revisits++;
+        else visits.Remember(ev->Hwnd(), ev->Url(), ev->UrlLen(), nextRowId++);
+        stored++;
+        notifyStage.Push(std::move(ev));
+    });
+
+    std::wstring canonical; // UrlMonitor와 같이 감지 스레드의 버퍼 재사용
+    std::vector<UrlEventPtr> due;
+    auto submitOne = [&](const std::wstring& raw) {
+        canonical.assign(raw);
+        if (!canonicalizer.Canonicalize(canonical)) return;
+        UrlEventPtr ev = UrlEventPool::Instance().Acquire();
+        ev->Assign(hwnd, browser, canonical, raw == canonical ? noRaw : raw, title);
+        clock.Advance(100);
+        if (churn.Offer(ev)) storeStage.Push(std::move(ev));
+    };
+    // 호스트를 번갈아 방문 (코퍼스는 호스트별로 모여 있음): 0.1초 간격이면 키마다 폭주 임계값 아래로 계속 살아 있음
+    const size_t perHost = corpus.size() / cfg.hosts;
+    auto submit = [&](size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            submitOne(corpus[(i % cfg.hosts) * perHost + (i / cfg.hosts) % perHost]);
+            if (i % 64 == 63) {
+                churn.CollectDue(due);
+                for (UrlEventPtr& d : due) storeStage.Push(std::move(d));
+                due.clear();
+            }
+        }
+    };
+    auto settle = [&]() { // 모든 단계와 라우터가 빌 때까지
+        while (storeStage.Metrics().depth || notifyStage.Metrics().depth || received.load() < stored.load())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    };
+
+    // 워밍업 1: 가장 긴 URL로 모든 대기열을 가득 채움 → 이벤트 수, 이벤트/페이로드 버퍼 크기, 큐 노드가 상한에 도달
+    const std::wstring* longest = &corpus[0];
+    for (const std::wstring& u : corpus) {
+        if (u.size() > longest->size()) longest = &u;
+    }
+    churn.SetEnabled(false); // 같은 URL 반복이 병합되지 않도록
+    std::thread burst([&]() {
+        for (size_t i = 0; i < kStageCapacity * 3 + kRouteCapacity; i++) submitOne(*longest);
+    });
+    while (storeStage.Metrics().depth < kStageCapacity || notifyStage.Metrics().depth < kStageCapacity)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    {
+        std::lock_guard<std::mutex> lk(gateLock);
+        gateOpen = true;
+    }
+    gateCv.notify_all();
+    burst.join();
+    settle();
+    churn.SetEnabled(true);
+    size_t burstEvents = UrlEventPool::Instance().Created();
+
+    // 워밍업 2: 키 상태/재방문 슬랩/스레드별 버퍼가 모두 만들어지도록 코퍼스를 몇 바퀴
+    submit(corpus.size() * 3);
+    settle();
+    unsigned long long warmAllocations = g_allocations.load();
+    unsigned long long warmReceived = received.load();
+    unsigned long long warmRevisits = revisits.load();
+
+    size_t steady = (size_t)cfg.iterations * corpus.size();
+    uint64_t start = NowUs();
+    unsigned long long before = g_allocations.load();
+    submit(steady);
+    settle();
+    unsigned long long allocations = g_allocations.load() - before;
+    uint64_t elapsedUs = NowUs() - start;
+
+    storeStage.Stop();
+    notifyStage.Stop();
+    router.Stop();
+    pool.Stop();
+
+    unsigned long long delivered = received.load() - warmReceived;
+    printf("[LoadGen] alloc: %zu urls, warm-up %llu allocations, pool %zu events (%zu after filling every queue)\n",
+        corpus.size(), warmAllocations, UrlEventPool::Instance().Created(), burstEvents);
+    printf("[LoadGen] steady state: %zu events -> %llu delivered (%llu revisits, %llu held by churn) in %.1f ms\n",
+        steady, delivered, revisits.load() - warmRevisits, churn.Suppressed(), elapsedUs / 1000.0);
+    printf("[LoadGen] operator new: %llu (%.3f per event)\n", allocations, steady ? (double)allocations / steady : 0.0);
+    bool ok = allocations == 0 && delivered > 0;
+    printf("[LoadGen] alloc check %s\n", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------- import
+
+static const int64_t kFixtureEpoch = 1767225600; // 2026-01-01 UTC, 방문 i는 +2i초
+static const int kFixtureSeedEvery = 100;         // Chromium 방문 100건마다 모니터가 이미 기록한 행을 대상 DB에 넣어 둠
+
+static bool ExecSql(sqlite3* db, const char* sql) {
+    char* msg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &msg) == SQLITE_OK) return true;
+    printf("[LoadGen] sql failed: %s\n", msg ? msg : sqlite3_errmsg(db));
+    sqlite3_free(msg);
+    return false;
+}
+
+static void RemoveDb(const std::string& path) {
+    remove(path.c_str());
+    remove((path + "-wal").c_str());
+    remove((path + "-shm").c_str());
+    remove((path + "-journal").c_str());
+}
+
+static long long QueryCount(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    long long n = -1;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+        n = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return n;
+}
+
+// 에이전트 스키마(현재 버전)의 BrowserUrls + ImportProgress
+static sqlite3* CreateImportTarget(const std::string& path) {
+    RemoveDb(path);
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK ||
+        !ExecSql(db,
+            "PRAGMA journal_mode=WAL;"
+            "CREATE TABLE BrowserUrls (id INTEGER PRIMARY KEY AUTOINCREMENT, browser_name TEXT NOT NULL, url TEXT NOT NULL, "
+            "window_title TEXT, timestamp DATETIME DEFAULT CURRENT_TIMESTAMP, visit_count INTEGER NOT NULL DEFAULT 1, "
+            "last_seen DATETIME, raw_url TEXT, change_count INTEGER NOT NULL DEFAULT 1);"
+            "CREATE INDEX idx_urls_timestamp ON BrowserUrls(timestamp);") ||
+        !ExecSql(db, HistoryImporter::kProgressSql)) {
+        sqlite3_close(db);
+        return nullptr;
+    }
+    return db;
+}
+
+// Chromium History 픽스처. 반환: 가져와야 할 행 수 (-1 = 실패)
+// URL 10개 중 1개는 정규화로 바뀌는 표기(raw_url 보관), 50개 중 1개는 data: (정규화 불가로 건너뜀)
+// 방문 20건 중 1건은 하위 프레임(transition 코어 3)으로 제외, 100건마다 대상 DB에 같은 방문을 미리 기록(중복)
+// 연결을 열어 둔 채 WAL에 남겨 두어 브라우저가 실행 중인 상태처럼 -wal 복사 경로도 확인
+static long long BuildChromiumFixture(const LoadConfig& cfg, sqlite3* src, sqlite3* target) {
+    if (!ExecSql(src,
+        "PRAGMA journal_mode=WAL; PRAGMA wal_autocheckpoint=0;"
+        "CREATE TABLE urls (id INTEGER PRIMARY KEY, url LONGVARCHAR, title LONGVARCHAR, visit_count INTEGER DEFAULT 0 NOT NULL, "
+        "typed_count INTEGER DEFAULT 0 NOT NULL, last_visit_time INTEGER NOT NULL, hidden INTEGER DEFAULT 0 NOT NULL);"
+        "CREATE TABLE visits (id INTEGER PRIMARY KEY, url INTEGER NOT NULL, visit_time INTEGER NOT NULL, "
+        "from_visit INTEGER, transition INTEGER DEFAULT 0 NOT NULL);"
+        "BEGIN;")) return -1;
+
+    const int nUrls = cfg.hosts * cfg.paths;
+    std::vector<std::string> urls(nUrls + 1);
+    sqlite3_stmt* insUrl = nullptr;
+    sqlite3_stmt* insVisit = nullptr;
+    sqlite3_stmt* seed = nullptr;
+    sqlite3_prepare_v2(src, "INSERT INTO urls (id, url, title, last_visit_time) VALUES (?, ?, ?, 0);", -1, &insUrl, nullptr);
+    sqlite3_prepare_v2(src, "INSERT INTO visits (id, url, visit_time, transition) VALUES (?, ?, ?, ?);", -1, &insVisit, nullptr);
+    sqlite3_prepare_v2(target, "INSERT INTO BrowserUrls (browser_name, url, window_title, timestamp) "
+        "VALUES ('chrome.exe', ?, 'live', datetime(?, 'unixepoch'));", -1, &seed, nullptr);
+    ExecSql(target, "BEGIN;");
+
+    char buf[128];
+    for (int u = 1; u <= nUrls; u++) {
+        int h = (u - 1) / cfg.paths, p = (u - 1) % cfg.paths;
+        if (u % 50 == 0) snprintf(buf, sizeof(buf), "data:text/html,%d", u);
+        else if (u % 10 == 1) snprintf(buf, sizeof(buf), "https://Site%d.Example:443/page%d/?utm_source=mail", h, p);
+        else snprintf(buf, sizeof(buf), "https://site%d.example/page%d", h, p);
+        urls[u] = buf;
+        snprintf(buf, sizeof(buf), "Page %d - Site %d", p, h);
+        sqlite3_bind_int(insUrl, 1, u);
+        sqlite3_bind_text(insUrl, 2, urls[u].c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(insUrl, 3, buf, -1, SQLITE_TRANSIENT);
+        sqlite3_step(insUrl);
+        sqlite3_reset(insUrl);
+    }
+
+    long long expected = 0;
+    for (int i = 0; i < cfg.visits; i++) {
+        int u = (int)((long long)i * 7919 % nUrls) + 1;
+        int64_t sec = kFixtureEpoch + 2LL * i;
+        bool subframe = i % 20 == 19;
+        sqlite3_bind_int(insVisit, 1, i + 1);
+        sqlite3_bind_int(insVisit, 2, u);
+        sqlite3_bind_int64(insVisit, 3, (sec + 11644473600LL) * 1000000 + 123);
+        sqlite3_bind_int(insVisit, 4, subframe ? 3 : (i & 1) ? 0x30000000 : 1); // 한정자 비트는 무시되어야 함
+        sqlite3_step(insVisit);
+        sqlite3_reset(insVisit);
+        if (subframe || u % 50 == 0) continue;
+        if (i % kFixtureSeedEvery == 7 && u % 10 != 1) {
+            sqlite3_bind_text(seed, 1, urls[u].c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(seed, 2, sec + 1);
+            sqlite3_step(seed);
+            sqlite3_reset(seed);
+            continue;
+        }
+        expected++;
+    }
+    sqlite3_finalize(insUrl);
+    sqlite3_finalize(insVisit);
+    sqlite3_finalize(seed);
+    if (!ExecSql(target, "COMMIT;") || !ExecSql(src, "COMMIT;")) return -1;
+    return expected;
+}
+
+// Firefox places.sqlite 픽스처 (롤백 저널 모드, 닫힌 상태). 방문 25건 중 1건은 EMBED(4)로 제외
+static long long BuildFirefoxFixture(const LoadConfig& cfg, const std::string& path) {
+    RemoveDb(path);
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK ||
+        !ExecSql(db,
+            "CREATE TABLE moz_places (id INTEGER PRIMARY KEY, url LONGVARCHAR, title LONGVARCHAR, rev_host LONGVARCHAR, "
+            "visit_count INTEGER DEFAULT 0, hidden INTEGER DEFAULT 0 NOT NULL, last_visit_date INTEGER);"
+            "CREATE TABLE moz_historyvisits (id INTEGER PRIMARY KEY, from_visit INTEGER, place_id INTEGER, "
+            "visit_date INTEGER, visit_type INTEGER, session INTEGER);"
+            "BEGIN;")) {
+        sqlite3_close(db);
+        return -1;
+    }
+    const int nPlaces = cfg.hosts * cfg.paths;
+    sqlite3_stmt* insPlace = nullptr;
+    sqlite3_stmt* insVisit = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO moz_places (id, url, title) VALUES (?, ?, ?);", -1, &insPlace, nullptr);
+    sqlite3_prepare_v2(db, "INSERT INTO moz_historyvisits (id, place_id, visit_date, visit_type) VALUES (?, ?, ?, ?);", -1, &insVisit, nullptr);
+    char url[128];
+    for (int u = 1; u <= nPlaces; u++) {
+        snprintf(url, sizeof(url), "https://ff%d.example/p%d", (u - 1) / cfg.paths, (u - 1) % cfg.paths);
+        sqlite3_bind_int(insPlace, 1, u);
+        sqlite3_bind_text(insPlace, 2, url, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_null(insPlace, 3); // 제목 없는 페이지
+        sqlite3_step(insPlace);
+        sqlite3_reset(insPlace);
+    }
+    long long expected = 0;
+    int visits = cfg.visits / 4;
+    for (int i = 0; i < visits; i++) {
+        bool embed = i % 25 == 24;
+        sqlite3_bind_int(insVisit, 1, i + 1);
+        sqlite3_bind_int(insVisit, 2, (int)((long long)i * 7919 % nPlaces) + 1);
+        sqlite3_bind_int64(insVisit, 3, (kFixtureEpoch + 2LL * i) * 1000000 + 456);
+        sqlite3_bind_int(insVisit, 4, embed ? 4 : 1);
+        sqlite3_step(insVisit);
+        sqlite3_reset(insVisit);
+        if (!embed) expected++;
+    }
+    sqlite3_finalize(insPlace);
+    sqlite3_finalize(insVisit);
+    bool ok = ExecSql(db, "COMMIT;");
+    sqlite3_close(db);
+    return ok ? expected : -1;
+}
+
+static void PrintImportStats(const char* label, const HistoryImportStats& st) {
+    printf("[LoadGen] %s: visits %llu, inserted %llu, duplicates %llu, skipped %llu, batches %d, %.0f ms (%.0f visits/s)%s%s%s\n",
+        label, st.visits, st.inserted, st.duplicates, st.skipped, st.batches, st.elapsedMs,
+        st.elapsedMs > 0 ? st.visits * 1000.0 / st.elapsedMs : 0.0, st.completed ? "" : " [interrupted]",
+        st.error.empty() ? "" : " error: ", st.error.c_str());
+}
+
+static int RunImport(const LoadConfig& cfg) {
+    std::string base = cfg.workDir + "/";
+    std::string targetPath = base + "import-target.db";
+    std::string chromePath = base + "import-chrome-History";
+    std::string firefoxPath = base + "import-places.sqlite";
+
+    uint64_t buildStart = NowUs();
+    sqlite3* target = CreateImportTarget(targetPath);
+    RemoveDb(chromePath);
+    sqlite3* chrome = nullptr;
+    if (!target || sqlite3_open(chromePath.c_str(), &chrome) != SQLITE_OK) {
+        printf("[LoadGen] cannot create fixtures in %s\n", cfg.workDir.c_str());
+        sqlite3_close(target);
+        sqlite3_close(chrome);
+        return 1;
+    }
+    long long expectChrome = BuildChromiumFixture(cfg, chrome, target);
+    long long expectFirefox = BuildFirefoxFixture(cfg, firefoxPath);
+    long long seeded = QueryCount(target, "SELECT COUNT(*) FROM BrowserUrls;");
+    if (expectChrome < 0 || expectFirefox < 0) {
+        sqlite3_close(target);
+        sqlite3_close(chrome);
+        return 1;
+    }
+    printf("[LoadGen] fixtures: chromium %d visits (WAL open), firefox %d visits, %lld live rows, built in %.1f s\n",
+        cfg.visits, cfg.visits / 4, seeded, (NowUs() - buildStart) / 1e6);
+
+    HistoryImportOptions options;
+    options.workDir = cfg.workDir;
+    options.dutyPercent = cfg.duty;
+    HistorySource chromeSource{ HistorySourceKind::Chromium, "chrome.exe", chromePath };
+    HistorySource firefoxSource{ HistorySourceKind::Firefox, "firefox.exe", firefoxPath };
+
+    // 1) 백그라운드 가져오기를 도중에 멈춘 뒤 2) 같은 원본을 다시 가져와 나머지만 들어오는지
+    {
+        HistoryImporter importer(targetPath, options);
+        importer.AddSource(chromeSource);
+        importer.Start();
+        // 첫 배치가 커밋될 때까지 기다렸다가 중단
+        for (int i = 0; i < 1000 && QueryCount(target, "SELECT COUNT(*) FROM BrowserUrls;") == seeded; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        importer.Stop();
+    }
+    long long afterStop = QueryCount(target, "SELECT COUNT(*) FROM BrowserUrls;") - seeded;
+
+    HistoryImporter importer(targetPath, options);
+    HistoryImportStats chromeStats, firefoxStats, again;
+    importer.Import(chromeSource, chromeStats);
+    PrintImportStats("chromium (resumed)", chromeStats);
+    importer.Import(firefoxSource, firefoxStats);
+    PrintImportStats("firefox", firefoxStats);
+
+    // 3) 전부 가져온 뒤 다시 실행하면 아무것도 들어오지 않음
+    unsigned long long reimported = 0;
+    importer.Import(chromeSource, again);
+    reimported += again.inserted;
+    importer.Import(firefoxSource, again);
+    reimported += again.inserted;
+
+    long long chromeRows = QueryCount(target, "SELECT COUNT(*) FROM BrowserUrls WHERE browser_name = 'chrome.exe' AND window_title <> 'live';");
+    long long firefoxRows = QueryCount(target, "SELECT COUNT(*) FROM BrowserUrls WHERE browser_name = 'firefox.exe';");
+    long long rawRows = QueryCount(target, "SELECT COUNT(*) FROM BrowserUrls WHERE raw_url IS NOT NULL;");
+    long long index = QueryCount(target, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'idx_urls_timestamp';");
+    printf("[LoadGen] rows before stop %lld, chromium %lld / %lld expected, firefox %lld / %lld expected, raw_url kept %lld\n",
+        afterStop, chromeRows, expectChrome, firefoxRows, expectFirefox, rawRows);
+    printf("[LoadGen] re-import inserted %llu, timestamp index %s\n", reimported, index == 1 ? "present" : "MISSING");
+
+    // 4) 오프라인(첫 실행) 가져오기: 큰 배치 + 인덱스를 끝에서 생성. 도중에 멈춰도 인덱스가 다시 만들어지는지
+    //    빈 대상 DB이므로 모니터가 기록한 행(seeded)도 모두 들어옴
+    std::string offlinePath = base + "import-offline.db";
+    sqlite3* offline = CreateImportTarget(offlinePath);
+    HistoryImportOptions offlineOptions = options;
+    offlineOptions.offline = true;
+    {
+        HistoryImporter importer(offlinePath, offlineOptions);
+        importer.AddSource(chromeSource);
+        importer.Start();
+        for (int i = 0; i < 1000 && QueryCount(offline, "SELECT COUNT(*) FROM BrowserUrls;") == 0; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        importer.Stop();
+    }
+    long long offlineIndexAfterStop = QueryCount(offline, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'idx_urls_timestamp';");
+    HistoryImporter offlineImporter(offlinePath, offlineOptions);
+    HistoryImportStats offlineChrome, offlineFirefox;
+    offlineImporter.Import(chromeSource, offlineChrome);
+    PrintImportStats("offline chromium (resumed)", offlineChrome);
+    offlineImporter.Import(firefoxSource, offlineFirefox);
+    PrintImportStats("offline firefox", offlineFirefox);
+    long long offlineChromeRows = QueryCount(offline, "SELECT COUNT(*) FROM BrowserUrls WHERE browser_name = 'chrome.exe';");
+    long long offlineFirefoxRows = QueryCount(offline, "SELECT COUNT(*) FROM BrowserUrls WHERE browser_name = 'firefox.exe';");
+    long long offlineIndex = QueryCount(offline, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'idx_urls_timestamp';");
+    printf("[LoadGen] offline: chromium %lld / %lld expected, firefox %lld / %lld expected, timestamp index %s after stop, %s at end\n",
+        offlineChromeRows, expectChrome + seeded, offlineFirefoxRows, expectFirefox,
+        offlineIndexAfterStop == 1 ? "present" : "MISSING", offlineIndex == 1 ? "present" : "MISSING");
+
+    sqlite3_close(offline);
+    sqlite3_close(chrome);
+    sqlite3_close(target);
+    bool ok = chromeRows == expectChrome && firefoxRows == expectFirefox && reimported == 0 && index == 1 &&
+        chromeStats.error.empty() && firefoxStats.error.empty();
+    ok &= Check(offlineChromeRows == expectChrome + seeded && offlineFirefoxRows == expectFirefox, "offline import rows");
+    ok &= Check(offlineIndexAfterStop == 1 && offlineIndex == 1, "offline import rebuilds timestamp index");
+    ok &= Check(offlineChrome.error.empty() && offlineFirefox.error.empty(), "offline import errors");
+    printf("[LoadGen] import check %s\n", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------- stage
+
+// 두 단계를 이어 items개를 흘려 보내고 도착 순서/처리량 확인
+static bool StageOrderingCheck(int items) {
+    PipelineStage<int> first("stage-first", 256);
+    PipelineStage<int> second("stage-second", 256);
+    std::atomic<int> received(0);
+    std::atomic<int> outOfOrder(0);
+    int expected = 0; // second 스레드만 사용
+
+    second.Start([&](int& v) {
+        if (v != expected) outOfOrder++;
+        expected = v + 1;
+        received++;
+    });
+    first.Start([&](int& v) { second.Push(v); });
+
+    uint64_t start = NowUs();
+    for (int i = 0; i < items; i++) first.Push(i);
+    first.Stop();  // 앞 단계부터 비움
+    second.Stop();
+    uint64_t elapsedUs = NowUs() - start;
+
+    StageMetrics m = second.Metrics();
+    printf("[LoadGen] ordering: %d items in %.1f ms (%.0f items/s), second stage high %zu, blocked %llu\n",
+        items, elapsedUs / 1000.0, elapsedUs ? items * 1e6 / elapsedUs : 0.0, m.queue.highWater, m.queue.blocked);
+    bool ok = Check(received.load() == items, "every item reached the last stage");
+    ok &= Check(outOfOrder.load() == 0, "items arrive in push order");
+    return ok;
+}
+
+// 처리 함수가 멈춘 동안 가득 찬 채널의 Push가 대기하고, 풀리면 이어서 들어가는지
+static bool StageBackpressureCheck() {
+    const size_t capacity = 4;
+    PipelineStage<int> stage("stage-gate", capacity);
+    std::mutex gateLock;
+    std::condition_variable gateCv;
+    bool open = false;
+    std::atomic<int> processed(0);
+
+    stage.Start([&](int&) {
+        std::unique_lock<std::mutex> lk(gateLock);
+        gateCv.wait(lk, [&]() { return open; });
+        processed++;
+    });
+
+    // 처리 중 1개 + 채널 capacity개까지는 바로 들어감
+    stage.Push(0);
+    while (stage.Metrics().depth != 0) std::this_thread::yield();
+    for (size_t i = 1; i <= capacity; i++) stage.Push((int)i);
+
+    std::atomic<bool> returned(false);
+    std::thread producer([&]() {
+        stage.Push((int)capacity + 1);
+        returned.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    bool blockedWhileFull = !returned.load();
+    StageMetrics full = stage.Metrics();
+
+    {
+        std::lock_guard<std::mutex> lk(gateLock);
+        open = true;
+    }
+    gateCv.notify_all();
+    producer.join();
+    stage.Stop();
+
+    printf("[LoadGen] backpressure: depth %zu of %zu while stalled, producer %s, blocked %llu, processed %d\n",
+        full.depth, capacity, blockedWhileFull ? "waited" : "did NOT wait", full.queue.blocked, processed.load());
+    bool ok = Check(blockedWhileFull, "push into a full channel waits");
+    ok &= Check(full.depth == capacity, "channel holds exactly its capacity");
+    ok &= Check(full.queue.blocked >= 1, "blocked push is counted");
+    ok &= Check(processed.load() == (int)capacity + 2, "waiting push is delivered after release");
+    return ok;
+}
+
+// Stop이 남은 항목을 모두 처리한 뒤 끝나고, 이후 Push는 거부되는지
+static bool StageShutdownCheck() {
+    const int items = 2000;
+    PipelineStage<std::string> stage("stage-drain", items);
+    std::atomic<int> processed(0);
+    stage.Start([&](std::string&) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        processed++;
+    });
+    for (int i = 0; i < items; i++) stage.Push(std::to_string(i));
+    size_t pending = stage.Metrics().depth;
+    stage.Stop();
+    bool rejected = !stage.Push("late");
+
+    printf("[LoadGen] shutdown: %zu pending at Stop, %d / %d processed, push after stop %s\n",
+        pending, processed.load(), items, rejected ? "rejected" : "ACCEPTED");
+    bool ok = Check(processed.load() == items, "Stop drains every queued item");
+    ok &= Check(rejected, "push after Stop fails");
+    return ok;
+}
+
+static int RunStage(const LoadConfig& cfg) {
+    bool ok = StageOrderingCheck(cfg.items);
+    ok &= StageBackpressureCheck();
+    ok &= StageShutdownCheck();
+    printf("[LoadGen] stage check %s\n", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------- ingest
+// 에이전트 수집 경로 대역: IMT_URL_LOG_BATCH → MessageRouter → UrlLogIngest::OnBatch → Database::SaveUrlLogBatch (임시 DB)
+
+class IngestSink {
+public:
+    explicit IngestSink(const std::string& dbPath)
+        : m_dbPath(dbPath), m_pool(2), m_router(&m_pool), m_ingest(&m_database), m_received(0) {}
+
+    bool Start(LoadTransport& transport) {
+        RemoveDb(m_dbPath);
+        if (!m_database.Initialize(m_dbPath.c_str())) {
+            printf("[LoadGen] ingest: cannot open %s\n", m_dbPath.c_str());
+            return false;
+        }
+        m_ingest.RegisterHandlers(m_router);
+        m_ingest.Start();
+        m_start = std::chrono::steady_clock::now();
+        return transport.Listen(IPC_NAME_URL_LOG, [this](const void* d, uint32_t n) { OnMessage(d, n); });
+    }
+
+    // 남은 묶음과 집계를 모두 저장한 뒤 UrlLogs의 hit_count 합이 수집 레코드 수와 같은지 확인
+    bool Finish() {
+        m_router.Stop();
+        m_ingest.Stop();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        m_database.Close();
+
+        long long stored = -1;
+        long long rows = -1;
+        sqlite3* db = nullptr;
+        if (sqlite3_open_v2(m_dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK) {
+            stored = QueryCount(db, "SELECT COALESCE(SUM(hit_count), 0) FROM UrlLogs");
+            rows = QueryCount(db, "SELECT COUNT(*) FROM UrlLogs");
+        }
+        sqlite3_close(db);
+
+        unsigned long long accepted = m_ingest.Records();
+        printf("[LoadGen] ingest: received %llu records, accepted %llu (router dropped %llu), rejected batches %llu\n",
+            m_received.load(), accepted, m_received.load() - accepted, m_ingest.Rejected());
+        printf("[LoadGen] ingest: %llu rows written, UrlLogs rows %lld, hit_count sum %lld, %.0f records/s end to end\n",
+            m_ingest.RowsWritten(), rows, stored, elapsed > 0 ? accepted / elapsed : 0.0);
+
+        bool ok = true;
+        ok &= Check(m_ingest.Rejected() == 0, "no rejected batches");
+        ok &= Check(stored == (long long)accepted, "hit_count sum equals accepted records");
+        ok &= Check(rows == (long long)m_ingest.RowsWritten(), "UrlLogs rows equal rows written");
+        RemoveDb(m_dbPath);
+        return ok;
+    }
+
+    unsigned long long Accepted() const { return m_ingest.Records(); }
+
+private:
+    std::string m_dbPath;
+    Database m_database;
+    WorkStealingPool m_pool;
+    MessageRouter m_router;
+    UrlLogIngest m_ingest;
+    std::atomic<unsigned long long> m_received;
+    std::chrono::steady_clock::time_point m_start;
+
+    void OnMessage(const void* data, uint32_t size) {
+        URL_LOG_BATCH_HEADER hdr;
+        if (size >= sizeof(IPC_MSG_HEADER) + sizeof(hdr)) {
+            memcpy(&hdr, (const BYTE*)data + sizeof(IPC_MSG_HEADER), sizeof(hdr));
+            m_received += hdr.wCount;
+        }
+        m_router.Dispatch(data, (DWORD)size);
+    }
+};
+
+static int RunIngest(const LoadConfig& cfg) {
+    std::unique_ptr<LoadTransport> transport = CreateLoadTransport("local", cfg.socketDir);
+    IngestSink sink(cfg.workDir + "/loadgen-ingest.db");
+    if (!sink.Start(*transport)) return 1;
+
+    int rc = RunUrlLog(cfg, *transport);
+    bool ok = sink.Finish();
+    ok &= Check(sink.Accepted() > 0, "ingest accepted records");
+    transport->Close();
+    printf("[LoadGen] ingest check %s\n", rc == 0 && ok ? "passed" : "FAILED");
+    return rc == 0 && ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------- migrate
+// Database의 백그라운드 마이그레이션(v8 이전 BrowserUrls.url 정규화)을 청크 도중에 중단한 뒤 재시작해서 이어 가는지
+
+static const int kMigrateChunkRows = 500; // WorkerThread의 kMigrationChunkRows와 같은 크기
+
+// SchemaBackgroundMigrations의 진행 위치 (행이 없으면 0)
+static long long MigrationCursor(sqlite3* db, bool& done) {
+    const std::string where = std::string(" FROM SchemaBackgroundMigrations WHERE name = '") + Database::kCanonicalUrlMigration + "';";
+    done = QueryCount(db, ("SELECT done" + where).c_str()) == 1;
+    long long cursor = QueryCount(db, ("SELECT cursor" + where).c_str());
+    return cursor < 0 ? 0 : cursor;
+}
+
+// 정규화된 행은 url == Canonicalize(raw_url), 나머지는 이미 정규 URL이거나 정규화할 수 없는 URL
+static long long CountMisconverted(sqlite3* db) {
+    UrlCanonicalizer canonicalizer;
+    sqlite3_stmt* stmt = nullptr;
+    long long bad = 0;
+    if (sqlite3_prepare_v2(db, "SELECT url, raw_url FROM BrowserUrls;", -1, &stmt, nullptr) != SQLITE_OK) return -1;
+    std::wstring wide;
+    std::string url;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* stored = (const char*)sqlite3_column_text(stmt, 0);
+        const char* raw = (const char*)sqlite3_column_text(stmt, 1);
+        const char* source = raw ? raw : stored;
+        DecodeUtf8Line(source, strlen(source), wide);
+        if (!canonicalizer.Canonicalize(wide)) {
+            if (raw) bad++; // 정규화할 수 없는 URL은 바뀌지 않아야 함
+            continue;
+        }
+        url.resize(Utf8CapacityFor(wide.size()));
+        url.resize(TranscodeUtf16ToUtf8(wide.data(), wide.size(), &url[0], url.size()));
+        if (url != stored || (!raw && url != source)) bad++;
+    }
+    sqlite3_finalize(stmt);
+    return bad;
+}
+
+static int RunMigrate(const LoadConfig& cfg) {
+    const std::string path = cfg.workDir + "/loadgen-migrate.db";
+    RemoveDb(path);
+
+    // 현재 스키마로 만든 뒤 v8 이전처럼 주소 표시줄 원본만 가진 행을 채움 (4행 중 1행은 이미 정규 URL, 100행마다 URL이 아닌 값)
+    {
+        Database database;
+        if (!database.Initialize(path.c_str())) return 1;
+        database.Close();
+    }
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        sqlite3_close(db);
+        return 1;
+    }
+    sqlite3_busy_timeout(db, 5000);
+    sqlite3_stmt* insert = nullptr;
+    bool ok = ExecSql(db, "BEGIN;") &&
+        sqlite3_prepare_v2(db, "INSERT INTO BrowserUrls (browser_name, url, window_title) VALUES ('chrome.exe', ?1, 'legacy');",
+            -1, &insert, nullptr) == SQLITE_OK;
+    long long legacy = 0;
+    char url[256];
+    for (int i = 0; ok && i < cfg.rows; i++) {
+        unsigned h = (unsigned)i % (unsigned)cfg.hosts;
+        unsigned p = (unsigned)i % (unsigned)cfg.paths;
+        if (i % 100 == 99) snprintf(url, sizeof(url), "about:blank#%d", i);
+        else if (i % 4 == 0) snprintf(url, sizeof(url), "https://host%u.example.com/page/%u", h, p);
+        else {
+            snprintf(url, sizeof(url), "HTTPS://Host%u.Example.COM:443/page/%u/?utm_source=legacy&id=%d#top", h, p, i);
+            legacy++;
+        }
+        sqlite3_bind_text(insert, 1, url, -1, SQLITE_TRANSIENT);
+        ok = sqlite3_step(insert) == SQLITE_DONE;
+        sqlite3_reset(insert);
+    }
+    sqlite3_finalize(insert);
+    ok = ok && ExecSql(db, "COMMIT;");
+    if (!ok) {
+        printf("[LoadGen] migrate: cannot build fixture: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    printf("[LoadGen] migrate: %d legacy rows (%lld need canonicalizing), chunk %d rows\n", cfg.rows, legacy, kMigrateChunkRows);
+
+    // 1) 청크 몇 개를 커밋한 뒤 큰 청크 하나를 실행 도중에 중단 (감시기 복구와 같은 Database::Interrupt)
+    Database database;
+    if (!database.Initialize(path.c_str())) {
+        sqlite3_close(db);
+        return 1;
+    }
+    const int firstChunks = 4;
+    for (int i = 0; i < firstChunks; i++) database.RunBackgroundMigrations(kMigrateChunkRows);
+    bool done = false;
+    long long beforeInterrupt = MigrationCursor(db, done);
+
+    std::atomic<bool> finished(false);
+    bool more = true;
+    std::thread chunk([&]() {
+        more = database.RunBackgroundMigrations(cfg.rows);
+        finished = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 청크 함수가 행을 처리하는 중
+    while (!finished.load()) {
+        database.Interrupt(DbShard::History);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    chunk.join();
+    long long afterInterrupt = MigrationCursor(db, done);
+    long long partial = QueryCount(db, ("SELECT COUNT(*) FROM BrowserUrls WHERE raw_url IS NOT NULL AND id > " +
+        std::to_string(beforeInterrupt) + ";").c_str());
+    printf("[LoadGen] migrate: cursor %lld after %d chunks, interrupted chunk %s, cursor %lld, rows changed past cursor %lld\n",
+        beforeInterrupt, firstChunks, more ? "COMPLETED" : "rolled back", afterInterrupt, partial);
+    database.Close();
+
+    // 2) 재시작: 커밋된 진행 위치부터 완료까지
+    uint64_t start = NowUs();
+    int chunks = 0;
+    if (database.Initialize(path.c_str())) {
+        while (database.RunBackgroundMigrations(kMigrateChunkRows)) chunks++;
+        database.Close();
+    }
+    double sec = (NowUs() - start) / 1e6;
+    long long resumed = MigrationCursor(db, done);
+    long long maxId = QueryCount(db, "SELECT MAX(id) FROM BrowserUrls;");
+    long long converted = QueryCount(db, "SELECT COUNT(*) FROM BrowserUrls WHERE raw_url IS NOT NULL;");
+    long long bad = CountMisconverted(db);
+    printf("[LoadGen] migrate: resumed %d chunks in %.2f s (%.0f rows/s), cursor %lld / %lld, done %d, converted %lld / %lld, mismatched %lld\n",
+        chunks, sec, sec > 0 ? (maxId - beforeInterrupt) / sec : 0.0, resumed, maxId, done ? 1 : 0, converted, legacy, bad);
+    sqlite3_close(db);
+    RemoveDb(path);
+
+    ok = true;
+    ok &= Check(beforeInterrupt > 0 && beforeInterrupt < maxId, "chunks commit progress before the interrupt");
+    ok &= Check(!more && afterInterrupt == beforeInterrupt && partial == 0, "interrupted chunk rolls back to the committed cursor");
+    ok &= Check(done && resumed == maxId, "migration resumes and completes after restart");
+    ok &= Check(converted == legacy && bad == 0, "legacy urls canonicalized, originals kept in raw_url");
+    printf("[LoadGen] migrate check %s\n", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------- pool
+// WorkStealingPool::Stop과 동시에 제출된 작업이 실행되지 않은 채 남지 않는지, 라우터가 거부된 제출을 호출 스레드에서 처리하는지
+
+// 제출 스레드들이 거부될 때까지 작업을 넣는 동안 Stop: 받아들인 작업은 Stop 반환 전에 모두 실행되어야 함
+static bool PoolStopRaceCheck(int rounds) {
+    unsigned long long stranded = 0;
+    for (int r = 0; r < rounds; r++) {
+        WorkStealingPool pool(2);
+        pool.Start();
+        std::atomic<unsigned long long> accepted(0), ran(0);
+        std::vector<std::thread> submitters;
+        for (int t = 0; t < 4; t++) {
+            submitters.emplace_back([&]() {
+                while (pool.Submit([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }))
+                    accepted.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200 + (r % 7) * 100));
+        pool.Stop();
+        unsigned long long ranAtStop = ran.load();
+        for (auto& t : submitters) t.join();
+        stranded += accepted.load() - ranAtStop;
+    }
+    printf("[LoadGen] pool: %d stop races, %llu accepted tasks not run by Stop\n", rounds, stranded);
+    return Check(stranded == 0, "tasks accepted by Submit run before Stop returns");
+}
+
+// 풀을 먼저 멈춘 뒤에도 Dispatch가 받아들인 메시지는 직렬/병렬 경로 모두 처리되어야 함
+static bool RouterRejectedSubmitCheck(int rounds) {
+    unsigned long long lost = 0;
+    for (int r = 0; r < rounds; r++) {
+        WorkStealingPool pool(2);
+        pool.Start();
+        MessageRouter router(&pool);
+        std::atomic<unsigned long long> handled(0);
+        RouteOptions serial;
+        serial.capacity = 1 << 16;
+        serial.binaryPayload = true;
+        RouteOptions parallel = serial;
+        parallel.ordering = HandlerOrdering::Parallel;
+        router.Register(IMT_URL_LOG_BATCH, "serial", [&handled](const IpcMessage&) { handled++; }, serial);
+        router.Register(IMT_URL_EVENT, "parallel", [&handled](const IpcMessage&) { handled++; }, parallel);
+
+        std::atomic<unsigned long long> accepted(0);
+        std::vector<std::thread> senders;
+        for (int t = 0; t < 4; t++) {
+            senders.emplace_back([&, t]() {
+                IPC_MSG_HEADER hdr = { (DWORD)(t % 2 ? IMT_URL_EVENT : IMT_URL_LOG_BATCH), 0 };
+                for (int i = 0; i < 2000; i++) {
+                    if (router.Dispatch(&hdr, (DWORD)sizeof(hdr))) accepted++;
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100 + (r % 5) * 100));
+        pool.Stop();
+        for (auto& t : senders) t.join();
+        router.Stop();
+        lost += accepted.load() - handled.load();
+    }
+    printf("[LoadGen] pool: %d router rounds with the pool stopped mid-dispatch, %llu accepted messages not handled\n", rounds, lost);
+    return Check(lost == 0, "router handles messages whose submit was rejected");
+}
+
+static int RunPool(const LoadConfig& cfg) {
+    bool ok = PoolStopRaceCheck(cfg.iterations * 10);
+    ok &= RouterRejectedSubmitCheck(cfg.iterations * 5);
+    printf("[LoadGen] pool check %s\n", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------- uia
+
+// 인덱스 기반 합성 UIA 트리: 호출 수를 세어 실제 UIA의 프로세스 간 왕복 횟수를 대신함
+// 노드 핸들은 인덱스 + 1 (nullptr == 없음), 반환한 핸들 수와 해제 수를 맞춰 누수 확인
+class FakeUiaTree : public IUiaTree {
+public:
+    struct Node {
+        int parent;
+        int indexInParent;
+        std::vector<int> children;
+        UiaNodeInfo info;
+    };
+
+    FakeUiaTree() : calls(0), visited(0), outstanding(0) {
+        Node root = { -1, 0, {}, {} };
+        root.info.name = L"Google Chrome";
+        m_nodes.push_back(root);
+    }
+
+    int Add(int parent, const wchar_t* name, int controlType, const wchar_t* automationId = L"", int at = -1) {
+        Node n = { parent, 0, {}, {} };
+        n.info.name = name;
+        n.info.automationId = automationId;
+        n.info.controlType = controlType;
+        n.info.keyboardFocusable = controlType == kUiaEditControlTypeId;
+        m_nodes.push_back(n);
+        int id = (int)m_nodes.size() - 1;
+        std::vector<int>& siblings = m_nodes[parent].children;
+        if (at < 0 || at > (int)siblings.size()) at = (int)siblings.size();
+        siblings.insert(siblings.begin() + at, id);
+        for (size_t i = 0; i < siblings.size(); i++) m_nodes[siblings[i]].indexInParent = (int)i;
+        return id;
+    }
+
+    size_t Size() const { return m_nodes.size(); }
+    static int IndexOf(UiaNode node) { return (int)((intptr_t)node - 1); }
+
+    UiaNode Root() override { return Handle(0); }
+    UiaNode FirstChild(UiaNode node) override {
+        calls++;
+        const Node& n = m_nodes[IndexOf(node)];
+        return n.children.empty() ? nullptr : Acquire(n.children[0]);
+    }
+    UiaNode NextSibling(UiaNode node) override {
+        calls++;
+        const Node& n = m_nodes[IndexOf(node)];
+        if (n.parent < 0) return nullptr;
+        const std::vector<int>& siblings = m_nodes[n.parent].children;
+        size_t next = (size_t)n.indexInParent + 1;
+        return next < siblings.size() ? Acquire(siblings[next]) : nullptr;
+    }
+    UiaNode Parent(UiaNode node) override {
+        calls++;
+        int parent = m_nodes[IndexOf(node)].parent;
+        return parent < 0 ? nullptr : Acquire(parent);
+    }
+    bool GetInfo(UiaNode node, UiaNodeInfo& info) override {
+        calls++;
+        info = m_nodes[IndexOf(node)].info;
+        return true;
+    }
+    bool IsSameNode(UiaNode a, UiaNode b) override { return a == b; }
+    void FindEditDescendants(std::vector<UiaNode>& out) override {
+        calls++;
+        // FindAll(TreeScope_Descendants)처럼 문서 순서로 전체 순회
+        std::vector<int> stack(1, 0);
+        while (!stack.empty()) {
+            int id = stack.back();
+            stack.pop_back();
+            visited++;
+            if (id != 0 && m_nodes[id].info.controlType == kUiaEditControlTypeId) out.push_back(Acquire(id));
+            const std::vector<int>& children = m_nodes[id].children;
+            for (size_t i = children.size(); i-- > 0;) stack.push_back(children[i]);
+        }
+    }
+    void ReleaseNode(UiaNode node) override {
+        if (node && IndexOf(node) != 0) outstanding--;
+    }
+
+    unsigned long long calls;
+    unsigned long long visited;
+    long long outstanding;
+
+private:
+    std::vector<Node> m_nodes;
+
+    static UiaNode Handle(int id) { return (UiaNode)(intptr_t)(id + 1); }
+    UiaNode Acquire(int id) {
+        if (id != 0) outstanding++;
+        return Handle(id);
+    }
+};
+
+static const int kUiaPaneType = 50033;
+static const int kUiaButtonType = 50000;
+static const int kUiaTextType = 50020;
+
+// Chromium 창 모양: 탭 줄과 도구 모음(주소 표시줄 포함) 아래 웹 콘텐츠
+// 콘텐츠에는 판별 규칙에 걸리는 검색 입력란도 섞음 (문서 순서상 주소 표시줄이 먼저)
+static int BuildChromiumLikeTree(FakeUiaTree& tree, int nodes, int& toolbarParent) {
+    int frame = tree.Add(0, L"", kUiaPaneType);
+    int browserView = tree.Add(frame, L"", kUiaPaneType, L"BrowserView");
+    int topContainer = tree.Add(browserView, L"", kUiaPaneType, L"TopContainerView");
+    int tabStrip = tree.Add(topContainer, L"Tab strip", kUiaPaneType);
+    for (int i = 0; i < 12; i++) tree.Add(tabStrip, L"Tab", kUiaButtonType);
+    int toolbar = tree.Add(topContainer, L"", kUiaPaneType); // AutomationId 없음 -> 자식 순서로만 찾음
+    tree.Add(toolbar, L"Back", kUiaButtonType);
+    tree.Add(toolbar, L"Forward", kUiaButtonType);
+    tree.Add(toolbar, L"Reload", kUiaButtonType);
+    int location = tree.Add(toolbar, L"", kUiaPaneType, L"LocationBarView");
+    tree.Add(location, L"View site information", kUiaButtonType);
+    int addressBar = tree.Add(location, L"Address and search bar", kUiaEditControlTypeId, L"OmniboxViewViews");
+    tree.Add(location, L"Bookmark this tab", kUiaButtonType);
+    toolbarParent = topContainer;
+
+    int content = tree.Add(browserView, L"", kUiaPaneType, L"ContentsWebView");
+    std::vector<int> containers(1, content);
+    unsigned int seed = 0x2545F491u;
+    while ((int)tree.Size() < nodes) {
+        seed = seed * 1103515245u + 12345u; // 재현 가능한 LCG
+        int parent = containers[(seed >> 8) % containers.size()];
+        switch ((seed >> 4) % 16) {
+        case 0: tree.Add(parent, L"Search", kUiaEditControlTypeId); break;
+        case 1: case 2: case 3: containers.push_back(tree.Add(parent, L"", kUiaPaneType)); break;
+        case 4: case 5: tree.Add(parent, L"Link", kUiaButtonType); break;
+        default: tree.Add(parent, L"Lorem ipsum", kUiaTextType); break;
+        }
+    }
+    return addressBar;
+}
+
+struct LocateCost {
+    double nsPerLocate;
+    double callsPerLocate;
+    double visitedPerLocate;
+    bool found;
+};
+
+// iterations번 Locate (learn=false면 매번 학습 경로를 지워 전체 탐색)
+static LocateCost MeasureLocate(AddressBarLocator& locator, FakeUiaTree& tree, int addressBar, bool learn, int iterations) {
+    const std::wstring version = L"120.0.6099.71";
+    tree.calls = tree.visited = 0;
+    bool found = true;
+    uint64_t elapsedNs = 0;
+    for (int it = 0; it < iterations; it++) {
+        if (!learn) locator.Clear();
+        auto start = std::chrono::steady_clock::now();
+        UiaNode node = locator.Locate(tree, BrowserType::Chrome, version);
+        elapsedNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        found &= FakeUiaTree::IndexOf(node) == addressBar;
+        tree.ReleaseNode(node);
+    }
+    LocateCost cost;
+    cost.nsPerLocate = (double)elapsedNs / iterations;
+    cost.callsPerLocate = (double)tree.calls / iterations;
+    cost.visitedPerLocate = (double)tree.visited / iterations;
+    cost.found = found;
+    return cost;
+}
+
+static int RunUia(const LoadConfig& cfg) {
+    FakeUiaTree tree;
+    int toolbarParent = 0;
+    int addressBar = BuildChromiumLikeTree(tree, cfg.nodes, toolbarParent);
+    printf("[LoadGen] synthetic UIA tree: %zu nodes\n", tree.Size());
+
+    AddressBarLocator locator;
+    LocateCost full = MeasureLocate(locator, tree, addressBar, false, cfg.iterations);
+    unsigned long fullSearches = locator.FullSearches(); // 마지막 전체 탐색이 경로를 학습해 둠
+    LocateCost path = MeasureLocate(locator, tree, addressBar, true, cfg.iterations);
+    printf("[LoadGen] full search : %.0f ns/locate, %.1f tree calls, %.0f nodes visited\n",
+        full.nsPerLocate, full.callsPerLocate, full.visitedPerLocate);
+    printf("[LoadGen] learned path: %.0f ns/locate, %.1f tree calls, %.0f nodes visited (path hits %lu)\n",
+        path.nsPerLocate, path.callsPerLocate, path.visitedPerLocate, locator.PathHits());
+
+    bool ok = Check(full.found && path.found, "every locate returns the address bar");
+    ok &= Check(fullSearches == (unsigned long)cfg.iterations, "cleared locator searches the whole tree");
+    ok &= Check(path.visitedPerLocate == 0, "learned path skips FindAll");
+    ok &= Check(tree.outstanding == 0, "every returned node is released");
+
+    // 도구 모음 앞에 패널이 끼어들면 (AutomationId 없는 단계의 순서 변경) 경로를 버리고 다시 학습
+    tree.Add(toolbarParent, L"Download bar", kUiaPaneType, L"", 1);
+    unsigned long searchesBefore = locator.FullSearches();
+    LocateCost relearn = MeasureLocate(locator, tree, addressBar, true, 2);
+    printf("[LoadGen] after UI change: %lu full search(es) over 2 locates\n", locator.FullSearches() - searchesBefore);
+    ok &= Check(relearn.found, "address bar is found after the UI change");
+    ok &= Check(locator.FullSearches() - searchesBefore == 1, "changed path is relearned once");
+    ok &= Check(tree.outstanding == 0, "no node leaks across relearning");
+
+    printf("[LoadGen] uia check %s\n", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------- notify
+
+// 모니터 스케줄러 흉내: 윈도우마다 샘플 타이머 하나, Post는 다음 루프에서 실행
+// (UrlMonitor::OnAddressBarChanged / PullForwardNotified와 같은 순서로 ChangeGate, ChangeNotifyQueue 사용)
+struct NotifyWindow {
+    HWND hwnd;
+    TimerId timer;
+    uint64_t nextSample;     // 예약된 다음 샘플 시각
+    uint64_t lastRead;       // 마지막 UIA 읽기 시각 (0 = 없음)
+    GateReason lastReason;
+};
+
+static int RunNotify(const LoadConfig&) {
+    const uint32_t kSampleMs = 5000; // 백오프된 폴링 간격 (알림이 없으면 이만큼 기다림)
+    StepClock clock;
+    TimerWheel wheel(clock.NowMs());
+    ChangeGate gate(&clock);
+
+    std::mutex postLock;
+    std::vector<std::function<void()>> posted;
+    std::vector<NotifyWindow> windows(2);
+    windows[0].hwnd = (HWND)(intptr_t)0x1001; // 알림을 보내는 윈도우
+    windows[1].hwnd = (HWND)(intptr_t)0x1002; // 조용한 윈도우
+
+    std::function<void(NotifyWindow&, uint32_t)> schedule;
+    schedule = [&](NotifyWindow& w, uint32_t delayMs) {
+        wheel.Cancel(w.timer);
+        w.nextSample = clock.NowMs() + delayMs;
+        w.timer = wheel.Schedule(w.nextSample, [&]() {
+            w.timer = 0;
+            unsigned long long before[(int)GateReason::Count];
+            for (int r = 0; r < (int)GateReason::Count; r++) before[r] = gate.Reads((GateReason)r);
+            if (gate.ShouldRead(w.hwnd, WindowSignature::FromTitle(L"Maps", 4), true, false)) {
+                w.lastRead = clock.NowMs();
+                for (int r = 0; r < (int)GateReason::Count; r++) {
+                    if (gate.Reads((GateReason)r) != before[r]) w.lastReason = (GateReason)r;
+                }
+            }
+            schedule(w, kSampleMs);
+        });
+    };
+
+    ChangeNotifyQueue notified([&]() {
+        std::lock_guard<std::mutex> guard(postLock);
+        posted.push_back([&]() {
+            std::vector<HWND> hwnds;
+            notified.Take(hwnds);
+            for (HWND hwnd : hwnds) {
+                for (NotifyWindow& w : windows) {
+                    if (w.hwnd == hwnd) schedule(w, 0);
+                }
+            }
+        });
+    });
+    auto runLoop = [&]() {
+        std::vector<std::function<void()>> fns;
+        {
+            std::lock_guard<std::mutex> guard(postLock);
+            fns.swap(posted);
+        }
+        for (auto& fn : fns) fn();
+        wheel.Advance(clock.NowMs());
+    };
+
+    for (NotifyWindow& w : windows) {
+        w.timer = 0;
+        w.lastRead = 0;
+        w.lastReason = GateReason::Count;
+        schedule(w, 0);
+    }
+    runLoop(); // 첫 샘플: 두 윈도우 모두 FirstSeen으로 읽음
+    bool ok = Check(windows[0].lastReason == GateReason::FirstSeen && windows[1].lastReason == GateReason::FirstSeen,
+        "first sample reads every window");
+
+    // 300ms 뒤 UIA 이벤트 스레드 두 개가 같은 윈도우의 알림을 몰아서 보냄
+    clock.Advance(300);
+    const uint64_t notifiedAt = clock.NowMs();
+    const uint64_t scheduledAt = windows[0].nextSample;
+    std::vector<std::thread> eventThreads;
+    for (int t = 0; t < 2; t++) {
+        eventThreads.emplace_back([&]() {
+            for (int i = 0; i < 500; i++) {
+                gate.MarkChanged(windows[0].hwnd);
+                notified.Add(windows[0].hwnd);
+            }
+        });
+    }
+    for (auto& t : eventThreads) t.join();
+    unsigned long long posts = notified.Posts();
+    runLoop();
+
+    printf("[LoadGen] notified window: read %s at +%llu ms (next scheduled sample +%llu ms), %llu post(s) for 1000 notifications\n",
+        windows[0].lastRead == notifiedAt ? "immediately" : "LATE",
+        (unsigned long long)(windows[0].lastRead - (notifiedAt - 300)), (unsigned long long)(scheduledAt - (notifiedAt - 300)),
+        posts);
+    ok &= Check(posts == 1, "a burst of notifications posts once");
+    ok &= Check(windows[0].lastRead == notifiedAt && notifiedAt < scheduledAt, "notified window is read before its scheduled sample");
+    ok &= Check(windows[0].lastReason == GateReason::Notified, "pulled-forward read is counted as Notified");
+    ok &= Check(windows[1].lastRead < notifiedAt, "quiet window keeps its schedule");
+
+    // 처리 후 다음 알림은 다시 post
+    clock.Advance(100);
+    notified.Add(windows[1].hwnd);
+    gate.MarkChanged(windows[1].hwnd);
+    runLoop();
+    ok &= Check(notified.Posts() == 2 && windows[1].lastRead == clock.NowMs(), "a later notification posts again");
+
+    printf("[LoadGen] gate: %llu checks, %llu notified reads, %llu notifications\n",
+        gate.Checks(), gate.Reads(GateReason::Notified), gate.Notifications());
+    printf("[LoadGen] notify check %s\n", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+static void PrintUsage() {
+    printf("usage: LoadGen bench|urllog|echo|canon|codec|alloc|import|ingest|migrate|pool|stage|uia|notify [options]\n");
+    printf("  common: --seconds=N --threads=N --transport=madchook|unix|local --socket-dir=PATH\n");
+    printf("  bench:  --rate=MSG_PER_SEC (0 = max) --option-percent=N --drain-ms=N\n");
+    printf("  urllog: --rate=RECORDS_PER_SEC (0 = max) --batch=N --hosts=N --paths=N --work-dir=PATH (local)\n");
+    printf("  canon:  --corpus=FILE (one URL per line, default synthetic) --iterations=N --hosts=N --paths=N\n");
+    printf("  codec:  --iterations=N --hosts=N --paths=N\n");
+    printf("  alloc:  --iterations=N --hosts=N --paths=N\n");
+    printf("  import: --visits=N --hosts=N --paths=N --work-dir=PATH --duty=PERCENT\n");
+    printf("  ingest: --rate=RECORDS_PER_SEC (0 = max) --batch=N --hosts=N --paths=N --work-dir=PATH\n");
+    printf("  migrate: --rows=N --hosts=N --paths=N --work-dir=PATH\n");
+    printf("  pool:   --iterations=N\n");
+    printf("  stage:  --items=N\n");
+    printf("  uia:    --nodes=N --iterations=N\n");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        PrintUsage();
+        return 2;
+    }
+
+    LoadConfig cfg;
+    for (int i = 2; i < argc; i++) {
+        int v = 0;
+        if (ParseIntArg(argv[i], "--rate=", v)) cfg.rate = v;
+        else if (ParseIntArg(argv[i], "--seconds=", v)) cfg.seconds = v;
+        else if (ParseIntArg(argv[i], "--threads=", v)) cfg.threads = v;
+        else if (ParseIntArg(argv[i], "--option-percent=", v)) cfg.optionPercent = v;
+        else if (ParseIntArg(argv[i], "--drain-ms=", v)) cfg.drainMs = v;
+        else if (ParseIntArg(argv[i], "--batch=", v)) cfg.batch = v;
+        else if (ParseIntArg(argv[i], "--hosts=", v)) cfg.hosts = v;
+        else if (ParseIntArg(argv[i], "--paths=", v)) cfg.paths = v;
+        else if (ParseIntArg(argv[i], "--iterations=", v)) cfg.iterations = v;
+        else if (ParseIntArg(argv[i], "--visits=", v)) cfg.visits = v;
+        else if (ParseIntArg(argv[i], "--duty=", v)) cfg.duty = v;
+        else if (ParseIntArg(argv[i], "--items=", v)) cfg.items = v;
+        else if (ParseIntArg(argv[i], "--nodes=", v)) cfg.nodes = v;
+        else if (ParseIntArg(argv[i], "--rows=", v)) cfg.rows = v;
+        else if (ParseStringArg(argv[i], "--work-dir=", cfg.workDir)) {}
+        else if (ParseStringArg(argv[i], "--corpus=", cfg.corpus)) {}
+        else if (ParseStringArg(argv[i], "--transport=", cfg.transport)) {}
+        else if (ParseStringArg(argv[i], "--socket-dir=", cfg.socketDir)) {}
+        else {
+            printf("[LoadGen] unknown option: %s\n", argv[i]);
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (cfg.seconds < 1 || cfg.threads < 1 || cfg.hosts < 1 || cfg.paths < 1 || cfg.rate < 0 ||
+        cfg.optionPercent < 0 || cfg.optionPercent > 100 || cfg.batch < 1 || cfg.batch > URL_LOG_BATCH_MAX_RECORDS) {
+        printf("[LoadGen] invalid option value\n");
+        return 2;
+    }
+    if (strcmp(argv[1], "canon") == 0) return cfg.iterations < 1 ? 2 : RunCanon(cfg); // 전송 불필요
+    if (strcmp(argv[1], "codec") == 0) return cfg.iterations < 1 ? 2 : RunCodec(cfg);
+    if (strcmp(argv[1], "alloc") == 0) return cfg.iterations < 1 ? 2 : RunAlloc(cfg);
+    if (strcmp(argv[1], "import") == 0) return cfg.visits < 1 || cfg.duty < 1 ? 2 : RunImport(cfg);
+    if (strcmp(argv[1], "ingest") == 0) return RunIngest(cfg); // 같은 프로세스의 local 전송 사용
+    if (strcmp(argv[1], "migrate") == 0) return cfg.rows < 1000 ? 2 : RunMigrate(cfg);
+    if (strcmp(argv[1], "pool") == 0) return cfg.iterations < 1 ? 2 : RunPool(cfg);
+    if (strcmp(argv[1], "stage") == 0) return cfg.items < 1 ? 2 : RunStage(cfg);
+    if (strcmp(argv[1], "notify") == 0) return RunNotify(cfg);
+    if (strcmp(argv[1], "uia") == 0) return cfg.nodes < 1 || cfg.iterations < 1 ? 2 : RunUia(cfg);
+
+    std::unique_ptr<LoadTransport> transport = CreateLoadTransport(cfg.transport, cfg.socketDir);
+    if (!transport) {
+        printf("[LoadGen] transport '%s' is not available on this platform\n", cfg.transport.c_str());
+        return 2;
+    }
+
+    // local 전송은 같은 프로세스의 기본 수신 측이 받음: 옵션/URL 이벤트는 에이전트 대역, URL 로그는 실제 수집 경로
+    std::unique_ptr<EchoAgent> echo;
+    std::unique_ptr<IngestSink> ingest;
+    bool local = strcmp(transport->Name(), "local") == 0;
+    if (local && strcmp(argv[1], "echo") != 0) {
+        echo.reset(new EchoAgent(*transport));
+        ingest.reset(new IngestSink(cfg.workDir + "/loadgen-ingest.db"));
+        if (!echo->Start(false) || !ingest->Start(*transport)) {
+            printf("[LoadGen] cannot start local receivers\n");
+            return 1;
+        }
+    }
+
+    int rc = 2;
+    if (strcmp(argv[1], "bench") == 0) rc = RunBench(cfg, *transport);
+    else if (strcmp(argv[1], "urllog") == 0) rc = RunUrlLog(cfg, *transport);
+    else if (strcmp(argv[1], "echo") == 0) rc = RunEcho(cfg, *transport);
+    else PrintUsage();
+
+    if (echo) echo->Report();
+    if (ingest && !ingest->Finish() && rc == 0) rc = 1;
+    transport->Close();
+    return rc;
+}
@@ -0,0 +1,175 @@
+﻿#include "MessageRouter.h"
+#include "IpcProtocol.h"
+#include "WorkStealingPool.h"
+#include "AsyncLogger.h"
+#include "Tracer.h"
+#include <string.h>
+#include <stdio.h>
+
+namespace {
+    // Serial strand가 한 번에 처리할 최대 메시지 수 (넘으면 다시 제출하여 다른 작업에 양보)
+    const int kSerialBatch = 64;
+    // 종류별로 보관하는 페이로드 버퍼 수 / 보관하지 않을 큰 버퍼 (폭주나 큰 메시지 뒤 메모리 회수)
+    const size_t kMaxSpareBuffers = 64;
+    const size_t kMaxSpareBufferBytes = 64 * 1024;
+}
+
+MessageRouter::MessageRouter(WorkStealingPool* pool)
+    : m_pool(pool), m_stopped(false), m_invalid(0), m_unknown(0) {
+}
+
+MessageRouter::~MessageRouter() {
+    Stop();
+}
+
+bool MessageRouter::Register(DWORD type, const char* name, MessageHandler handler, const RouteOptions& options) {
+    if (!handler || m_routes.count(type)) {
+        printf("[Router] Register failed for type 0x%04lX\n", (unsigned long)type);
+        return false;
+    }
+
+    std::unique_ptr<Route> route(new Route(type, name, std::move(handler), options));
+    if (options.overflow == QueueOverflowPolicy::CoalesceByKey && options.coalesceKey)
+        route->queue.SetCoalescer(options.coalesceKey, options.coalesceMerge);
+    route->spare.reserve(kMaxSpareBuffers);
+    m_routes[type] = std::move(route);
+    return true;
+}
+
+bool MessageRouter::Dispatch(const void* message, DWORD size) {
+    if (!message || size < sizeof(IPC_MSG_HEADER)) {
+        m_invalid.fetch_add(1, std::memory_order_relaxed);
+        AGENT_LOG_WARN("[Router] Invalid message (size=%lu)", (unsigned long)size);
+        return false;
+    }
+    if (m_stopped.load()) return false;
+
+    const IPC_MSG_HEADER* hdr = (const IPC_MSG_HEADER*)message;
+    auto it = m_routes.find(hdr->nType);
+    if (it == m_routes.end()) {
+        m_unknown.fetch_add(1, std::memory_order_relaxed);
+        AGENT_LOG_WARN("[Router] Unknown type 0x%04lX", (unsigned long)hdr->nType);
+        return false;
+    }
+    Route* route = it->second.get();
+
+    // 헤더의 dwSize가 실제 수신 크기를 넘으면 수신 크기로 제한
+    const char* payload = (const char*)message + sizeof(IPC_MSG_HEADER);
+    DWORD available = size - (DWORD)sizeof(IPC_MSG_HEADER);
+    DWORD len = hdr->dwSize <= available ? hdr->dwSize : available;
+
+    IpcMessage msg;
+    msg.type = hdr->nType;
+    if (len >= sizeof(IPC_TRACE_TRAILER)) {
+        IPC_TRACE_TRAILER trailer;
+        memcpy(&trailer, payload + len - sizeof(trailer), sizeof(trailer));
+        if (trailer.dwMagic == IPC_TRACE_TRAILER_MAGIC) {
+            msg.traceId = trailer.qwCorrelationId;
+            len -= (DWORD)sizeof(trailer);
+        }
+    }
+    TRACE_CORRELATE(msg.traceId);
+    TRACE_SPAN("MessageRouter::Dispatch");
+    TRACE_FLOW('t', msg.traceId);
+
+    if (!route->binaryPayload) {
+        while (len > 0 && payload[len - 1] == '\0') len--;
+    }
+
+    TakeBuffer(route, msg.payload);
+    msg.payload.assign(payload, len);
+    AGENT_LOG_DEBUG("[Router] %s: %lu bytes", route->name, (unsigned long)len);
+
+    if (!route->queue.Push(std::move(msg))) return false;
+
+    if (route->ordering == HandlerOrdering::Serial) {
+        ScheduleSerial(route);
+    }
+    else {
+        // 메시지 하나당 작업 하나 (병합/폐기된 경우 작업은 빈 큐를 보고 끝남)
+        auto task = [this, route]() {
+            IpcMessage m;
+            if (route->queue.TryPop(m)) Invoke(route, m);
+        };
+        if (!m_pool->Submit(task)) task(); // 풀이 정지 중이면 받은 메시지는 이 스레드에서 처리
+    }
+    return true;
+}
+
+void MessageRouter::ScheduleSerial(Route* route) {
+    if (route->draining.exchange(true)) return; // 이미 strand가 실행 중
+    // 풀이 정지 중이면 제출이 거부됨: 대기 메시지를 잃지 않도록 호출 스레드에서 strand 실행
+    if (!m_pool->Submit([this, route]() { DrainSerial(route); }))
+        DrainSerial(route);
+}
+
+// strand 실행. 큐가 비었을 때만 draining을 해제 (메시지가 남아 있는 동안은 항상 누군가 처리 중)
+void MessageRouter::DrainSerial(Route* route) {
+    IpcMessage msg;
+    for (;;) {
+        for (int i = 0; i < kSerialBatch; i++) {
+            if (!route->queue.TryPop(msg)) {
+                // 해제 후 그 사이 들어온 메시지가 있으면 다시 strand 획득
+                route->draining.store(false);
+                if (route->queue.Size() == 0 || route->draining.exchange(true)) return;
+                continue;
+            }
+            Invoke(route, msg);
+        }
+
+        // 배치 소진: draining 유지한 채 다시 제출하여 다른 종류에도 워커를 양보
+        if (m_pool->Submit([this, route]() { DrainSerial(route); })) return;
+        // 풀이 정지 중 (WorkStealingPool::Stop 이후 제출 거부): 종료 시 대기 메시지 처리를 보장하도록
+        // strand를 유지한 채 이 스레드에서 큐가 빌 때까지 계속
+    }
+}
+
+void MessageRouter::Invoke(Route* route, IpcMessage& msg) {
+    // 핸들러 안의 구간도 송신 측과 같은 상관 ID로 기록
+    TRACE_CORRELATE(msg.traceId);
+    TRACE_SPAN(route->name.c_str());
+    TRACE_FLOW('f', msg.traceId);
+
+    try {
+        route->handler(msg);
+        route->handled.fetch_add(1, std::memory_order_relaxed);
+    }
+    catch (const std::exception& e) {
+        route->failed.fetch_add(1, std::memory_order_relaxed);
+        AGENT_LOG_ERROR("[Router] %s handler failed: %s", route->name, e.what());
+    }
+    catch (...) {
+        route->failed.fetch_add(1, std::memory_order_relaxed);
+        AGENT_LOG_ERROR("[Router] %s handler failed", route->name);
+    }
+    RecycleBuffer(route, msg.payload);
+}
+
+void MessageRouter::TakeBuffer(Route* route, std::string& out) {
+    std::lock_guard<std::mutex> lock(route->spareLock);
+    if (route->spare.empty()) return;
+    out.swap(route->spare.back());
+    route->spare.pop_back();
+}
+
+void MessageRouter::RecycleBuffer(Route* route, std::string& buffer) {
+    if (buffer.capacity() > kMaxSpareBufferBytes) return;
+    std::lock_guard<std::mutex> lock(route->spareLock);
+    if (route->spare.size() >= kMaxSpareBuffers) return;
+    route->spare.push_back(std::move(buffer));
+}
+
+void MessageRouter::Stop() {
+    if (m_stopped.exchange(true)) return;
+    for (auto& kv : m_routes) kv.second->queue.Close();
+}
+
+void MessageRouter::DumpStats() {
+    for (auto& kv : m_routes) {
+        Route* r = kv.second.get();
+        QueueStats s = r->queue.Stats();
+        AGENT_LOG_INFO("[Router] %s: pushed=%llu handled=%llu failed=%llu coalesced=%llu dropped=%llu high=%zu",
+            r->name, s.pushed, r->handled.load(), r->failed.load(), s.coalesced, s.dropped, s.highWater);
+    }
+    AGENT_LOG_INFO("[Router] invalid=%llu unknown=%llu", m_invalid.load(), m_unknown.load());
+}
@@ -0,0 +1,90 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BoundedQueue.h"
+#include "IpcProtocol.h"
+
+class WorkStealingPool;
+
+// 라우터가 핸들러에 전달하는 메시지 (헤더를 제외한 페이로드 복사본)
+struct IpcMessage {
+    DWORD type = 0;
+    std::string payload; // 텍스트 메시지는 끝의 NUL 제외
+    uint64_t traceId = 0; // IPC_TRACE_TRAILER의 상관 ID (없으면 0)
+};
+
+// 같은 종류의 메시지 처리 순서
+enum class HandlerOrdering {
+    Serial,   // 도착 순서대로 한 번에 하나씩 (종류별 strand)
+    Parallel  // 풀의 여러 워커에서 동시에
+};
+
+typedef std::function<void(const IpcMessage&)> MessageHandler;
+
+// 메시지 종류별 등록 옵션
+struct RouteOptions {
+    HandlerOrdering ordering = HandlerOrdering::Serial;
+    size_t capacity = 1024;                                    // 대기 메시지 상한
+    bool binaryPayload = false;                                // false: 텍스트로 보고 끝의 NUL 제거
+    QueueOverflowPolicy overflow = QueueOverflowPolicy::DropOldest;
+    BoundedQueue<IpcMessage>::KeyFn coalesceKey;               // overflow가 CoalesceByKey일 때
+    BoundedQueue<IpcMessage>::MergeFn coalesceMerge;
+};
+
+// IPC_MSG_HEADER::nType → 핸들러 라우터
+// - 새 메시지 종류는 Register 한 번으로 추가 (IpcServer::Start 전에 등록)
+// - 종류마다 bounded queue를 두고 작업 훔치기 풀에서 실행
+// - 처리가 끝난 페이로드 버퍼는 종류별로 보관했다가 다음 수신에 재사용 (정상 상태에서 메시지당 할당 없음)
+class MessageRouter {
+public:
+    explicit MessageRouter(WorkStealingPool* pool);
+    ~MessageRouter();
+
+    bool Register(DWORD type, const char* name, MessageHandler handler,
+        const RouteOptions& options = RouteOptions());
+
+    // 수신 원본 메시지(헤더 + 페이로드) 검증 후 해당 핸들러로 전달
+    bool Dispatch(const void* message, DWORD size);
+
+    // 이후 Dispatch를 거부. 대기 중인 메시지는 모두 처리됨 (풀이 정지 중이면 제출하던 스레드에서)
+    void Stop();
+
+    void DumpStats();
+
+private:
+    struct Route {
+        DWORD type;
+        std::string name;
+        MessageHandler handler;
+        HandlerOrdering ordering;
+        bool binaryPayload;
+        BoundedQueue<IpcMessage> queue;
+        std::atomic<bool> draining;            // Serial: strand 실행 중 여부
+        std::atomic<unsigned long long> handled;
+        std::atomic<unsigned long long> failed;
+        std::mutex spareLock;
+        std::vector<std::string> spare;        // 재사용할 페이로드 버퍼 (용량 유지)
+
+        Route(DWORD t, const char* n, MessageHandler h, const RouteOptions& o)
+            : type(t), name(n ? n : ""), handler(std::move(h)), ordering(o.ordering),
+              binaryPayload(o.binaryPayload), queue(o.capacity, o.overflow), draining(false), handled(0), failed(0) {
+        }
+    };
+
+    WorkStealingPool* m_pool;
+    std::unordered_map<DWORD, std::unique_ptr<Route>> m_routes;
+    std::atomic<bool> m_stopped;
+    std::atomic<unsigned long long> m_invalid;
+    std::atomic<unsigned long long> m_unknown;
+
+    void ScheduleSerial(Route* route);
+    void DrainSerial(Route* route);
+    void Invoke(Route* route, IpcMessage& msg); // 핸들러 호출 후 페이로드 버퍼 반납
+    void TakeBuffer(Route* route, std::string& out);
+    void RecycleBuffer(Route* route, std::string& buffer);
+};
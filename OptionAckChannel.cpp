@@ -0,0 +1,212 @@
+﻿#include "OptionAckChannel.h"
+#include "AsyncLogger.h"
+#include "Tracer.h"
+#include "Watchdog.h"
+#include "IpcProtocol.h"
+#include <stdio.h>
+#include <string.h>
+
+static const uint32_t kAckSendBudgetMs = 5000; // 송신 한 번 (madCHook 큐 쓰기) 정지 판정 기준
+
+OptionAckChannel::OptionAckChannel(IClock* clock)
+    : m_clock(clock ? clock : SteadyClock::Instance()), m_running(false),
+      m_posted(0), m_replaced(0), m_dropped(0), m_sent(0), m_batches(0), m_failures(0), m_expired(0), m_maxBatch(0) {
+}
+
+OptionAckChannel::~OptionAckChannel() {
+    Stop();
+}
+
+void OptionAckChannel::Start(SendFn send) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_running) return;
+    if (m_options.maxBatch == 0 || m_options.maxBatch > OPTION_ACK_BATCH_MAX_RECORDS)
+        m_options.maxBatch = OPTION_ACK_BATCH_MAX_RECORDS;
+    m_send = std::move(send);
+    m_running = true;
+    m_thread = std::thread(&OptionAckChannel::ThreadProc, this);
+}
+
+void OptionAckChannel::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_running) return;
+        m_running = false;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+    DumpMetrics();
+}
+
+bool OptionAckChannel::Post(const OptionAck& ack) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_running) return false;
+        m_posted++;
+
+        Pending entry = { ack, m_clock->NowMs(), 0 };
+        auto found = m_pending.find(ack.seq);
+        if (found != m_pending.end()) {
+            found->second = entry; // 같은 SEQ는 마지막 결과만 보냄
+            m_replaced++;
+        }
+        else {
+            if (m_pending.size() >= m_options.capacity) {
+                m_pending.erase(m_pending.begin()); // 가장 낮은 SEQ (사용자 프로그램이 이미 다음 옵션을 보냄)
+                m_dropped++;
+            }
+            m_pending.emplace(ack.seq, entry);
+        }
+    }
+    m_cv.notify_one();
+    return true;
+}
+
+// 잠금을 잡은 상태에서 호출: 기한이 지난 결과는 버리고 SEQ 순으로 최대 maxBatch개를 꺼냄
+size_t OptionAckChannel::TakeBatch(std::vector<Pending>& batch) {
+    uint64_t now = m_clock->NowMs();
+    size_t expired = 0;
+    auto it = m_pending.begin();
+    while (it != m_pending.end() && batch.size() < m_options.maxBatch) {
+        if (now - it->second.queuedMs > m_options.expiryMs) expired++;
+        else batch.push_back(it->second);
+        it = m_pending.erase(it);
+    }
+    if (expired) {
+        m_expired += expired;
+        AGENT_LOG_WARN("[OptionAck] %zu acknowledgements expired undelivered", expired);
+    }
+    return batch.size();
+}
+
+// 잠금을 잡은 상태에서 호출: 보내지 못한 결과를 되돌림 (그 사이 같은 SEQ의 새 결과가 왔으면 새 것 유지)
+void OptionAckChannel::Requeue(std::vector<Pending>& batch) {
+    for (Pending& p : batch) {
+        if (m_pending.count(p.ack.seq)) continue;
+        if (m_pending.size() >= m_options.capacity) {
+            m_dropped++;
+            continue;
+        }
+        m_pending.emplace(p.ack.seq, p);
+    }
+    batch.clear();
+}
+
+bool OptionAckChannel::Deliver(std::vector<Pending>& batch) {
+    TRACE_SPAN("OptionAckChannel::Deliver");
+    WATCHDOG_STAGE("ipc.option_ack", kAckSendBudgetMs);
+    for (Pending& p : batch) p.attempts++;
+
+    if (m_options.format == OptionAckFormat::Text && m_options.formatText) {
+        // 문자열 응답은 결과마다 메시지 하나: 실패한 지점부터 남김
+        size_t done = 0;
+        for (; done < batch.size(); done++) {
+            std::string text = m_options.formatText(batch[done].ack);
+            if (!m_send(text.c_str(), (uint32_t)text.size() + 1)) break;
+        }
+        m_sent += done;
+        batch.erase(batch.begin(), batch.begin() + done);
+        return batch.empty();
+    }
+
+    thread_local std::vector<OptionAck> acks;
+    thread_local std::vector<uint16_t> attempts;
+    thread_local std::string message; // 용량 재사용
+    acks.clear();
+    attempts.clear();
+    for (const Pending& p : batch) {
+        acks.push_back(p.ack);
+        attempts.push_back(p.attempts);
+    }
+    EncodeBatch(acks, attempts, message);
+    if (!m_send(message.data(), (uint32_t)message.size())) return false;
+
+    m_sent += batch.size();
+    m_batches++;
+    if (batch.size() > m_maxBatch.load()) m_maxBatch.store(batch.size());
+    batch.clear();
+    return true;
+}
+
+void OptionAckChannel::ThreadProc() {
+    Tracer::SetThreadName("OptionAck");
+    WatchdogThreadScope watchdog("OptionAck");
+
+    std::vector<Pending> batch;
+    uint32_t backoffMs = 0;
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (true) {
+        if (backoffMs) {
+            // 재시도 대기 중에도 정지 요청에는 바로 반응
+            m_cv.wait_for(lock, std::chrono::milliseconds(backoffMs), [this]() { return !m_running; });
+        }
+        else {
+            m_cv.wait(lock, [this]() { return !m_pending.empty() || !m_running; });
+        }
+        bool stopping = !m_running;
+        if (m_pending.empty()) {
+            if (stopping) break;
+            backoffMs = 0;
+            continue;
+        }
+
+        TakeBatch(batch);
+        lock.unlock();
+        bool ok = batch.empty() || Deliver(batch);
+        lock.lock();
+
+        if (ok) {
+            backoffMs = 0;
+            continue; // 보내는 동안 쌓인 것이 있으면 바로 다음 묶음
+        }
+        m_failures++;
+        Requeue(batch);
+        if (stopping) break;
+        backoffMs = backoffMs ? backoffMs * 2 : m_options.retryMs;
+        if (backoffMs > m_options.maxRetryMs) backoffMs = m_options.maxRetryMs;
+        AGENT_LOG_DEBUG("[OptionAck] Delivery failed, retrying in %u ms (%zu pending)", backoffMs, m_pending.size());
+    }
+
+    if (!m_pending.empty()) {
+        m_dropped += m_pending.size();
+        AGENT_LOG_WARN("[OptionAck] %zu acknowledgements undelivered at shutdown", m_pending.size());
+        m_pending.clear();
+    }
+}
+
+void OptionAckChannel::EncodeBatch(const std::vector<OptionAck>& acks, const std::vector<uint16_t>& attempts, std::string& out) {
+    size_t count = acks.size();
+    size_t payload = sizeof(OPTION_ACK_BATCH_HEADER) + count * sizeof(OPTION_ACK_RECORD);
+    out.resize(sizeof(IPC_MSG_HEADER) + payload);
+    char* base = &out[0];
+
+    IPC_MSG_HEADER hdr = { IMT_OPTION_ACK_BATCH, (DWORD)payload };
+    memcpy(base, &hdr, sizeof(hdr));
+    OPTION_ACK_BATCH_HEADER batch = { OPTION_ACK_BATCH_VERSION, (WORD)count };
+    memcpy(base + sizeof(hdr), &batch, sizeof(batch));
+
+    char* pos = base + sizeof(hdr) + sizeof(batch);
+    for (size_t i = 0; i < count; i++) {
+        const OptionAck& ack = acks[i];
+        OPTION_ACK_RECORD rec;
+        rec.dwSeq = (DWORD)ack.seq;
+        rec.wStatus = ack.status;
+        rec.wAttempts = i < attempts.size() ? attempts[i] : 1;
+        for (int k = 0; k < 3; k++) rec.dwOpt[k] = (DWORD)ack.opt[k];
+        rec.qwSentAt = ack.sentAt;
+        memcpy(pos, &rec, sizeof(rec));
+        pos += sizeof(rec);
+    }
+}
+
+void OptionAckChannel::DumpMetrics() {
+    size_t pending;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        pending = m_pending.size();
+    }
+    AGENT_LOG_INFO("[OptionAck] posted=%llu replaced=%llu sent=%llu batches=%llu maxBatch=%zu failures=%llu "
+        "expired=%llu dropped=%llu pending=%zu",
+        m_posted.load(), m_replaced.load(), m_sent.load(), m_batches.load(), m_maxBatch.load(), m_failures.load(),
+        m_expired.load(), m_dropped.load(), pending);
+}
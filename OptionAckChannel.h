@@ -0,0 +1,93 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Clock.h"
+
+// 옵션 메시지 하나의 처리 결과
+struct OptionAck {
+    int seq = 0;
+    uint16_t status = 0;     // OPTION_ACK_* (IpcProtocol.h)
+    int opt[3] = { 0, 0, 0 };
+    uint64_t sentAt = 0;     // 요청의 TS (없으면 0)
+};
+
+// 결과 전달 형식
+enum class OptionAckFormat {
+    Batch,  // IMT_OPTION_ACK_BATCH 바이너리 묶음
+    Text    // 기존 문자열 응답 (결과마다 메시지 하나, 구버전 사용자 프로그램용)
+};
+
+struct OptionAckOptions {
+    OptionAckFormat format = OptionAckFormat::Batch;
+    std::function<std::string(const OptionAck&)> formatText; // Text 형식의 응답 문자열
+    size_t capacity = 1024;        // 대기 결과 상한 (넘치면 가장 낮은 SEQ부터 버림)
+    size_t maxBatch = 64;          // 메시지 하나에 담는 결과 수 (OPTION_ACK_BATCH_MAX_RECORDS 이하)
+    uint32_t retryMs = 100;        // 전달 실패 후 첫 재시도 대기 (실패할 때마다 두 배)
+    uint32_t maxRetryMs = 2000;
+    uint32_t expiryMs = 10000;     // 이 시간 안에 전달하지 못한 결과는 버림
+};
+
+// 옵션 적용 결과를 사용자 프로그램에 보내는 비동기 채널
+// - Post는 SEQ를 키로 대기 목록에 넣고 바로 반환 (같은 SEQ가 대기 중이면 새 결과로 교체)
+// - 송신 스레드가 대기 중인 결과를 SEQ 순으로 묶어 한 메시지로 보냄. 보내는 동안 쌓인 것은 다음 묶음으로
+// - 전달 실패(사용자 프로그램 없음/큐 가득 참) 시 결과를 되돌려 두고 지수 백오프로 재시도, expiryMs가 지나면 버림
+// - 송신 함수는 주입 (WorkerThread: SendIpcMessage, 테스트/벤치마크: 임의 함수)
+class OptionAckChannel {
+public:
+    typedef std::function<bool(const void* data, uint32_t size)> SendFn;
+
+    explicit OptionAckChannel(IClock* clock = nullptr);
+    ~OptionAckChannel();
+
+    void SetOptions(const OptionAckOptions& options) { m_options = options; } // Start 전에 호출
+    void Start(SendFn send);
+    void Stop(); // 남은 결과를 한 번 더 보내 본 뒤 종료 (재시도 대기 없음)
+
+    // 호출 스레드는 전달을 기다리지 않음. false: 정지됨
+    bool Post(const OptionAck& ack);
+
+    unsigned long long Sent() const { return m_sent.load(); }
+    unsigned long long Expired() const { return m_expired.load(); }
+    void DumpMetrics();
+
+    // 결과 묶음을 IMT_OPTION_ACK_BATCH 메시지로 (attempts: 결과별 시도 횟수)
+    static void EncodeBatch(const std::vector<OptionAck>& acks, const std::vector<uint16_t>& attempts, std::string& out);
+
+private:
+    struct Pending {
+        OptionAck ack;
+        uint64_t queuedMs;
+        uint16_t attempts;
+    };
+
+    IClock* m_clock;
+    OptionAckOptions m_options;
+    SendFn m_send;
+
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::map<int, Pending> m_pending; // SEQ → 결과 (m_lock)
+    bool m_running;
+    std::thread m_thread;
+
+    std::atomic<unsigned long long> m_posted;
+    std::atomic<unsigned long long> m_replaced;
+    std::atomic<unsigned long long> m_dropped;
+    std::atomic<unsigned long long> m_sent;
+    std::atomic<unsigned long long> m_batches;
+    std::atomic<unsigned long long> m_failures;
+    std::atomic<unsigned long long> m_expired;
+    std::atomic<size_t> m_maxBatch;
+
+    void ThreadProc();
+    size_t TakeBatch(std::vector<Pending>& batch);
+    bool Deliver(std::vector<Pending>& batch);
+    void Requeue(std::vector<Pending>& batch);
+};
@@ -0,0 +1,122 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include "BoundedQueue.h"
+#include "Tracer.h"
+#include "Watchdog.h"
+
+// 파이프라인 단계 지표 (시간은 마이크로초)
+struct StageMetrics {
+    QueueStats queue;                 // 입력 채널 (blocked = 앞 단계가 역압력으로 대기한 횟수)
+    size_t depth = 0;                 // 현재 대기 항목 수
+    unsigned long long processed = 0;
+    unsigned long long waitUs = 0;    // 채널에서 기다린 시간 합
+    unsigned long long maxWaitUs = 0;
+    unsigned long long busyUs = 0;    // 처리 함수 실행 시간 합
+    unsigned long long maxBusyUs = 0;
+};
+
+// 입력 채널(BoundedQueue) 하나와 전용 스레드 하나로 된 파이프라인 단계
+// - 앞 단계는 Push만 하고 돌아감. 채널이 가득 차면 정책에 따라 대기(Block) 또는 버림(DropOldest)
+// - 처리 함수는 단계 스레드에서 항목 순서대로 호출됨. 다음 단계로 넘기려면 그 단계에 Push
+// - 단계 스레드는 이름으로 추적/감시기에 등록 (처리 함수 안의 WATCHDOG_STAGE가 감시됨)
+// - Stop: 채널을 닫고 남은 항목을 모두 처리한 뒤 스레드 종료 (이후 Push는 false)
+template <typename T>
+class PipelineStage {
+public:
+    typedef std::function<void(T&)> Handler;
+
+    // name: 스레드/지표 이름 (정적 리터럴)
+    PipelineStage(const char* name, size_t capacity, QueueOverflowPolicy policy = QueueOverflowPolicy::Block)
+        : m_name(name), m_channel(capacity, policy), m_running(false),
+          m_processed(0), m_waitUs(0), m_maxWaitUs(0), m_busyUs(0), m_maxBusyUs(0) {
+    }
+    ~PipelineStage() { Stop(); }
+
+    PipelineStage(const PipelineStage&) = delete;
+    PipelineStage& operator=(const PipelineStage&) = delete;
+
+    bool Start(Handler handler) {
+        if (m_running.exchange(true)) return false;
+        m_handler = std::move(handler);
+        m_channel.Reopen();
+        m_thread = std::thread(&PipelineStage::ThreadProc, this);
+        return true;
+    }
+
+    void Stop() {
+        if (!m_running.exchange(false)) return;
+        m_channel.Close();
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    // false: 멈춘 단계 (항목은 호출자에게 남지 않고 해제됨)
+    bool Push(T item) {
+        return m_channel.Push(Slot{ std::move(item), NowUs() });
+    }
+
+    const char* Name() const { return m_name; }
+
+    StageMetrics Metrics() {
+        StageMetrics m;
+        m.queue = m_channel.Stats();
+        m.depth = m_channel.Size();
+        m.processed = m_processed.load();
+        m.waitUs = m_waitUs.load();
+        m.maxWaitUs = m_maxWaitUs.load();
+        m.busyUs = m_busyUs.load();
+        m.maxBusyUs = m_maxBusyUs.load();
+        return m;
+    }
+
+private:
+    struct Slot {
+        T item;
+        uint64_t enqueuedUs;
+    };
+
+    static uint64_t NowUs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void RaiseMax(std::atomic<unsigned long long>& max, unsigned long long value) {
+        if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed); // 기록은 단계 스레드만
+    }
+
+    void ThreadProc() {
+        Tracer::SetThreadName(m_name);
+        WatchdogThreadScope watchdog(m_name);
+
+        Slot slot;
+        while (m_channel.Pop(slot)) {
+            uint64_t start = NowUs();
+            unsigned long long waited = start > slot.enqueuedUs ? start - slot.enqueuedUs : 0;
+            m_handler(slot.item);
+            unsigned long long busy = NowUs() - start;
+            slot.item = T(); // 다음 항목을 기다리는 동안 붙잡지 않음 (풀 객체 반납)
+
+            m_processed.fetch_add(1, std::memory_order_relaxed);
+            m_waitUs.fetch_add(waited, std::memory_order_relaxed);
+            m_busyUs.fetch_add(busy, std::memory_order_relaxed);
+            RaiseMax(m_maxWaitUs, waited);
+            RaiseMax(m_maxBusyUs, busy);
+        }
+    }
+
+    const char* m_name;
+    BoundedQueue<Slot> m_channel;
+    Handler m_handler;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+
+    std::atomic<unsigned long long> m_processed;
+    std::atomic<unsigned long long> m_waitUs;
+    std::atomic<unsigned long long> m_maxWaitUs;
+    std::atomic<unsigned long long> m_busyUs;
+    std::atomic<unsigned long long> m_maxBusyUs;
+};
@@ -0,0 +1,165 @@
+﻿#include "PollScheduler.h"
+#include <wtsapi32.h>
+#include <stdio.h>
+
+#define WM_SCHEDULER_WAKE (WM_USER + 1)
+
+static const wchar_t* kSchedulerWndClass = L"PCAgentPollScheduler";
+
+// WinEvent/WndProc 콜백에는 컨텍스트 인자가 없으므로 스레드별로 현재 스케줄러 보관
+static thread_local PollScheduler* t_scheduler = nullptr;
+
+PollScheduler::PollScheduler()
+    : m_wheel(GetTickCount64())
+    , m_msgWnd(nullptr)
+    , m_fgHook(nullptr)
+    , m_sessionRegistered(false)
+    , m_locked(false)
+    , m_wakeups(0)
+{
+}
+
+PollScheduler::~PollScheduler() {
+    Detach();
+}
+
+bool PollScheduler::Attach() {
+    if (m_msgWnd) return true;
+    t_scheduler = this;
+
+    HINSTANCE hInst = GetModuleHandleW(nullptr);
+    WNDCLASSEXW wc = { sizeof(WNDCLASSEXW) };
+    wc.lpfnWndProc = &PollScheduler::WndProc;
+    wc.hInstance = hInst;
+    wc.lpszClassName = kSchedulerWndClass;
+    RegisterClassExW(&wc); // 이미 등록된 경우 실패해도 무방
+
+    // 메시지 전용 윈도우: 세션 알림 수신 및 다른 스레드에서 깨우기 용도
+    m_msgWnd = CreateWindowExW(0, kSchedulerWndClass, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, hInst, nullptr);
+    if (!m_msgWnd) {
+        printf("[Scheduler] CreateWindowEx failed: %lu\n", GetLastError());
+        t_scheduler = nullptr;
+        return false;
+    }
+
+    m_sessionRegistered = WTSRegisterSessionNotification(m_msgWnd, NOTIFY_FOR_THIS_SESSION) != FALSE;
+    if (!m_sessionRegistered) {
+        printf("[Scheduler] Session notification unavailable\n");
+    }
+
+    // 포그라운드 전환 이벤트 (이 스레드의 메시지 루프에서 전달됨)
+    m_fgHook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+        &PollScheduler::WinEventProc, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+    if (!m_fgHook) {
+        printf("[Scheduler] Foreground hook unavailable\n");
+    }
+    return true;
+}
+
+void PollScheduler::Detach() {
+    if (m_fgHook) {
+        UnhookWinEvent(m_fgHook);
+        m_fgHook = nullptr;
+    }
+    if (m_msgWnd) {
+        if (m_sessionRegistered) WTSUnRegisterSessionNotification(m_msgWnd);
+        m_sessionRegistered = false;
+        DestroyWindow(m_msgWnd);
+        m_msgWnd = nullptr;
+    }
+    if (t_scheduler == this) t_scheduler = nullptr;
+}
+
+void PollScheduler::Run(const std::atomic<bool>& running) {
+    while (running.load()) {
+        RunPosted();
+        m_wheel.Advance(GetTickCount64());
+        if (!running.load()) break;
+
+        // 다음 데드라인까지만 대기 (예약된 타이머가 없으면 이벤트가 올 때까지 무기한)
+        DWORD timeout = INFINITE;
+        uint64_t next = 0;
+        if (m_wheel.NextDeadline(next)) {
+            ULONGLONG now = GetTickCount64();
+            timeout = next > now ? (DWORD)(next - now) : 0;
+        }
+        {
+            std::lock_guard<std::mutex> guard(m_postLock);
+            if (!m_posted.empty()) timeout = 0;
+        }
+
+        DWORD r = MsgWaitForMultipleObjects(0, nullptr, FALSE, timeout, QS_ALLINPUT);
+        m_wakeups++;
+        if (r == WAIT_OBJECT_0) {
+            MSG msg;
+            while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+                TranslateMessage(&msg);
+                DispatchMessageW(&msg);
+            }
+        }
+    }
+}
+
+void PollScheduler::Post(std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> guard(m_postLock);
+        m_posted.push_back(std::move(fn));
+    }
+    Wake();
+}
+
+void PollScheduler::Wake() {
+    if (m_msgWnd) PostMessageW(m_msgWnd, WM_SCHEDULER_WAKE, 0, 0);
+}
+
+void PollScheduler::RunPosted() {
+    std::vector<std::function<void()>> posted;
+    {
+        std::lock_guard<std::mutex> guard(m_postLock);
+        posted.swap(m_posted);
+    }
+    for (auto& fn : posted) fn();
+}
+
+TimerId PollScheduler::ScheduleAfter(uint32_t delayMs, TimerCallback cb) {
+    return m_wheel.Schedule(GetTickCount64() + delayMs, std::move(cb));
+}
+
+bool PollScheduler::Cancel(TimerId id) {
+    return id ? m_wheel.Cancel(id) : false;
+}
+
+void PollScheduler::AddPeriodicTask(const char* name, uint32_t intervalMs, std::function<void()> fn) {
+    PeriodicTask task = { name ? name : "", intervalMs, std::move(fn) };
+    m_tasks.push_back(std::move(task));
+    SchedulePeriodic(m_tasks.size() - 1);
+}
+
+void PollScheduler::SchedulePeriodic(size_t index) {
+    ScheduleAfter(m_tasks[index].intervalMs, [this, index]() {
+        m_tasks[index].fn();
+        SchedulePeriodic(index);
+        });
+}
+
+LRESULT CALLBACK PollScheduler::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    PollScheduler* self = t_scheduler;
+    if (self && msg == WM_WTSSESSION_CHANGE) {
+        if (wParam == WTS_SESSION_LOCK || wParam == WTS_SESSION_UNLOCK) {
+            self->m_locked = (wParam == WTS_SESSION_LOCK);
+            printf("[Scheduler] Session %s\n", self->m_locked ? "locked" : "unlocked");
+            if (self->m_onSession) self->m_onSession(self->m_locked);
+        }
+        return 0;
+    }
+    if (msg == WM_SCHEDULER_WAKE) return 0; // Run 루프가 게시된 작업을 처리
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+void CALLBACK PollScheduler::WinEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd,
+    LONG idObject, LONG idChild, DWORD idEventThread, DWORD dwmsEventTime)
+{
+    PollScheduler* self = t_scheduler;
+    if (!self || event != EVENT_SYSTEM_FOREGROUND || idObject != OBJID_WINDOW) return;
+    if (self->m_onForeground) self->m_onForeground(hwnd);
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+#include <windows.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "TimerWheel.h"
+
+// 모니터 스레드용 데드라인 기반 스케줄러
+// - 타이머 휠의 다음 만료 시각까지만 MsgWaitForMultipleObjects로 대기 (고정 Sleep 없음)
+// - 포그라운드 전환(WinEvent)과 세션 잠금/해제(WTS) 알림으로 즉시 깨어남
+// - 여러 윈도우 폴링과 주기 작업(DB flush, 지표 출력 등)이 한 스레드를 공유
+class PollScheduler {
+public:
+    PollScheduler();
+    ~PollScheduler();
+
+    // 호출한 스레드를 스케줄러 스레드로 사용 (메시지 전용 윈도우, 이벤트 훅 등록)
+    bool Attach();
+    void Detach();
+
+    // running이 false가 될 때까지 타이머/메시지 처리
+    void Run(const std::atomic<bool>& running);
+
+    // 다른 스레드에서 호출 가능
+    void Post(std::function<void()> fn);
+    void Wake();
+
+    // 스케줄러 스레드에서만 호출
+    TimerId ScheduleAfter(uint32_t delayMs, TimerCallback cb);
+    bool Cancel(TimerId id);
+    void AddPeriodicTask(const char* name, uint32_t intervalMs, std::function<void()> fn);
+
+    void SetForegroundHandler(std::function<void(HWND)> fn) { m_onForeground = fn; }
+    void SetSessionHandler(std::function<void(bool)> fn) { m_onSession = fn; }
+
+    bool IsSessionLocked() const { return m_locked; }
+    unsigned long Wakeups() const { return m_wakeups; }
+
+private:
+    struct PeriodicTask {
+        std::string name;
+        uint32_t intervalMs;
+        std::function<void()> fn;
+    };
+
+    TimerWheel m_wheel;
+    HWND m_msgWnd;
+    HWINEVENTHOOK m_fgHook;
+    bool m_sessionRegistered;
+    bool m_locked;
+    unsigned long m_wakeups;
+
+    std::mutex m_postLock;
+    std::vector<std::function<void()>> m_posted;
+    std::vector<PeriodicTask> m_tasks;
+
+    std::function<void(HWND)> m_onForeground;
+    std::function<void(bool)> m_onSession;
+
+    void RunPosted();
+    void SchedulePeriodic(size_t index);
+
+    static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+    static void CALLBACK WinEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd,
+        LONG idObject, LONG idChild, DWORD idEventThread, DWORD dwmsEventTime);
+};
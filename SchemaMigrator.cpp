@@ -0,0 +1,170 @@
+﻿#include "SchemaMigrator.h"
+#include "AsyncLogger.h"
+#include <stdio.h>
+#include <algorithm>
+
+namespace {
+    const unsigned long long kProgressLogRows = 50000; // 백그라운드 마이그레이션 진행 로그 간격 (행)
+}
+
+const char* SchemaMigrator::kBackgroundStateSql =
+    "CREATE TABLE IF NOT EXISTS SchemaBackgroundMigrations ("
+    "name TEXT PRIMARY KEY, "
+    "cursor INTEGER NOT NULL DEFAULT 0, "
+    "done INTEGER NOT NULL DEFAULT 0"
+    ");";
+
+void SchemaMigrator::AddStep(int version, const char* name, const char* sql) {
+    m_steps.push_back(Step{ version, name, sql, nullptr });
+}
+
+void SchemaMigrator::AddStep(int version, const char* name, StepFn fn) {
+    m_steps.push_back(Step{ version, name, std::string(), std::move(fn) });
+}
+
+void SchemaMigrator::AddBackgroundMigration(const char* name, int requiredVersion, ChunkFn fn) {
+    m_background.push_back(Background{ name, requiredVersion, std::move(fn), false, false, 0, 0 });
+}
+
+int SchemaMigrator::TargetVersion() const {
+    int target = 0;
+    for (const Step& s : m_steps) target = std::max(target, s.version);
+    return target;
+}
+
+int SchemaMigrator::CurrentVersion() {
+    sqlite3_stmt* stmt = nullptr;
+    int version = -1;
+    if (sqlite3_prepare_v2(m_db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) version = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return version;
+}
+
+bool SchemaMigrator::Exec(const char* sql) {
+    char* err = nullptr;
+    int rc = sqlite3_exec(m_db, sql, nullptr, nullptr, &err);
+    if (rc != SQLITE_OK) {
+        AGENT_LOG_ERROR("[DB] Migration SQL failed: %s", err ? err : sqlite3_errmsg(m_db));
+        if (err) sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+bool SchemaMigrator::Migrate() {
+    int current = CurrentVersion();
+    if (current < 0) {
+        AGENT_LOG_ERROR("[DB] Cannot read user_version: %s", sqlite3_errmsg(m_db));
+        return false;
+    }
+
+    int target = TargetVersion();
+    if (current == target) return true; // 일반적인 경우: PRAGMA 한 번으로 끝
+    if (current > target) {
+        // 더 새로운 에이전트가 만든 DB: 단계는 추가만 하므로 현재 코드로도 사용 가능
+        AGENT_LOG_WARN("[DB] Schema v%d is newer than agent (v%d), leaving as is", current, target);
+        return true;
+    }
+
+    std::vector<Step> pending;
+    for (const Step& s : m_steps) {
+        if (s.version > current) pending.push_back(s);
+    }
+    std::sort(pending.begin(), pending.end(),
+        [](const Step& a, const Step& b) { return a.version < b.version; });
+
+    for (const Step& s : pending) {
+        if (!ApplyStep(s)) return false; // 실패한 단계 이전까지는 커밋되어 있으므로 다음 시작 시 이어서 적용
+    }
+    return true;
+}
+
+bool SchemaMigrator::ApplyStep(const Step& step) {
+    if (!Exec("BEGIN IMMEDIATE;")) return false;
+
+    bool ok = step.fn ? step.fn(m_db) : Exec(step.sql.c_str());
+    if (ok) {
+        char sql[64];
+        snprintf(sql, sizeof(sql), "PRAGMA user_version = %d;", step.version);
+        ok = Exec(sql);
+    }
+    if (!ok || !Exec("COMMIT;")) {
+        sqlite3_exec(m_db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        AGENT_LOG_ERROR("[DB] Migration v%d (%s) failed", step.version, step.name.c_str());
+        return false;
+    }
+
+    AGENT_LOG_INFO("[DB] Migrated to v%d: %s", step.version, step.name);
+    return true;
+}
+
+bool SchemaMigrator::RunBackgroundChunk(int maxRows) {
+    int current = -1;
+    for (Background& bg : m_background) {
+        if (bg.done) continue;
+        if (current < 0) current = CurrentVersion();
+        if (current < bg.requiredVersion) continue;
+
+        if (!Exec("BEGIN IMMEDIATE;")) return false;
+
+        // 진행 위치 조회
+        sqlite3_int64 cursor = 0;
+        bool done = false;
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(m_db, "SELECT cursor, done FROM SchemaBackgroundMigrations WHERE name = ?;",
+            -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, bg.name.c_str(), -1, SQLITE_TRANSIENT);
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                cursor = sqlite3_column_int64(stmt, 0);
+                done = sqlite3_column_int(stmt, 1) != 0;
+            }
+            sqlite3_finalize(stmt);
+        }
+
+        if (!done && !bg.started) {
+            AGENT_LOG_INFO("[DB] Background migration %s running (from cursor %lld)", bg.name, (long long)cursor);
+            bg.started = true;
+        }
+        const sqlite3_int64 from = cursor;
+        int processed = done ? 0 : bg.fn(m_db, cursor, maxRows);
+        if (processed < 0) {
+            sqlite3_exec(m_db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            AGENT_LOG_WARN("[DB] Background migration %s chunk failed at cursor %lld: %s (retrying later)",
+                bg.name, (long long)from, sqlite3_errmsg(m_db));
+            return false; // 커밋된 진행 위치부터 다음 주기에 재시도
+        }
+
+        // 청크 결과와 진행 위치를 같은 트랜잭션으로 커밋
+        stmt = nullptr;
+        int rc = sqlite3_prepare_v2(m_db,
+            "INSERT OR REPLACE INTO SchemaBackgroundMigrations (name, cursor, done) VALUES (?, ?, ?);",
+            -1, &stmt, nullptr);
+        if (rc == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, bg.name.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(stmt, 2, cursor);
+            sqlite3_bind_int(stmt, 3, processed == 0 ? 1 : 0);
+            rc = sqlite3_step(stmt);
+            sqlite3_finalize(stmt);
+        }
+        if (rc != SQLITE_DONE || !Exec("COMMIT;")) {
+            sqlite3_exec(m_db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            return false;
+        }
+
+        if (processed == 0) {
+            bg.done = true;
+            if (bg.started) AGENT_LOG_INFO("[DB] Background migration %s complete (%llu rows)", bg.name, bg.rows);
+            continue;
+        }
+        bg.rows += (unsigned long long)processed;
+        AGENT_LOG_DEBUG("[DB] Background migration %s: %d rows, cursor %lld", bg.name, processed, (long long)cursor);
+        if (bg.rows - bg.loggedRows >= kProgressLogRows) {
+            AGENT_LOG_INFO("[DB] Background migration %s: %llu rows, cursor %lld", bg.name, bg.rows, (long long)cursor);
+            bg.loggedRows = bg.rows;
+        }
+        return true;
+    }
+    return false;
+}
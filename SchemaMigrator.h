@@ -0,0 +1,63 @@
+﻿#pragma once
+#include <sqlite3.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+// PRAGMA user_version 기반 스키마 마이그레이션
+// - 단계는 버전 순서대로 등록하며, 각 단계는 user_version 갱신과 함께 자체 트랜잭션으로 적용
+// - 스키마가 최신이면 PRAGMA 한 번만 읽고 반환 (시작 시 스키마를 건드리지 않음)
+// - DB가 에이전트보다 새 버전이면 (배포 중 롤백 등) 아무것도 변경하지 않음
+// - 대용량 데이터 변환은 백그라운드 마이그레이션으로 등록하여 청크 단위로 온라인 실행
+class SchemaMigrator {
+public:
+    typedef std::function<bool(sqlite3*)> StepFn;
+    // 청크 하나 처리: cursor는 이어서 처리할 위치 (트랜잭션 안에서 호출)
+    // 반환: 처리한 행 수, 0이면 완료, 음수면 오류
+    typedef std::function<int(sqlite3*, sqlite3_int64& cursor, int maxRows)> ChunkFn;
+
+    explicit SchemaMigrator(sqlite3* db) : m_db(db) {}
+
+    // version: 이 단계를 적용한 뒤의 user_version (1부터 연속)
+    void AddStep(int version, const char* name, const char* sql);
+    void AddStep(int version, const char* name, StepFn fn);
+
+    // requiredVersion 이상의 스키마에서만 실행
+    void AddBackgroundMigration(const char* name, int requiredVersion, ChunkFn fn);
+
+    int TargetVersion() const;
+    int CurrentVersion();
+
+    bool Migrate();
+
+    // 남은 백그라운드 마이그레이션 청크 하나 실행
+    // 반환: 바로 이어서 실행할 작업이 있으면 true (완료/오류 시 false, 오류는 다음 주기에 재시도)
+    bool RunBackgroundChunk(int maxRows);
+
+    // 백그라운드 진행 상태 테이블 (스키마 단계에서 생성)
+    static const char* kBackgroundStateSql;
+
+private:
+    struct Step {
+        int version;
+        std::string name;
+        std::string sql;
+        StepFn fn;
+    };
+    struct Background {
+        std::string name;
+        int requiredVersion;
+        ChunkFn fn;
+        bool done;
+        bool started;                  // 이번 실행에서 청크를 실행했는지 (시작/완료 로그용)
+        unsigned long long rows;       // 이번 실행에서 처리한 행 (진행 로그용)
+        unsigned long long loggedRows; // 마지막 진행 로그 시점의 rows
+    };
+
+    sqlite3* m_db;
+    std::vector<Step> m_steps;
+    std::vector<Background> m_background;
+
+    bool ApplyStep(const Step& step);
+    bool Exec(const char* sql);
+};
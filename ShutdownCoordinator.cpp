@@ -0,0 +1,113 @@
+﻿#include "ShutdownCoordinator.h"
+#include "AsyncLogger.h"
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+
+static const uint32_t kDefaultShutdownDeadlineMs = 4000; // 창 닫기 시 OS가 기다려 주는 5초 안쪽
+static const DWORD kHandlerGraceMs = 1000;               // 콘솔 핸들러가 기한 뒤에 더 기다리는 시간
+
+ShutdownCoordinator& ShutdownCoordinator::Instance() {
+    static ShutdownCoordinator coordinator;
+    return coordinator;
+}
+
+ShutdownCoordinator::ShutdownCoordinator()
+    : m_deadlineMs(kDefaultShutdownDeadlineMs), m_requested(false),
+      m_requestEvent(CreateEventA(nullptr, TRUE, FALSE, nullptr)),
+      m_completeEvent(CreateEventA(nullptr, TRUE, FALSE, nullptr)),
+      m_stepsDone(0), m_current(nullptr) {
+}
+
+ShutdownCoordinator::~ShutdownCoordinator() {
+    if (m_requestEvent) CloseHandle(m_requestEvent);
+    if (m_completeEvent) CloseHandle(m_completeEvent);
+}
+
+void ShutdownCoordinator::InstallConsoleHandler() {
+    if (!SetConsoleCtrlHandler(&ShutdownCoordinator::ConsoleHandler, TRUE))
+        printf("[Shutdown] SetConsoleCtrlHandler failed (err=%lu)\n", GetLastError());
+}
+
+// 제어 이벤트마다 새 스레드에서 호출됨
+BOOL WINAPI ShutdownCoordinator::ConsoleHandler(DWORD ctrlType) {
+    const char* reason;
+    switch (ctrlType) {
+    case CTRL_C_EVENT: reason = "Ctrl+C"; break;
+    case CTRL_BREAK_EVENT: reason = "Ctrl+Break"; break;
+    case CTRL_CLOSE_EVENT: reason = "console closed"; break;
+    case CTRL_LOGOFF_EVENT: reason = "logoff"; break;
+    case CTRL_SHUTDOWN_EVENT: reason = "system shutdown"; break;
+    default: return FALSE;
+    }
+
+    ShutdownCoordinator& self = Instance();
+    self.Request(reason);
+    WaitForSingleObject(self.m_completeEvent, self.m_deadlineMs + kHandlerGraceMs);
+    return TRUE;
+}
+
+void ShutdownCoordinator::AddStep(const char* name, Step step) {
+    m_steps.push_back(NamedStep{ name, std::move(step) });
+}
+
+void ShutdownCoordinator::Request(const char* reason) {
+    if (m_requested.exchange(true)) return;
+    printf("[Shutdown] Requested (%s)\n", reason);
+    SetEvent(m_requestEvent);
+}
+
+void ShutdownCoordinator::WaitForRequest() {
+    WaitForSingleObject(m_requestEvent, INFINITE);
+}
+
+bool ShutdownCoordinator::Run() {
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(m_deadlineMs);
+
+    // 멈춘 단계가 있으면 이 스레드는 프로세스 종료와 함께 정리됨 (join하지 않음)
+    std::thread runner([this]() {
+        for (NamedStep& s : m_steps) {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_current = s.name;
+            }
+            auto stepStart = std::chrono::steady_clock::now();
+            s.step();
+            long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - stepStart).count();
+            AGENT_LOG_INFO("[Shutdown] %s done (%lld ms)", s.name, ms);
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_stepsDone++;
+                m_current = nullptr;
+            }
+            m_cv.notify_all();
+        }
+    });
+
+    bool finished;
+    const char* stuck = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        finished = m_cv.wait_until(lock, deadline, [this]() { return m_stepsDone == m_steps.size(); });
+        if (!finished) stuck = m_current;
+    }
+    long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (finished) {
+        runner.join();
+        printf("[Shutdown] Completed in %lld ms\n", elapsed);
+        return true;
+    }
+    runner.detach();
+    AGENT_LOG_ERROR("[Shutdown] Deadline %u ms exceeded in %s; exiting without remaining steps",
+        m_deadlineMs, stuck ? stuck : "(unknown)");
+    printf("[Shutdown] Deadline exceeded in %s\n", stuck ? stuck : "(unknown)");
+    return false;
+}
+
+void ShutdownCoordinator::Complete() {
+    SetEvent(m_completeEvent);
+}
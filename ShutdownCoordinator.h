@@ -0,0 +1,57 @@
+﻿#pragma once
+#include <windows.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 종료 요청 수신과 정해진 순서의 종료 단계 실행
+// - 콘솔 제어 이벤트(Ctrl+C/Break, 창 닫기, 로그오프, 시스템 종료) 또는 Request로 종료 요청
+// - Run: 등록 순서대로 단계를 별도 스레드에서 실행하고 기한까지 기다림
+//   기한을 넘기면 멈춘 단계를 로그로 남기고 false (호출자는 남은 정리 없이 프로세스 종료)
+// - 콘솔 핸들러는 Complete가 호출될 때까지 반환하지 않음 (창 닫기 등은 핸들러가 반환하면 바로 종료되므로)
+class ShutdownCoordinator {
+public:
+    typedef std::function<void()> Step;
+
+    static ShutdownCoordinator& Instance();
+
+    void InstallConsoleHandler();
+    void SetDeadline(uint32_t deadlineMs) { m_deadlineMs = deadlineMs ? deadlineMs : m_deadlineMs; }
+    uint32_t Deadline() const { return m_deadlineMs; }
+
+    // 단계 등록 (Run 전에, 실행할 순서대로)
+    void AddStep(const char* name, Step step);
+
+    void Request(const char* reason);
+    bool IsRequested() const { return m_requested.load(); }
+    void WaitForRequest();
+
+    bool Run();
+    void Complete();
+
+private:
+    ShutdownCoordinator();
+    ~ShutdownCoordinator();
+
+    static BOOL WINAPI ConsoleHandler(DWORD ctrlType);
+
+    struct NamedStep {
+        const char* name;
+        Step step;
+    };
+
+    uint32_t m_deadlineMs;
+    std::vector<NamedStep> m_steps;
+    std::atomic<bool> m_requested;
+    HANDLE m_requestEvent;
+    HANDLE m_completeEvent;
+
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    size_t m_stepsDone;        // 끝난 단계 수 (m_lock)
+    const char* m_current;     // 실행 중인 단계 (m_lock)
+};
@@ -0,0 +1,23 @@
+﻿#pragma once
+#include <string>
+#include <unordered_set>
+
+// 문자열 인터닝: 같은 내용은 하나의 std::string으로 공유하고 그 주소를 ID처럼 사용
+// - 반환된 포인터는 Clear 또는 소멸 전까지 유효 (이동해도 노드 주소는 유지됨)
+// - 스레드 안전하지 않음 (호출자가 직렬화)
+class StringInterner {
+public:
+    const std::string* Intern(const char* data, size_t len) {
+        m_probe.assign(data, len); // 조회용 임시 문자열은 용량을 재사용하여 할당 없음
+        auto it = m_strings.find(m_probe);
+        if (it != m_strings.end()) return &*it;
+        return &*m_strings.insert(m_probe).first;
+    }
+
+    size_t Size() const { return m_strings.size(); }
+    void Clear() { m_strings.clear(); }
+
+private:
+    std::unordered_set<std::string> m_strings;
+    std::string m_probe;
+};
@@ -0,0 +1,233 @@
+﻿#include "TextCodec.h"
+#include <string>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TEXTCODEC_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTCODEC_SSE2 1
+#endif
+
+static const uint32_t kReplacementChar = 0xFFFD;
+
+// ASCII 블록 처리: 변환한 UTF-16 단위 수 반환 (첫 비ASCII 블록에서 멈춤)
+template <typename U16>
+static size_t AsciiBlock16To8(const U16* src, size_t len, char* dst, size_t cap) {
+    size_t i = 0;
+    size_t limit = len < cap ? len : cap;
+#if TEXTCODEC_AVX2
+    const __m256i mask256 = _mm256_set1_epi16((short)0xFF80);
+    while (i + 16 <= limit) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        if (!_mm256_testz_si256(v, mask256)) break;
+        // packus는 128비트 레인별로 묶이므로 64비트 단위 재배치 후 하위 16바이트 저장
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0x08);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm256_castsi256_si128(packed));
+        i += 16;
+    }
+#endif
+#if TEXTCODEC_SSE2
+    const __m128i mask = _mm_set1_epi16((short)0xFF80);
+    const __m128i zero = _mm_setzero_si128();
+    while (i + 8 <= limit) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, mask), zero)) != 0xFFFF) break;
+        _mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(v, v));
+        i += 8;
+    }
+#endif
+    return i;
+}
+
+// ASCII 블록 처리: 변환한 UTF-8 바이트 수 반환
+template <typename U16>
+static size_t AsciiBlock8To16(const char* src, size_t len, U16* dst, size_t cap) {
+    size_t i = 0;
+    size_t limit = len < cap ? len : cap;
+#if TEXTCODEC_AVX2
+    while (i + 32 <= limit) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        if (_mm256_movemask_epi8(v) != 0) break;
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+        _mm256_storeu_si256((__m256i*)(dst + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+        i += 32;
+    }
+#endif
+#if TEXTCODEC_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    while (i + 16 <= limit) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        if (_mm_movemask_epi8(v) != 0) break;
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpackhi_epi8(v, zero));
+        i += 16;
+    }
+#endif
+    return i;
+}
+
+template <typename U16>
+static size_t Utf16ToUtf8Impl(const U16* src, size_t len, char* dst, size_t cap) {
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < len) {
+        // 1. ASCII 고속 경로 (블록 단위)
+        size_t n = AsciiBlock16To8(src + i, len - i, dst + o, cap - o);
+        i += n;
+        o += n;
+        if (i >= len) break;
+
+        // 2. 스칼라 경로: 코드 포인트 하나 처리 후 다시 고속 경로 시도
+        uint32_t c = (uint16_t)src[i];
+        if (c < 0x80) {
+            if (o + 1 > cap) return kTextCodecOverflow;
+            dst[o++] = (char)c;
+            i++;
+            continue;
+        }
+        if (c < 0x800) {
+            if (o + 2 > cap) return kTextCodecOverflow;
+            dst[o++] = (char)(0xC0 | (c >> 6));
+            dst[o++] = (char)(0x80 | (c & 0x3F));
+            i++;
+            continue;
+        }
+        if (c >= 0xD800 && c <= 0xDFFF) {
+            uint32_t next = (i + 1 < len) ? (uint16_t)src[i + 1] : 0;
+            if (c <= 0xDBFF && next >= 0xDC00 && next <= 0xDFFF) {
+                uint32_t cp = 0x10000 + ((c - 0xD800) << 10) + (next - 0xDC00);
+                if (o + 4 > cap) return kTextCodecOverflow;
+                dst[o++] = (char)(0xF0 | (cp >> 18));
+                dst[o++] = (char)(0x80 | ((cp >> 12) & 0x3F));
+                dst[o++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                dst[o++] = (char)(0x80 | (cp & 0x3F));
+                i += 2;
+                continue;
+            }
+            c = kReplacementChar; // 짝이 맞지 않는 서로게이트
+        }
+        if (o + 3 > cap) return kTextCodecOverflow;
+        dst[o++] = (char)(0xE0 | (c >> 12));
+        dst[o++] = (char)(0x80 | ((c >> 6) & 0x3F));
+        dst[o++] = (char)(0x80 | (c & 0x3F));
+        i++;
+    }
+    return o;
+}
+
+template <typename U16>
+static size_t Utf8ToUtf16Impl(const char* src, size_t len, U16* dst, size_t cap) {
+    const unsigned char* s = (const unsigned char*)src;
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < len) {
+        size_t n = AsciiBlock8To16(src + i, len - i, dst + o, cap - o);
+        i += n;
+        o += n;
+        if (i >= len) break;
+
+        uint32_t c = s[i];
+        uint32_t cp = kReplacementChar;
+        size_t used = 1; // 잘못된 시퀀스는 1바이트씩 U+FFFD로 대체
+
+        if (c < 0x80) {
+            cp = c;
+        }
+        else if (c >= 0xC2 && c <= 0xDF) {
+            if (i + 1 < len && (s[i + 1] & 0xC0) == 0x80) {
+                cp = ((c & 0x1F) << 6) | (s[i + 1] & 0x3F);
+                used = 2;
+            }
+        }
+        else if (c >= 0xE0 && c <= 0xEF) {
+            if (i + 2 < len && (s[i + 1] & 0xC0) == 0x80 && (s[i + 2] & 0xC0) == 0x80) {
+                uint32_t v = ((c & 0x0F) << 12) | ((s[i + 1] & 0x3F) << 6) | (s[i + 2] & 0x3F);
+                if (v >= 0x800 && (v < 0xD800 || v > 0xDFFF)) { // 과잉 길이/서로게이트 거부
+                    cp = v;
+                    used = 3;
+                }
+            }
+        }
+        else if (c >= 0xF0 && c <= 0xF4) {
+            if (i + 3 < len && (s[i + 1] & 0xC0) == 0x80 && (s[i + 2] & 0xC0) == 0x80 && (s[i + 3] & 0xC0) == 0x80) {
+                uint32_t v = ((c & 0x07) << 18) | ((s[i + 1] & 0x3F) << 12) | ((s[i + 2] & 0x3F) << 6) | (s[i + 3] & 0x3F);
+                if (v >= 0x10000 && v <= 0x10FFFF) {
+                    cp = v;
+                    used = 4;
+                }
+            }
+        }
+
+        if (cp >= 0x10000) {
+            if (o + 2 > cap) return kTextCodecOverflow;
+            cp -= 0x10000;
+            dst[o++] = (U16)(0xD800 + (cp >> 10));
+            dst[o++] = (U16)(0xDC00 + (cp & 0x3FF));
+        }
+        else {
+            if (o + 1 > cap) return kTextCodecOverflow;
+            dst[o++] = (U16)cp;
+        }
+        i += used;
+    }
+    return o;
+}
+
+size_t TranscodeUtf16ToUtf8(const char16_t* src, size_t srcLen, char* dst, size_t dstCap) {
+    return Utf16ToUtf8Impl(src, srcLen, dst, dstCap);
+}
+
+size_t TranscodeUtf8ToUtf16(const char* src, size_t srcLen, char16_t* dst, size_t dstCap) {
+    return Utf8ToUtf16Impl(src, srcLen, dst, dstCap);
+}
+
+#if WCHAR_MAX <= 0xFFFF
+size_t TranscodeUtf16ToUtf8(const wchar_t* src, size_t srcLen, char* dst, size_t dstCap) {
+    return Utf16ToUtf8Impl(src, srcLen, dst, dstCap);
+}
+
+size_t TranscodeUtf8ToUtf16(const char* src, size_t srcLen, wchar_t* dst, size_t dstCap) {
+    return Utf8ToUtf16Impl(src, srcLen, dst, dstCap);
+}
+#else
+size_t TranscodeUtf16ToUtf8(const wchar_t* src, size_t srcLen, char* dst, size_t dstCap) {
+    size_t o = 0;
+    for (size_t i = 0; i < srcLen; i++) {
+        uint32_t c = (uint32_t)src[i];
+        if ((c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF) c = kReplacementChar;
+        size_t n = c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+        if (o + n > dstCap) return kTextCodecOverflow;
+        if (n == 1) {
+            dst[o++] = (char)c;
+            continue;
+        }
+        static const unsigned char kLead[5] = { 0, 0, 0xC0, 0xE0, 0xF0 };
+        dst[o] = (char)(kLead[n] | (c >> (6 * (n - 1))));
+        for (size_t k = 1; k < n; k++) dst[o + k] = (char)(0x80 | ((c >> (6 * (n - 1 - k))) & 0x3F));
+        o += n;
+    }
+    return o;
+}
+
+// UTF-16으로 디코드한 뒤 서로게이트 쌍을 합침 (LoadGen 전용 경로라 임시 버퍼 사용)
+size_t TranscodeUtf8ToUtf16(const char* src, size_t srcLen, wchar_t* dst, size_t dstCap) {
+    std::u16string units(Utf16CapacityFor(srcLen), u'\0');
+    size_t n = Utf8ToUtf16Impl(src, srcLen, &units[0], units.size());
+    if (n == kTextCodecOverflow) return kTextCodecOverflow;
+    size_t o = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t c = units[i];
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < n) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (units[i + 1] - 0xDC00);
+            i++;
+        }
+        if (o + 1 > dstCap) return kTextCodecOverflow;
+        dst[o++] = (wchar_t)c;
+    }
+    return o;
+}
+#endif
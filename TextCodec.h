@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <wchar.h>
+
+// UTF-16 <-> UTF-8 단일 패스 변환기 (플랫폼 독립)
+// - 호출자가 제공한 버퍼에 직접 기록 (크기 계산용 사전 패스 없음)
+// - URL은 대부분 ASCII이므로 SSE2/AVX2로 ASCII 구간을 블록 단위 처리
+// - 비ASCII 구간은 스칼라 경로: 서로게이트 쌍 결합, 짝 없는 서로게이트/잘못된 UTF-8은 U+FFFD로 대체
+
+// 버퍼 부족 시 반환값
+static const size_t kTextCodecOverflow = (size_t)-1;
+
+// 최악의 경우 필요한 출력 크기 (이 크기면 Overflow가 발생하지 않음)
+#if WCHAR_MAX <= 0xFFFF
+inline size_t Utf8CapacityFor(size_t utf16Units) { return utf16Units * 3; }
+#else
+inline size_t Utf8CapacityFor(size_t units) { return units * 4; } // wchar_t(UTF-32) 한 단위가 4바이트까지
+#endif
+inline size_t Utf16CapacityFor(size_t utf8Bytes) { return utf8Bytes; }
+
+// 반환: 기록한 바이트 수 (NUL 미포함, NUL을 쓰지 않음) 또는 kTextCodecOverflow
+size_t TranscodeUtf16ToUtf8(const char16_t* src, size_t srcLen, char* dst, size_t dstCap);
+
+// 반환: 기록한 UTF-16 단위 수 또는 kTextCodecOverflow
+size_t TranscodeUtf8ToUtf16(const char* src, size_t srcLen, char16_t* dst, size_t dstCap);
+
+#if WCHAR_MAX <= 0xFFFF
+// Windows: wchar_t == UTF-16 단위
+size_t TranscodeUtf16ToUtf8(const wchar_t* src, size_t srcLen, char* dst, size_t dstCap);
+size_t TranscodeUtf8ToUtf16(const char* src, size_t srcLen, wchar_t* dst, size_t dstCap);
+#else
+// wchar_t가 32비트인 빌드(Linux LoadGen): wstring(UTF-32) → UTF-8 (스칼라, 서로게이트/범위 밖 값은 U+FFFD)
+// 에이전트 코드가 wstring을 그대로 넘기는 호출을 같은 이름으로 컴파일하기 위한 것
+size_t TranscodeUtf16ToUtf8(const wchar_t* src, size_t srcLen, char* dst, size_t dstCap);
+// UTF-8 → wstring(UTF-32), 반환: 기록한 wchar_t 수 (Utf16CapacityFor 크기면 충분)
+size_t TranscodeUtf8ToUtf16(const char* src, size_t srcLen, wchar_t* dst, size_t dstCap);
+#endif
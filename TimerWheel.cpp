@@ -0,0 +1,84 @@
+﻿#include "TimerWheel.h"
+
+TimerWheel::TimerWheel(uint64_t nowMs, uint32_t tickMs, size_t slotCount)
+    : m_tickMs(tickMs ? tickMs : 1)
+    , m_currentTick(nowMs / (tickMs ? tickMs : 1))
+    , m_nextId(1)
+    , m_slots(slotCount ? slotCount : 1)
+{
+}
+
+TimerId TimerWheel::Schedule(uint64_t deadlineMs, TimerCallback cb) {
+    uint64_t tick = deadlineMs / m_tickMs;
+    if (tick < m_currentTick) tick = m_currentTick; // 이미 지난 시각은 다음 Advance에서 실행
+
+    TimerId id = m_nextId++;
+    size_t slot = SlotOf(tick);
+    Entry e = { id, deadlineMs, std::move(cb) };
+    m_slots[slot].push_back(std::move(e));
+    m_index[id] = slot;
+    return id;
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+    auto it = m_index.find(id);
+    if (it == m_index.end()) return false;
+
+    std::vector<Entry>& slot = m_slots[it->second];
+    for (size_t i = 0; i < slot.size(); i++) {
+        if (slot[i].id == id) {
+            slot[i] = std::move(slot.back());
+            slot.pop_back();
+            break;
+        }
+    }
+    m_index.erase(it);
+    return true;
+}
+
+size_t TimerWheel::Advance(uint64_t nowMs) {
+    uint64_t nowTick = nowMs / m_tickMs;
+    size_t fired = 0;
+
+    // 오래 멈춰 있었다면 한 바퀴만 확인하면 충분 (모든 슬롯을 한 번씩 검사)
+    uint64_t from = m_currentTick;
+    if (nowTick >= from + m_slots.size()) from = nowTick + 1 - m_slots.size();
+
+    std::vector<Entry> due;
+    for (uint64_t tick = from; tick <= nowTick; tick++) {
+        std::vector<Entry>& slot = m_slots[SlotOf(tick)];
+        for (size_t i = 0; i < slot.size();) {
+            if (slot[i].deadline <= nowMs) {
+                m_index.erase(slot[i].id);
+                due.push_back(std::move(slot[i]));
+                slot[i] = std::move(slot.back());
+                slot.pop_back();
+            }
+            else {
+                i++; // 다음 바퀴 타이머
+            }
+        }
+    }
+    // 현재 틱은 일부만 지났으므로 다음 Advance에서 다시 확인
+    if (nowTick > m_currentTick) m_currentTick = nowTick;
+
+    // 콜백은 슬롯 순회가 끝난 뒤 실행 (콜백 내 재예약 허용)
+    for (Entry& e : due) {
+        e.cb();
+        fired++;
+    }
+    return fired;
+}
+
+bool TimerWheel::NextDeadline(uint64_t& deadlineMs) const {
+    bool found = false;
+    for (const std::vector<Entry>& slot : m_slots) {
+        for (const Entry& e : slot) {
+            if (!found || e.deadline < deadlineMs) {
+                deadlineMs = e.deadline;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
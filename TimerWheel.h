@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <vector>
+#include <unordered_map>
+
+typedef uint64_t TimerId;
+typedef std::function<void()> TimerCallback;
+
+// 해시드 타이머 휠 (플랫폼 독립, 단일 스레드 전용)
+// - 슬롯 = tickMs 단위 시간 구간, 한 바퀴를 넘는 타이머는 같은 슬롯에서 다음 바퀴까지 대기
+// - 예약/취소 O(1), Advance는 지나간 틱의 슬롯만 확인
+class TimerWheel {
+public:
+    TimerWheel(uint64_t nowMs, uint32_t tickMs = 10, size_t slotCount = 256);
+
+    // 절대 시각(ms)에 콜백 예약, 0은 유효하지 않은 ID
+    TimerId Schedule(uint64_t deadlineMs, TimerCallback cb);
+    bool Cancel(TimerId id);
+
+    // nowMs까지 만료된 타이머 실행, 실행 개수 반환 (콜백 안에서 Schedule/Cancel 가능)
+    size_t Advance(uint64_t nowMs);
+
+    // 가장 이른 만료 시각 (예약된 타이머가 없으면 false)
+    bool NextDeadline(uint64_t& deadlineMs) const;
+
+    size_t Pending() const { return m_index.size(); }
+
+private:
+    struct Entry {
+        TimerId id;
+        uint64_t deadline;
+        TimerCallback cb;
+    };
+
+    uint32_t m_tickMs;
+    uint64_t m_currentTick;              // 아직 완전히 지나지 않은 가장 이른 틱
+    TimerId m_nextId;
+    std::vector<std::vector<Entry>> m_slots;
+    std::unordered_map<TimerId, size_t> m_index; // ID -> 슬롯
+
+    size_t SlotOf(uint64_t tick) const { return (size_t)(tick % m_slots.size()); }
+};
@@ -0,0 +1,45 @@
+﻿#include "Tracer.h"
+#include "MessageRouter.h"
+#include "IpcProtocol.h"
+#include "AsyncLogger.h"
+#include <windows.h>
+#include <stdio.h>
+
+// Tracer의 에이전트 측 제어 (기본 저장 위치, IMT_TRACE_CONTROL 핸들러)
+// 수집/저장 자체는 Tracer.cpp (windows.h/라우터 비의존, LoadGen에서 그대로 사용)
+
+namespace {
+    const char* kTraceDir = "C:\\ProgramData\\AgentLogs";
+}
+
+bool Tracer::DumpDefault() {
+    CreateDirectoryA(kTraceDir, nullptr);
+    SYSTEMTIME st;
+    GetLocalTime(&st);
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s\\trace-%04u%02u%02u-%02u%02u%02u.json", kTraceDir,
+        (unsigned)st.wYear, (unsigned)st.wMonth, (unsigned)st.wDay,
+        (unsigned)st.wHour, (unsigned)st.wMinute, (unsigned)st.wSecond);
+    return Dump(path);
+}
+
+void Tracer::RegisterHandlers(MessageRouter& router) {
+    RouteOptions options;
+    options.ordering = HandlerOrdering::Serial;
+    options.capacity = 8;
+    router.Register(IMT_TRACE_CONTROL, "TraceControl", [this](const IpcMessage& msg) {
+        if (msg.payload == "start") {
+            Enable();
+        }
+        else if (msg.payload == "stop") {
+            Disable();
+            DumpDefault();
+        }
+        else if (msg.payload == "dump") {
+            DumpDefault();
+        }
+        else {
+            AGENT_LOG_WARN("[Trace] Unknown command: %s", msg.payload.c_str());
+        }
+    }, options);
+}
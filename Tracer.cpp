@@ -0,0 +1,179 @@
+﻿#include "Tracer.h"
+#include "AsyncLogger.h"
+#include <stdio.h>
+#include <chrono>
+#include <functional>
+#include <thread>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    const size_t kMaxEventsPerThread = 128 * 1024; // 넘으면 버림 (스레드당 약 5MB)
+
+    thread_local uint64_t t_correlationId = 0;
+    thread_local std::shared_ptr<Tracer::ThreadBuffer> t_buffer;
+
+    std::atomic<uint64_t> g_nextCorrelationId(1);
+
+    // 추적 파일의 tid (std::thread::id 해시를 32비트로 접음)
+    uint32_t CurrentThreadTraceId() {
+        uint64_t h = (uint64_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+        return (uint32_t)(h ^ (h >> 32));
+    }
+
+    unsigned long CurrentProcessId() {
+#ifdef _WIN32
+        return (unsigned long)_getpid();
+#else
+        return (unsigned long)getpid();
+#endif
+    }
+}
+
+std::atomic<bool> Tracer::s_enabled(false);
+
+Tracer& Tracer::Instance() {
+    static Tracer instance;
+    return instance;
+}
+
+Tracer::Tracer() : m_dropped(0) {
+}
+
+uint64_t Tracer::NowUs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t Tracer::NewCorrelationId() {
+    if (!IsEnabled()) return 0;
+    return g_nextCorrelationId.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Tracer::CurrentCorrelationId() {
+    return t_correlationId;
+}
+
+void Tracer::SetCurrentCorrelationId(uint64_t id) {
+    t_correlationId = id;
+}
+
+void Tracer::SetThreadName(const char* name) {
+    ThreadBuffer* buffer = Instance().LocalBuffer();
+    std::lock_guard<std::mutex> lock(buffer->lock);
+    buffer->name = name ? name : "";
+}
+
+Tracer::ThreadBuffer* Tracer::LocalBuffer() {
+    if (!t_buffer) {
+        t_buffer = std::make_shared<ThreadBuffer>();
+        t_buffer->tid = CurrentThreadTraceId();
+        std::lock_guard<std::mutex> lock(m_buffersLock);
+        m_buffers.push_back(t_buffer);
+    }
+    return t_buffer.get();
+}
+
+void Tracer::Record(const char* name, char phase, uint64_t startUs, uint64_t durUs, uint64_t correlationId) {
+    ThreadBuffer* buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(buffer->lock);
+    if (buffer->events.size() >= kMaxEventsPerThread) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (buffer->events.capacity() == 0) buffer->events.reserve(4096);
+    Event e = { name, startUs, durUs, correlationId, phase };
+    buffer->events.push_back(e);
+}
+
+void Tracer::Enable() {
+    {
+        std::lock_guard<std::mutex> lock(m_buffersLock);
+        for (auto& buffer : m_buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->lock);
+            buffer->events.clear();
+        }
+    }
+    m_dropped.store(0);
+    s_enabled.store(true);
+    AGENT_LOG_INFO("[Trace] Enabled");
+}
+
+void Tracer::Disable() {
+    s_enabled.store(false);
+    AGENT_LOG_INFO("[Trace] Disabled");
+}
+
+bool Tracer::Dump(const char* path) {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_buffersLock);
+        buffers = m_buffers;
+        // 종료된 스레드(레지스트리만 참조)의 버퍼는 이번 Dump 후 해제
+        std::vector<std::shared_ptr<ThreadBuffer>> alive;
+        for (auto& buffer : m_buffers) {
+            if (buffer.use_count() > 2) alive.push_back(buffer); // m_buffers + buffers + 소유 스레드
+        }
+        m_buffers.swap(alive);
+    }
+
+    FILE* file = nullptr;
+#ifdef _WIN32
+    if (fopen_s(&file, path, "wb") != 0) file = nullptr;
+#else
+    file = fopen(path, "wb");
+#endif
+    if (!file) {
+        AGENT_LOG_ERROR("[Trace] Cannot write %s", path);
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1024 * 1024);
+
+    const unsigned long pid = CurrentProcessId();
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":0,\"args\":{\"name\":\"PCAgent\"}}", pid);
+
+    size_t count = 0;
+    std::vector<Event> events;
+    for (auto& buffer : buffers) {
+        std::string name;
+        events.clear();
+        {
+            std::lock_guard<std::mutex> lock(buffer->lock);
+            events.swap(buffer->events);
+            name = buffer->name;
+        }
+        const unsigned long tid = (unsigned long)buffer->tid;
+        if (!name.empty()) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                pid, tid, name.c_str());
+        }
+
+        for (const Event& e : events) {
+            if (e.phase == 'X') {
+                fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"agent\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,"
+                    "\"pid\":%lu,\"tid\":%lu,\"args\":{\"cid\":%llu}}",
+                    e.name, (unsigned long long)e.startUs, (unsigned long long)e.durUs, pid, tid,
+                    (unsigned long long)e.correlationId);
+            }
+            else {
+                // 흐름 이벤트: 같은 id의 s → t → f가 화살표로 연결됨
+                fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"flow\",\"ph\":\"%c\",\"id\":%llu,\"ts\":%llu,"
+                    "\"pid\":%lu,\"tid\":%lu%s}",
+                    e.name, e.phase, (unsigned long long)e.correlationId, (unsigned long long)e.startUs, pid, tid,
+                    e.phase == 'f' ? ",\"bp\":\"e\"" : "");
+            }
+        }
+        count += events.size();
+    }
+
+    fprintf(file, "\n]}\n");
+    bool ok = ferror(file) == 0;
+    fclose(file);
+
+    AGENT_LOG_INFO("[Trace] Wrote %zu events to %s (dropped %llu)", count, path, m_dropped.load());
+    return ok;
+}
@@ -0,0 +1,123 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class MessageRouter;
+
+// URL 파이프라인 구간 추적 (Chrome trace_event JSON → Perfetto / chrome://tracing)
+// - TRACE_SPAN: 스코프 하나를 "X"(완료) 이벤트로 기록. 이름은 정적 리터럴이어야 함 (포인터만 저장)
+// - 꺼져 있으면 atomic bool 하나만 읽고 끝남
+// - 이벤트는 스레드별 버퍼에 쌓이고 Dump 시에만 모아서 파일로 기록
+// - 상관 ID: 폴링 한 번에서 시작된 작업을 IPC 너머(IPC_TRACE_TRAILER)까지 같은 ID로 묶음
+//   (AGENT_DISABLE_TRACING 정의 시 매크로가 모두 비어 코드에서 제거됨)
+// - 수집/저장(Tracer.cpp)은 windows.h 비의존. DumpDefault/RegisterHandlers는 TraceControl.cpp (에이전트 전용)
+class Tracer {
+public:
+    static Tracer& Instance();
+
+    static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    void Enable();  // 이전 이벤트를 비우고 기록 시작
+    void Disable();
+
+    // 지금까지의 이벤트를 Chrome trace JSON으로 기록 (기록된 버퍼는 비워짐)
+    bool Dump(const char* path);
+    // C:\ProgramData\AgentLogs\trace-<시각>.json
+    bool DumpDefault();
+
+    // IMT_TRACE_CONTROL: "start" | "stop"(끄고 저장) | "dump"(계속 기록하며 저장)
+    void RegisterHandlers(MessageRouter& router);
+
+    static uint64_t NowUs();
+    static uint64_t NewCorrelationId(); // 꺼져 있으면 0
+    static uint64_t CurrentCorrelationId();
+    static void SetCurrentCorrelationId(uint64_t id);
+    static void SetThreadName(const char* name);
+
+    // phase: 'X' 구간, 's'/'f' 상관 ID 흐름 시작/끝 (IPC 송신/수신)
+    void Record(const char* name, char phase, uint64_t startUs, uint64_t durUs, uint64_t correlationId);
+
+    unsigned long long Dropped() const { return m_dropped.load(); }
+
+    struct Event {
+        const char* name;
+        uint64_t startUs;
+        uint64_t durUs;
+        uint64_t correlationId;
+        char phase;
+    };
+    struct ThreadBuffer {
+        std::mutex lock; // 소유 스레드와 Dump만 사용 (평소에는 경합 없음)
+        std::vector<Event> events;
+        uint32_t tid = 0;
+        std::string name;
+    };
+
+private:
+    Tracer();
+
+    static std::atomic<bool> s_enabled;
+
+    std::mutex m_buffersLock;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers; // 스레드 종료 후에도 Dump 전까지 유지
+    std::atomic<unsigned long long> m_dropped;
+
+    ThreadBuffer* LocalBuffer();
+};
+
+// 스코프 구간 하나 기록
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name)
+        : m_name(Tracer::IsEnabled() ? name : nullptr), m_start(m_name ? Tracer::NowUs() : 0) {
+    }
+    ~TraceSpan() {
+        if (m_name)
+            Tracer::Instance().Record(m_name, 'X', m_start, Tracer::NowUs() - m_start, Tracer::CurrentCorrelationId());
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_start;
+};
+
+// 스코프 동안 현재 스레드의 상관 ID 설정 (0이면 아무것도 안 함)
+class TraceCorrelationScope {
+public:
+    explicit TraceCorrelationScope(uint64_t id) : m_active(id != 0), m_prev(0) {
+        if (m_active) {
+            m_prev = Tracer::CurrentCorrelationId();
+            Tracer::SetCurrentCorrelationId(id);
+        }
+    }
+    ~TraceCorrelationScope() {
+        if (m_active) Tracer::SetCurrentCorrelationId(m_prev);
+    }
+    TraceCorrelationScope(const TraceCorrelationScope&) = delete;
+    TraceCorrelationScope& operator=(const TraceCorrelationScope&) = delete;
+
+private:
+    bool m_active;
+    uint64_t m_prev;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+// TRACE_FLOW: IPC 송신('s') → 수신('t') → 처리('f') 지점 표시 (Perfetto에서 화살표로 연결)
+#ifndef AGENT_DISABLE_TRACING
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#define TRACE_CORRELATE(id) TraceCorrelationScope TRACE_CONCAT(traceCid_, __LINE__)(id)
+#define TRACE_FLOW(phase, id) \
+    do { if ((id) && Tracer::IsEnabled()) Tracer::Instance().Record("ipc", (phase), Tracer::NowUs(), 0, (id)); } while (0)
+#else
+#define TRACE_SPAN(name) ((void)0)
+#define TRACE_CORRELATE(id) ((void)0)
+#define TRACE_FLOW(phase, id) ((void)0)
+#endif
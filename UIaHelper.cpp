@@ -1,8 +1,45 @@
 ﻿#include "UiaHelper.h"
+#include "AsyncLogger.h"
+#include "Tracer.h"
 #include <vector>
 #include <stdio.h>
 
-UiaHelper::UiaHelper() : m_uia(nullptr), m_initialized(false) {
+// 주소 표시줄 ValueValue 속성 변경 이벤트 수신 (UIA 이벤트 스레드에서 호출됨, 요소 하나당 하나)
+class UiaValueChangeSink final : public IUIAutomationPropertyChangedEventHandler {
+public:
+    UiaValueChangeSink(HWND hwnd, const std::function<void(HWND)>& listener)
+        : m_refs(1), m_hwnd(hwnd), m_listener(listener) {
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override { return InterlockedIncrement(&m_refs); }
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG refs = InterlockedDecrement(&m_refs);
+        if (refs == 0) delete this;
+        return refs;
+    }
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppv) override {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IUIAutomationPropertyChangedEventHandler)) {
+            *ppv = static_cast<IUIAutomationPropertyChangedEventHandler*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+    HRESULT STDMETHODCALLTYPE HandlePropertyChangedEvent(IUIAutomationElement*, PROPERTYID, VARIANT) override {
+        m_listener(m_hwnd); // 값은 읽지 않음 (다음 샘플에서 평소 경로로 읽음)
+        return S_OK;
+    }
+
+private:
+    LONG m_refs;
+    HWND m_hwnd;
+    std::function<void(HWND)> m_listener;
+};
+
+UiaHelper::UiaHelper(AddressBarLocator* sharedLocator)
+    : m_uia(nullptr), m_walker(nullptr), m_cacheReq(nullptr), m_stateReq(nullptr), m_initialized(false)
+    , m_locator(sharedLocator ? sharedLocator : &m_ownLocator) {
 
 }
 UiaHelper::~UiaHelper() {
@@ -34,18 +71,66 @@ bool UiaHelper::Initialize() {
         return false;
     }
 
+    // 경로 탐색용 TreeWalker와 속성 일괄 조회용 CacheRequest는 한 번만 생성하여 재사용
+    m_uia->get_ControlViewWalker(&m_walker);
+    if (SUCCEEDED(m_uia->CreateCacheRequest(&m_cacheReq)) && m_cacheReq) {
+        m_cacheReq->AddProperty(UIA_NamePropertyId);
+        m_cacheReq->AddProperty(UIA_ControlTypePropertyId);
+        m_cacheReq->AddProperty(UIA_IsKeyboardFocusablePropertyId);
+        m_cacheReq->AddProperty(UIA_AutomationIdPropertyId);
+    }
+    // 주소 표시줄 값과 포커스(편집 중 여부)를 한 번에 읽기 위한 CacheRequest
+    if (SUCCEEDED(m_uia->CreateCacheRequest(&m_stateReq)) && m_stateReq) {
+        m_stateReq->AddProperty(UIA_ValueValuePropertyId);
+        m_stateReq->AddProperty(UIA_HasKeyboardFocusPropertyId);
+    }
+    if (!m_walker || !m_cacheReq || !m_stateReq) {
+        printf("[UIA] TreeWalker/CacheRequest creation failed\n");
+        if (m_walker) { m_walker->Release(); m_walker = nullptr; }
+        if (m_cacheReq) { m_cacheReq->Release(); m_cacheReq = nullptr; }
+        if (m_stateReq) { m_stateReq->Release(); m_stateReq = nullptr; }
+        m_uia->Release();
+        m_uia = nullptr;
+        CoUninitialize();
+        return false;
+    }
+
     m_initialized = true;
     printf("[UIA] Initialized\n");
     return true;
 }
 
 void UiaHelper::Shutdown() {
+    // 구독을 한 번에 해제 (진행 중인 알림 처리가 끝날 때까지 대기하므로 이후 수신자 호출 없음)
+    bool subscribed = false;
+    for (auto& it : m_cachedAddr) {
+        if (it.second.sink) subscribed = true;
+    }
+    if (subscribed && m_uia) m_uia->RemoveAllEventHandlers();
+
     // 캐시된 UIA 요소들을 모두 Release
     for (auto& it : m_cachedAddr) { //캐시된 모든 UI요소 순회
-        if (it.second) it.second->Release(); //UIA 요소의 참조 카운트를 감소시켜 해제
+        if (it.second.sink) {
+            it.second.sink->Release();
+            it.second.sink = nullptr;
+        }
+        ReleaseCached(it.second); //UIA 요소의 참조 카운트를 감소시켜 해제
     }
 	m_cachedAddr.clear(); //캐시 맵 비우기
+    PruneVersions(true);
 
+    if (m_cacheReq) {
+        m_cacheReq->Release();
+        m_cacheReq = nullptr;
+    }
+    if (m_stateReq) {
+        m_stateReq->Release();
+        m_stateReq = nullptr;
+    }
+    if (m_walker) {
+        m_walker->Release();
+        m_walker = nullptr;
+    }
     if (m_uia) {
         m_uia->Release(); //IUIAutomation 객체 해제
         m_uia = nullptr;
@@ -56,19 +141,98 @@ void UiaHelper::Shutdown() {
     }
 }
 
+// 더 이상 존재하지 않는 윈도우의 캐시 항목 정리
+void UiaHelper::PruneDeadWindows() {
+    for (auto it = m_cachedAddr.begin(); it != m_cachedAddr.end();) {
+        if (!IsWindow(it->first)) {
+            ReleaseCached(it->second);
+            it = m_cachedAddr.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    PruneVersions(false);
+}
+
+// 프로세스 버전 (캐시 적중 시 종료 여부만 확인, 미스일 때만 버전 리소스 조회)
+std::wstring UiaHelper::GetProcessVersion(DWORD pid) {
+    auto it = m_versions.find(pid);
+    if (it != m_versions.end()) {
+        if (WaitForSingleObject(it->second.process, 0) == WAIT_TIMEOUT) return it->second.version;
+        CloseHandle(it->second.process); // 종료됨 -> 같은 PID의 새 프로세스일 수 있으므로 다시 조회
+        m_versions.erase(it);
+    }
+
+    std::wstring version = BrowserHelper::GetProcessVersion(pid);
+    HANDLE process = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (process) { // 열 수 없으면 캐시하지 않음 (종료 감지 불가)
+        CachedVersion& entry = m_versions[pid];
+        entry.process = process;
+        entry.version = version;
+    }
+    return version;
+}
+
+// 종료된 프로세스의 버전 캐시 정리 (all이면 전부)
+void UiaHelper::PruneVersions(bool all) {
+    for (auto it = m_versions.begin(); it != m_versions.end();) {
+        if (all || WaitForSingleObject(it->second.process, 0) != WAIT_TIMEOUT) {
+            CloseHandle(it->second.process);
+            it = m_versions.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+// 캐시 항목 해제 (구독 중이면 먼저 구독 해제)
+void UiaHelper::ReleaseCached(CachedAddr& cached) {
+    if (cached.sink) {
+        if (m_uia && cached.element) m_uia->RemovePropertyChangedEventHandler(cached.element, cached.sink);
+        cached.sink->Release();
+        cached.sink = nullptr;
+    }
+    if (cached.element) {
+        cached.element->Release();
+        cached.element = nullptr;
+    }
+}
+
+// 캐시한 주소 표시줄 요소의 값 변경 이벤트 구독 (지원하지 않는 브라우저면 구독 없이 폴링만)
+void UiaHelper::Subscribe(HWND hwnd, CachedAddr& cached) {
+    if (!m_listener || !m_uia || !cached.element) return;
+
+    PROPERTYID props[] = { UIA_ValueValuePropertyId };
+    UiaValueChangeSink* sink = new UiaValueChangeSink(hwnd, m_listener);
+    HRESULT hr = m_uia->AddPropertyChangedEventHandlerNativeArray(
+        cached.element, TreeScope_Element, nullptr, sink, props, 1);
+    if (FAILED(hr)) {
+        AGENT_LOG_DEBUG("[UIA] Value change subscription failed: 0x%08X", (unsigned)hr);
+        sink->Release();
+        return;
+    }
+    cached.sink = sink;
+}
+
 // 브라우저 유형을 인자로 받아 URL을 읽어오는 함수
-bool UiaHelper::GetAddressBarUrl(HWND hwnd, BrowserType type, std::wstring& urlOut) {
+bool UiaHelper::GetAddressBarUrl(HWND hwnd, BrowserType type, std::wstring& urlOut, bool* editingOut) {
+    TRACE_SPAN("UiaHelper::GetAddressBarUrl");
+    if (editingOut) *editingOut = false;
     if (!m_uia || !hwnd || type == BrowserType::Unknown) return false;
 
     // 1️. 캐시 우선: 이전에 찾은 요소가 있다면 재탐색 없이 사용 시도
 	auto it = m_cachedAddr.find(hwnd); //hwnd에 해당하는 캐시된 요소 찾기
     if (it != m_cachedAddr.end()) {
-        if (ReadValueFromElement(it->second, urlOut) ||
-            ReadTextFromElement(it->second, urlOut)) {
+        IUIAutomationElement* cached = it->second.element;
+        if (ReadStateFromElement(cached, urlOut, editingOut) ||
+            ReadValueFromElement(cached, urlOut) ||
+            ReadTextFromElement(cached, urlOut)) {
             return true;
         }
         // 캐시된 요소에서 값을 못 읽으면 (예: 탭 전환으로 요소가 무효화됨) 캐시 제거
-        it->second->Release();
+        ReleaseCached(it->second);
         m_cachedAddr.erase(it);
     }
 
@@ -77,18 +241,24 @@ bool UiaHelper::GetAddressBarUrl(HWND hwnd, BrowserType type, std::wstring& urlO
     HRESULT hr = m_uia->ElementFromHandle(hwnd, &root); //HWND를 기반으로 UIA 트리의 루트 얻기
     if (FAILED(hr) || !root) return false;
 
-    // 3️. 브라우저 유형에 맞춰 주소 표시줄 요소 탐색
-    IUIAutomationElement* addr = FindAddressBarElementByBrowser(root, type); //브라우저 유형별 주소 표시줄 요소 찾기
+    // 3️. 브라우저 유형/버전에 맞춰 주소 표시줄 요소 탐색 (버전이 바뀌면 경로를 새로 학습)
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+    std::wstring version = GetProcessVersion(pid);
+    IUIAutomationElement* addr = FindAddressBarElementByBrowser(root, type, version); //브라우저 유형별 주소 표시줄 요소 찾기
     root->Release(); //루트 요소의 참조카운트를 감소
 
     if (!addr) return false;
 
     // 4️. 캐시: 성공적으로 찾은 요소를 캐시
     addr->AddRef(); //찾은 요소의 참조 카운트 증가
-    m_cachedAddr[hwnd] = addr; //캐시에 저장
+    CachedAddr& entry = m_cachedAddr[hwnd];
+    entry.element = addr; //캐시에 저장
+    Subscribe(hwnd, entry);
 
     // 5️. 값 읽기
     bool ok =
+        ReadStateFromElement(addr, urlOut, editingOut) ||
         ReadValueFromElement(addr, urlOut) ||
         ReadTextFromElement(addr, urlOut);
 
@@ -96,120 +266,134 @@ bool UiaHelper::GetAddressBarUrl(HWND hwnd, BrowserType type, std::wstring& urlO
     return ok;
 }
 
-//브라우저 유형별 주소 표시줄 탐색 로직 (핵심 분기)
+//브라우저 유형별 주소 표시줄 탐색 (학습된 경로 우선, 실패 시 전체 탐색)
 IUIAutomationElement* UiaHelper::FindAddressBarElementByBrowser(
-    IUIAutomationElement* root, BrowserType type)
+    IUIAutomationElement* root, BrowserType type, const std::wstring& version)
+{
+    UiaElementTree tree(m_uia, m_walker, m_cacheReq, root);
+    IUIAutomationElement* el = (IUIAutomationElement*)m_locator->Locate(tree, type, version);
+    if (el) {
+        AGENT_LOG_DEBUG("[UIA] AddressBar FOUND for Browser Type: %d (path hits=%lu, full searches=%lu)",
+            (int)type, m_locator->PathHits(), m_locator->FullSearches());
+    }
+    return el;
+}
+
+UiaElementTree::UiaElementTree(IUIAutomation* uia, IUIAutomationTreeWalker* walker,
+    IUIAutomationCacheRequest* cacheReq, IUIAutomationElement* root)
+    : m_uia(uia), m_walker(walker), m_cacheReq(cacheReq), m_root(root)
 {
-    // A. 공통 조건: ControlType이 Edit인 요소
+}
+
+UiaNode UiaElementTree::FirstChild(UiaNode node) {
+    IUIAutomationElement* child = nullptr;
+    m_walker->GetFirstChildElementBuildCache((IUIAutomationElement*)node, m_cacheReq, &child);
+    return child;
+}
+
+UiaNode UiaElementTree::NextSibling(UiaNode node) {
+    IUIAutomationElement* next = nullptr;
+    m_walker->GetNextSiblingElementBuildCache((IUIAutomationElement*)node, m_cacheReq, &next);
+    return next;
+}
+
+UiaNode UiaElementTree::Parent(UiaNode node) {
+    IUIAutomationElement* parent = nullptr;
+    m_walker->GetParentElementBuildCache((IUIAutomationElement*)node, m_cacheReq, &parent);
+    return parent;
+}
+
+// CacheRequest로 받아둔 속성만 읽으므로 추가 프로세스 간 호출 없음
+bool UiaElementTree::GetInfo(UiaNode node, UiaNodeInfo& info) {
+    IUIAutomationElement* el = (IUIAutomationElement*)node;
+    if (!el) return false;
+
+    BSTR name = nullptr;
+    if (SUCCEEDED(el->get_CachedName(&name)) && name) {
+        info.name.assign(name, SysStringLen(name));
+        SysFreeString(name);
+    }
+    else {
+        info.name.clear();
+    }
+
+    BSTR id = nullptr;
+    if (SUCCEEDED(el->get_CachedAutomationId(&id)) && id) {
+        info.automationId.assign(id, SysStringLen(id));
+        SysFreeString(id);
+    }
+    else {
+        info.automationId.clear();
+    }
+
+    CONTROLTYPEID ct = 0;
+    el->get_CachedControlType(&ct);
+    info.controlType = ct;
+
+    BOOL focusable = FALSE;
+    el->get_CachedIsKeyboardFocusable(&focusable);
+    info.keyboardFocusable = (focusable != FALSE);
+    return true;
+}
+
+bool UiaElementTree::IsSameNode(UiaNode a, UiaNode b) {
+    if (a == b) return true;
+    BOOL same = FALSE;
+    m_uia->CompareElements((IUIAutomationElement*)a, (IUIAutomationElement*)b, &same);
+    return same != FALSE;
+}
+
+// 전체 탐색도 FindAllBuildCache로 후보 속성을 한 번에 가져옴 (후보별 get_CurrentName 제거)
+void UiaElementTree::FindEditDescendants(std::vector<UiaNode>& out) {
     VARIANT vEdit;
     VariantInit(&vEdit);
     vEdit.vt = VT_I4;
     vEdit.lVal = UIA_EditControlTypeId;
 
     IUIAutomationCondition* condEdit = nullptr;
-    m_uia->CreatePropertyCondition(UIA_ControlTypePropertyId, vEdit, &condEdit);
+    if (FAILED(m_uia->CreatePropertyCondition(UIA_ControlTypePropertyId, vEdit, &condEdit)) || !condEdit) return;
 
     IUIAutomationElementArray* list = nullptr;
-    HRESULT hr = root->FindAll(
-        TreeScope_Descendants, // 모든 자손 탐색
-        condEdit,
-        &list);
-
+    HRESULT hr = m_root->FindAllBuildCache(TreeScope_Descendants, condEdit, m_cacheReq, &list);
     condEdit->Release();
-    if (FAILED(hr) || !list) return nullptr;
+    if (FAILED(hr) || !list) return;
 
     int count = 0;
     list->get_Length(&count);
-
-    // 브라우저별 특화된 필터링/탐색 로직
     for (int i = 0; i < count; i++) {
         IUIAutomationElement* el = nullptr;
-        list->GetElement(i, &el);
-
-        BSTR name = nullptr;
-        el->get_CurrentName(&name); // Name 속성 가져오기
-
-        bool match = false;
-
-        switch (type) {
-        case BrowserType::Chrome: // 크롬, 웨일, 엣지 (Chromium) 공통 구조
-        case BrowserType::Edge:
-        case BrowserType::Whale:
-            // Chromium 기반은 Name이 "Address and search bar" / "주소 및 검색 창" 등인 경우가 많음
-            if (name) {
-                std::wstring n = name;
-                if (n.find(L"Address") != std::wstring::npos ||
-                    n.find(L"address") != std::wstring::npos ||
-                    n.find(L"search") != std::wstring::npos ||
-                    n.find(L"주소") != std::wstring::npos) {
-                    match = true;
-                }
-            }
-            break;
-
-        case BrowserType::FireFox:
-            // Firefox는 UIA ControlType=Edit인 요소의 Name이 빈 경우가 많거나 "Search or enter address" 등
-            if (name) {
-                std::wstring n = name;
-                if (n.find(L"address") != std::wstring::npos ||
-                    n.find(L"주소") != std::wstring::npos ||
-                    n.find(L"search") != std::wstring::npos) {
-                    match = true;
-                }
-            }
-            else {
-                // 특정 포커스 가능한 Edit 컨트롤이 주소 표시줄인 경우가 많음 (버전별로 다름)
-                BOOL focusable = FALSE;
-                el->get_CurrentIsKeyboardFocusable(&focusable);
-                if (focusable) {
-                    // 추가적인 휴리스틱(예: Automation ID나 Bounding Rect 위치)이 필요할 수 있음
-                    match = true;
-                }
-            }
-            break;
-
-        case BrowserType::IE:
-            // IE는 일반적으로 ControlType=Edit이고, Name이 "주소" 또는 "Address"인 경우가 많음
-            if (name) {
-                std::wstring n = name;
-                if (n.find(L"Address") != std::wstring::npos ||
-                    n.find(L"주소") != std::wstring::npos) {
-                    match = true;
-                }
-            }
-            break;
-
-        default:
-            // 알 수 없는 브라우저는 기본 로직 적용
-            if (name) {
-                std::wstring n = name;
-                if (n.find(L"Address") != std::wstring::npos ||
-                    n.find(L"address") != std::wstring::npos ||
-                    n.find(L"search") != std::wstring::npos ||
-                    n.find(L"주소") != std::wstring::npos) {
-                    match = true;
-                }
-            }
-            break;
-        }
+        if (SUCCEEDED(list->GetElement(i, &el)) && el) out.push_back(el);
+    }
+    list->Release();
+}
 
-        if (name) SysFreeString(name); // Name BSTR 해제
+void UiaElementTree::ReleaseNode(UiaNode node) {
+    if (node && node != m_root) ((IUIAutomationElement*)node)->Release();
+}
 
-        if (!match) {
-            el->Release();
-            continue;
-        }
 
-        list->Release();
-        printf("[UIA] AddressBar FOUND for Browser Type: %d\n", (int)type);
-        return el; // 찾은 요소 반환
+// 값(ValueValue)과 키보드 포커스를 BuildUpdatedCache 한 번의 왕복으로 읽기
+bool UiaHelper::ReadStateFromElement(IUIAutomationElement* element, std::wstring& out, bool* editingOut) {
+    IUIAutomationElement* updated = nullptr;
+    if (FAILED(element->BuildUpdatedCache(m_stateReq, &updated)) || !updated) return false;
+
+    VARIANT v;
+    VariantInit(&v);
+    bool ok = SUCCEEDED(updated->GetCachedPropertyValue(UIA_ValueValuePropertyId, &v)) &&
+        v.vt == VT_BSTR && v.bstrVal;
+    if (ok) {
+        out.assign(v.bstrVal, SysStringLen(v.bstrVal));
+        if (editingOut) {
+            BOOL focus = FALSE;
+            updated->get_CachedHasKeyboardFocus(&focus); //주소 표시줄에 포커스 = 사용자 입력 중
+            *editingOut = (focus != FALSE);
+        }
     }
-
-    list->Release();
-    return nullptr;
+    VariantClear(&v);
+    updated->Release();
+    return ok;
 }
 
-
 // UIA Value Pattern을 이용해 값 읽기
 bool UiaHelper::ReadValueFromElement(IUIAutomationElement* element, std::wstring& out) {
     IUIAutomationValuePattern* vp = nullptr;
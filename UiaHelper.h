@@ -1,33 +1,95 @@
 ﻿#pragma once
 #include <UIAutomation.h>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <windows.h>
 #include "BrowserHelper.h" // BrowserType 사용을 위해 포함
+#include "AddressBarLocator.h"
+
+// IUiaTree의 UIA 구현: 캐시된 TreeWalker + CacheRequest로 속성을 한 번에 가져옴
+class UiaElementTree : public IUiaTree {
+public:
+    UiaElementTree(IUIAutomation* uia, IUIAutomationTreeWalker* walker,
+        IUIAutomationCacheRequest* cacheReq, IUIAutomationElement* root);
+
+    UiaNode Root() override { return m_root; }
+    UiaNode FirstChild(UiaNode node) override;
+    UiaNode NextSibling(UiaNode node) override;
+    UiaNode Parent(UiaNode node) override;
+    bool GetInfo(UiaNode node, UiaNodeInfo& info) override;
+    bool IsSameNode(UiaNode a, UiaNode b) override;
+    void FindEditDescendants(std::vector<UiaNode>& out) override;
+    void ReleaseNode(UiaNode node) override;
+
+private:
+    IUIAutomation* m_uia;
+    IUIAutomationTreeWalker* m_walker;
+    IUIAutomationCacheRequest* m_cacheReq;
+    IUIAutomationElement* m_root;
+};
+
+class UiaValueChangeSink;
 
 class UiaHelper {
 public:
-    UiaHelper();
+    // sharedLocator: 여러 UIA 작업 스레드가 학습한 경로를 공유할 때 지정 (nullptr이면 자체 보유)
+    explicit UiaHelper(AddressBarLocator* sharedLocator = nullptr);
     ~UiaHelper();
 
     bool Initialize();
     void Shutdown();
 
     // 브라우저 유형을 인자로 받도록 수정
-    bool GetAddressBarUrl(HWND hwnd, BrowserType type, std::wstring& urlOut);
+    // editingOut: 주소 표시줄에 키보드 포커스가 있으면 true (사용자가 입력 중)
+    bool GetAddressBarUrl(HWND hwnd, BrowserType type, std::wstring& urlOut, bool* editingOut = nullptr);
+
+    // 소멸된 윈도우의 캐시된 주소 표시줄 요소와 종료된 프로세스의 버전 캐시 해제
+    void PruneDeadWindows();
+
+    // 주소 표시줄 값 변경 알림 수신자 (Initialize 전에 설정, UIA 이벤트 스레드에서 호출됨)
+    // 설정하면 캐시한 주소 표시줄 요소마다 ValueValue 속성 변경 이벤트를 구독 (브라우저가 지원하는 경우)
+    void SetChangeListener(std::function<void(HWND)> listener) { m_listener = listener; }
 
 private:
     IUIAutomation* m_uia;
+    IUIAutomationTreeWalker* m_walker;        // 경로 탐색용 (Initialize에서 한 번 생성)
+    IUIAutomationCacheRequest* m_cacheReq;    // Name, ControlType, IsKeyboardFocusable, AutomationId
+    IUIAutomationCacheRequest* m_stateReq;    // ValueValue, HasKeyboardFocus
     bool m_initialized;
 
-    // HWND → AddressBar 캐시
-    std::unordered_map<HWND, IUIAutomationElement*> m_cachedAddr;
+    // (브라우저 유형, 버전)별 주소 표시줄 경로 학습
+    AddressBarLocator m_ownLocator;
+    AddressBarLocator* m_locator;
+
+    // HWND → AddressBar 캐시 (구독 중이면 알림 수신 객체 포함)
+    struct CachedAddr {
+        IUIAutomationElement* element = nullptr;
+        UiaValueChangeSink* sink = nullptr;
+    };
+    std::unordered_map<HWND, CachedAddr> m_cachedAddr;
+    std::function<void(HWND)> m_listener;
+
+    // PID → 실행 파일 버전 캐시 (요소 캐시 미스마다 버전 리소스를 다시 읽지 않도록)
+    // 프로세스 핸들을 보관하므로 종료 전까지 PID가 재사용되지 않고, 종료가 감지되면 항목 폐기
+    struct CachedVersion {
+        HANDLE process = nullptr;
+        std::wstring version;
+    };
+    std::unordered_map<DWORD, CachedVersion> m_versions;
+
+    std::wstring GetProcessVersion(DWORD pid);
+    void PruneVersions(bool all);
+
+    void Subscribe(HWND hwnd, CachedAddr& cached);
+    void ReleaseCached(CachedAddr& cached);
 
     // 브라우저 유형별 주소 표시줄 요소를 찾는 함수로 변경
     IUIAutomationElement* FindAddressBarElementByBrowser(
-        IUIAutomationElement* root, BrowserType type);
+        IUIAutomationElement* root, BrowserType type, const std::wstring& version);
 
-    // UIA 패턴을 이용해 값 읽는 함수들 (변화 없음)
+    // UIA 패턴을 이용해 값 읽는 함수들
+    bool ReadStateFromElement(IUIAutomationElement* element, std::wstring& valueOut, bool* editingOut);
     bool ReadValueFromElement(IUIAutomationElement* element, std::wstring& valueOut);
     bool ReadTextFromElement(IUIAutomationElement* element, std::wstring& valueOut);
 };
\ No newline at end of file
@@ -0,0 +1,361 @@
+﻿#include "UrlCanonicalizer.h"
+#include <stdint.h>
+#include <string.h>
+#include <wctype.h>
+
+namespace {
+
+    struct DefaultPort {
+        const wchar_t* scheme;
+        const wchar_t* port;
+    };
+    const DefaultPort kDefaultPorts[] = {
+        { L"http", L"80" }, { L"https", L"443" }, { L"ws", L"80" }, { L"wss", L"443" }, { L"ftp", L"21" },
+    };
+
+    const char* const kDefaultStripParams[] = {
+        "utm_*", "fbclid", "gclid", "dclid", "gbraid", "wbraid", "msclkid", "mc_cid", "mc_eid", "yclid", "igshid",
+    };
+
+    inline wchar_t AsciiLower(wchar_t c) {
+        return (c >= L'A' && c <= L'Z') ? (wchar_t)(c + (L'a' - L'A')) : c;
+    }
+
+    inline bool IsAsciiAlnum(unsigned c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    }
+
+    inline bool IsSchemeChar(wchar_t c) {
+        return IsAsciiAlnum(c) || c == L'+' || c == L'-' || c == L'.';
+    }
+
+    // RFC 3986 비예약 문자: 인코딩 여부와 관계없이 같은 의미
+    inline bool IsUnreserved(unsigned c) {
+        return IsAsciiAlnum(c) || c == '-' || c == '.' || c == '_' || c == '~';
+    }
+
+    inline int HexValue(wchar_t c) {
+        if (c >= L'0' && c <= L'9') return c - L'0';
+        if (c >= L'a' && c <= L'f') return c - L'a' + 10;
+        if (c >= L'A' && c <= L'F') return c - L'A' + 10;
+        return -1;
+    }
+
+    inline bool EqualsAscii(const wchar_t* a, size_t len, const wchar_t* b) {
+        size_t i = 0;
+        for (; i < len; i++) {
+            if (b[i] == 0 || a[i] != b[i]) return false;
+        }
+        return b[i] == 0;
+    }
+
+    bool IsDefaultPort(const wchar_t* scheme, size_t schemeLen, const wchar_t* port, size_t portLen) {
+        for (const DefaultPort& d : kDefaultPorts) {
+            if (EqualsAscii(scheme, schemeLen, d.scheme)) return EqualsAscii(port, portLen, d.port);
+        }
+        return false;
+    }
+
+    // 주소 표시줄에 보이는 IDN 구분자(、．｡)도 '.'로 취급
+    inline bool IsLabelSeparator(uint32_t c) {
+        return c == '.' || c == 0x3002 || c == 0xFF0E || c == 0xFF61;
+    }
+
+    // ---- Punycode (RFC 3492) ----
+    const uint32_t kBase = 36, kTMin = 1, kTMax = 26, kSkew = 38, kDamp = 700;
+    const uint32_t kInitialBias = 72, kInitialN = 128;
+
+    inline wchar_t PunyDigit(uint32_t d) {
+        return (wchar_t)(d < 26 ? L'a' + d : L'0' + (d - 26));
+    }
+
+    uint32_t PunyAdapt(uint32_t delta, uint32_t numPoints, bool first) {
+        delta = first ? delta / kDamp : delta / 2;
+        delta += delta / numPoints;
+        uint32_t k = 0;
+        while (delta > ((kBase - kTMin) * kTMax) / 2) {
+            delta /= kBase - kTMin;
+            k += kBase;
+        }
+        return k + (kBase - kTMin + 1) * delta / (delta + kSkew);
+    }
+
+    bool PunycodeEncode(const std::vector<uint32_t>& input, std::wstring& out) {
+        uint32_t n = kInitialN, delta = 0, bias = kInitialBias;
+        uint32_t basic = 0;
+        for (uint32_t c : input) {
+            if (c < 0x80) { out += (wchar_t)c; basic++; }
+        }
+        uint32_t handled = basic;
+        if (basic > 0) out += L'-';
+
+        while (handled < input.size()) {
+            uint32_t m = UINT32_MAX;
+            for (uint32_t c : input) {
+                if (c >= n && c < m) m = c;
+            }
+            if ((uint64_t)(m - n) * (handled + 1) > UINT32_MAX - delta) return false;
+            delta += (m - n) * (handled + 1);
+            n = m;
+
+            for (uint32_t c : input) {
+                if (c < n && ++delta == 0) return false;
+                if (c != n) continue;
+                uint32_t q = delta;
+                for (uint32_t k = kBase;; k += kBase) {
+                    uint32_t t = k <= bias ? kTMin : (k >= bias + kTMax ? kTMax : k - bias);
+                    if (q < t) break;
+                    out += PunyDigit(t + (q - t) % (kBase - t));
+                    q = (q - t) / (kBase - t);
+                }
+                out += PunyDigit(q);
+                bias = PunyAdapt(delta, handled + 1, handled == basic);
+                delta = 0;
+                handled++;
+            }
+            delta++;
+            n++;
+        }
+        return true;
+    }
+
+    // 호스트를 레이블별로 소문자화 후 비ASCII 레이블은 "xn--" + punycode로 변환
+    bool ToAsciiHost(const wchar_t* p, size_t len, std::wstring& out) {
+        thread_local std::vector<uint32_t> label;
+        out.clear();
+        size_t i = 0;
+        while (true) {
+            label.clear();
+            bool ascii = true;
+            while (i < len) {
+                uint32_t c = (uint32_t)p[i++];
+                // UTF-16 서로게이트 쌍 → 코드 포인트 (wchar_t가 32비트면 해당 없음)
+                if (c >= 0xD800 && c <= 0xDBFF && i < len && (uint32_t)p[i] >= 0xDC00 && (uint32_t)p[i] <= 0xDFFF) {
+                    c = 0x10000 + ((c - 0xD800) << 10) + ((uint32_t)p[i++] - 0xDC00);
+                }
+                if (IsLabelSeparator(c)) break;
+                if (c < 0x80) c = AsciiLower((wchar_t)c);
+                else if (c <= 0xFFFF) c = (uint32_t)towlower((wint_t)c);
+                if (c >= 0x80) ascii = false;
+                label.push_back(c);
+            }
+            if (label.empty()) {
+                if (i < len) return false; // 빈 레이블 (a..b)
+            }
+            else if (ascii) {
+                for (uint32_t c : label) out += (wchar_t)c;
+            }
+            else {
+                out += L"xn--";
+                if (!PunycodeEncode(label, out)) return false;
+            }
+            if (i >= len) break;
+            out += L'.';
+        }
+        return !out.empty();
+    }
+
+    // 경로/쿼리의 %xx 정규화. 결과는 항상 입력보다 짧거나 같으므로 제자리 기록, 반환: 새 끝 위치
+    size_t NormalizePercent(wchar_t* s, size_t begin, size_t end) {
+        static const wchar_t kHex[] = L"0123456789ABCDEF";
+        size_t w = begin;
+        for (size_t r = begin; r < end;) {
+            int hi, lo;
+            if (s[r] == L'%' && r + 2 < end && (hi = HexValue(s[r + 1])) >= 0 && (lo = HexValue(s[r + 2])) >= 0) {
+                unsigned v = (unsigned)(hi * 16 + lo);
+                if (IsUnreserved(v)) {
+                    s[w++] = (wchar_t)v;
+                }
+                else {
+                    s[w++] = L'%';
+                    s[w++] = kHex[hi];
+                    s[w++] = kHex[lo];
+                }
+                r += 3;
+            }
+            else {
+                s[w++] = s[r++];
+            }
+        }
+        return w;
+    }
+
+    // RFC 3986 5.2.4 dot-segment 제거 ('/'로 시작하는 경로), 반환: 새 끝 위치
+    size_t RemoveDotSegments(wchar_t* s, size_t begin, size_t end) {
+        size_t w = begin;
+        size_t r = begin;
+        while (r < end) {
+            size_t segEnd = r + 1;
+            while (segEnd < end && s[segEnd] != L'/') segEnd++;
+            size_t segLen = segEnd - r - 1;
+            bool last = segEnd == end;
+
+            if (segLen == 1 && s[r + 1] == L'.') {
+                if (last) s[w++] = L'/';
+            }
+            else if (segLen == 2 && s[r + 1] == L'.' && s[r + 2] == L'.') {
+                // 직전 "/세그먼트" 하나를 출력에서 제거
+                if (w > begin) {
+                    do { w--; } while (w > begin && s[w] != L'/');
+                }
+                if (last) s[w++] = L'/';
+            }
+            else {
+                for (size_t i = r; i < segEnd; i++) s[w++] = s[i];
+            }
+            r = segEnd;
+        }
+        return w;
+    }
+}
+
+CanonicalizeOptions CanonicalizeOptions::Default() {
+    CanonicalizeOptions options;
+    for (const char* name : kDefaultStripParams) {
+        options.stripParams.emplace_back(name, name + strlen(name));
+    }
+    return options;
+}
+
+UrlCanonicalizer::UrlCanonicalizer(const CanonicalizeOptions& options)
+    : m_options(options) {
+}
+
+std::vector<std::wstring> UrlCanonicalizer::ParseParamList(const char* list) {
+    std::vector<std::wstring> names;
+    const char* p = list;
+    while (p && *p) {
+        const char* end = strchr(p, ',');
+        if (!end) end = p + strlen(p);
+        if (end > p) names.emplace_back(p, end);
+        p = *end ? end + 1 : end;
+    }
+    return names;
+}
+
+bool UrlCanonicalizer::IsStrippedParam(const wchar_t* name, size_t len) const {
+    for (const std::wstring& pattern : m_options.stripParams) {
+        size_t n = pattern.size();
+        bool prefix = n > 0 && pattern[n - 1] == L'*';
+        if (prefix) n--;
+        if (prefix ? len < n : len != n) continue;
+
+        size_t i = 0;
+        while (i < n && AsciiLower(name[i]) == AsciiLower(pattern[i])) i++;
+        if (i == n) return true;
+    }
+    return false;
+}
+
+// '?'부터 end까지 파라미터를 걸러 제자리 기록. 남는 파라미터가 없으면 '?'도 제거, 반환: 새 끝 위치
+size_t UrlCanonicalizer::FilterQuery(wchar_t* s, size_t begin, size_t end) const {
+    size_t w = begin + 1;
+    size_t r = begin + 1;
+    while (r < end) {
+        size_t paramEnd = r;
+        size_t nameEnd = end;
+        while (paramEnd < end && s[paramEnd] != L'&') {
+            if (s[paramEnd] == L'=' && nameEnd == end) nameEnd = paramEnd;
+            paramEnd++;
+        }
+        if (nameEnd > paramEnd) nameEnd = paramEnd;
+
+        if (paramEnd > r && !IsStrippedParam(s + r, nameEnd - r)) {
+            if (w > begin + 1) s[w++] = L'&';
+            for (size_t i = r; i < paramEnd; i++) s[w++] = s[i];
+        }
+        r = paramEnd + 1;
+    }
+    return w > begin + 1 ? w : begin;
+}
+
+bool UrlCanonicalizer::Canonicalize(std::wstring& url) const {
+    size_t sep = url.find(L"://");
+    if (sep == std::wstring::npos || sep == 0) return false;
+    for (size_t i = 0; i < sep; i++) {
+        if (!IsSchemeChar(url[i])) return false;
+        url[i] = AsciiLower(url[i]);
+    }
+
+    // 권한(authority) 영역: [userinfo@]host[:port]
+    size_t hostStart = sep + 3;
+    size_t authEnd = url.find_first_of(L"/?#", hostStart);
+    if (authEnd == std::wstring::npos) authEnd = url.size();
+    for (size_t i = authEnd; i > hostStart; i--) {
+        if (url[i - 1] == L'@') { hostStart = i; break; }
+    }
+
+    size_t scanFrom = hostStart;
+    if (hostStart < authEnd && url[hostStart] == L'[') { // IPv6 리터럴
+        scanFrom = url.find(L']', hostStart);
+        if (scanFrom == std::wstring::npos || scanFrom >= authEnd) return false;
+    }
+    size_t hostEnd = url.find(L':', scanFrom);
+    if (hostEnd > authEnd) hostEnd = authEnd;
+    if (hostEnd == hostStart) return false;
+
+    // 1) 포트: 비어 있거나 스킴 기본값이면 제거 (호스트 길이가 바뀌기 전에 처리)
+    if (hostEnd < authEnd) {
+        const wchar_t* port = url.data() + hostEnd + 1;
+        size_t portLen = authEnd - hostEnd - 1;
+        while (portLen > 1 && *port == L'0') { port++; portLen--; }
+        if (portLen == 0 || IsDefaultPort(url.data(), sep, port, portLen)) {
+            url.erase(hostEnd, authEnd - hostEnd);
+            authEnd = hostEnd;
+        }
+    }
+
+    // 2) 호스트: ASCII는 제자리 소문자화, 비ASCII가 있으면 punycode로 교체
+    bool ascii = true;
+    for (size_t i = hostStart; i < hostEnd; i++) {
+        if ((uint32_t)url[i] >= 0x80) ascii = false;
+        else url[i] = AsciiLower(url[i]);
+    }
+    if (!ascii) {
+        thread_local std::wstring host;
+        if (!ToAsciiHost(url.data() + hostStart, hostEnd - hostStart, host)) return false;
+        url.replace(hostStart, hostEnd - hostStart, host);
+        authEnd = authEnd - (hostEnd - hostStart) + host.size();
+        hostEnd = hostStart + host.size();
+    }
+    if (hostEnd - hostStart > 1 && url[hostEnd - 1] == L'.') {
+        url.erase(hostEnd - 1, 1);
+        hostEnd--;
+        authEnd--;
+    }
+
+    // 3) 프래그먼트
+    size_t tailEnd = url.find(L'#', authEnd);
+    if (tailEnd == std::wstring::npos) tailEnd = url.size();
+    else if (m_options.dropFragment) url.resize(tailEnd);
+
+    // 4) 경로/쿼리의 퍼센트 인코딩
+    size_t w = NormalizePercent(&url[0], authEnd, tailEnd);
+    url.erase(w, tailEnd - w);
+    tailEnd = w;
+
+    // 5) 경로: dot-segment, 빈 경로, 끝 '/'
+    size_t query = url.find(L'?', authEnd);
+    if (query > tailEnd) query = tailEnd;
+    w = RemoveDotSegments(&url[0], authEnd, query);
+    url.erase(w, query - w);
+    tailEnd -= query - w;
+    query = w;
+    if (query == authEnd) {
+        url.insert(authEnd, 1, L'/');
+        query++;
+        tailEnd++;
+    }
+    else if (m_options.stripTrailingSlash && query - authEnd > 1 && url[query - 1] == L'/') {
+        url.erase(query - 1, 1);
+        query--;
+        tailEnd--;
+    }
+
+    // 6) 쿼리 파라미터
+    if (query < tailEnd) {
+        w = FilterQuery(&url[0], query, tailEnd);
+        url.erase(w, tailEnd - w);
+    }
+    return true;
+}
@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+
+// 정규화 옵션 (모니터 시작 전에 설정)
+struct CanonicalizeOptions {
+    std::vector<std::wstring> stripParams; // 제거할 쿼리 파라미터 이름 (대소문자 무시, '*'로 끝나면 접두어 일치)
+    bool dropFragment = true;              // '#' 이후 제거
+    bool stripTrailingSlash = true;        // 루트가 아닌 경로의 끝 '/' 제거
+
+    // utm_*, fbclid, gclid 등 추적용 파라미터를 제거하는 기본값
+    static CanonicalizeOptions Default();
+};
+
+// 확정된 URL을 저장/IPC 전에 같은 자원이면 같은 문자열이 되도록 정규화
+// - 스킴/호스트 소문자, 비ASCII(IDN) 호스트 → punycode(xn--), 호스트 끝 '.' 제거
+// - 스킴 기본 포트(:80, :443 ...) 제거
+// - 비예약 문자의 %xx 해제, 나머지 %xx는 대문자 16진으로 통일
+// - 경로 dot-segment(., ..) 해석, 빈 경로는 "/"
+// - 옵션에 따라 프래그먼트, 끝 '/', 추적용 쿼리 파라미터 제거
+// 입력 문자열을 제자리에서 고치므로 호출 측 버퍼를 재사용하면 할당이 없음 (IDN 호스트 제외)
+// windows.h 비의존 (LoadGen 코퍼스 벤치마크에서 그대로 사용), 여러 스레드에서 동시 호출 가능
+class UrlCanonicalizer {
+public:
+    explicit UrlCanonicalizer(const CanonicalizeOptions& options = CanonicalizeOptions::Default());
+
+    // url을 제자리에서 정규화. "스킴://호스트" 형태가 아니면 false
+    bool Canonicalize(std::wstring& url) const;
+
+    // "utm_*,fbclid,gclid" 형식의 목록 파싱 (명령줄 옵션용)
+    static std::vector<std::wstring> ParseParamList(const char* list);
+
+private:
+    CanonicalizeOptions m_options;
+
+    bool IsStrippedParam(const wchar_t* name, size_t len) const;
+    size_t FilterQuery(wchar_t* s, size_t begin, size_t end) const;
+};
@@ -0,0 +1,66 @@
+﻿#include "UrlDebouncer.h"
+
+UrlDebouncer::UrlDebouncer(IClock* clock, uint32_t quietMs)
+    : m_clock(clock ? clock : SteadyClock::Instance())
+    , m_quietMs(quietMs)
+    , m_state(State::Idle)
+    , m_since(0)
+{
+}
+
+void UrlDebouncer::Reset() {
+    m_state = State::Idle;
+    m_candidate.clear();
+    m_confirmedRaw.clear();
+    m_since = 0;
+}
+
+bool UrlDebouncer::Feed(const std::wstring& raw, bool editing, std::wstring& confirmedOut) {
+    uint64_t now = m_clock->NowMs();
+
+    // 입력 중인 값은 미완성 URL이므로 후보로도 취급하지 않음
+    if (editing) {
+        m_state = State::Typing;
+        m_candidate.clear();
+        return false;
+    }
+
+    if (raw.empty()) {
+        m_state = State::Idle;
+        m_candidate.clear();
+        return false;
+    }
+
+    // 이미 확정한 값으로 돌아온 경우 (편집 취소 등) 다시 내보내지 않음
+    if (raw == m_confirmedRaw) {
+        m_state = State::Confirmed;
+        m_candidate.clear();
+        return false;
+    }
+
+    // 새 후보: 안정 구간 시작
+    if (m_state != State::Pending || raw != m_candidate) {
+        m_state = State::Pending;
+        m_candidate = raw;
+        m_since = now;
+        if (m_quietMs != 0) return false;
+    }
+
+    if (now - m_since < m_quietMs) return false;
+
+    // 안정 구간 경과 -> 확정
+    m_state = State::Confirmed;
+    m_confirmedRaw = m_candidate;
+    m_candidate.clear();
+    confirmedOut = m_confirmedRaw;
+    return true;
+}
+
+bool UrlDebouncer::TimeUntilConfirm(uint32_t& msOut) {
+    if (m_state != State::Pending) return false;
+
+    uint64_t now = m_clock->NowMs();
+    uint64_t elapsed = now - m_since;
+    msOut = elapsed >= m_quietMs ? 0 : (uint32_t)(m_quietMs - elapsed);
+    return true;
+}
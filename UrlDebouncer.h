@@ -0,0 +1,37 @@
+﻿#pragma once
+#include <stdint.h>
+#include <string>
+#include "Clock.h"
+
+// 윈도우별 주소 표시줄 값 확정기 (샘플 횟수가 아닌 시간 기준)
+// - 값이 quietMs 동안 바뀌지 않으면 한 번 확정
+// - 주소 표시줄에 포커스가 있는 동안(사용자 입력 중)은 Typing 상태로 절대 확정하지 않음
+class UrlDebouncer {
+public:
+    enum class State {
+        Idle,      // 후보 없음
+        Pending,   // 후보가 안정되기를 기다리는 중
+        Typing,    // 사용자가 주소 표시줄 편집 중
+        Confirmed  // 현재 값 확정 완료 (같은 값은 다시 확정하지 않음)
+    };
+
+    explicit UrlDebouncer(IClock* clock = nullptr, uint32_t quietMs = 150);
+
+    // 샘플 입력: 이번 샘플로 확정되면 true와 확정된 원본 값 반환
+    bool Feed(const std::wstring& raw, bool editing, std::wstring& confirmedOut);
+
+    // 대기 중인 후보가 확정 가능해질 때까지 남은 시간 (대기 중이 아니면 false)
+    bool TimeUntilConfirm(uint32_t& msOut);
+
+    State GetState() const { return m_state; }
+    void SetQuietPeriod(uint32_t quietMs) { m_quietMs = quietMs; }
+    void Reset();
+
+private:
+    IClock* m_clock;
+    uint32_t m_quietMs;
+    State m_state;
+    std::wstring m_candidate;
+    uint64_t m_since;             // 후보가 처음 관측된 시각
+    std::wstring m_confirmedRaw;  // 마지막으로 확정한 값
+};
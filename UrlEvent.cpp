@@ -0,0 +1,110 @@
+﻿#include "UrlEvent.h"
+#include "TextCodec.h"
+#include <string.h>
+
+// NUL 뒤에 붙을 수 있는 트레일러 최대 크기
+static const size_t kTrailerSpace = sizeof(IPC_URL_CHURN_TRAILER) + sizeof(IPC_TRACE_TRAILER);
+
+void UrlEvent::Assign(HWND hwnd, const std::wstring& browser, const std::wstring& url,
+    const std::wstring& rawUrl, const std::wstring& title)
+{
+    m_hwnd = hwnd;
+    m_changes = 1;
+    m_traceId = 0;
+
+    size_t textCap = Utf8CapacityFor(browser.size() + url.size() + title.size()) + 3; // 구분자 2개 + NUL
+    size_t need = sizeof(IPC_MSG_HEADER) + textCap + kTrailerSpace + Utf8CapacityFor(rawUrl.size());
+    if (m_buf.size() < need) m_buf.resize(need);
+
+    char* base = m_buf.data();
+    size_t pos = sizeof(IPC_MSG_HEADER);
+    size_t end = pos + textCap;
+
+    m_browserLen = (uint32_t)TranscodeUtf16ToUtf8(browser.data(), browser.size(), base + pos, end - pos);
+    pos += m_browserLen;
+    base[pos++] = '|';
+    m_urlOff = (uint32_t)pos;
+    m_urlLen = (uint32_t)TranscodeUtf16ToUtf8(url.data(), url.size(), base + pos, end - pos);
+    pos += m_urlLen;
+    base[pos++] = '|';
+    m_titleOff = (uint32_t)pos;
+    m_titleLen = (uint32_t)TranscodeUtf16ToUtf8(title.data(), title.size(), base + pos, end - pos);
+    pos += m_titleLen;
+    base[pos++] = '\0';
+    m_textEnd = (uint32_t)pos;
+
+    // raw URL은 트레일러 자리 뒤 (IPC로는 보내지 않음)
+    m_rawOff = (uint32_t)(end + kTrailerSpace);
+    m_rawLen = (uint32_t)TranscodeUtf16ToUtf8(rawUrl.data(), rawUrl.size(), base + m_rawOff, m_buf.size() - m_rawOff);
+}
+
+PIPC_MSG_HEADER UrlEvent::FinishIpc(DWORD type, uint64_t traceId, DWORD& totalSize) {
+    char* base = m_buf.data();
+    size_t n = m_textEnd;
+
+    // 병합된 이벤트면 변경 수 트레일러 (추적 트레일러보다 앞)
+    if (m_changes > 1) {
+        IPC_URL_CHURN_TRAILER churn = { m_changes, IPC_URL_CHURN_TRAILER_MAGIC };
+        memcpy(base + n, &churn, sizeof(churn));
+        n += sizeof(churn);
+    }
+    // 추적 중이면 상관 ID 트레일러 (수신 측 구간과 연결)
+    if (traceId) {
+        IPC_TRACE_TRAILER trailer = { traceId, IPC_TRACE_TRAILER_MAGIC };
+        memcpy(base + n, &trailer, sizeof(trailer));
+        n += sizeof(trailer);
+    }
+
+    PIPC_MSG_HEADER hdr = (PIPC_MSG_HEADER)base;
+    hdr->nType = type;
+    hdr->dwSize = (DWORD)(n - sizeof(IPC_MSG_HEADER));
+    totalSize = (DWORD)n;
+    return hdr;
+}
+
+void UrlEventDeleter::operator()(UrlEvent* ev) const {
+    UrlEventPool::Instance().Release(ev);
+}
+
+UrlEventPool& UrlEventPool::Instance() {
+    static UrlEventPool pool;
+    return pool;
+}
+
+UrlEventPool::UrlEventPool() : m_created(0) {
+    m_free.reserve(kMaxPooled); // 반납 시 목록 재할당 없음
+}
+
+UrlEventPool::~UrlEventPool() {
+    for (UrlEvent* ev : m_free) delete ev;
+}
+
+UrlEventPtr UrlEventPool::Acquire() {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_free.empty()) {
+            UrlEvent* ev = m_free.back();
+            m_free.pop_back();
+            return UrlEventPtr(ev);
+        }
+        m_created++;
+    }
+    return UrlEventPtr(new UrlEvent());
+}
+
+void UrlEventPool::Release(UrlEvent* ev) {
+    if (!ev) return;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_free.size() < kMaxPooled) {
+            m_free.push_back(ev);
+            return;
+        }
+    }
+    delete ev;
+}
+
+size_t UrlEventPool::Pooled() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_free.size();
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "IpcProtocol.h"
+
+// 확정된 URL 이벤트 하나 (UrlEventPool에서 빌려 쓰고 반납)
+// 필드는 UTF-8로 한 번만 변환해 IPC 메시지 모양 그대로 한 버퍼에 저장:
+//   [IPC_MSG_HEADER][browser '|' url '|' title '\0'][트레일러 자리][raw URL]
+// DB 바인딩(SQLITE_STATIC), IPC 송신, 폭주 병합 보류가 모두 이 버퍼를 가리키므로 추가 복사/할당 없음
+// 버퍼는 반납 후에도 용량을 유지 (더 긴 URL이 올 때만 커짐)
+class UrlEvent {
+public:
+    UrlEvent() : m_hwnd(nullptr), m_changes(1), m_traceId(0), m_urlOff(0), m_urlLen(0), m_titleOff(0), m_titleLen(0),
+        m_browserLen(0), m_textEnd(0), m_rawOff(0), m_rawLen(0) {}
+
+    // url: 정규 URL, rawUrl: 다를 때만 전달하는 원본 (비어 있으면 raw 없음)
+    void Assign(HWND hwnd, const std::wstring& browser, const std::wstring& url,
+        const std::wstring& rawUrl, const std::wstring& title);
+
+    HWND Hwnd() const { return m_hwnd; }
+    uint32_t Changes() const { return m_changes; }
+    void SetChanges(uint32_t changes) { m_changes = changes; }
+    // 확정한 폴링의 상관 ID (저장/전송 단계는 다른 스레드이므로 이벤트에 실어 보냄)
+    uint64_t TraceId() const { return m_traceId; }
+    void SetTraceId(uint64_t traceId) { m_traceId = traceId; }
+
+    const char* Browser() const { return m_buf.data() + sizeof(IPC_MSG_HEADER); }
+    uint32_t BrowserLen() const { return m_browserLen; }
+    const char* Url() const { return m_buf.data() + m_urlOff; }
+    uint32_t UrlLen() const { return m_urlLen; }
+    const char* Title() const { return m_buf.data() + m_titleOff; }
+    uint32_t TitleLen() const { return m_titleLen; }
+    const char* RawUrl() const { return m_buf.data() + m_rawOff; }
+    uint32_t RawUrlLen() const { return m_rawLen; }
+
+    // IMT_URL_EVENT 메시지 완성: NUL 뒤에 병합/추적 트레일러를 쓰고 헤더 설정, 반환: 헤더 (totalSize = 전체 크기)
+    PIPC_MSG_HEADER FinishIpc(DWORD type, uint64_t traceId, DWORD& totalSize);
+
+private:
+    HWND m_hwnd;
+    uint32_t m_changes;
+    uint64_t m_traceId;
+    std::vector<char> m_buf;
+    uint32_t m_urlOff, m_urlLen;
+    uint32_t m_titleOff, m_titleLen;
+    uint32_t m_browserLen;
+    uint32_t m_textEnd;   // NUL 다음 위치 (트레일러 시작)
+    uint32_t m_rawOff, m_rawLen;
+};
+
+struct UrlEventDeleter {
+    void operator()(UrlEvent* ev) const;
+};
+typedef std::unique_ptr<UrlEvent, UrlEventDeleter> UrlEventPtr;
+
+// UrlEvent 재사용 풀: 반납된 객체(버퍼 용량 포함)를 다음 이벤트에 그대로 사용
+// 이벤트는 작업 스레드에서 만들어져 스케줄러 스레드(병합 배출)에서 반납될 수 있으므로 스레드별이 아닌 공용 목록
+class UrlEventPool {
+public:
+    static UrlEventPool& Instance();
+
+    UrlEventPtr Acquire();
+    void Release(UrlEvent* ev);
+
+    size_t Created() const { return m_created; }
+    size_t Pooled();
+
+private:
+    static const size_t kMaxPooled = 256; // 초과 반납분은 해제 (폭주 후 메모리 회수)
+
+    UrlEventPool();
+    ~UrlEventPool();
+
+    std::mutex m_lock;
+    std::vector<UrlEvent*> m_free;
+    size_t m_created;
+};
@@ -0,0 +1,199 @@
+﻿#include "UrlLogIngest.h"
+#include "Database.h"
+#include "IpcProtocol.h"
+#include "MessageRouter.h"
+#include "AsyncLogger.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+namespace {
+    const double kRateReportSec = 10.0;
+}
+
+UrlLogIngest::UrlLogIngest(Database* database, uint32_t windowMs, size_t maxPendingRows)
+    : m_database(database), m_windowMs(windowMs), m_maxPendingRows(maxPendingRows),
+      m_flushRequested(false), m_running(false), m_records(0), m_rejected(0), m_rowsWritten(0),
+      m_rateSince(std::chrono::steady_clock::now()), m_rateRecords(0) {
+}
+
+UrlLogIngest::~UrlLogIngest() {
+    Stop();
+}
+
+void UrlLogIngest::Start() {
+    bool expected = false;
+    if (!m_running.compare_exchange_strong(expected, true)) return;
+    m_thread = std::thread(&UrlLogIngest::FlushThread, this);
+}
+
+void UrlLogIngest::Stop() {
+    if (!m_running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+
+    AGENT_LOG_INFO("[UrlLog] Stopped (records=%llu, rows=%llu, rejected=%llu)",
+        m_records.load(), m_rowsWritten.load(), m_rejected.load());
+}
+
+void UrlLogIngest::RegisterHandlers(MessageRouter& router) {
+    // 집계 맵이 하나이므로 직렬 처리. 넘치면 오래된 묶음부터 버림
+    RouteOptions options;
+    options.ordering = HandlerOrdering::Serial;
+    options.capacity = 256;
+    options.overflow = QueueOverflowPolicy::DropOldest;
+    options.binaryPayload = true;
+    router.Register(IMT_URL_LOG_BATCH, "UrlLogBatch", [this](const IpcMessage& msg) {
+        OnBatch(msg.payload.data(), msg.payload.size());
+    }, options);
+}
+
+// 묶음 전체를 먼저 검증한 뒤 집계 (일부만 반영되는 일이 없도록)
+bool UrlLogIngest::OnBatch(const char* data, size_t size) {
+    if (size < sizeof(URL_LOG_BATCH_HEADER)) {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    URL_LOG_BATCH_HEADER hdr;
+    memcpy(&hdr, data, sizeof(hdr));
+    const char* end = data + size;
+    const char* p = data + sizeof(hdr);
+
+    if (hdr.wVersion != URL_LOG_BATCH_VERSION || hdr.wCount == 0 || hdr.wCount > URL_LOG_BATCH_MAX_RECORDS ||
+        (size_t)(end - p) < hdr.wProcNameLen) {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        AGENT_LOG_WARN("[UrlLog] Rejected batch header (version=%u, count=%u, size=%zu)",
+            (unsigned)hdr.wVersion, (unsigned)hdr.wCount, size);
+        return false;
+    }
+    const char* procName = p;
+    p += hdr.wProcNameLen;
+
+    const char* records = p;
+    for (unsigned i = 0; i < hdr.wCount; i++) {
+        URL_LOG_RECORD rec;
+        if ((size_t)(end - p) < sizeof(rec)) break;
+        memcpy(&rec, p, sizeof(rec));
+        size_t body = (size_t)rec.bMethodLen + rec.bSchemeLen + rec.wHostLen + rec.wPathLen + rec.wFullUrlLen;
+        p += sizeof(rec);
+        if ((size_t)(end - p) < body) {
+            p = end + 1; // 잘린 레코드
+            break;
+        }
+        p += body;
+    }
+    if (p != end) {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        AGENT_LOG_WARN("[UrlLog] Rejected malformed batch from pid %lu", (unsigned long)hdr.dwPid);
+        return false;
+    }
+
+    bool flushNow = false;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        const std::string* proc = m_interner.Intern(procName, hdr.wProcNameLen);
+
+        p = records;
+        for (unsigned i = 0; i < hdr.wCount; i++) {
+            URL_LOG_RECORD rec;
+            memcpy(&rec, p, sizeof(rec));
+            p += sizeof(rec);
+            const char* method = p;  p += rec.bMethodLen;
+            const char* scheme = p;  p += rec.bSchemeLen;
+            const char* host = p;    p += rec.wHostLen;
+            const char* path = p;    p += rec.wPathLen;
+            const char* fullUrl = p; p += rec.wFullUrlLen;
+
+            Key key{ (int)hdr.dwPid, m_interner.Intern(host, rec.wHostLen), m_interner.Intern(path, rec.wPathLen) };
+            auto it = m_pending.find(key);
+            if (it != m_pending.end()) {
+                it->second.hits++;
+                continue;
+            }
+            Aggregate agg;
+            agg.procName = proc;
+            agg.method = m_interner.Intern(method, rec.bMethodLen);
+            agg.scheme = m_interner.Intern(scheme, rec.bSchemeLen);
+            agg.fullUrl = m_interner.Intern(fullUrl, rec.wFullUrlLen);
+            agg.port = rec.wPort;
+            agg.hits = 1;
+            m_pending.emplace(key, agg);
+        }
+
+        if (m_pending.size() >= m_maxPendingRows && !m_flushRequested) {
+            m_flushRequested = true;
+            flushNow = true;
+        }
+    }
+    m_records.fetch_add(hdr.wCount, std::memory_order_relaxed);
+
+    if (flushNow) m_cv.notify_one();
+    return true;
+}
+
+void UrlLogIngest::FlushThread() {
+    while (m_running.load()) {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_cv.wait_for(lock, std::chrono::milliseconds(m_windowMs), [this]() {
+                return m_flushRequested || !m_running.load();
+                });
+        }
+        Flush();
+    }
+    Flush(); // 종료 시 남은 집계 저장
+}
+
+// 현재 구간의 집계와 인터너를 통째로 떼어내 잠금 밖에서 저장 (수신 경로를 막지 않음)
+void UrlLogIngest::Flush() {
+    AggregateMap pending;
+    StringInterner interner;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_flushRequested = false;
+        if (m_pending.empty()) return;
+        pending.swap(m_pending);
+        std::swap(interner, m_interner);
+    }
+
+    thread_local std::vector<UrlLogRow> rows;
+    rows.clear();
+    rows.reserve(pending.size());
+    for (const auto& kv : pending) {
+        const Aggregate& a = kv.second;
+        UrlLogRow row;
+        row.procName = a.procName->data(); row.nProc = (uint32_t)a.procName->size();
+        row.pid = kv.first.pid;
+        row.method = a.method->data();     row.nMethod = (uint32_t)a.method->size();
+        row.scheme = a.scheme->data();     row.nScheme = (uint32_t)a.scheme->size();
+        row.host = kv.first.host->data();  row.nHost = (uint32_t)kv.first.host->size();
+        row.port = a.port;
+        row.path = kv.first.path->data();  row.nPath = (uint32_t)kv.first.path->size();
+        row.fullUrl = a.fullUrl->data();   row.nFullUrl = (uint32_t)a.fullUrl->size();
+        row.hitCount = a.hits;
+        rows.push_back(row);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = m_database && m_database->SaveUrlLogBatch(rows);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (ok) m_rowsWritten.fetch_add(rows.size(), std::memory_order_relaxed);
+    else AGENT_LOG_ERROR("[UrlLog] Failed to save %zu rows", rows.size());
+
+    // 수집률 보고 (부하 테스트 시 에이전트 측 처리량 확인용)
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_rateSince).count();
+    if (elapsed >= kRateReportSec) {
+        unsigned long long records = m_records.load();
+        AGENT_LOG_INFO("[UrlLog] %.0f records/s, last flush %zu rows in %.1f ms",
+            (records - m_rateRecords) / elapsed, rows.size(), ms);
+        m_rateSince = now;
+        m_rateRecords = records;
+    }
+}
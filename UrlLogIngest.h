@@ -0,0 +1,81 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "StringInterner.h"
+
+class Database;
+class MessageRouter;
+
+// 후킹된 프로세스가 보내는 HTTP 요청 기록(IMT_URL_LOG_BATCH) 수집기
+// - 바이너리 묶음 검증 → 문자열 인터닝 → (pid, host, path) 단위로 구간 내 집계
+// - 구간이 끝나거나 대기 행이 많아지면 한 트랜잭션으로 UrlLogs에 일괄 저장
+class UrlLogIngest {
+public:
+    UrlLogIngest(Database* database, uint32_t windowMs = 1000, size_t maxPendingRows = 50000);
+    ~UrlLogIngest();
+
+    void Start();
+    void Stop(); // 남은 집계를 저장 후 종료
+
+    void RegisterHandlers(MessageRouter& router);
+
+    // 묶음 하나 처리. false: 형식 오류로 전체 거부
+    bool OnBatch(const char* data, size_t size);
+
+    unsigned long long Records() const { return m_records.load(); }
+    unsigned long long Rejected() const { return m_rejected.load(); }
+    unsigned long long RowsWritten() const { return m_rowsWritten.load(); }
+
+private:
+    struct Key {
+        int pid;
+        const std::string* host; // 인턴된 문자열 주소
+        const std::string* path;
+        bool operator==(const Key& o) const { return pid == o.pid && host == o.host && path == o.path; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            size_t h = std::hash<const void*>()(k.host);
+            h ^= std::hash<const void*>()(k.path) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h ^ (size_t)k.pid;
+        }
+    };
+    struct Aggregate {
+        const std::string* procName;
+        const std::string* method;
+        const std::string* scheme;
+        const std::string* fullUrl; // 구간 내 첫 요청의 전체 URL
+        int port;
+        int hits;
+    };
+    typedef std::unordered_map<Key, Aggregate, KeyHash> AggregateMap;
+
+    Database* m_database;
+    const uint32_t m_windowMs;
+    const size_t m_maxPendingRows;
+
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    StringInterner m_interner;  // 현재 구간 전용, 저장 후 통째로 교체
+    AggregateMap m_pending;
+    bool m_flushRequested;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+
+    std::atomic<unsigned long long> m_records;
+    std::atomic<unsigned long long> m_rejected;
+    std::atomic<unsigned long long> m_rowsWritten;
+
+    std::chrono::steady_clock::time_point m_rateSince; // 저장 스레드 전용
+    unsigned long long m_rateRecords;
+
+    void FlushThread();
+    void Flush();
+};
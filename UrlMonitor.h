@@ -3,29 +3,147 @@
 #include <string>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <unordered_map>
 #include "UiaHelper.h"
 #include "Database.h"
+#include "WindowRegistry.h"
+#include "PollScheduler.h"
+#include "AdaptivePollInterval.h"
+#include "UrlDebouncer.h"
+#include "VisitAggregator.h"
+#include "UrlCanonicalizer.h"
+#include "ChurnCoalescer.h"
+#include "ChangeGate.h"
+#include "ChangeNotifyQueue.h"
+#include "Watchdog.h"
+#include "PipelineStage.h"
+#include "AgentCheckpoint.h"
+#include "UrlEvent.h"
 
 class UrlMonitor {
 public:
-    UrlMonitor(Database* db);
+    // multiWindow: true ׶ ƴ϶   츦 ÿ 
+    UrlMonitor(Database* db, bool multiWindow = false);
     ~UrlMonitor();
 
     bool Start();
     void Stop();
 
+    // URL Ȯ ʿ   (  ð  ٲ  Ȯ)
+    void SetQuietPeriod(uint32_t quietMs);
+
+    //  : 湮 /   Ȯ URL    (Start  ȣ)
+    void SetForensicMode(bool enable) { m_forensic = enable; m_churn.SetEnabled(!enable); }
+
+    // URL ȭ Ģ ( Ķ   , Start  ȣ)
+    void SetCanonicalizeOptions(const CanonicalizeOptions& options) { m_canonicalizer = UrlCanonicalizer(options); }
+
+    // SPA ּ    Ģ (Start  ȣ,  忡  )
+    void SetChurnOptions(const ChurnOptions& options) { m_churn.SetOptions(options); }
+
+    // UIA б  ȭ   (Start  ȣ). verifyMs: ȭ   ׶ 츦 ٽ д ֱ
+    void SetChangeGate(bool enable, uint32_t verifyMs);
+
+    //    (캰  URL, 湮 , ּ ǥ )
+    // Save Stop , Restore Start  ȣ. ̹   ׸ 
+    void SaveCheckpoint(AgentCheckpoint& cp);
+    void RestoreCheckpoint(const AgentCheckpoint& cp);
+
 private:
+    //   忡 캰  
+    struct WindowWatch {
+        BrowserWindowInfo info;
+        UrlDebouncer debouncer;
+        std::wstring lastUrl;  // 캰 ߺ  
+        TimerId timer = 0;     //  ø Ÿ̸
+        bool busy = false;     // ۾ 尡 ó 
+        bool foreground = false;
+    };
+    typedef std::shared_ptr<WindowWatch> WatchPtr;
+
+    enum class PollResult {
+        NotBrowser, // ׶尡  ƴ ->  ߴ
+        Idle,       // ȭ  -> 
+        Activity    // ּ ǥ  ȭ/URL Ȯ ->  
+    };
+
     Database* m_database;
     UiaHelper m_uia;
+    WindowRegistry m_registry;
+    AddressBarLocator m_locator; // ۾     ĳ
 
     std::thread m_thread;
     std::atomic<bool> m_running;
+    bool m_multiWindow;
 
     // ߺ  
     HWND m_lastHwnd;
     std::wstring m_lastUrl;
     std::wstring m_lastBrowser;
+    std::unordered_map<HWND, UrlDebouncer> m_debouncers; // 캰 URL Ȯ
+    std::wstring m_lastRaw;
+    std::unordered_map<HWND, std::wstring> m_restoredUrls; // üũƮ  URL (츦 ó   ߺ  )
+    uint32_t m_quietMs;
+    VisitAggregator m_visits; //  ȯ  湮    ó
+    bool m_forensic;
+    UrlCanonicalizer m_canonicalizer; // Ȯ URL  /IPC  URL
+    ChurnCoalescer m_churn;           // ȣƮ/κ    ̺Ʈ 
+    ChangeGate m_gate;                // ٲ   UIA б 
+    HWND m_gateHwnd;                  //   :   ģ  (ȯ   б)
+    ChangeNotifyQueue m_notified;     //   ˸ ޾  б⸦ մ   (˸   Post  )
+
+    // Ȯ  ܰ: (ٷ/UIA ۾ )  (DB, 湮 )  (IPC)
+    //  ܰ   뷮  ä Ƿ DB/IPC     
+    PipelineStage<UrlEventPtr> m_storeStage;
+    PipelineStage<UrlEventPtr> m_notifyStage;
+
+    //   (  = ٷ )
+    PollScheduler m_scheduler;
+    AdaptivePollInterval m_interval;
+    TimerId m_pollTimer;
+    DWORD m_lastInputTick;
+    std::atomic<unsigned long> m_polls;
+    std::atomic<unsigned long> m_uiaReads;
+    std::atomic<unsigned long> m_suspends;
+
+    //   :  (ٷ  ) UIA ۾  Ǯ
+    std::unordered_map<HWND, WatchPtr> m_watches;
+    std::mutex m_watchLock; // ۾ ť ȣ
+    std::condition_variable m_jobCv;
+    std::deque<WatchPtr> m_fgJobs; // ׶ 켱 ó
+    std::deque<WatchPtr> m_bgJobs;
+    std::vector<std::thread> m_workers;        // ü() 嵵 Stop join  
+    std::vector<uint32_t> m_workerGen;         // (index)  , ٸ ü  (m_watchLock)
+    std::atomic<unsigned> m_retiredWorkers;    // üǾ  UIA ȣ⿡ ƿ   
+    std::atomic<unsigned long> m_workerRestarts;
+    std::atomic<bool> m_uiaResetRequested;     //   :   UIA  
 
     void MonitorThread();
-    void OnUrlChanged(const std::wstring& browser, const std::wstring& url, const std::wstring& title);
-};
\ No newline at end of file
+    void SchedulePoll(uint32_t delayMs);
+    void OnPollTimer();
+    PollResult PollForeground(uint32_t& confirmInMs);
+    void DumpMetrics();
+    void OnAddressBarChanged(HWND hwnd);
+    void PullForwardNotified();
+
+    void MultiWindowThread();
+    void RefreshWindows();
+    void RestoreLastUrl(WindowWatch& watch);
+    void OnForegroundWindow(HWND hwnd);
+    void ScheduleWatch(const WatchPtr& watch, uint32_t delayMs);
+    void UiaWorkerThread(int index, uint32_t generation);
+    void ReplaceWorker(int index, const StallInfo& stall);
+    void ObserveWindow(WindowWatch& watch, UiaHelper& uia, uint32_t& confirmInMs);
+    bool NormalizeUrl(const std::wstring& raw, std::wstring& confirmed, std::wstring& canonical) const;
+    void SubmitUrl(HWND hwnd, const std::wstring& browser, const std::wstring& url, const std::wstring& rawUrl);
+    void FlushChurn();
+    void DispatchUrl(UrlEventPtr ev);
+    void StoreUrl(UrlEventPtr& ev);
+    void NotifyUrl(UrlEventPtr& ev);
+    static void DumpStage(const char* name, const StageMetrics& m);
+};
@@ -1,35 +1,41 @@
 ﻿#include "UrlMonitor.h"
 #include "BrowserHelper.h"
-#include "CommonUtils.h" // Utf16ToUtf8 사용
+#include "AsyncLogger.h"
+#include "Tracer.h"
 #include <regex>
 #include <stdio.h>
+#include <string.h>
 #include <string>
+#include "IpcProtocol.h"
 #include "madCHook.h" // SendIpcMessage 사용
 
-// IPC 정의 (IpcServer.cpp와 동일하게 정의)
-#define IPC_NAME_URL "BrowserUrlEvent"
-#define IMT_URL_EVENT 0x9001
-
-#pragma pack(push,1)
-typedef struct _IPC_URL_MSG_HEADER {
-    DWORD nType; DWORD dwSize;
-} IPC_URL_MSG_HEADER, * PIPC_URL_MSG_HEADER;
-#pragma pack(pop)
-
-static std::wstring g_candidate; //URL 의심 후보
-static int g_count = 0; //연속 확인 횟수
-static DWORD g_firstTick = 0; //URL 후보 처음 나타난 시점 (URL이 너무 빨리 바뀌는 경우 방지용)
+// 다중 윈도우 모드 주기
+static const uint32_t kForegroundIntervalMs = 200;  // 포그라운드 윈도우 샘플링 주기
+static const uint32_t kBackgroundIntervalMs = 2000; // 백그라운드 윈도우 샘플링 주기
+static const uint32_t kRegistryRefreshMs = 1000;    // 최상위 윈도우 재열거 주기
+static const ULONGLONG kUiaPruneMs = 5000;          // 소멸된 윈도우 캐시 정리 주기
+static const unsigned kMaxUiaWorkers = 4;
+
+static const uint32_t kMetricsIntervalMs = 60000;   // 모니터 지표 출력 주기
+static const uint32_t kPruneIntervalMs = 30000;     // 소멸된 윈도우 확정 상태 정리 주기
+static const uint32_t kDefaultQuietMs = 150;        // URL 확정 안정 구간 기본값
+static const uint32_t kChurnFlushMs = 1000;         // 병합된 URL 이벤트 배출 확인 주기
+static const uint32_t kUiaReadBudgetMs = 5000;      // 주소 표시줄 읽기(교차 프로세스 COM) 정지 판정 기준
+static const unsigned kMaxRetiredWorkers = 4;       // 멈춘 채 교체된 작업 스레드 상한 (넘으면 교체 중단)
+static const uint32_t kGateVerifyMs = 2000;         // 변화 감지 관문: 포그라운드 윈도우 검증 읽기 주기
+static const uint32_t kGateVerifyBackgroundMs = 10000; // 백그라운드 윈도우 검증 읽기 주기
+static const size_t kStoreChannelCapacity = 256;    // 저장 대기 이벤트 상한 (가득 차면 감지 스레드가 대기)
+static const size_t kNotifyChannelCapacity = 256;   // 전송 대기 이벤트 상한 (가득 차면 저장 단계가 대기)
 
 static const std::wregex kUrlRegex(
     LR"(^(https?:\/\/)?([a-z0-9-]+\.)+[a-z]{2,}(:\d+)?(\/.*)?$)",
     std::regex_constants::icase
 ); //URL 형식 검사용 정규식 (불변)
 
-// 확정 로직 기준: 2회 연속, 100ms
-static bool ConfirmUrl(const std::wstring& raw, std::wstring& confirmed)
+// 안정된 주소 표시줄 값 검증 및 정규화
+// confirmed: 스킴이 없으면 https:// 보정한 원본, canonical: 저장/IPC/중복 판정에 쓰는 정규 URL
+bool UrlMonitor::NormalizeUrl(const std::wstring& raw, std::wstring& confirmed, std::wstring& canonical) const
 {
-    DWORD now = GetTickCount();
-
 	// 기본 형태 검사(길이, 공백, 최소 도메인 등)
     if (raw.length() < 6) return false;
     if (raw.find(L' ') != std::wstring::npos) return false;
@@ -38,45 +44,54 @@ static bool ConfirmUrl(const std::wstring& raw, std::wstring& confirmed)
     if (dot == std::wstring::npos) return false;
     if (raw.length() - dot < 3) return false;
 
-    // 새로운 후보가 들어오면 카운트 초기화
-    if (g_candidate != raw) 
-    {
-        g_candidate = raw;
-        g_count = 1;
-        g_firstTick = now;
-        return false;
-    }
-
-    g_count++;
+    confirmed = raw;
+    if (confirmed.find(L"://") == std::wstring::npos)
+        confirmed.insert(0, L"https://");
 
-    // 확정 조건: 2회 연속 + 100ms
-    if (g_count >= 2 && now - g_firstTick >= 100)
-    {
-        std::wstring norm = raw;
-        if (norm.find(L"://") == std::wstring::npos)
-            norm = L"https://" + norm;
-
-        if (std::regex_match(norm, kUrlRegex))
-        {
-            confirmed = norm;
+    // 정규화 후 검사 (IDN 호스트도 punycode로 바뀐 뒤 형식 검사를 통과)
+    canonical.assign(confirmed);
+    if (!m_canonicalizer.Canonicalize(canonical)) return false;
+    if (!std::regex_match(canonical, kUrlRegex)) return false;
 
-            // reset
-            g_candidate.clear();
-            g_count = 0;
-            g_firstTick = 0;
+    return true;
+}
 
-            return true;
-        }
-    }
+// 변화 감지 관문 1단계 서명: 제목 길이와 해시 (윈도우 메시지만 사용, UIA 호출 없음)
+static WindowSignature ReadSignature(HWND hwnd) {
+    thread_local std::wstring title; // 용량 재사용
+    BrowserHelper::GetWindowTitle(hwnd, title);
+    return WindowSignature::FromTitle(title.data(), title.size());
+}
 
-    return false;
+// 확정기가 후보를 기다리거나 사용자가 입력 중이면 값이 곧 바뀔 수 있으므로 관문을 통과시킴
+static bool IsPending(const UrlDebouncer& debouncer) {
+    UrlDebouncer::State state = debouncer.GetState();
+    return state == UrlDebouncer::State::Pending || state == UrlDebouncer::State::Typing;
 }
 
-UrlMonitor::UrlMonitor(Database* db)
+UrlMonitor::UrlMonitor(Database* db, bool multiWindow)
     : m_database(db)
+    , m_uia(&m_locator)
     , m_running(false)
+    , m_multiWindow(multiWindow)
     , m_lastHwnd(nullptr)
+    , m_quietMs(kDefaultQuietMs)
+    , m_forensic(false)
+    , m_gateHwnd(nullptr)
+    , m_notified([this]() { m_scheduler.Post([this]() { PullForwardNotified(); }); })
+    , m_storeStage("UrlStore", kStoreChannelCapacity)
+    , m_notifyStage("UrlNotify", kNotifyChannelCapacity)
+    , m_pollTimer(0)
+    , m_lastInputTick(0)
+    , m_polls(0)
+    , m_uiaReads(0)
+    , m_suspends(0)
+    , m_retiredWorkers(0)
+    , m_workerRestarts(0)
+    , m_uiaResetRequested(false)
 {
+    m_gate.SetVerifyInterval(kGateVerifyMs, kGateVerifyBackgroundMs);
+    m_uia.SetChangeListener([this](HWND hwnd) { OnAddressBarChanged(hwnd); });
 }
 
 UrlMonitor::~UrlMonitor() {
@@ -89,21 +104,137 @@ bool UrlMonitor::Start() {
         return false;
     }
 
+    // 뒤 단계부터 시작 (앞 단계가 넘기는 이벤트를 바로 받을 수 있도록)
+    m_notifyStage.Start([this](UrlEventPtr& ev) { NotifyUrl(ev); });
+    m_storeStage.Start([this](UrlEventPtr& ev) { StoreUrl(ev); });
+
+    if (m_multiWindow) {
+        // 0번 작업 스레드는 포그라운드 전용 (백그라운드 윈도우가 많아도 포그라운드 지연 방지)
+        unsigned hw = std::thread::hardware_concurrency();
+        unsigned count = hw / 2;
+        if (count < 2) count = 2;
+        if (count > kMaxUiaWorkers) count = kMaxUiaWorkers;
+        {
+            std::lock_guard<std::mutex> guard(m_watchLock); // 감시기의 ReplaceWorker와 공유
+            m_workerGen.assign(count, 0);
+            for (unsigned i = 0; i < count; i++) {
+                m_workers.emplace_back(&UrlMonitor::UiaWorkerThread, this, (int)i, 0u);
+            }
+        }
+        m_thread = std::thread(&UrlMonitor::MultiWindowThread, this); //윈도우 디스패처 시작
+        printf("[UrlMonitor] Started (multi-window, %u UIA workers)\n", count);
+        return true;
+    }
+
 	m_thread = std::thread(&UrlMonitor::MonitorThread, this); //URL 모니터링 스레드 시작
     printf("[UrlMonitor] Started\n");
     return true;
 }
 
+void UrlMonitor::SetQuietPeriod(uint32_t quietMs) {
+    m_quietMs = quietMs; // Start 이전에 호출
+}
+
+void UrlMonitor::SetChangeGate(bool enable, uint32_t verifyMs) {
+    m_gate.SetEnabled(enable);
+    if (verifyMs) m_gate.SetVerifyInterval(verifyMs, verifyMs > kGateVerifyBackgroundMs ? verifyMs : kGateVerifyBackgroundMs);
+}
+
 void UrlMonitor::Stop() {
 	m_running.store(false); //스레드 루프 종료 신호
+    m_scheduler.Wake(); //스케줄러 대기 해제
     if (m_thread.joinable()) { //스레드가 실행중이면 종료될 때까지 대기
         m_thread.join();
     }
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> guard(m_watchLock);
+        m_fgJobs.clear();
+        m_bgJobs.clear();
+        workers.swap(m_workers); // 이후 ReplaceWorker는 m_running을 보고 스레드를 만들지 않음
+    }
+    m_jobCv.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join(); // 교체된 스레드는 UIA 호출이 돌아온 뒤 종료
+    }
+    // 감지가 멈춘 뒤 병합 구간에 보류된 이벤트까지 넘기고, 앞 단계부터 남은 이벤트를 모두 저장/전송하고 종료
+    std::vector<UrlEventPtr> pending;
+    m_churn.Drain(pending);
+    for (UrlEventPtr& ev : pending) DispatchUrl(std::move(ev));
+    m_storeStage.Stop();
+    m_notifyStage.Stop();
     m_uia.Shutdown(); //URL 모니터링 UIA 자원 해제
     printf("[UrlMonitor] Stopped\n");
 }
 
+void UrlMonitor::SaveCheckpoint(AgentCheckpoint& cp) {
+    std::unordered_map<HWND, size_t> index; // hwnd → cp.windows 위치
+    auto addWindow = [&](HWND hwnd, const std::wstring& browser, const std::wstring& url) {
+        if (index.count(hwnd)) return;
+        DWORD pid = AgentCheckpoint::WindowPid(hwnd);
+        if (!pid) return; // 이미 닫힌 윈도우
+        index[hwnd] = cp.windows.size();
+        CheckpointWindow win;
+        win.hwnd = hwnd;
+        win.pid = pid;
+        win.browser = browser;
+        win.url = url;
+        cp.windows.push_back(std::move(win));
+    };
+
+    if (m_multiWindow) {
+        for (const auto& kv : m_watches) {
+            if (!kv.second->lastUrl.empty()) addWindow(kv.first, kv.second->info.browserName, kv.second->lastUrl);
+        }
+    }
+    else if (m_lastHwnd && !m_lastUrl.empty()) {
+        addWindow(m_lastHwnd, m_lastBrowser, m_lastUrl);
+    }
+
+    // 재방문 항목은 소유 윈도우가 남아 있는 것만 (URL 없이 윈도우만 기록)
+    std::vector<VisitSnapshot> visits;
+    m_visits.Snapshot(visits);
+    static const std::wstring kNone;
+    for (VisitSnapshot& v : visits) {
+        addWindow(v.hwnd, kNone, kNone);
+        if (index.count(v.hwnd)) cp.visits.push_back(std::move(v));
+    }
+
+    m_locator.Snapshot(cp.locatorPaths);
+}
+
+void UrlMonitor::RestoreCheckpoint(const AgentCheckpoint& cp) {
+    std::unordered_map<HWND, bool> alive;
+    size_t urls = 0;
+    for (const CheckpointWindow& win : cp.windows) {
+        if (!AgentCheckpoint::IsSameWindow(win.hwnd, win.pid)) continue;
+        alive[win.hwnd] = true;
+        if (!win.url.empty()) {
+            m_restoredUrls[win.hwnd] = win.url;
+            urls++;
+        }
+    }
+
+    uint32_t elapsed = cp.ElapsedSinceSaveMs();
+    std::vector<VisitSnapshot> visits;
+    for (const VisitSnapshot& v : cp.visits) {
+        if (!alive.count(v.hwnd)) continue;
+        visits.push_back(v);
+        uint64_t age = (uint64_t)v.ageMs + elapsed;
+        visits.back().ageMs = age > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)age;
+    }
+    m_visits.Restore(visits);
+    m_locator.Restore(cp.locatorPaths);
+
+    printf("[UrlMonitor] Checkpoint restored (windows=%zu/%zu, visits=%zu, paths=%zu, downtime=%u ms)\n",
+        urls, cp.windows.size(), m_visits.Size(), cp.locatorPaths.size(), elapsed);
+}
+
 void UrlMonitor::MonitorThread() {
+    Tracer::SetThreadName("UrlMonitor");
+    // 스케줄러 스레드가 UIA 호출에서 멈추면 호출이 돌아온 뒤 세션을 새로 만듦
+    WatchdogThreadScope watchdog("UrlMonitor", [this](const StallInfo&) { m_uiaResetRequested = true; });
+
     // 스레드별 COM 초기화 (UIA 사용을 위해 필수)
     HRESULT hrCo = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
     bool comInitialized = (SUCCEEDED(hrCo) || hrCo == RPC_E_CHANGED_MODE);
@@ -113,89 +244,533 @@ void UrlMonitor::MonitorThread() {
         if (comInitialized) CoUninitialize();
         return;
     }
+    if (!m_scheduler.Attach()) {
+        m_uia.Shutdown();
+        if (comInitialized) CoUninitialize();
+        return;
+    }
+
+    // 포커스 전환/세션 잠금 해제 시 즉시 폴링 재개
+    m_scheduler.SetForegroundHandler([this](HWND) {
+        if (m_scheduler.IsSessionLocked()) return;
+        m_interval.OnActivity(GetTickCount64());
+        SchedulePoll(0);
+        });
+    m_scheduler.SetSessionHandler([this](bool locked) {
+        if (locked) {
+            m_scheduler.Cancel(m_pollTimer); // 잠금 중에는 폴링 중단
+            m_pollTimer = 0;
+        }
+        else {
+            m_interval.OnActivity(GetTickCount64());
+            SchedulePoll(0);
+        }
+        });
+    m_scheduler.AddPeriodicTask("metrics", kMetricsIntervalMs, [this]() { DumpMetrics(); });
+    m_scheduler.AddPeriodicTask("churn", kChurnFlushMs, [this]() { FlushChurn(); });
+    m_scheduler.AddPeriodicTask("prune", kPruneIntervalMs, [this]() {
+        for (auto it = m_debouncers.begin(); it != m_debouncers.end();) {
+            if (!IsWindow(it->first)) it = m_debouncers.erase(it);
+            else ++it;
+        }
+        m_gate.PruneDeadWindows();
+        });
+
+    SchedulePoll(0);
+    m_scheduler.Run(m_running);
 
+    m_scheduler.Detach();
+    m_uia.Shutdown();
+    if (comInitialized) CoUninitialize();
+}
 
-	while (m_running.load()) { //m_running이 true인 동안 반복
-		HWND fg = GetForegroundWindow(); //현재 포그라운드 윈도우 핸들 가져오기
-        if (!fg) { Sleep(200); continue; }
+// 주소 표시줄 값 변경 알림 (UIA 이벤트 스레드): 관문에 표시하고 스케줄러를 깨워 다음 읽기를 앞당김
+void UrlMonitor::OnAddressBarChanged(HWND hwnd) {
+    m_gate.MarkChanged(hwnd);
+    m_notified.Add(hwnd); // 첫 알림이면 PullForwardNotified를 Post (Post가 Wake 호출)
+}
 
-		HWND top = GetAncestor(fg, GA_ROOT); //최상위 윈도우 핸들 가져오기
-        if (!top) { Sleep(200); continue; }
+// 알림받은 윈도우의 샘플 타이머를 지금으로 당김 (스케줄러 스레드)
+void UrlMonitor::PullForwardNotified() {
+    std::vector<HWND> notified;
+    m_notified.Take(notified);
+    if (m_scheduler.IsSessionLocked()) return; // 잠금 해제 알림에서 재개
 
-        HWND uiaRoot = BrowserHelper::FindUiaRootWindow(top); //UIA 지원 브라우저 윈도우 찾기
-        if (!uiaRoot) {
-            Sleep(200);
+    for (HWND hwnd : notified) {
+        if (!m_multiWindow) {
+            // 포그라운드 윈도우만 폴링. 폴링이 멈춰 있으면(비브라우저) 포커스 전환에서 재개
+            if (hwnd == m_gateHwnd && m_pollTimer) SchedulePoll(0);
             continue;
         }
+        auto it = m_watches.find(hwnd);
+        if (it != m_watches.end() && !it->second->busy) ScheduleWatch(it->second, 0);
+    }
+}
 
-        std::wstring browserName;
-        // 브라우저 윈도우인지 확인 및 브라우저 유형 획득
-        BrowserType type = BrowserHelper::GetBrowserType(uiaRoot, browserName);
-        if (type == BrowserType::Unknown) {
-            Sleep(200);
-            continue;
-        }
+void UrlMonitor::SchedulePoll(uint32_t delayMs) {
+    m_scheduler.Cancel(m_pollTimer);
+    m_pollTimer = m_scheduler.ScheduleAfter(delayMs, [this]() { OnPollTimer(); });
+}
+
+// 폴링 타이머: 결과에 따라 다음 주기 결정 (활동 -> 빠르게, 유휴 -> 백오프, 비브라우저 -> 중단)
+void UrlMonitor::OnPollTimer() {
+    m_pollTimer = 0;
+    if (m_scheduler.IsSessionLocked()) return; // 잠금 해제 알림에서 재개
+
+    // 폴링 한 번 = 추적 상관 ID 하나 (URL이 확정되면 IPC 트레일러로 수신 측까지 전달)
+    TRACE_CORRELATE(Tracer::NewCorrelationId());
+    TRACE_SPAN("UrlMonitor::Poll");
+
+    m_polls++;
+    uint32_t confirmInMs = UINT32_MAX;
+    PollResult result = PollForeground(confirmInMs);
+    ULONGLONG now = GetTickCount64();
+
+    if (result == PollResult::NotBrowser) {
+        m_suspends++;
+        return; // 브라우저가 포그라운드가 되면 포커스 전환 이벤트에서 재개
+    }
+
+    // 사용자 입력도 활동으로 간주 (링크 클릭, 주소 입력 등)
+    LASTINPUTINFO lii = { sizeof(LASTINPUTINFO) };
+    if (GetLastInputInfo(&lii) && lii.dwTime != m_lastInputTick) {
+        m_lastInputTick = lii.dwTime;
+        result = PollResult::Activity;
+    }
+
+    if (result == PollResult::Activity) m_interval.OnActivity(now);
+    uint32_t delay = m_interval.Next(now);
+    if (confirmInMs < delay) delay = confirmInMs; // 후보가 안정 구간을 채우는 시점에 바로 재확인
+    SchedulePoll(delay);
+}
 
-        std::wstring raw, confirmed;
+UrlMonitor::PollResult UrlMonitor::PollForeground(uint32_t& confirmInMs) {
+	HWND fg = GetForegroundWindow(); //현재 포그라운드 윈도우 핸들 가져오기
+    if (!fg) return PollResult::Idle; // 전환 중 일시적으로 없을 수 있음
 
-        // UIA 호출 시 브라우저 유형 전달 (유형별 로직 분기)
-        if (m_uia.GetAddressBarUrl(uiaRoot, type, raw)) { //UIA를 통해 주소 표시줄의 URL 후보를 읽어옴
+	HWND top = GetAncestor(fg, GA_ROOT); //최상위 윈도우 핸들 가져오기
+    if (!top) return PollResult::Idle;
 
-            if (ConfirmUrl(raw, confirmed)) { //URL 확정 로직 수행
+    HWND uiaRoot = BrowserHelper::FindUiaRootWindow(top); //UIA 지원 브라우저 윈도우 찾기
+    if (!uiaRoot) return PollResult::NotBrowser;
 
-                // 동일 URL 중복 방지
-                if (uiaRoot != m_lastHwnd || confirmed != m_lastUrl) {
+    // 브라우저 윈도우인지 확인 및 브라우저 유형 획득 (HWND별 캐시)
+    BrowserWindowInfo info;
+    {
+        TRACE_SPAN("WindowRegistry::Resolve");
+        if (!m_registry.Resolve(uiaRoot, info)) return PollResult::NotBrowser;
+    }
+    BrowserType type = info.type;
+    const std::wstring& browserName = info.browserName;
+
+    std::wstring raw, stable, confirmed;
+    thread_local std::wstring canonical; // 정규화 버퍼 재사용
+    bool editing = false;
+    bool activity = false;
+
+    // 변화 감지 관문: 같은 윈도우의 제목이 그대로고 값 변경 알림도 없고 확정 대기 중도 아니면 읽기 생략
+    // (다른 윈도우로 전환한 직후는 재방문 판정을 위해 항상 읽음)
+    auto pendingIt = m_debouncers.find(uiaRoot);
+    bool pending = pendingIt != m_debouncers.end() && IsPending(pendingIt->second);
+    bool switched = (uiaRoot != m_gateHwnd);
+    m_gateHwnd = uiaRoot;
+    if (!m_gate.ShouldRead(uiaRoot, ReadSignature(uiaRoot), true, pending, switched)) return PollResult::Idle;
+
+    // UIA 호출 시 브라우저 유형 전달 (유형별 로직 분기)
+    m_uiaReads++;
+    bool read;
+    {
+        WATCHDOG_STAGE("uia.read", kUiaReadBudgetMs);
+        read = m_uia.GetAddressBarUrl(uiaRoot, type, raw, &editing); //UIA를 통해 주소 표시줄의 URL 후보를 읽어옴
+    }
+    if (m_uiaResetRequested.exchange(false)) {
+        // 감시기가 정지를 보고함: 응답 없던 세션(캐시된 요소 포함)을 버리고 새로 생성
+        AGENT_LOG_WARN("[UrlMonitor] Recreating UIA session after stall");
+        m_uia.Shutdown();
+        if (!m_uia.Initialize()) AGENT_LOG_ERROR("[UrlMonitor] UIA re-init failed");
+        m_workerRestarts++;
+    }
+    if (!read) m_gate.Invalidate(uiaRoot); // 다음 폴링에서 다시 읽음
+    if (read) {
 
-					std::wstring title = BrowserHelper::GetWindowTitle(uiaRoot); //윈도우 타이틀 가져오기
-					OnUrlChanged(browserName, confirmed, title); //URL 변경 이벤트 처리
+        if (raw != m_lastRaw) { // 주소 표시줄 값 변화 -> 확정될 때까지 빠르게 폴링
+            m_lastRaw = raw;
+            activity = true;
+        }
+
+        TRACE_SPAN("ConfirmUrl");
 
-                    m_lastHwnd = uiaRoot;
-                    m_lastUrl = confirmed;
-                    m_lastBrowser = browserName;
+        // 윈도우별 확정기 (윈도우 전환 시에도 후보 유지)
+        auto it = m_debouncers.find(uiaRoot);
+        if (it == m_debouncers.end()) {
+            it = m_debouncers.emplace(uiaRoot, UrlDebouncer(nullptr, m_quietMs)).first;
+        }
+        UrlDebouncer& debouncer = it->second;
+
+        bool stableNow = debouncer.Feed(raw, editing, stable);
+        debouncer.TimeUntilConfirm(confirmInMs);
+
+        if (stableNow && NormalizeUrl(stable, confirmed, canonical)) { //URL 확정 로직 수행
+
+            // 재시작 전에 이 윈도우에서 마지막으로 확정한 URL이면 이미 저장된 것
+            if (!m_restoredUrls.empty()) {
+                auto restored = m_restoredUrls.find(uiaRoot);
+                if (restored != m_restoredUrls.end()) {
+                    if (restored->second == canonical) {
+                        m_lastHwnd = uiaRoot;
+                        m_lastUrl = canonical;
+                        m_lastBrowser = browserName;
+                    }
+                    m_restoredUrls.erase(restored);
                 }
             }
+
+            // 동일 URL 중복 방지 (정규 URL 기준: 프래그먼트/추적 파라미터만 바뀐 경우 제외)
+            if (uiaRoot != m_lastHwnd || canonical != m_lastUrl) {
+
+				SubmitUrl(uiaRoot, browserName, canonical, confirmed); //URL 변경 이벤트 처리
+
+                m_lastHwnd = uiaRoot;
+                m_lastUrl = canonical;
+                m_lastBrowser = browserName;
+                activity = true;
+            }
+        }
+    }
+
+    return activity ? PollResult::Activity : PollResult::Idle;
+}
+
+void UrlMonitor::DumpMetrics() {
+    AGENT_LOG_INFO("[UrlMonitor] polls=%lu uiaReads=%lu suspends=%lu wakeups=%lu interval=%ums restarts=%lu",
+        m_polls.load(), m_uiaReads.load(), m_suspends.load(), m_scheduler.Wakeups(), m_interval.Current(),
+        m_workerRestarts.load());
+    AGENT_LOG_INFO("[UrlMonitor] visits: revisits=%llu new=%llu tracked=%zu",
+        m_visits.Hits(), m_visits.Misses(), m_visits.Size());
+    AGENT_LOG_INFO("[UrlMonitor] churn: coalesced=%zu suppressed=%llu",
+        m_churn.CoalescedKeys(), m_churn.Suppressed());
+    AGENT_LOG_INFO("[UrlMonitor] events: created=%zu pooled=%zu",
+        UrlEventPool::Instance().Created(), UrlEventPool::Instance().Pooled());
+    AGENT_LOG_INFO("[UrlMonitor] gate: checks=%llu skipped=%llu (%.1f%%) reads: first=%llu switch=%llu title=%llu "
+        "notified=%llu pending=%llu verify=%llu notifications=%llu",
+        m_gate.Checks(), m_gate.Skips(), m_gate.SkipRate(), m_gate.Reads(GateReason::FirstSeen),
+        m_gate.Reads(GateReason::Forced), m_gate.Reads(GateReason::Title), m_gate.Reads(GateReason::Notified),
+        m_gate.Reads(GateReason::Pending), m_gate.Reads(GateReason::Verify), m_gate.Notifications());
+    DumpStage("store", m_storeStage.Metrics());
+    DumpStage("notify", m_notifyStage.Metrics());
+}
+
+void UrlMonitor::DumpStage(const char* name, const StageMetrics& m) {
+    unsigned long long n = m.processed ? m.processed : 1;
+    AGENT_LOG_INFO("[UrlMonitor] stage %s: processed=%llu depth=%zu highWater=%zu blocked=%llu dropped=%llu "
+        "wait avg=%lluus max=%lluus busy avg=%lluus max=%lluus",
+        name, m.processed, m.depth, m.queue.highWater, m.queue.blocked, m.queue.dropped,
+        m.waitUs / n, m.maxWaitUs, m.busyUs / n, m.maxBusyUs);
+}
+
+// 다중 윈도우 모드 디스패처: 스케줄러 스레드에서 레지스트리 갱신 및 윈도우별 샘플링 타이머 관리
+void UrlMonitor::MultiWindowThread() {
+    WatchdogThreadScope watchdog("UrlMonitor");
+    if (!m_scheduler.Attach()) return;
+
+    m_scheduler.SetForegroundHandler([this](HWND hwnd) { OnForegroundWindow(hwnd); });
+    m_lastHwnd = nullptr; // 다중 윈도우 모드에서는 마지막 포그라운드 윈도우로 사용
+    m_scheduler.SetSessionHandler([this](bool locked) {
+        // 잠금 중에는 모든 윈도우 샘플링 중단, 해제 시 즉시 재개
+        for (auto& kv : m_watches) {
+            WindowWatch& w = *kv.second;
+            if (locked) {
+                m_scheduler.Cancel(w.timer);
+                w.timer = 0;
+            }
+            else if (!w.busy) {
+                ScheduleWatch(kv.second, 0);
+            }
         }
+        });
+    m_scheduler.AddPeriodicTask("registry", kRegistryRefreshMs, [this]() { RefreshWindows(); });
+    m_scheduler.AddPeriodicTask("metrics", kMetricsIntervalMs, [this]() { DumpMetrics(); });
+    m_scheduler.AddPeriodicTask("churn", kChurnFlushMs, [this]() { FlushChurn(); });
+
+    RefreshWindows();
+    OnForegroundWindow(GetForegroundWindow());
+    m_scheduler.Run(m_running);
+    m_scheduler.Detach();
+}
 
-        Sleep(200); // 모니터링 주기
+// 최상위 윈도우 재열거 (생성/소멸 추적)
+void UrlMonitor::RefreshWindows() {
+    std::vector<BrowserWindowInfo> created;
+    std::vector<HWND> destroyed;
+    m_registry.Refresh(created, destroyed);
+    if (created.empty() && destroyed.empty()) return;
+
+    for (const BrowserWindowInfo& info : created) {
+        WatchPtr watch = std::make_shared<WindowWatch>();
+        watch->info = info;
+        watch->debouncer.SetQuietPeriod(m_quietMs);
+        RestoreLastUrl(*watch);
+        m_watches[info.hwnd] = watch;
+        ScheduleWatch(watch, 0);
+    }
+    for (HWND hwnd : destroyed) {
+        auto it = m_watches.find(hwnd);
+        if (it == m_watches.end()) continue;
+        m_scheduler.Cancel(it->second->timer); // 처리 중인 작업은 shared_ptr로 안전하게 완료됨
+        m_watches.erase(it);
+        m_gate.Invalidate(hwnd);
     }
+    AGENT_LOG_DEBUG("[UrlMonitor] Browser windows: %zu (+%zu, -%zu)",
+        m_watches.size(), created.size(), destroyed.size());
+}
 
-    m_uia.Shutdown();
+// 체크포인트에 남은 이 윈도우의 마지막 URL을 중복 판정 기준으로 사용 (스케줄러 스레드)
+void UrlMonitor::RestoreLastUrl(WindowWatch& watch) {
+    auto it = m_restoredUrls.find(watch.info.hwnd);
+    if (it == m_restoredUrls.end()) return;
+    watch.lastUrl.swap(it->second);
+    m_restoredUrls.erase(it);
+}
+
+// 포그라운드 전환: 이전 윈도우는 백그라운드 주기로, 새 윈도우는 즉시 샘플링
+void UrlMonitor::OnForegroundWindow(HWND hwnd) {
+    HWND top = hwnd ? GetAncestor(hwnd, GA_ROOT) : nullptr;
+    if (top == m_lastHwnd) return;
+
+    auto old = m_watches.find(m_lastHwnd);
+    if (old != m_watches.end()) old->second->foreground = false;
+    m_lastHwnd = top;
+
+    BrowserWindowInfo info;
+    if (!top || !m_registry.Resolve(top, info)) return;
+
+    WatchPtr& watch = m_watches[top];
+    if (!watch) {
+        watch = std::make_shared<WindowWatch>();
+        watch->info = info;
+        watch->debouncer.SetQuietPeriod(m_quietMs);
+        RestoreLastUrl(*watch);
+    }
+    watch->foreground = true;
+    if (!watch->busy && !m_scheduler.IsSessionLocked()) ScheduleWatch(watch, 0);
+}
+
+void UrlMonitor::ScheduleWatch(const WatchPtr& watch, uint32_t delayMs) {
+    m_scheduler.Cancel(watch->timer);
+    watch->timer = m_scheduler.ScheduleAfter(delayMs, [this, watch]() {
+        watch->timer = 0;
+        if (m_watches.find(watch->info.hwnd) == m_watches.end()) return; // 이미 소멸
+        watch->busy = true;
+        {
+            std::lock_guard<std::mutex> guard(m_watchLock);
+            if (watch->foreground) m_fgJobs.push_back(watch);
+            else m_bgJobs.push_back(watch);
+        }
+        m_jobCv.notify_all();
+        });
+}
+
+// UIA 작업 스레드: 스레드별 COM/UIA 세션, 학습된 주소 표시줄 경로는 공유
+// generation: 역할(index)의 세대. 감시기가 정지를 보고하면 같은 역할의 새 세대 스레드가 대신 큐를 처리하고,
+// 멈춘 스레드는 UIA 호출이 돌아오는 대로 자기 세션을 정리하고 종료
+void UrlMonitor::UiaWorkerThread(int index, uint32_t generation) {
+    char threadName[32];
+    if (generation == 0) snprintf(threadName, sizeof(threadName), "UiaWorker %d", index);
+    else snprintf(threadName, sizeof(threadName), "UiaWorker %d.%u", index, generation);
+    Tracer::SetThreadName(threadName);
+    WatchdogThreadScope watchdog(threadName, [this, index](const StallInfo& stall) { ReplaceWorker(index, stall); });
+
+    HRESULT hrCo = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    bool comInitialized = (SUCCEEDED(hrCo) || hrCo == RPC_E_CHANGED_MODE);
+
+    UiaHelper uia(&m_locator);
+    uia.SetChangeListener([this](HWND hwnd) { OnAddressBarChanged(hwnd); });
+    if (!uia.Initialize()) {
+        printf("[UrlMonitor] UIA init failed in worker %d\n", index);
+        if (comInitialized) CoUninitialize();
+        return;
+    }
+
+    ULONGLONG lastPrune = GetTickCount64();
+    while (true) {
+        WatchPtr job;
+        {
+            std::unique_lock<std::mutex> lk(m_watchLock);
+            if (m_workerGen[index] != generation) { // 교체됨
+                m_retiredWorkers--;
+                AGENT_LOG_INFO("[UrlMonitor] Replaced UIA worker %s exiting", threadName);
+                break;
+            }
+            m_jobCv.wait(lk, [this, index]() {
+                return !m_running.load() || !m_fgJobs.empty() || (index != 0 && !m_bgJobs.empty());
+                });
+            if (!m_running.load()) break;
+
+            if (!m_fgJobs.empty()) {
+                job = m_fgJobs.front();
+                m_fgJobs.pop_front();
+            }
+            else {
+                job = m_bgJobs.front();
+                m_bgJobs.pop_front();
+            }
+        }
+
+        uint32_t confirmInMs = UINT32_MAX;
+        ObserveWindow(*job, uia, confirmInMs);
+
+        // 다음 샘플링 예약은 스케줄러 스레드에서 (watch 상태는 스케줄러 스레드 소유)
+        m_scheduler.Post([this, job, confirmInMs]() {
+            job->busy = false;
+            if (m_scheduler.IsSessionLocked()) return;
+            uint32_t delay = job->foreground ? kForegroundIntervalMs : kBackgroundIntervalMs;
+            if (confirmInMs < delay) delay = confirmInMs;
+            ScheduleWatch(job, delay);
+            });
+
+        ULONGLONG now = GetTickCount64();
+
+        if (now - lastPrune >= kUiaPruneMs) {
+            uia.PruneDeadWindows();
+            lastPrune = now;
+        }
+    }
+
+    uia.Shutdown();
     if (comInitialized) CoUninitialize();
 }
 
-//URL 확정 시 데이터베이스 저장 및 IPC 메시지 전송
-void UrlMonitor::OnUrlChanged(const std::wstring& browser, const std::wstring& url, const std::wstring& title) {
-    printf("[UrlMonitor] %ls: %ls\n", browser.c_str(), url.c_str());
+// 감시 스레드에서 호출: 멈춘 작업 스레드 대신 같은 역할의 새 스레드(새 COM/UIA 세션) 시작
+// 멈춘 스레드를 강제로 끝낼 수는 없으므로, 돌아오지 않은 스레드가 상한에 이르면 교체를 멈춤
+void UrlMonitor::ReplaceWorker(int index, const StallInfo& stall) {
+    std::lock_guard<std::mutex> guard(m_watchLock);
+    if (!m_running.load()) return;
+    if (m_retiredWorkers.load() >= kMaxRetiredWorkers) {
+        AGENT_LOG_ERROR("[UrlMonitor] %s stalled in %s, %u workers already stuck; not replacing",
+            stall.thread, stall.stage, m_retiredWorkers.load());
+        return;
+    }
+
+    uint32_t generation = ++m_workerGen[index];
+    m_retiredWorkers++;
+    m_workerRestarts++;
+    m_workers.emplace_back(&UrlMonitor::UiaWorkerThread, this, index, generation);
+    AGENT_LOG_WARN("[UrlMonitor] %s stalled in %s for %llu ms; started replacement generation %u",
+        stall.thread, stall.stage, (unsigned long long)stall.elapsedMs, generation);
+}
+
+// 윈도우 하나의 주소 표시줄 확인 (busy 플래그를 가진 작업 스레드만 watch 상태를 수정)
+void UrlMonitor::ObserveWindow(WindowWatch& watch, UiaHelper& uia, uint32_t& confirmInMs) {
+    TRACE_CORRELATE(Tracer::NewCorrelationId());
+    TRACE_SPAN("UrlMonitor::ObserveWindow");
 
-    if (m_database) {
-        m_database->SaveBrowserUrl(browser, url, title);
+    std::wstring raw, stable, confirmed;
+    thread_local std::wstring canonical; // 정규화 버퍼 재사용
+    bool editing = false;
+    HWND hwnd = watch.info.hwnd;
+    if (!m_gate.ShouldRead(hwnd, ReadSignature(hwnd), watch.foreground, IsPending(watch.debouncer))) return;
+
+    m_uiaReads++;
+    {
+        WATCHDOG_STAGE("uia.read", kUiaReadBudgetMs);
+        if (!uia.GetAddressBarUrl(hwnd, watch.info.type, raw, &editing)) {
+            m_gate.Invalidate(hwnd);
+            return;
+        }
     }
 
-    // IPC 메시지 전송 로직
-    // 데이터 형식: [BrowserName]|[URL]|[WindowTitle]
-    std::wstring wpayload = browser + L"|" + url + L"|" + title;
-    std::string payload = Utf16ToUtf8(wpayload);
+    {
+        TRACE_SPAN("ConfirmUrl");
+        bool stableNow = watch.debouncer.Feed(raw, editing, stable);
+        watch.debouncer.TimeUntilConfirm(confirmInMs);
+        if (!stableNow || !NormalizeUrl(stable, confirmed, canonical)) return;
+        if (canonical == watch.lastUrl) return;
+    }
 
-    DWORD payloadSize = (DWORD)payload.size() + 1; // null-terminator 포함
-    DWORD totalSize = sizeof(IPC_URL_MSG_HEADER) + payloadSize;
+    SubmitUrl(watch.info.hwnd, watch.info.browserName, canonical, confirmed);
+    watch.lastUrl = canonical;
+}
+
+// 확정된 변경을 이벤트 객체(풀)에 한 번만 UTF-8로 담아 폭주 병합기에 제출, 지금 내보낼 이벤트만 저장 단계로 넘김
+void UrlMonitor::SubmitUrl(HWND hwnd, const std::wstring& browser, const std::wstring& url, const std::wstring& rawUrl) {
+    static const std::wstring kNoRaw;
+    thread_local std::wstring title; // 용량 재사용
+    BrowserHelper::GetWindowTitle(hwnd, title); //윈도우 타이틀 가져오기
 
-    PIPC_URL_MSG_HEADER hdr = (PIPC_URL_MSG_HEADER)malloc(totalSize);
-    if (!hdr) return;
+    UrlEventPtr ev = UrlEventPool::Instance().Acquire();
+    ev->Assign(hwnd, browser, url, rawUrl == url ? kNoRaw : rawUrl, title);
+    ev->SetTraceId(Tracer::CurrentCorrelationId());
+    if (!m_churn.Offer(ev)) return; // 병합 구간에 보류 (ev는 병합기로 넘어감)
 
-    memset(hdr, 0, totalSize);
+    DispatchUrl(std::move(ev));
+}
+
+// 변경이 멈췄거나 간격이 지난 병합 이벤트 배출 (스케줄러 스레드)
+void UrlMonitor::FlushChurn() {
+    thread_local std::vector<UrlEventPtr> due;
+    m_churn.CollectDue(due);
+    for (UrlEventPtr& ev : due) {
+        DispatchUrl(std::move(ev));
+    }
+    due.clear(); // 벡터 용량은 유지
+}
 
-    hdr->nType = IMT_URL_EVENT;
-    hdr->dwSize = payloadSize;
+// 저장 단계 채널에 넣음 (감지 스레드). 채널이 가득 차면 자리가 날 때까지 대기 (역압력)
+void UrlMonitor::DispatchUrl(UrlEventPtr ev) {
+    if (!m_storeStage.Push(std::move(ev))) {
+        AGENT_LOG_WARN("[UrlMonitor] URL event dropped (pipeline stopped)");
+    }
+}
 
-    // 페이로드 복사
-    memcpy((BYTE*)hdr + sizeof(IPC_URL_MSG_HEADER),
-        payload.c_str(), payloadSize);
+//URL 확정 시 데이터베이스 저장 (저장 단계 스레드), 끝나면 전송 단계로 넘김
+// ev->Url(): 정규 URL (저장/IPC/재방문 판정), ev->RawUrl(): 주소 표시줄 원본 (다를 때만, raw_url로 저장)
+// ev->Changes(): 병합된 변경 수 (1보다 크면 change_count 컬럼과 IPC 트레일러로 전달)
+// DB 바인딩과 IPC 송신 모두 이벤트 버퍼를 그대로 사용 (추가 변환/할당 없음)
+void UrlMonitor::StoreUrl(UrlEventPtr& ev) {
+    TRACE_CORRELATE(ev->TraceId());
+    TRACE_SPAN("UrlMonitor::StoreUrl");
+    AGENT_LOG_INFO("[UrlMonitor] %s: %s (changes=%u)",
+        LogSlice{ ev->Browser(), ev->BrowserLen() }, LogSlice{ ev->Url(), ev->UrlLen() }, ev->Changes());
+
+    if (m_database) {
+        // 창 안의 재방문(A→B→A)은 기존 행 갱신, 갱신 실패 시 새 행으로 저장
+        int64_t rowId = 0;
+        bool touched = false;
+        // 병합된 이벤트는 변경 수를 보존하도록 항상 새 행
+        bool aggregate = !m_forensic && ev->Changes() <= 1;
+        if (aggregate && m_visits.Lookup(ev->Hwnd(), ev->Url(), ev->UrlLen(), rowId)) {
+            touched = m_database->TouchBrowserUrl(rowId, ev->Title(), ev->TitleLen());
+            if (!touched) m_visits.Forget(ev->Hwnd(), ev->Url(), ev->UrlLen());
+        }
+        if (!touched) {
+            BrowserUrlRow row;
+            row.browser = ev->Browser(); row.nBrowser = ev->BrowserLen();
+            row.url = ev->Url(); row.nUrl = ev->UrlLen();
+            row.title = ev->Title(); row.nTitle = ev->TitleLen();
+            row.raw = ev->RawUrl(); row.nRaw = ev->RawUrlLen();
+            row.changeCount = (int)ev->Changes();
+            if (m_database->SaveBrowserUrl(row, &rowId) && rowId > 0 && aggregate) {
+                m_visits.Remember(ev->Hwnd(), ev->Url(), ev->UrlLen(), rowId);
+            }
+        }
+    }
+
+    m_notifyStage.Push(std::move(ev));
+}
+
+// IPC 메시지 전송 (전송 단계 스레드)
+// 데이터 형식: [BrowserName]|[URL]|[WindowTitle] (이벤트 버퍼가 이미 이 모양, 트레일러만 덧붙임)
+void UrlMonitor::NotifyUrl(UrlEventPtr& ev) {
+    uint64_t traceId = ev->TraceId();
+    TRACE_CORRELATE(traceId);
+    DWORD totalSize = 0;
+    PIPC_MSG_HEADER hdr = ev->FinishIpc(IMT_URL_EVENT, traceId, totalSize);
 
     // SendIpcMessage는 madCHook에 정의된 함수
+    TRACE_SPAN("SendIpcMessage");
+    TRACE_FLOW('s', traceId);
     BOOL ok = SendIpcMessage(IPC_NAME_URL, hdr, totalSize);
     if (!ok) {
-        printf("[UrlMonitor] Failed to send URL IPC message to user program\n");
+        AGENT_LOG_ERROR("[UrlMonitor] Failed to send URL IPC message to user program");
     }
-
-    free(hdr);
-}
\ No newline at end of file
+}
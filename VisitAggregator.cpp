@@ -0,0 +1,175 @@
+﻿#include "VisitAggregator.h"
+#include <string.h>
+
+const int32_t VisitAggregator::kNone; // vector::assign 등에서 참조로 전달
+
+VisitAggregator::VisitAggregator(IClock* clock, uint32_t windowMs, size_t capacity)
+    : m_clock(clock ? clock : SteadyClock::Instance()), m_windowMs(windowMs),
+      m_entries(capacity ? capacity : 1), m_mask(0), m_head(kNone), m_tail(kNone), m_free(kNone),
+      m_size(0), m_hits(0), m_misses(0) {
+    // 적재율 50% 이하 유지
+    size_t tableSize = 2;
+    while (tableSize < m_entries.size() * 2) tableSize <<= 1;
+    m_table.assign(tableSize, kNone);
+    m_mask = tableSize - 1;
+
+    for (size_t i = m_entries.size(); i-- > 0;) {
+        m_entries[i].next = m_free;
+        m_free = (int32_t)i;
+    }
+}
+
+// FNV-1a (URL 바이트 + 윈도우 핸들)
+uint64_t VisitAggregator::Hash(HWND hwnd, const char* url, size_t len) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)url[i];
+        h *= 1099511628211ULL;
+    }
+    h ^= (uint64_t)(uintptr_t)hwnd;
+    h *= 1099511628211ULL;
+    return h;
+}
+
+size_t VisitAggregator::FindSlot(HWND hwnd, const char* url, size_t len, uint64_t hash) const {
+    size_t pos = (size_t)hash & m_mask;
+    while (m_table[pos] != kNone) {
+        const Entry& e = m_entries[m_table[pos]];
+        if (e.hash == hash && e.hwnd == hwnd && e.url.size() == len && memcmp(e.url.data(), url, len) == 0) break;
+        pos = (pos + 1) & m_mask;
+    }
+    return pos;
+}
+
+void VisitAggregator::Unlink(int32_t idx) {
+    Entry& e = m_entries[idx];
+    if (e.prev != kNone) m_entries[e.prev].next = e.next; else m_head = e.next;
+    if (e.next != kNone) m_entries[e.next].prev = e.prev; else m_tail = e.prev;
+    e.prev = e.next = kNone;
+}
+
+void VisitAggregator::PushFront(int32_t idx) {
+    Entry& e = m_entries[idx];
+    e.prev = kNone;
+    e.next = m_head;
+    if (m_head != kNone) m_entries[m_head].prev = idx;
+    m_head = idx;
+    if (m_tail == kNone) m_tail = idx;
+}
+
+// 항목 제거: 테이블에서는 뒤따르는 탐사열을 당겨 채움 (묘비 없음), 슬롯은 빈 목록으로
+void VisitAggregator::Erase(int32_t idx) {
+    Entry& e = m_entries[idx];
+    size_t pos = (size_t)e.hash & m_mask;
+    while (m_table[pos] != idx) pos = (pos + 1) & m_mask;
+
+    size_t hole = pos;
+    m_table[hole] = kNone;
+    for (size_t j = (hole + 1) & m_mask; m_table[j] != kNone; j = (j + 1) & m_mask) {
+        size_t home = (size_t)m_entries[m_table[j]].hash & m_mask;
+        // home이 (hole, j] 구간 밖이면 hole로 옮겨도 탐사열이 끊기지 않음
+        bool between = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (between) continue;
+        m_table[hole] = m_table[j];
+        m_table[j] = kNone;
+        hole = j;
+    }
+
+    Unlink(idx);
+    e.hwnd = nullptr;
+    e.url.clear(); // 용량은 유지
+    e.next = m_free;
+    m_free = idx;
+    m_size--;
+}
+
+bool VisitAggregator::Lookup(HWND hwnd, const char* url, size_t len, int64_t& rowIdOut) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    uint64_t now = m_clock->NowMs();
+    EvictExpired(now);
+
+    size_t pos = FindSlot(hwnd, url, len, Hash(hwnd, url, len));
+    int32_t idx = m_table[pos];
+    if (idx == kNone) {
+        m_misses++;
+        return false;
+    }
+
+    Entry& e = m_entries[idx];
+    e.lastSeen = now;
+    Unlink(idx);
+    PushFront(idx);
+    rowIdOut = e.rowId;
+    m_hits++;
+    return true;
+}
+
+void VisitAggregator::Remember(HWND hwnd, const char* url, size_t len, int64_t rowId) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    uint64_t now = m_clock->NowMs();
+    EvictExpired(now);
+    Insert(hwnd, url, len, rowId, now);
+}
+
+// 잠금을 잡은 상태에서 호출. 같은 키는 교체, 가득 차면 가장 오래 방문하지 않은 항목 재사용
+void VisitAggregator::Insert(HWND hwnd, const char* url, size_t len, int64_t rowId, uint64_t lastSeen) {
+    uint64_t hash = Hash(hwnd, url, len);
+    size_t pos = FindSlot(hwnd, url, len, hash);
+    if (m_table[pos] != kNone) {
+        Erase(m_table[pos]);
+    }
+    if (m_free == kNone) {
+        Erase(m_tail);
+    }
+    pos = FindSlot(hwnd, url, len, hash); // 제거로 탐사열이 바뀌었을 수 있음
+
+    int32_t idx = m_free;
+    Entry& e = m_entries[idx];
+    m_free = e.next;
+    e.hwnd = hwnd;
+    e.url.assign(url, len);
+    e.hash = hash;
+    e.rowId = rowId;
+    e.lastSeen = lastSeen;
+    m_table[pos] = idx;
+    PushFront(idx);
+    m_size++;
+}
+
+void VisitAggregator::Forget(HWND hwnd, const char* url, size_t len) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    size_t pos = FindSlot(hwnd, url, len, Hash(hwnd, url, len));
+    if (m_table[pos] != kNone) Erase(m_table[pos]);
+}
+
+void VisitAggregator::Snapshot(std::vector<VisitSnapshot>& out) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    uint64_t now = m_clock->NowMs();
+    EvictExpired(now);
+    out.reserve(out.size() + m_size);
+    for (int32_t idx = m_head; idx != kNone; idx = m_entries[idx].next) {
+        const Entry& e = m_entries[idx];
+        out.push_back(VisitSnapshot{ e.hwnd, e.url, e.rowId, (uint32_t)(now - e.lastSeen) });
+    }
+}
+
+// 오래된 것부터 넣어 LRU 순서 유지 (재시작 전 경과 시간을 그대로 이어감)
+void VisitAggregator::Restore(const std::vector<VisitSnapshot>& entries) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    uint64_t now = m_clock->NowMs();
+    for (size_t i = entries.size(); i-- > 0;) {
+        const VisitSnapshot& v = entries[i];
+        if (v.ageMs > m_windowMs || v.url.empty()) continue;
+        Insert(v.hwnd, v.url.data(), v.url.size(), v.rowId, now > v.ageMs ? now - v.ageMs : 0);
+    }
+}
+
+size_t VisitAggregator::Size() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_size;
+}
+
+// 목록이 마지막 방문 순이므로 뒤쪽부터 창이 지난 항목 제거
+void VisitAggregator::EvictExpired(uint64_t now) {
+    while (m_tail != kNone && now - m_entries[m_tail].lastSeen > m_windowMs) Erase(m_tail);
+}
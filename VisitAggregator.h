@@ -0,0 +1,79 @@
+﻿#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include "IpcProtocol.h" // Windows 외 빌드(LoadGen)용 HWND 등 최소 정의
+#endif
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Clock.h"
+
+// 체크포인트용 항목 사본 (ageMs: 마지막 방문 이후 지난 시간)
+struct VisitSnapshot {
+    HWND hwnd;
+    std::string url;
+    int64_t rowId;
+    uint32_t ageMs;
+};
+
+// 최근 방문한 (윈도우, URL) → BrowserUrls 행 id
+// - 창(windowMs) 안에 다시 확정된 URL은 새 행 대신 기존 행의 visit_count/last_seen 갱신에 사용
+// - 마지막 방문 기준 창이 지나거나 capacity를 넘으면 오래된 것부터 제거 (메모리 상한)
+// - 항목은 생성 시 capacity만큼 미리 잡은 슬랩에서 재사용 (URL 문자열 용량 포함) → 정상 상태에서 할당 없음
+// - 여러 UIA 작업 스레드에서 호출 가능. URL은 UTF-8 (UrlEvent 버퍼를 그대로 전달)
+class VisitAggregator {
+public:
+    explicit VisitAggregator(IClock* clock = nullptr, uint32_t windowMs = 30 * 60 * 1000, size_t capacity = 4096);
+
+    // 창 안에서 본 적 있으면 행 id를 돌려주고 마지막 방문 시각 갱신
+    bool Lookup(HWND hwnd, const char* url, size_t len, int64_t& rowIdOut);
+
+    // 새로 저장한 행 기록 (같은 키가 있으면 교체)
+    void Remember(HWND hwnd, const char* url, size_t len, int64_t rowId);
+
+    // 행 갱신에 실패한 항목 제거 (행이 사라졌거나 DB가 바뀐 경우)
+    void Forget(HWND hwnd, const char* url, size_t len);
+
+    // 최근 방문 순으로 항목 복사 / 재시작 시 복원 (창이 지난 항목은 버림)
+    void Snapshot(std::vector<VisitSnapshot>& out);
+    void Restore(const std::vector<VisitSnapshot>& entries);
+
+    size_t Size();
+    unsigned long long Hits() const { return m_hits; }
+    unsigned long long Misses() const { return m_misses; }
+
+private:
+    static const int32_t kNone = -1;
+
+    struct Entry {
+        HWND hwnd = nullptr;
+        std::string url;
+        uint64_t hash = 0;
+        int64_t rowId = 0;
+        uint64_t lastSeen = 0;
+        int32_t prev = kNone; // LRU 목록 (앞쪽이 최근 방문) / 빈 슬롯 목록은 next만 사용
+        int32_t next = kNone;
+    };
+
+    IClock* m_clock;
+    const uint64_t m_windowMs;
+
+    std::mutex m_lock;
+    std::vector<Entry> m_entries;  // 슬랩 (크기 = capacity)
+    std::vector<int32_t> m_table;  // 선형 탐사 해시 테이블: 항목 인덱스 또는 kNone (크기 = 2의 거듭제곱)
+    size_t m_mask;
+    int32_t m_head, m_tail, m_free;
+    size_t m_size;
+    unsigned long long m_hits;
+    unsigned long long m_misses;
+
+    static uint64_t Hash(HWND hwnd, const char* url, size_t len);
+    size_t FindSlot(HWND hwnd, const char* url, size_t len, uint64_t hash) const; // 테이블 위치 또는 빈 위치
+    void Unlink(int32_t idx);
+    void PushFront(int32_t idx);
+    void Erase(int32_t idx);
+    void EvictExpired(uint64_t now);
+    void Insert(HWND hwnd, const char* url, size_t len, int64_t rowId, uint64_t lastSeen);
+};
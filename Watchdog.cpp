@@ -0,0 +1,236 @@
+﻿#include "Watchdog.h"
+#include "AsyncLogger.h"
+#include "Tracer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+static const uint32_t kWatchdogMetricsMs = 60000; // 지표 출력 주기
+
+static thread_local Heartbeat* t_heartbeat = nullptr;
+
+std::atomic<bool> Watchdog::s_injectArmed(false);
+
+Heartbeat::Heartbeat(Watchdog* owner, const std::string& name, StallHandler onStall)
+    : m_owner(owner), m_name(name), m_onStall(onStall),
+      m_seq(0), m_stage(nullptr), m_startMs(0), m_budgetMs(0), m_lastBeatMs(owner->NowMs()) {
+}
+
+void Heartbeat::Publish(const char* stage, uint64_t startMs, uint32_t budgetMs) {
+    uint32_t seq = m_seq.load(std::memory_order_relaxed);
+    m_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_stage.store(stage, std::memory_order_relaxed);
+    m_startMs.store(startMs, std::memory_order_relaxed);
+    m_budgetMs.store(budgetMs, std::memory_order_relaxed);
+    m_seq.store(seq + 2, std::memory_order_release);
+}
+
+Heartbeat::Saved Heartbeat::Enter(const char* stage, uint32_t budgetMs) {
+    Saved prev = { m_stage.load(std::memory_order_relaxed), m_startMs.load(std::memory_order_relaxed),
+        m_budgetMs.load(std::memory_order_relaxed) };
+    uint64_t now = m_owner->NowMs();
+    m_lastBeatMs.store(now, std::memory_order_relaxed);
+    Publish(stage, now, budgetMs);
+    return prev;
+}
+
+void Heartbeat::Leave(const Saved& prev) {
+    m_lastBeatMs.store(m_owner->NowMs(), std::memory_order_relaxed);
+    Publish(prev.stage, prev.startMs, prev.budgetMs);
+}
+
+Watchdog& Watchdog::Instance() {
+    static Watchdog watchdog;
+    return watchdog;
+}
+
+Watchdog::Watchdog(IClock* clock)
+    : m_clock(clock ? clock : SteadyClock::Instance()), m_recovery(true), m_running(false), m_checkIntervalMs(1000),
+      m_stalls(0), m_recoveries(0), m_stalledMs(0), m_activeStalls(0) {
+}
+
+Watchdog::~Watchdog() {
+    Stop();
+}
+
+void Watchdog::Start(uint32_t checkIntervalMs) {
+    std::lock_guard<std::mutex> lk(m_wakeLock);
+    if (m_running) return;
+    m_running = true;
+    m_checkIntervalMs = checkIntervalMs ? checkIntervalMs : 1000;
+    m_thread = std::thread(&Watchdog::ThreadProc, this);
+    printf("[Watchdog] Started (check every %u ms, recovery %s)\n", m_checkIntervalMs, m_recovery ? "on" : "off");
+}
+
+void Watchdog::Stop() {
+    {
+        std::lock_guard<std::mutex> lk(m_wakeLock);
+        if (!m_running) return;
+        m_running = false;
+    }
+    m_wakeCv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+    printf("[Watchdog] Stopped\n");
+}
+
+HeartbeatPtr Watchdog::Register(const std::string& name, StallHandler onStall) {
+    HeartbeatPtr hb = std::make_shared<Heartbeat>(this, name, onStall);
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_beats.push_back(hb);
+    }
+    t_heartbeat = hb.get();
+    return hb;
+}
+
+void Watchdog::Unregister(const HeartbeatPtr& hb) {
+    if (!hb) return;
+    if (t_heartbeat == hb.get()) t_heartbeat = nullptr;
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (size_t i = 0; i < m_beats.size(); i++) {
+        if (m_beats[i] == hb) {
+            m_beats.erase(m_beats.begin() + i);
+            break;
+        }
+    }
+}
+
+Heartbeat* Watchdog::Current() {
+    return t_heartbeat;
+}
+
+void Watchdog::SetStageHandler(const char* stage, StallHandler handler) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (handler) m_stageHandlers[stage] = handler;
+    else m_stageHandlers.erase(stage);
+}
+
+void Watchdog::InjectStall(const char* stage, uint32_t delayMs, uint32_t count) {
+    if (!stage || !*stage || delayMs == 0 || count == 0) return;
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_injections[stage] = Injection{ delayMs, count };
+    s_injectArmed.store(true);
+}
+
+bool Watchdog::ParseInjectSpec(const char* spec) {
+    const char* colon = spec ? strchr(spec, ':') : nullptr;
+    if (!colon || colon == spec) return false;
+    char* end = nullptr;
+    unsigned long delayMs = strtoul(colon + 1, &end, 10);
+    unsigned long count = 1;
+    if (end && *end == ':') count = strtoul(end + 1, &end, 10);
+    if (delayMs == 0 || count == 0 || (end && *end)) return false;
+
+    InjectStall(std::string(spec, colon - spec).c_str(), (uint32_t)delayMs, (uint32_t)count);
+    printf("[Watchdog] Stall injection armed: %.*s %lu ms x%lu\n", (int)(colon - spec), spec, delayMs, count);
+    return true;
+}
+
+// 단계 진입 직후 호출: 주입이 남아 있으면 그 스레드를 지연 (단계는 이미 게시되어 감시 대상)
+void Watchdog::ApplyInjection(const char* stage) {
+    uint32_t delayMs = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_injections.find(stage);
+        if (it == m_injections.end()) return;
+        delayMs = it->second.delayMs;
+        if (--it->second.remaining == 0) m_injections.erase(it);
+        if (m_injections.empty()) s_injectArmed.store(false);
+    }
+    AGENT_LOG_WARN("[Watchdog] Injecting %u ms stall in %s", delayMs, stage);
+    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+}
+
+size_t Watchdog::CheckNow() {
+    std::vector<HeartbeatPtr> beats;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        beats = m_beats;
+    }
+
+    uint64_t now = m_clock->NowMs();
+    std::vector<std::pair<StallInfo, StallHandler>> actions;
+    size_t flagged = 0;
+    size_t active = 0;
+
+    for (const HeartbeatPtr& hb : beats) {
+        // seqlock 읽기: 기록 중이거나 읽는 동안 바뀌었으면 이번 바퀴는 건너뜀
+        uint32_t seq = hb->m_seq.load(std::memory_order_acquire);
+        if (seq & 1) continue;
+        const char* stage = hb->m_stage.load(std::memory_order_relaxed);
+        uint64_t startMs = hb->m_startMs.load(std::memory_order_relaxed);
+        uint32_t budgetMs = hb->m_budgetMs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (hb->m_seq.load(std::memory_order_relaxed) != seq) continue;
+
+        // 보고했던 정지에서 벗어남
+        if (hb->m_flaggedSeq != 0 && hb->m_flaggedSeq != seq) {
+            uint64_t resumedAt = hb->m_lastBeatMs.load(std::memory_order_relaxed);
+            uint64_t stalled = resumedAt > hb->m_flaggedAtMs ? resumedAt - hb->m_flaggedAtMs : 0;
+            m_stalledMs += stalled;
+            hb->m_flaggedSeq = 0;
+            AGENT_LOG_INFO("[Watchdog] %s resumed after %llu ms", hb->Name(), (unsigned long long)stalled);
+        }
+
+        if (!stage || budgetMs == 0 || now < startMs || now - startMs <= budgetMs) continue;
+        active++;
+        if (hb->m_flaggedSeq == seq) continue; // 같은 정지는 한 번만 보고
+
+        hb->m_flaggedSeq = seq;
+        hb->m_flaggedAtMs = startMs;
+        flagged++;
+        m_stalls++;
+
+        StallInfo info = { hb->Name(), stage, now - startMs, budgetMs };
+        AGENT_LOG_WARN("[Watchdog] Stall: %s stuck in %s for %llu ms (budget %u ms)",
+            info.thread, stage, (unsigned long long)info.elapsedMs, budgetMs);
+        if (hb->m_onStall) actions.emplace_back(info, hb->m_onStall);
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto it = m_stageHandlers.find(stage);
+            if (it != m_stageHandlers.end()) actions.emplace_back(info, it->second);
+        }
+    }
+    m_activeStalls.store(active);
+
+    // 복구는 잠금 밖에서 (핸들러가 스레드를 만들거나 Register를 호출할 수 있음)
+    if (m_recovery) {
+        for (auto& action : actions) {
+            action.second(action.first);
+            m_recoveries++;
+        }
+    }
+    return flagged;
+}
+
+void Watchdog::DumpMetrics() {
+    size_t threads;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        threads = m_beats.size();
+    }
+    AGENT_LOG_INFO("[Watchdog] threads=%zu stalls=%llu active=%zu recoveries=%llu stalledMs=%llu",
+        threads, m_stalls.load(), m_activeStalls.load(), m_recoveries.load(), m_stalledMs.load());
+}
+
+void Watchdog::ThreadProc() {
+    Tracer::SetThreadName("Watchdog");
+
+    uint64_t lastMetrics = m_clock->NowMs();
+    std::unique_lock<std::mutex> lk(m_wakeLock);
+    while (m_running) {
+        m_wakeCv.wait_for(lk, std::chrono::milliseconds(m_checkIntervalMs), [this]() { return !m_running; });
+        if (!m_running) break;
+
+        lk.unlock();
+        CheckNow();
+        uint64_t now = m_clock->NowMs();
+        if (now - lastMetrics >= kWatchdogMetricsMs) {
+            DumpMetrics();
+            lastMetrics = now;
+        }
+        lk.lock();
+    }
+}
@@ -0,0 +1,176 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Clock.h"
+
+// 정지로 판정된 단계 하나
+struct StallInfo {
+    std::string thread;   // 하트비트 이름 (예: "UiaWorker 1")
+    const char* stage;    // 단계 이름 (정적 리터럴)
+    uint64_t elapsedMs;   // 단계에 들어간 뒤 지난 시간
+    uint32_t budgetMs;    // 단계 예산
+};
+
+typedef std::function<void(const StallInfo&)> StallHandler;
+
+class Watchdog;
+
+// 스레드 하나의 하트비트 슬롯 (소유 스레드만 기록, 감시 스레드는 읽기만)
+// 단계는 중첩 가능: 안쪽 단계가 끝나면 바깥 단계와 그 시작 시각이 복원됨
+class Heartbeat {
+public:
+    Heartbeat(Watchdog* owner, const std::string& name, StallHandler onStall);
+
+    const std::string& Name() const { return m_name; }
+    Watchdog* Owner() const { return m_owner; }
+
+    struct Saved {
+        const char* stage;
+        uint64_t startMs;
+        uint32_t budgetMs;
+    };
+
+    Saved Enter(const char* stage, uint32_t budgetMs);
+    void Leave(const Saved& prev);
+
+private:
+    friend class Watchdog;
+
+    Watchdog* m_owner;
+    std::string m_name;
+    StallHandler m_onStall;
+
+    // seqlock: 기록 중이면 홀수 (감시 스레드가 찢어진 값을 읽지 않도록)
+    std::atomic<uint32_t> m_seq;
+    std::atomic<const char*> m_stage; // nullptr = 대기 중 (감시하지 않음)
+    std::atomic<uint64_t> m_startMs;
+    std::atomic<uint32_t> m_budgetMs;
+    std::atomic<uint64_t> m_lastBeatMs;
+
+    // 감시 스레드 전용
+    uint32_t m_flaggedSeq = 0;  // 이미 보고한 정지의 seq (0 = 없음)
+    uint64_t m_flaggedAtMs = 0;
+
+    void Publish(const char* stage, uint64_t startMs, uint32_t budgetMs);
+};
+
+typedef std::shared_ptr<Heartbeat> HeartbeatPtr;
+
+// 장시간 실행 스레드 정지 감시
+// - 스레드는 WatchdogThreadScope로 하트비트 슬롯을 등록하고, 막힐 수 있는 호출(UIA 교차 프로세스 COM, SQLite 쓰기 등)을
+//   WATCHDOG_STAGE(이름, 예산ms)로 감쌈. 등록되지 않은 스레드에서는 아무것도 하지 않음
+// - 감시 스레드가 주기적으로 슬롯을 훑어 예산을 넘긴 단계를 정지로 판정 (정지 한 번당 로그/지표 한 번)
+// - 복구: 슬롯의 핸들러(스레드 교체 등)와 단계 핸들러(sqlite3_interrupt 등)를 감시 스레드에서 호출
+// - InjectStall: 지정한 단계에 들어갈 때 지연을 넣어 감지/복구 경로를 재현 (--watchdog-inject)
+class Watchdog {
+public:
+    static Watchdog& Instance();
+
+    explicit Watchdog(IClock* clock = nullptr);
+    ~Watchdog();
+
+    void Start(uint32_t checkIntervalMs = 1000);
+    void Stop();
+
+    // false면 정지를 기록만 하고 복구 핸들러는 호출하지 않음 (기본 true)
+    void SetRecoveryEnabled(bool enable) { m_recovery = enable; }
+
+    // 호출한 스레드의 하트비트 등록/해제 (WatchdogThreadScope 사용 권장)
+    HeartbeatPtr Register(const std::string& name, StallHandler onStall = nullptr);
+    void Unregister(const HeartbeatPtr& hb);
+    static Heartbeat* Current(); // 현재 스레드의 하트비트 (없으면 nullptr)
+
+    // 단계 이름별 복구 핸들러 (nullptr이면 해제)
+    void SetStageHandler(const char* stage, StallHandler handler);
+
+    // 다음 count번 stage에 들어갈 때 delayMs씩 멈춤 (테스트/현장 재현용)
+    void InjectStall(const char* stage, uint32_t delayMs, uint32_t count = 1);
+    // "stage:지연ms[:횟수]"
+    bool ParseInjectSpec(const char* spec);
+
+    // 감시 한 바퀴 (감시 스레드가 주기적으로 호출, 테스트에서는 직접 호출). 반환: 새로 판정한 정지 수
+    size_t CheckNow();
+
+    uint64_t NowMs() { return m_clock->NowMs(); }
+    unsigned long long Stalls() const { return m_stalls.load(); }
+    unsigned long long Recoveries() const { return m_recoveries.load(); }
+    size_t ActiveStalls() const { return m_activeStalls.load(); }
+    void DumpMetrics();
+
+    // WatchdogStage에서 호출 (주입이 설정된 경우에만 잠금)
+    static bool HasInjection() { return s_injectArmed.load(std::memory_order_relaxed); }
+    void ApplyInjection(const char* stage);
+
+private:
+    struct Injection {
+        uint32_t delayMs;
+        uint32_t remaining;
+    };
+
+    IClock* m_clock;
+    bool m_recovery;
+
+    std::mutex m_lock; // 슬롯 목록, 단계 핸들러, 주입 목록
+    std::vector<HeartbeatPtr> m_beats;
+    std::unordered_map<std::string, StallHandler> m_stageHandlers;
+    std::unordered_map<std::string, Injection> m_injections;
+    static std::atomic<bool> s_injectArmed;
+
+    std::thread m_thread;
+    std::mutex m_wakeLock;
+    std::condition_variable m_wakeCv;
+    bool m_running;
+    uint32_t m_checkIntervalMs;
+
+    std::atomic<unsigned long long> m_stalls;
+    std::atomic<unsigned long long> m_recoveries;
+    std::atomic<unsigned long long> m_stalledMs; // 정지가 풀린 것들의 총 정지 시간
+    std::atomic<size_t> m_activeStalls;
+
+    void ThreadProc();
+};
+
+// 스레드 수명 동안 하트비트 등록
+class WatchdogThreadScope {
+public:
+    explicit WatchdogThreadScope(const std::string& name, StallHandler onStall = nullptr)
+        : m_hb(Watchdog::Instance().Register(name, onStall)) {
+    }
+    ~WatchdogThreadScope() { Watchdog::Instance().Unregister(m_hb); }
+    WatchdogThreadScope(const WatchdogThreadScope&) = delete;
+    WatchdogThreadScope& operator=(const WatchdogThreadScope&) = delete;
+
+private:
+    HeartbeatPtr m_hb;
+};
+
+// 스코프 동안 현재 스레드의 단계 설정 (등록되지 않은 스레드면 아무것도 안 함)
+class WatchdogStage {
+public:
+    WatchdogStage(const char* stage, uint32_t budgetMs) : m_hb(Watchdog::Current()) {
+        if (!m_hb) return;
+        m_prev = m_hb->Enter(stage, budgetMs);
+        if (Watchdog::HasInjection()) m_hb->Owner()->ApplyInjection(stage);
+    }
+    ~WatchdogStage() {
+        if (m_hb) m_hb->Leave(m_prev);
+    }
+    WatchdogStage(const WatchdogStage&) = delete;
+    WatchdogStage& operator=(const WatchdogStage&) = delete;
+
+private:
+    Heartbeat* m_hb;
+    Heartbeat::Saved m_prev;
+};
+
+#define WATCHDOG_CONCAT_INNER(a, b) a##b
+#define WATCHDOG_CONCAT(a, b) WATCHDOG_CONCAT_INNER(a, b)
+#define WATCHDOG_STAGE(stage, budgetMs) WatchdogStage WATCHDOG_CONCAT(watchdogStage_, __LINE__)(stage, budgetMs)
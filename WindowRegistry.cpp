@@ -0,0 +1,80 @@
+﻿#include "WindowRegistry.h"
+#include "BrowserHelper.h"
+#include <unordered_set>
+#include <stdio.h>
+
+bool WindowRegistry::Resolve(HWND hwnd, BrowserWindowInfo& out) {
+    if (!hwnd) return false;
+
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid); // 같은 프로세스 내 호출이라 저렴함
+
+    // 1. 캐시 확인 (HWND 재사용에 대비해 PID까지 비교)
+    auto it = m_windows.find(hwnd);
+    if (it != m_windows.end()) {
+        if (it->second.pid == pid) {
+            out = it->second;
+            return true;
+        }
+        m_windows.erase(it);
+    }
+    auto nb = m_nonBrowser.find(hwnd);
+    if (nb != m_nonBrowser.end()) {
+        if (nb->second == pid) return false;
+        m_nonBrowser.erase(nb);
+    }
+
+    // 2. 캐시 미스: 프로세스 스냅샷으로 브라우저 판별
+    BrowserWindowInfo info;
+    info.hwnd = hwnd;
+    info.pid = pid;
+    info.type = BrowserHelper::GetBrowserType(hwnd, info.browserName);
+    if (info.type == BrowserType::Unknown) {
+        m_nonBrowser[hwnd] = pid;
+        return false;
+    }
+
+    m_windows[hwnd] = info;
+    out = info;
+    return true;
+}
+
+// EnumWindows 콜백: 보이는 소유자 없는 최상위 윈도우만 수집
+BOOL CALLBACK WindowRegistry::EnumProc(HWND hwnd, LPARAM lParam) {
+    std::vector<HWND>* tops = (std::vector<HWND>*)lParam;
+    if (IsWindowVisible(hwnd) && !GetWindow(hwnd, GW_OWNER)) {
+        tops->push_back(hwnd);
+    }
+    return TRUE;
+}
+
+void WindowRegistry::Refresh(std::vector<BrowserWindowInfo>& created, std::vector<HWND>& destroyed) {
+    std::vector<HWND> tops;
+    EnumWindows(&WindowRegistry::EnumProc, (LPARAM)&tops);
+
+    std::unordered_set<HWND> seen;
+    for (HWND hwnd : tops) {
+        seen.insert(hwnd);
+
+        bool known = m_windows.find(hwnd) != m_windows.end();
+        BrowserWindowInfo info;
+        if (Resolve(hwnd, info) && !known) {
+            created.push_back(info);
+        }
+    }
+
+    // 열거되지 않은 윈도우는 소멸(또는 숨김)으로 간주
+    for (auto it = m_windows.begin(); it != m_windows.end();) {
+        if (seen.find(it->first) == seen.end()) {
+            destroyed.push_back(it->first);
+            it = m_windows.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    for (auto it = m_nonBrowser.begin(); it != m_nonBrowser.end();) {
+        if (seen.find(it->first) == seen.end()) it = m_nonBrowser.erase(it);
+        else ++it;
+    }
+}
@@ -0,0 +1,35 @@
+﻿#pragma once
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "BrowserType.h"
+
+// 레지스트리에 등록된 브라우저 최상위 윈도우 정보
+struct BrowserWindowInfo {
+    HWND hwnd = nullptr;
+    DWORD pid = 0;
+    BrowserType type = BrowserType::Unknown;
+    std::wstring browserName;
+};
+
+// 최상위 윈도우 레지스트리
+// - HWND별 브라우저 판별 결과를 캐시하여 포커스 전환 시 GetBrowserType 재호출 방지
+// - Refresh()로 최상위 윈도우를 열거하여 생성/소멸된 브라우저 윈도우 추적
+// - 단일 스레드(모니터 스레드)에서만 사용
+class WindowRegistry {
+public:
+    // HWND의 브라우저 정보 조회 (캐시 우선), 브라우저가 아니면 false
+    bool Resolve(HWND hwnd, BrowserWindowInfo& out);
+
+    // 최상위 윈도우 재열거: 새로 나타난 브라우저 윈도우와 사라진 윈도우 반환
+    void Refresh(std::vector<BrowserWindowInfo>& created, std::vector<HWND>& destroyed);
+
+    size_t Count() const { return m_windows.size(); }
+
+private:
+    std::unordered_map<HWND, BrowserWindowInfo> m_windows; // 브라우저 윈도우
+    std::unordered_map<HWND, DWORD> m_nonBrowser;          // 브라우저 아님 (HWND -> PID)
+
+    static BOOL CALLBACK EnumProc(HWND hwnd, LPARAM lParam);
+};
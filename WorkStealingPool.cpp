@@ -0,0 +1,122 @@
+﻿#include "WorkStealingPool.h"
+#include "AsyncLogger.h"
+#include "Tracer.h"
+#include "Watchdog.h"
+#include <stdio.h>
+
+namespace {
+    // 현재 스레드가 속한 풀과 워커 번호 (외부 스레드면 nullptr)
+    thread_local const WorkStealingPool* t_pool = nullptr;
+    thread_local unsigned t_workerIndex = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned threads)
+    : m_threadCount(threads), m_running(false), m_nextWorker(0), m_pending(0),
+      m_executed(0), m_stolen(0) {
+    if (m_threadCount == 0) {
+        m_threadCount = std::thread::hardware_concurrency();
+        if (m_threadCount < 2) m_threadCount = 2;
+    }
+    for (unsigned i = 0; i < m_threadCount; i++)
+        m_workers.emplace_back(new Worker());
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    Stop();
+}
+
+void WorkStealingPool::Start() {
+    bool expected = false;
+    if (!m_running.compare_exchange_strong(expected, true)) return;
+
+    for (unsigned i = 0; i < m_threadCount; i++)
+        m_workers[i]->thread = std::thread(&WorkStealingPool::WorkerLoop, this, i);
+    printf("[Pool] Started (%u workers)\n", m_threadCount);
+}
+
+void WorkStealingPool::Stop() {
+    {
+        // Submit과 같은 잠금: 이후의 Submit은 모두 거부되고, 그 전에 받아들인 작업은 m_pending에 반영되어 있음
+        std::lock_guard<std::mutex> lock(m_idleLock);
+        if (!m_running.exchange(false)) return;
+    }
+    m_idleCv.notify_all();
+
+    for (auto& w : m_workers) {
+        if (w->thread.joinable()) w->thread.join();
+    }
+    AGENT_LOG_INFO("[Pool] Stopped (executed=%llu, stolen=%llu)", m_executed.load(), m_stolen.load());
+}
+
+bool WorkStealingPool::Submit(Task task) {
+    unsigned target = (t_pool == this)
+        ? t_workerIndex
+        : m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_threadCount;
+    {
+        // 정지 확인과 추가를 Stop과 같은 잠금 안에서 (확인 후 추가 전에 Stop이 끝나 작업이 남는 경합 방지)
+        // 워커도 이 잠금 아래에서 m_pending을 보고 대기/종료하므로 알림을 놓치지 않음
+        std::lock_guard<std::mutex> idle(m_idleLock);
+        if (!m_running.load()) return false; // 정지 중: 호출자가 직접 실행 (MessageRouter 참고)
+        m_pending.fetch_add(1); // 꺼내기 전에 항상 증가되어 있도록 먼저 올림
+        std::lock_guard<std::mutex> lock(m_workers[target]->lock);
+        m_workers[target]->tasks.push_back(std::move(task));
+    }
+    m_idleCv.notify_one();
+    return true;
+}
+
+bool WorkStealingPool::PopLocal(unsigned index, Task& task) {
+    Worker& w = *m_workers[index];
+    std::lock_guard<std::mutex> lock(w.lock);
+    if (w.tasks.empty()) return false;
+    task = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::Steal(unsigned index, Task& task) {
+    for (unsigned i = 1; i < m_threadCount; i++) {
+        Worker& victim = *m_workers[(index + i) % m_threadCount];
+        std::lock_guard<std::mutex> lock(victim.lock);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        m_stolen.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::WorkerLoop(unsigned index) {
+    t_pool = this;
+    t_workerIndex = index;
+
+    char threadName[32];
+    snprintf(threadName, sizeof(threadName), "Pool %u", index);
+    Tracer::SetThreadName(threadName);
+    WatchdogThreadScope watchdog(threadName); // 핸들러 안의 DB 쓰기 등 감시
+
+    Task task;
+    while (true) {
+        if (PopLocal(index, task) || Steal(index, task)) {
+            m_pending.fetch_sub(1);
+            try {
+                task();
+            }
+            catch (...) {
+                AGENT_LOG_ERROR("[Pool] Task threw an exception (worker %u)", index);
+            }
+            task = nullptr;
+            m_executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_idleLock);
+        m_idleCv.wait(lock, [this]() {
+            return m_pending.load() > 0 || !m_running.load();
+            });
+        if (!m_running.load() && m_pending.load() == 0) break;
+    }
+
+    t_pool = nullptr;
+}
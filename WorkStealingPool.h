@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 작업 훔치기(work-stealing) 스레드 풀
+// - 워커마다 자기 deque를 가짐: 자기 작업은 뒤에서(LIFO), 다른 워커의 작업은 앞에서(FIFO) 훔침
+// - 워커 스레드 안에서 Submit하면 자기 deque에, 외부 스레드에서 Submit하면 라운드로빈으로 분배
+// - Stop은 이미 제출된 작업을 모두 실행한 뒤 반환
+class WorkStealingPool {
+public:
+    typedef std::function<void()> Task;
+
+    explicit WorkStealingPool(unsigned threads = 0); // 0: 코어 수
+    ~WorkStealingPool();
+
+    void Start();
+    void Stop();
+
+    bool Submit(Task task); // false: 정지됨 (Stop 이후, 작업은 실행되지 않으므로 호출자가 처리)
+
+    unsigned ThreadCount() const { return m_threadCount; }
+    unsigned long long Executed() const { return m_executed.load(); }
+    unsigned long long Stolen() const { return m_stolen.load(); }
+
+private:
+    struct Worker {
+        std::mutex lock;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    unsigned m_threadCount;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<bool> m_running;
+    std::atomic<unsigned> m_nextWorker;
+    std::atomic<size_t> m_pending;
+    std::atomic<unsigned long long> m_executed;
+    std::atomic<unsigned long long> m_stolen;
+
+    std::mutex m_idleLock;
+    std::condition_variable m_idleCv;
+
+    void WorkerLoop(unsigned index);
+    bool PopLocal(unsigned index, Task& task);
+    bool Steal(unsigned index, Task& task);
+};
@@ -1,18 +1,28 @@
 #include <windows.h>
 #include "WorkerThread.h"
+#include "AsyncLogger.h"
+#include "Tracer.h"
+#include "Watchdog.h"
+#include "IpcProtocol.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <sstream>
 #include "madCHook.h"
 
-// static  ʱȭ
-std::queue<std::string> WorkerThread::m_queue;
-std::queue<std::string> WorkerThread::m_urlQueue;
-std::mutex WorkerThread::m_lock;
-std::mutex WorkerThread::m_urlLock;
-std::condition_variable WorkerThread::m_cv;
-std::condition_variable WorkerThread::m_urlCv;
+namespace {
+    const char* kDatabasePath = "C:\\ProgramData\\AgentOptions.db";
+    const char* kSpoolPath = "C:\\ProgramData\\AgentEvents.spool";
+    const size_t kReplayBatch = 256;          // ƮǴ ڵ 
+    const int kReplayIdleMs = 200;            // Ǯ   Ȯ ֱ
+    const int kDbRetryMs = 5000;              // DB 翬/÷   
+    const int kMigrationChunkRows = 500;      // ׶ ̱׷̼ ƮǴ  
+    const size_t kOptionQueueCapacity = 64;
+    const size_t kUrlQueueCapacity = 1024;
+    const ULONGLONG kStopReplayMs = 2000;     //    Ǯ ݿ  ִ ð
+}
 
-WorkerThread::WorkerThread() : m_running(false) {
+WorkerThread::WorkerThread()
+    : m_layout(DatabaseLayout::SingleFile(kDatabasePath)), m_running(false), m_ackFormat(OptionAckFormat::Batch) {
 }
 
 WorkerThread::~WorkerThread() {
@@ -25,103 +35,139 @@ void WorkerThread::Start() {
         return; // ̹  
     }
 
-    if (!m_database.Initialize("C:\\ProgramData\\AgentOptions.db")) {
-        printf("[SYSTEM] DB init failed\n");
-        m_running.store(false);
-        return;
+    // Ǯ   DB ʱȭ  ÿ ̺Ʈ   ְ 
+    if (m_spool.Open(kSpoolPath)) {
+        m_database.AttachSpool(&m_spool);
+    }
+
+    if (!m_database.Initialize(m_layout)) {
+        printf("[SYSTEM] DB init failed, retrying in background\n");
     }
 
-    m_thread = std::thread(&WorkerThread::ThreadProc, this);
-    m_urlThread = std::thread(&WorkerThread::UrlThreadProc, this);
+    // /÷̰  ѱ  忡   SQL ߴ (ߴܵ ̺Ʈ Ǯ, ÷̴ ѹ  õ)
+    for (int i = 0; i < (int)DbShard::Count; i++) {
+        DbShard shard = (DbShard)i;
+        StallHandler interrupt = [this, shard](const StallInfo&) { m_database.Interrupt(shard); };
+        Watchdog::Instance().SetStageHandler(Database::WriteStage(shard), interrupt);
+        Watchdog::Instance().SetStageHandler(Database::ReplayStage(shard), interrupt);
+    }
+
+    OptionAckOptions ackOptions;
+    ackOptions.format = m_ackFormat;
+    ackOptions.formatText = &WorkerThread::FormatAckText;
+    m_acks.SetOptions(ackOptions);
+    m_acks.Start([](const void* data, uint32_t size) {
+        return SendIpcMessage(IPC_NAME_OPTION_RESPONSE, (void*)data, (DWORD)size) != FALSE;
+    });
+
+    m_spoolThread = std::thread(&WorkerThread::SpoolThreadProc, this);
     printf("[SYSTEM] WorkerThread started\n");
 }
 
 void WorkerThread::Stop() {
     m_running.store(false);
-    m_cv.notify_all();
-    m_urlCv.notify_all();
+    {
+        std::lock_guard<std::mutex> guard(m_spoolLock);
+    }
+    m_spoolCv.notify_all();
 
-    if (m_thread.joinable()) {
-        m_thread.join();
+    if (m_spoolThread.joinable()) {
+        m_spoolThread.join();
     }
-    if (m_urlThread.joinable()) {
-        m_urlThread.join();
+    for (int i = 0; i < (int)DbShard::Count; i++) {
+        Watchdog::Instance().SetStageHandler(Database::WriteStage((DbShard)i), nullptr);
+        Watchdog::Instance().SetStageHandler(Database::ReplayStage((DbShard)i), nullptr);
     }
 
+    m_acks.Stop();
     m_database.Close();
+    m_spool.Close();
     printf("[SYSTEM] WorkerThread stopped\n");
 }
 
-void WorkerThread::PushMessage(std::string msg) {
-    {
-        std::lock_guard<std::mutex> guard(m_lock);
-        m_queue.push(std::move(msg));
-    }
-    m_cv.notify_one();
+void WorkerThread::SaveCheckpoint(AgentCheckpoint& cp) {
+    std::lock_guard<std::mutex> lock(m_optionLock);
+    cp.options = m_lastOptions;
 }
 
-void WorkerThread::PushUrlMessage(std::string msg) {
-    {
-        std::lock_guard<std::mutex> guard(m_urlLock);
-        m_urlQueue.push(std::move(msg));
-    }
-    m_urlCv.notify_one();
+void WorkerThread::RestoreCheckpoint(const AgentCheckpoint& cp) {
+    if (!cp.options.valid) return;
+    std::lock_guard<std::mutex> lock(m_optionLock);
+    m_lastOptions = cp.options;
+    printf("[SYSTEM] Last options restored (SEQ=%d OPT1=%d OPT2=%d OPT3=%d)\n",
+        m_lastOptions.seq, m_lastOptions.opt1, m_lastOptions.opt2, m_lastOptions.opt3);
 }
 
-void WorkerThread::ThreadProc() {
-    while (true) {
-        std::unique_lock<std::mutex> lk(m_lock);
-        m_cv.wait(lk, [this]() {
-            return !m_queue.empty() || !m_running.load();
-            });
-
-        if (!m_queue.empty()) {
-            std::string msg = std::move(m_queue.front());
-            m_queue.pop();
-            lk.unlock();
-
-            ProcessMessage(msg);
+void WorkerThread::RegisterHandlers(MessageRouter& router) {
+    // ɼ ޽ ü ɼ ̹Ƿ     SEQ   ϳ óϸ 
+    RouteOptions options;
+    options.ordering = HandlerOrdering::Serial;
+    options.capacity = kOptionQueueCapacity;
+    options.overflow = QueueOverflowPolicy::CoalesceByKey;
+    options.coalesceKey = [](const IpcMessage&) { return std::string("options"); };
+    // ó ʰ  ʵ û   SUPERSEDED  (ť  ȿ ȣǹǷ Post)
+    options.coalesceMerge = [this](IpcMessage& existing, IpcMessage&& incoming) {
+        OptionAck ack;
+        if (ParseSeq(incoming.payload) >= ParseSeq(existing.payload)) {
+            ParseOptions(existing.payload, ack);
+            existing = std::move(incoming);
         }
-        else if (!m_running.load()) {
-            break;
+        else {
+            ParseOptions(incoming.payload, ack);
         }
-    }
-}
-
-void WorkerThread::UrlThreadProc() {
-    while (true) {
-        std::unique_lock<std::mutex> lk(m_urlLock);
-        m_urlCv.wait(lk, [this]() {
-            return !m_urlQueue.empty() || !m_running.load();
-            });
+        ack.status = OPTION_ACK_SUPERSEDED;
+        m_acks.Post(ack);
+    };
+    router.Register(IMT_USER_OPTION_UPDATE, "UserOptionUpdate",
+        [this](const IpcMessage& msg) { ProcessMessage(msg.payload); }, options);
 
-        if (!m_urlQueue.empty()) {
-            std::string msg = std::move(m_urlQueue.front());
-            m_urlQueue.pop();
-            lk.unlock();
+    // ó   URL ̺Ʈ ϳ , ġ  ͺ 
+    RouteOptions url;
+    url.ordering = HandlerOrdering::Serial;
+    url.capacity = kUrlQueueCapacity;
+    url.overflow = QueueOverflowPolicy::CoalesceByKey;
+    url.coalesceKey = [](const IpcMessage& msg) { return msg.payload; };
+    url.coalesceMerge = [](IpcMessage&, IpcMessage&&) {};
+    router.Register(IMT_URL_EVENT, "BrowserUrlEvent",
+        [this](const IpcMessage& msg) { ProcessUrlMessage(msg.payload); }, url);
+}
 
-            ProcessUrlMessage(msg);
-        }
-        else if (!m_running.load()) {
-            break;
-        }
+// "OPT1=..;SEQ=.."  SEQ  ( 0)
+int WorkerThread::ParseSeq(const std::string& msg) {
+    size_t pos = msg.find("SEQ=");
+    while (pos != std::string::npos && pos != 0 && msg[pos - 1] != ';') {
+        pos = msg.find("SEQ=", pos + 4);
     }
+    if (pos == std::string::npos) return 0;
+    return atoi(msg.c_str() + pos + 4);
 }
 
-void WorkerThread::ProcessMessage(const std::string& msg) {
-    printf("[SYSTEM] Worker Process msg: %s\n", msg.c_str());
-
+// "OPT1=..;OPT2=..;OPT3=..;SEQ=..;TS=.." Ľ
+bool WorkerThread::ParseOptions(const std::string& msg, OptionAck& ack) {
     int seq = 0;
     int opt1 = 0, opt2 = 0, opt3 = 0;
 
     std::istringstream ss(msg);
     std::string token;
+    bool valid = true;
 
     while (std::getline(ss, token, ';')) {
         size_t pos = token.find('=');
         if (pos != std::string::npos) {
             std::string key = token.substr(0, pos);
-            int value = std::stoi(token.substr(pos + 1));
+            if (key == "TS") {
+                // ۽  Ÿӽ ():  ״ 
+                ack.sentAt = strtoull(token.c_str() + pos + 1, nullptr, 10);
+                continue;
+            }
+            int value = 0;
+            try {
+                value = std::stoi(token.substr(pos + 1));
+            }
+            catch (const std::exception&) {
+                valid = false;
+                continue;
+            }
 
             if (key == "OPT1") opt1 = value;
             else if (key == "OPT2") opt2 = value;
@@ -130,24 +176,125 @@ void WorkerThread::ProcessMessage(const std::string& msg) {
         }
     }
 
-    bool success = m_database.SaveOptions(seq, opt1, opt2, opt3);
+    ack.seq = seq;
+    ack.opt[0] = opt1;
+    ack.opt[1] = opt2;
+    ack.opt[2] = opt3;
+    return valid;
+}
+
+//   ֱ 翬,  忡 Ǯ ġ  ݿ ( ϳ ׾  )
+//    ׶ Ű ̱׷̼ ûũ 
+void WorkerThread::SpoolThreadProc() {
+    Tracer::SetThreadName("DbSpool");
+    WatchdogThreadScope watchdog("DbSpool");
+
+    ULONGLONG lastOpenAttempt = GetTickCount64();
+    while (m_running.load()) {
+        int waitMs = kReplayIdleMs;
+
+        if (!m_database.IsOpen()) {
+            ULONGLONG now = GetTickCount64();
+            if (now - lastOpenAttempt >= (ULONGLONG)kDbRetryMs) {
+                lastOpenAttempt = now;
+                m_database.Initialize(m_layout);
+            }
+            if (!m_database.IsOpen()) waitMs = kDbRetryMs;
+        }
+        if (m_spool.IsOpen()) {
+            int applied = m_database.ReplaySpool(kReplayBatch);
+            if (applied < 0) {
+                AGENT_LOG_WARN("[SYSTEM] Spool replay deferred (DB unavailable)");
+                waitMs = kDbRetryMs;
+            }
+            else if (applied > 0) {
+                continue; // и ڵ尡   ٷ  ġ
+            }
+            else {
+                m_spool.ResetIfDrained();
+                // Ǯ    ¶ ̱׷̼ ݾ 
+                if (m_database.RunBackgroundMigrations(kMigrationChunkRows)) continue;
+            }
+        }
+
+        std::unique_lock<std::mutex> lk(m_spoolLock);
+        m_spoolCv.wait_for(lk, std::chrono::milliseconds(waitMs), [this]() {
+            return !m_running.load();
+            });
+    }
+
+    //    ڵ带  ȿ ݿ (    ࿡ ÷)
+    ULONGLONG stopDeadline = GetTickCount64() + kStopReplayMs;
+    while (GetTickCount64() < stopDeadline && m_database.ReplaySpool(kReplayBatch) > 0) {}
+}
+
+void WorkerThread::ProcessMessage(const std::string& msg) {
+    AGENT_LOG_DEBUG("[SYSTEM] Worker Process msg: %s", msg.c_str());
+
+    OptionAck ack;
+    bool valid = ParseOptions(msg, ack);
+    int seq = ack.seq;
+    int opt1 = ack.opt[0], opt2 = ack.opt[1], opt3 = ack.opt[2];
 
-    std::string response = success
-        ? ("SYSTEM: Ǿϴ. DB  Ϸ (OPT1=" + std::to_string(opt1) +
-            ", OPT2=" + std::to_string(opt2) + ", OPT3=" + std::to_string(opt3) + ")")
-        : "SYSTEM:  . DB ";
+    if (!valid) {
+        AGENT_LOG_WARN("[SYSTEM] Malformed option message: %s", msg.c_str());
+        ack.status = OPTION_ACK_INVALID;
+        m_acks.Post(ack);
+        return;
+    }
 
-    const char* userQueue = "UserOptionResponse";
-    BOOL ok = SendIpcMessage(userQueue, (void*)response.c_str(), (DWORD)response.size() + 1);
+    //    α׷  ɼ ٽ  ̹  ̹Ƿ 丸 
+    bool duplicate;
+    {
+        std::lock_guard<std::mutex> lock(m_optionLock);
+        duplicate = m_lastOptions.valid && m_lastOptions.seq == seq &&
+            m_lastOptions.opt1 == opt1 && m_lastOptions.opt2 == opt2 && m_lastOptions.opt3 == opt3;
+    }
+    if (duplicate) {
+        AGENT_LOG_DEBUG("[SYSTEM] Options SEQ=%d already applied", seq);
+        ack.status = OPTION_ACK_ALREADY_APPLIED;
+    }
+    else if (m_database.SaveOptions(seq, opt1, opt2, opt3)) {
+        std::lock_guard<std::mutex> lock(m_optionLock);
+        m_lastOptions.valid = true;
+        m_lastOptions.seq = seq;
+        m_lastOptions.opt1 = opt1;
+        m_lastOptions.opt2 = opt2;
+        m_lastOptions.opt3 = opt3;
+        ack.status = OPTION_ACK_APPLIED;
+    }
+    else {
+        ack.status = OPTION_ACK_STORAGE_FAILED;
+    }
+
+    //  ۽ 尡  ó ( α׷ ų  ɼ ó )
+    m_acks.Post(ack);
+}
 
-    if (ok) {
-        printf("[SYSTEM] Sent response: %s\n", response.c_str());
+//  ڿ  (--option-ack=text)
+std::string WorkerThread::FormatAckText(const OptionAck& ack) {
+    std::string response;
+    if (ack.status == OPTION_ACK_APPLIED || ack.status == OPTION_ACK_ALREADY_APPLIED) {
+        response = "SYSTEM: Ǿϴ. DB  Ϸ (OPT1=" + std::to_string(ack.opt[0]) +
+            ", OPT2=" + std::to_string(ack.opt[1]) + ", OPT3=" + std::to_string(ack.opt[2]) + ")";
+    }
+    else if (ack.status == OPTION_ACK_INVALID) {
+        response = "SYSTEM:  .  ";
+    }
+    else if (ack.status == OPTION_ACK_SUPERSEDED) {
+        response = "SYSTEM:   .  ֽ ɼ ü";
     }
     else {
-        printf("[SYSTEM] Failed to send response\n");
+        response = "SYSTEM:  . DB ";
+    }
+    if (ack.sentAt) {
+        //  (LoadGen)     ֵ SEQ/TS ȯ
+        response += " SEQ=" + std::to_string(ack.seq) + ";TS=" + std::to_string(ack.sentAt);
     }
+    return response;
 }
 
 void WorkerThread::ProcessUrlMessage(const std::string& msg) {
-    printf("[SYSTEM] URL message received: %s\n", msg.c_str());    
+    TRACE_SPAN("WorkerThread::ProcessUrlMessage");
+    AGENT_LOG_DEBUG("[SYSTEM] URL message received: %s", msg.c_str());    
 }
\ No newline at end of file
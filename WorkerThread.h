@@ -3,10 +3,13 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
 #include <string>
 #include <atomic>
 #include "Database.h"
+#include "EventSpool.h"
+#include "MessageRouter.h"
+#include "AgentCheckpoint.h"
+#include "OptionAckChannel.h"
 
 class WorkerThread {
 public:
@@ -15,28 +18,45 @@ public:
 
     void Start();
     void Stop();
-    void PushMessage(std::string msg);
-    void PushUrlMessage(std::string msg); // URL ޽
+
+    // DB  ġ (Start  ȣ, ⺻ AgentOptions.db ϳ)
+    void SetDatabaseLayout(const DatabaseLayout& layout) { m_layout = layout; }
+
+    // ɼ     (Start  ȣ, ⺻ IMT_OPTION_ACK_BATCH )
+    void SetOptionAckFormat(OptionAckFormat format) { m_ackFormat = format; }
+
+    // ɼ/URL ޽ ڵ鷯 Ϳ 
+    void RegisterHandlers(MessageRouter& router);
 
     // Database  ȯ
     Database* GetDatabase() { return &m_database; }
 
+    //   ɼ / (Restore Start  ȣ)
+    void SaveCheckpoint(AgentCheckpoint& cp);
+    void RestoreCheckpoint(const AgentCheckpoint& cp);
+
 private:
     Database m_database;
+    DatabaseLayout m_layout;
+    EventSpool m_spool; // DB /  ̺Ʈ 
+
+    std::thread m_spoolThread; // DB 翬  Ǯ ÷
+    std::mutex m_spoolLock;
+    std::condition_variable m_spoolCv;
 
-    std::thread m_thread;
-    std::thread m_urlThread; // URL ó  
     std::atomic<bool> m_running;
 
-    static std::queue<std::string> m_queue;
-    static std::queue<std::string> m_urlQueue; // URL  ť
-    static std::mutex m_lock;
-    static std::mutex m_urlLock; // URL ť ؽ
-    static std::condition_variable m_cv;
-    static std::condition_variable m_urlCv; // URL ť cv
+    OptionAckChannel m_acks;   // ɼ   񵿱  (ó   ٸ )
+    OptionAckFormat m_ackFormat;
+
+    std::mutex m_optionLock;
+    CheckpointOptions m_lastOptions; //    ɼ  DB ٽ  
 
-    void ThreadProc();
-    void UrlThreadProc(); // URL ó 
+    void SpoolThreadProc(); // Ǯ ÷ 
     void ProcessMessage(const std::string& msg);
     void ProcessUrlMessage(const std::string& msg); // URL ޽ ó
+
+    static int ParseSeq(const std::string& msg);
+    static bool ParseOptions(const std::string& msg, OptionAck& ack); // false:   (  ack ä)
+    static std::string FormatAckText(const OptionAck& ack);
 };
\ No newline at end of file
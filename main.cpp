@@ -1,34 +1,239 @@
 ﻿#include <windows.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "madCHook.h"
 #include "IpcServer.h"
 #include "WorkerThread.h"
 #include "UrlMonitor.h"
+#include "AsyncLogger.h"
+#include "IpcProtocol.h"
+#include "MessageRouter.h"
+#include "WorkStealingPool.h"
+#include "UrlLogIngest.h"
+#include "HistoryExporter.h"
+#include "HistoryImporter.h"
+#include "Tracer.h"
+#include "Watchdog.h"
+#include "ShutdownCoordinator.h"
+#include "AgentCheckpoint.h"
+
+static const char* kCheckpointPath = "C:\\ProgramData\\AgentCheckpoint.bin";
+
+// --log-level=debug|info|warn|error
+static bool ParseLogLevel(const char* value, LogLevel& out) {
+    if (_stricmp(value, "debug") == 0) { out = LogLevel::Debug; return true; }
+    if (_stricmp(value, "info") == 0) { out = LogLevel::Info; return true; }
+    if (_stricmp(value, "warn") == 0) { out = LogLevel::Warn; return true; }
+    if (_stricmp(value, "error") == 0) { out = LogLevel::Error; return true; }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    // 로그는 백그라운드 스레드가 파일에 기록 (호출 스레드는 링 버퍼에 기록만 함)
+    AsyncLogger& logger = AsyncLogger::Instance();
+    for (int i = 1; i < argc; i++) {
+        LogLevel level;
+        if (strncmp(argv[i], "--log-level=", 12) == 0 && ParseLogLevel(argv[i] + 12, level))
+            logger.SetLevel(level);
+        else if (strcmp(argv[i], "--log-console") == 0)
+            logger.SetConsoleEcho(true);
+    }
+    logger.Start("C:\\ProgramData\\AgentLogs\\agent.log");
+
+    // --trace: 시작부터 구간 추적 (실행 중에는 IMT_TRACE_CONTROL로 켜고 끔)
+    Tracer& tracer = Tracer::Instance();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0) tracer.Enable();
+    }
+
+    // 스레드 정지 감시: --no-watchdog, --watchdog-no-recover(보고만), --watchdog-inject=단계:지연ms[:횟수]
+    Watchdog& watchdog = Watchdog::Instance();
+    bool watchdogEnabled = true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-watchdog") == 0) watchdogEnabled = false;
+        else if (strcmp(argv[i], "--watchdog-no-recover") == 0) watchdog.SetRecoveryEnabled(false);
+        else if (strncmp(argv[i], "--watchdog-inject=", 18) == 0 && !watchdog.ParseInjectSpec(argv[i] + 18))
+            printf("[Watchdog] Invalid inject spec: %s\n", argv[i] + 18);
+    }
+    if (watchdogEnabled) watchdog.Start();
+
+    // 종료 요청(Ctrl+C, 창 닫기, 로그오프/시스템 종료) 시 정해진 순서로 정리: --shutdown-timeout=ms
+    ShutdownCoordinator& shutdown = ShutdownCoordinator::Instance();
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--shutdown-timeout=", 19) == 0) shutdown.SetDeadline((uint32_t)atoi(argv[i] + 19));
+    }
+    shutdown.InstallConsoleHandler();
+
+    // 이전 실행이 종료 시 남긴 작업 상태 (--no-checkpoint: 읽지도 저장하지도 않음)
+    bool checkpointEnabled = true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-checkpoint") == 0) checkpointEnabled = false;
+    }
+    AgentCheckpoint checkpoint;
+    if (checkpointEnabled) {
+        ULONGLONG loadStart = GetTickCount64();
+        if (checkpoint.Load(kCheckpointPath))
+            printf("[Checkpoint] Loaded in %llu ms\n", (unsigned long long)(GetTickCount64() - loadStart));
+    }
 
-int main() {
     InitializeMadCHook();
 
+    // 메시지 처리 풀 (코어 수만큼)과 nType별 라우터
+    WorkStealingPool pool;
+    pool.Start();
+    MessageRouter router(&pool);
+
     //옵션 리드 시작
+    // --db-shards: 설정/브라우저 이력/요청 기록을 파일별로 분리 (이력 쓰기 폭주가 옵션 응답을 지연시키지 않도록)
+    // --option-ack=text: 옵션 적용 결과를 묶음 대신 기존 문자열 응답으로 (구버전 사용자 프로그램)
     WorkerThread worker;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--db-shards") == 0) worker.SetDatabaseLayout(DatabaseLayout::Sharded("C:\\ProgramData"));
+        else if (strcmp(argv[i], "--option-ack=text") == 0) worker.SetOptionAckFormat(OptionAckFormat::Text);
+    }
+    worker.RestoreCheckpoint(checkpoint);
     worker.Start();
+    worker.RegisterHandlers(router);
 
-    IpcServer server(&worker);
+    // 후킹된 프로세스의 HTTP 요청 기록 수집
+    UrlLogIngest urlLogIngest(worker.GetDatabase());
+    urlLogIngest.Start();
+    urlLogIngest.RegisterHandlers(router);
+
+    // SIEM 수집용 이력 내보내기 (주기 실행 + IMT_EXPORT_HISTORY 요청)
+    // --export-format=ndjson|csv --export-interval=초 --export-dir=경로 --export-compress
+    ExportOptions exportOptions;
+    for (int i = 1; i < argc; i++) {
+        if (_stricmp(argv[i], "--export-format=csv") == 0) exportOptions.format = ExportFormat::Csv;
+        else if (strncmp(argv[i], "--export-interval=", 18) == 0) exportOptions.intervalSec = (uint32_t)atoi(argv[i] + 18);
+        else if (strncmp(argv[i], "--export-dir=", 13) == 0) exportOptions.outputDir = argv[i] + 13;
+        else if (strcmp(argv[i], "--export-compress") == 0) exportOptions.compress = true;
+    }
+    HistoryExporter exporter(worker.GetDatabase(), exportOptions);
+    exporter.Start();
+    exporter.RegisterHandlers(router);
+    tracer.RegisterHandlers(router);
+
+    // 배포 직후 기존 브라우저 이력 채우기 (낮은 우선순위 백그라운드, 중단되면 다음 실행에서 이어서)
+    // --import-history(현재 사용자 프로필 자동 탐색) --import-history=chromium|firefox:브라우저:경로 --import-duty=%
+    // --import-offline: 배포 직후 첫 실행처럼 아직 조회가 없을 때만 (큰 배치 + timestamp 인덱스 재생성)
+    HistoryImportOptions importOptions;
+    std::vector<HistorySource> importSources;
+    for (int i = 1; i < argc; i++) {
+        HistorySource source;
+        if (strcmp(argv[i], "--import-history") == 0) {
+            std::vector<HistorySource> found = HistoryImporter::DiscoverSources();
+            importSources.insert(importSources.end(), found.begin(), found.end());
+        }
+        else if (strncmp(argv[i], "--import-history=", 17) == 0) {
+            if (HistoryImporter::ParseSourceSpec(argv[i] + 17, source)) importSources.push_back(source);
+            else printf("[Import] Invalid source spec: %s\n", argv[i] + 17);
+        }
+        else if (strncmp(argv[i], "--import-duty=", 14) == 0) importOptions.dutyPercent = atoi(argv[i] + 14);
+        else if (strcmp(argv[i], "--import-offline") == 0) importOptions.offline = true;
+    }
+    HistoryImporter importer(worker.GetDatabase()->GetPath(DbShard::History), importOptions);
+    for (const HistorySource& source : importSources) importer.AddSource(source);
+    importer.Start();
+
+    IpcServer server(&router);
+    server.AddQueue(IPC_NAME_OPTIONS, { IMT_USER_OPTION_UPDATE });
+    server.AddQueue(IPC_NAME_URL, { IMT_URL_EVENT });
+    server.AddQueue(IPC_NAME_URL_LOG, { IMT_URL_LOG_BATCH });
+    server.AddQueue(IPC_NAME_CONTROL, { IMT_EXPORT_HISTORY, IMT_TRACE_CONTROL });
     server.Start();
 
     printf("[SYSTEM] Running with Option Reading...\n");
 
+    // --all-windows: 포그라운드뿐 아니라 모든 브라우저 윈도우 감시
+    bool multiWindow = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--all-windows") == 0) multiWindow = true;
+    }
+
     // URL 모니터 시작
-    UrlMonitor urlMonitor(worker.GetDatabase()); // Database 포인터 전달
+    UrlMonitor urlMonitor(worker.GetDatabase(), multiWindow); // Database 포인터 전달
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--forensic") == 0) urlMonitor.SetForensicMode(true); // 재방문도 모두 새 행
+    }
+
+    // URL 정규화: --strip-params=utm_*,fbclid,... (기본 목록 대체), --keep-fragment
+    CanonicalizeOptions canonOptions = CanonicalizeOptions::Default();
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--strip-params=", 15) == 0) canonOptions.stripParams = UrlCanonicalizer::ParseParamList(argv[i] + 15);
+        else if (strcmp(argv[i], "--keep-fragment") == 0) canonOptions.dropFragment = false;
+    }
+    urlMonitor.SetCanonicalizeOptions(canonOptions);
+
+    // 주소 변경 폭주 병합: --churn-threshold=N --churn-window=초 --churn-interval=초 --churn-exempt=host,...
+    //   --churn-key-params=q,query,... (값이 다르면 병합하지 않는 쿼리 파라미터, 빈 값이면 쿼리 전체 무시)
+    ChurnOptions churnOptions;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--churn-threshold=", 18) == 0) churnOptions.threshold = (uint32_t)atoi(argv[i] + 18);
+        else if (strncmp(argv[i], "--churn-window=", 15) == 0) churnOptions.windowMs = (uint32_t)atoi(argv[i] + 15) * 1000;
+        else if (strncmp(argv[i], "--churn-interval=", 17) == 0) churnOptions.emitIntervalMs = (uint32_t)atoi(argv[i] + 17) * 1000;
+        else if (strncmp(argv[i], "--churn-exempt=", 15) == 0) churnOptions.exemptHosts = UrlCanonicalizer::ParseParamList(argv[i] + 15);
+        else if (strncmp(argv[i], "--churn-key-params=", 19) == 0) churnOptions.keyParams = UrlCanonicalizer::ParseParamList(argv[i] + 19);
+    }
+    urlMonitor.SetChurnOptions(churnOptions);
+
+    // UIA 읽기 앞 변화 감지 관문: --no-uia-gate(매 폴링 읽기), --uia-verify=ms(변화가 안 보여도 다시 읽는 주기)
+    bool gateEnabled = true;
+    uint32_t gateVerifyMs = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-uia-gate") == 0) gateEnabled = false;
+        else if (strncmp(argv[i], "--uia-verify=", 13) == 0) gateVerifyMs = (uint32_t)atoi(argv[i] + 13);
+    }
+    urlMonitor.SetChangeGate(gateEnabled, gateVerifyMs);
+    urlMonitor.RestoreCheckpoint(checkpoint);
     urlMonitor.Start();
 
     printf("[SYSTEM] Running with URL monitoring...\n");
 
-    while (true) Sleep(1000);
+    // 감지를 먼저 멈춰 대기 중인 URL 이벤트를 모두 저장/전송하고, 수신을 닫은 뒤 큐에 남은 메시지를 처리
+    // 체크포인트는 옵션 메시지까지 반영된 뒤 저장, 스풀은 WorkerThread가 기한 안에서 DB에 반영
+    shutdown.AddStep("url-monitor", [&]() { urlMonitor.Stop(); });
+    shutdown.AddStep("ipc", [&]() {
+        server.Stop();
+        router.Stop();
+        pool.Stop(); // 대기 중인 메시지 처리 완료
+        router.DumpStats();
+    });
+    shutdown.AddStep("checkpoint", [&]() {
+        if (!checkpointEnabled) return;
+        AgentCheckpoint cp;
+        urlMonitor.SaveCheckpoint(cp);
+        worker.SaveCheckpoint(cp);
+        if (cp.Save(kCheckpointPath))
+            AGENT_LOG_INFO("[Checkpoint] Saved (windows=%zu, visits=%zu, paths=%zu)",
+                cp.windows.size(), cp.visits.size(), cp.locatorPaths.size());
+    });
+    shutdown.AddStep("history-import", [&]() { importer.Stop(); }); // 진행 위치는 배치마다 커밋됨
+    shutdown.AddStep("exporter", [&]() { exporter.Stop(); });
+    shutdown.AddStep("url-log", [&]() { urlLogIngest.Stop(); }); // 남은 집계 저장
+    shutdown.AddStep("worker", [&]() { worker.Stop(); });
+    shutdown.AddStep("watchdog", [&]() {
+        watchdog.DumpMetrics();
+        watchdog.Stop();
+    });
+    shutdown.AddStep("tracer", [&]() {
+        if (Tracer::IsEnabled()) {
+            tracer.Disable();
+            tracer.DumpDefault();
+        }
+    });
 
-    urlMonitor.Stop();
-    server.Stop();
-    worker.Stop();
+    shutdown.WaitForRequest();
+    if (!shutdown.Run()) {
+        // 멈춘 단계의 스레드가 남아 있으므로 소멸자를 거치지 않고 종료 (스풀/DB는 다음 실행에서 복구)
+        logger.Stop();
+        shutdown.Complete();
+        TerminateProcess(GetCurrentProcess(), 1);
+    }
 
     FinalizeMadCHook();
+    logger.Stop();
+    shutdown.Complete();
     return 0;
 }
\ No newline at end of file